@@ -65,6 +65,8 @@ byte       DW1000Class::_preambleCode        = PREAMBLE_CODE_16MHZ_4;
 byte       DW1000Class::_channel             = CHANNEL_5;
 DW1000Time DW1000Class::_antennaDelay;
 boolean	   DW1000Class::_antennaCalibrated	 = false;
+byte       DW1000Class::_xtalTrim            = 0xFF; // ===== [Add] =====
+float      DW1000Class::_delaySlackUs        = 0.0f; // ===== [Add] =====
 boolean    DW1000Class::_smartPower          = false;
 
 boolean    DW1000Class::_frameCheck          = true;
@@ -680,7 +682,11 @@ void DW1000Class::tune() {
 	// Crystal calibration from OTP (if available)
 	byte buf_otp[4];
 	readBytesOTP(0x01E, buf_otp);
-	if (buf_otp[0] == 0) {
+	// ===== [Update] setXtalTrim() 設過的值優先（commitConfiguration() 會再跑一次 tune()） =====
+	if (_xtalTrim != 0xFF) {
+		writeValueToBytes(fsxtalt, ((_xtalTrim & 0x1F) | 0x60), LEN_FS_XTALT);
+	} else if (buf_otp[0] == 0) {
+	// ========= [End Update] =========
 		// No trim value available from OTP, use midrange value of 0x10
 		writeValueToBytes(fsxtalt, ((0x10 & 0x1F) | 0x60), LEN_FS_XTALT);
 	} else {
@@ -1022,6 +1028,22 @@ void DW1000Class::setAntennaDelay(const uint16_t value) {
 	// added by SJR
 }
 
+// ===== [Add] Crystal trim =====
+// bits 7:5 必須寫 011（user manual 7.2.44.5）
+void DW1000Class::setXtalTrim(uint8_t trim) {
+	_xtalTrim = trim & 0x1F;
+	byte fsxtalt[LEN_FS_XTALT];
+	writeValueToBytes(fsxtalt, (_xtalTrim | 0x60), LEN_FS_XTALT);
+	writeBytes(FS_CTRL, FS_XTALT_SUB, fsxtalt, LEN_FS_XTALT);
+}
+
+uint8_t DW1000Class::getXtalTrim() {
+	byte fsxtalt[LEN_FS_XTALT];
+	readBytes(FS_CTRL, FS_XTALT_SUB, fsxtalt, LEN_FS_XTALT);
+	return fsxtalt[0] & 0x1F;
+}
+// ========= [End Add] =========
+
 uint16_t DW1000Class::getAntennaDelay() {
 	return static_cast<uint16_t>(_antennaDelay.getTimestamp());
 }
@@ -1137,6 +1159,54 @@ DW1000Time DW1000Class::setDelay(const DW1000Time& delay) {
 	return futureTime;
 }
 
+// ===== [Add] 以 reference 為基準的 delayed TX =====
+boolean DW1000Class::setDelayFrom(const DW1000Time& reference, const DW1000Time& delay, DW1000Time* txTime) {
+	if(_deviceMode != TX_MODE) {
+		return false;
+	}
+	byte       delayBytes[5];
+	DW1000Time now;
+	DW1000Time target((reference.getTimestamp() + delay.getTimestamp()) & DW1000Time::TIME_MAX);
+	target.getTimestamp(delayBytes);
+	delayBytes[0] = 0;
+	delayBytes[1] &= 0xFE;
+	target.setTimestamp(delayBytes);
+	getSystemTimestamp(now);
+	// 40-bit 環狀差值，超過半個週期視為負（已經過了）
+	int64_t slack = (target.getTimestamp() - now.getTimestamp()) & DW1000Time::TIME_MAX;
+	if(slack > DW1000Time::TIME_MAX / 2) {
+		slack -= DW1000Time::TIME_OVERFLOW;
+	}
+	_delaySlackUs = (float)slack * DW1000Time::TIME_RES;
+	if(_delaySlackUs < DW1000_DELAYED_TX_MIN_SLACK_US) {
+		return false;
+	}
+	setBit(_sysctrl, LEN_SYS_CTRL, TXDLYS_BIT, true);
+	writeBytes(DX_TIME, NO_SUB, delayBytes, LEN_DX_TIME);
+	*txTime = target;
+	*txTime += _antennaDelay;
+	return true;
+}
+
+boolean DW1000Class::cancelLateTransmit() {
+	byte status[LEN_SYS_STATUS];
+	readBytes(SYS_STATUS, NO_SUB, status, LEN_SYS_STATUS);
+	if(!getBit(status, LEN_SYS_STATUS, HPDWARN_BIT)) {
+		return false;
+	}
+	idle();
+	// 清掉 HPDWARN（寫 1 清除）
+	memset(status, 0, LEN_SYS_STATUS);
+	setBit(status, LEN_SYS_STATUS, HPDWARN_BIT, true);
+	writeBytes(SYS_STATUS, NO_SUB, status, LEN_SYS_STATUS);
+	if(_permanentReceive) {
+		newReceive();
+		startReceive();
+	}
+	return true;
+}
+// ========= [End Add] =========
+
 
 void DW1000Class::setDataRate(byte rate) {
 	rate &= 0x03;
@@ -1524,6 +1594,7 @@ void DW1000Class::clearTransmitStatus() {
 	setBit(_sysstatus, LEN_SYS_STATUS, TXPRS_BIT, true);
 	setBit(_sysstatus, LEN_SYS_STATUS, TXPHS_BIT, true);
 	setBit(_sysstatus, LEN_SYS_STATUS, TXFRS_BIT, true);
+	setBit(_sysstatus, LEN_SYS_STATUS, HPDWARN_BIT, true); // ===== [Add] 上一次 delayed TX 留下的 HPDWARN =====
 	writeBytes(SYS_STATUS, NO_SUB, _sysstatus, LEN_SYS_STATUS);
 }
 
@@ -1597,6 +1668,104 @@ float DW1000Class::getReceivePower() {
 	return estRxPwr;
 }
 
+// ===== [Add] channel impulse response（accumulator） =====
+void DW1000Class::enableAccumulatorClock(boolean val) {
+	byte pmscctrl0[LEN_PMSC_CTRL0];
+	memset(pmscctrl0, 0, LEN_PMSC_CTRL0);
+	readBytes(PMSC, PMSC_CTRL0_SUB, pmscctrl0, LEN_PMSC_CTRL0);
+	pmscctrl0[0] &= PMSC_CTRL0_ACC_MASK;
+	if(val) {
+		pmscctrl0[0] |= PMSC_CTRL0_ACC_ON;
+	}
+	setBit(pmscctrl0, LEN_PMSC_CTRL0, AMCE_BIT, val);
+	writeBytes(PMSC, PMSC_CTRL0_SUB, pmscctrl0, 2);
+}
+
+uint16_t DW1000Class::getAccumulatorLength() {
+	return (_pulseFrequency == TX_PULSE_FREQ_16MHZ) ? CIR_SAMPLES_16MHZ : CIR_SAMPLES_64MHZ;
+}
+
+uint16_t DW1000Class::readAccumulator(uint16_t offset, uint16_t count, CirSample buffer[], uint16_t bufferLen,
+                                      void (*handler)(uint16_t index, const CirSample samples[], uint16_t n)) {
+	const uint16_t total = getAccumulatorLength();
+	if(offset >= total || bufferLen == 0) {
+		return 0;
+	}
+	if(count > total - offset) {
+		count = total - offset;
+	}
+	if(handler == 0 && count > bufferLen) {
+		count = bufferLen;
+	}
+	// ACC_MEM 每次讀取的第一個 byte 是 dummy，所以多讀 1 byte 再丟掉
+	byte raw[DW1000_ACC_CHUNK*CIR_BYTES_PER_SAMPLE+1];
+	uint16_t done = 0;
+	enableAccumulatorClock(true);
+	while(done < count) {
+		uint16_t n = count-done;
+		if(n > DW1000_ACC_CHUNK) {
+			n = DW1000_ACC_CHUNK;
+		}
+		// handler 模式每段都從 buffer 開頭放；否則接在後面
+		CirSample* dst = (handler != 0) ? buffer : buffer+done;
+		if(handler != 0 && n > bufferLen) {
+			n = bufferLen;
+		}
+		readBytes(ACC_MEM, (offset+done)*CIR_BYTES_PER_SAMPLE, raw, n*CIR_BYTES_PER_SAMPLE+1);
+		cirUnpack(raw+1, n, dst);
+		if(handler != 0) {
+			(*handler)(offset+done, dst, n);
+		}
+		done += n;
+	}
+	enableAccumulatorClock(false);
+	return done;
+}
+
+float DW1000Class::getFirstPathIndex() {
+	byte fpIndexBytes[LEN_FP_INDEX];
+	readBytes(RX_TIME, FP_INDEX_SUB, fpIndexBytes, LEN_FP_INDEX);
+	uint16_t fpIndex = (uint16_t)fpIndexBytes[0] | ((uint16_t)fpIndexBytes[1] << 8);
+	return (float)fpIndex/64.0f;
+}
+
+boolean DW1000Class::refineFirstPath(float* hwIndex, float* refinedIndex) {
+	const float fp = getFirstPathIndex();
+	*hwIndex      = fp;
+	*refinedIndex = fp;
+	
+	byte noiseBytes[LEN_STD_NOISE];
+	readBytes(RX_FQUAL, STD_NOISE_SUB, noiseBytes, LEN_STD_NOISE);
+	const float noise = (float)((uint16_t)noiseBytes[0] | ((uint16_t)noiseBytes[1] << 8));
+	
+	int16_t start = (int16_t)fp-CIR_LDE_SEARCH_BACK;
+	if(start < 0) {
+		start = 0;
+	}
+	CirSample window[CIR_LDE_SEARCH_BACK+CIR_LDE_SEARCH_AHEAD+1];
+	uint16_t n = readAccumulator((uint16_t)start, CIR_LDE_SEARCH_BACK+CIR_LDE_SEARCH_AHEAD+1, window,
+	                             CIR_LDE_SEARCH_BACK+CIR_LDE_SEARCH_AHEAD+1);
+	float edge = cirLeadingEdge(window, n, (uint16_t)start, noise);
+	if(edge < 0.0f) {
+		return false;
+	}
+	*refinedIndex = edge;
+	return true;
+}
+// ========= [End Add] =========
+
+// ===== [Add] 時鐘頻偏（carrier integrator） =====
+int32_t DW1000Class::getCarrierIntegrator() {
+	byte carInt[LEN_DRX_CAR_INT];
+	readBytes(DRX_TUNE, DRX_CAR_INT_SUB, carInt, LEN_DRX_CAR_INT);
+	return carrierIntegratorDecode(carInt);
+}
+
+float DW1000Class::getClockOffsetPpm() {
+	return carrierIntegratorToPpm(getCarrierIntegrator(), _channel, _dataRate == TRX_RATE_110KBPS);
+}
+// ========= [End Add] =========
+
 /* ###########################################################################
  * #### Helper functions #####################################################
  * ######################################################################### */
@@ -36,6 +36,24 @@
 #include <SPI.h>
 #include "DW1000Constants.h"
 #include "DW1000Time.h"
+#include "UWBCir.h"   // ===== [Add] =====
+#include "UWBClockOffset.h" // ===== [Add] =====
+
+// ===== [Add] readAccumulator() 每次 SPI burst 的 sample 數（stack 上要 4 * N + 1 bytes） =====
+#ifndef DW1000_ACC_CHUNK
+#if defined(ARDUINO_ARCH_ESP32) || !defined(ARDUINO)
+#define DW1000_ACC_CHUNK 64
+#else
+#define DW1000_ACC_CHUNK 16
+#endif
+#endif
+// ========= [End Add] =========
+
+// ===== [Add] setDelayFrom()：離預定 TX 時間少於這個就不排程（之後還要寫 TX buffer / SYS_CTRL） =====
+#ifndef DW1000_DELAYED_TX_MIN_SLACK_US
+#define DW1000_DELAYED_TX_MIN_SLACK_US 200
+#endif
+// ========= [End Add] =========
 
 class DW1000Class {
 public:
@@ -243,6 +261,15 @@ public:
 	
 	/* transmit and receive configuration. */
 	static DW1000Time   setDelay(const DW1000Time& delay);
+	// ===== [Add] delayed TX 以 reference（通常是剛收到的 RX timestamp）為基準，不是「讀 SYS_TIME 的當下」 =====
+	// 回覆時間不再包含 loop() 發現封包前的延遲。剩下的時間 < DW1000_DELAYED_TX_MIN_SLACK_US 時
+	// 不排程、回 false（fast-fail，呼叫端決定改用 setDelay() 或放棄）；txTime = 預計的 TX timestamp（同 setDelay 回傳值）
+	static boolean      setDelayFrom(const DW1000Time& reference, const DW1000Time& delay, DW1000Time* txTime);
+	static float        getDelaySlackUs() { return _delaySlackUs; }   // 最近一次 setDelayFrom 剩下的時間（us，負 = 已經過了）
+	// startTransmit() 之後檢查：送出指令時 delayed TX 的時間已經過了（HPDWARN），chip 會等約 17 s 才送；
+	// 這時取消 TX 並回 true（receivePermanently 時重新開始 receive）
+	static boolean      cancelLateTransmit();
+	// ========= [End Add] =========
 	static void         receivePermanently(boolean val);
 	static void         setData(byte data[], uint16_t n);
 	static void         setData(const String& data);
@@ -261,6 +288,34 @@ public:
 	static float getFirstPathPower();
 	static float getReceiveQuality();
 	
+	// ===== [Add] channel impulse response（accumulator，見 UWBCir.h） =====
+	/* 
+	從 ACC_MEM 讀 count 個 CIR sample（從 sample offset 開始），每次 SPI burst 最多 DW1000_ACC_CHUNK 個。
+	handler 不為 0 時：每讀完一段就放進 buffer[0..n) 呼叫 handler(index, buffer, n)，buffer 只要 bufferLen 大；
+	handler 為 0 時：全部依序填進 buffer（最多 bufferLen 個）。
+	要在收到封包後、下一次 receive 開始前呼叫（下一個封包會覆蓋 accumulator）。
+
+	@return 實際讀到的 sample 數
+	*/
+	static uint16_t readAccumulator(uint16_t offset, uint16_t count, CirSample buffer[], uint16_t bufferLen,
+	                                void (*handler)(uint16_t index, const CirSample samples[], uint16_t n) = 0);
+	static uint16_t getAccumulatorLength();       // 依目前 PRF：992 或 1016
+	static float    getFirstPathIndex();          // FP_INDEX（sample，含小數）
+	/* 
+	在 FP_INDEX 附近讀一小段 CIR，用 cirLeadingEdge() 找 sub-sample 的 leading edge。
+	(refinedIndex - hwIndex) * CIR_TICKS_PER_SAMPLE 就是 RX timestamp 的修正量（tick）。
+
+	@return 找不到 edge 時回傳 false，refinedIndex = hwIndex
+	*/
+	static boolean  refineFirstPath(float* hwIndex, float* refinedIndex);
+	// ========= [End Add] =========
+	
+	// ===== [Add] 時鐘頻偏（carrier integrator，見 UWBClockOffset.h） =====
+	// 收到封包後、下一次 receive 開始前讀；正值 = 對方時鐘比自己快
+	static int32_t getCarrierIntegrator();
+	static float   getClockOffsetPpm();     // 依目前 channel / data rate 換算
+	// ========= [End Add] =========
+	
 	/* interrupt management. */
 	static void interruptOnSent(boolean val);
 	static void interruptOnReceived(boolean val);
@@ -272,6 +327,11 @@ public:
 	/* Antenna delay calibration */
 	static void setAntennaDelay(const uint16_t value);
 	static uint16_t getAntennaDelay();
+	
+	// ===== [Add] Crystal trim（FS_XTALT bits 4:0，0..31；設定後 tune() 不再用 OTP 值蓋掉） =====
+	static void    setXtalTrim(uint8_t trim);
+	static uint8_t getXtalTrim();
+	// ========= [End Add] =========
 
 	/* callback handler management. */
 	static void attachErrorHandler(void (* handleError)(void)) {
@@ -457,6 +517,8 @@ public:
 	static byte       _pacSize;
 	static DW1000Time _antennaDelay;
 	static boolean    _antennaCalibrated;
+	static byte       _xtalTrim;          // ===== [Add] 0xFF = 用 OTP 值 =====
+	static float      _delaySlackUs;      // ===== [Add] setDelayFrom() 剩下的時間 =====
 	
 	/* internal helper to remember how to properly act. */
 	static boolean _permanentReceive;
@@ -523,6 +585,7 @@ public:
 	
 	/* clock management. */
 	static void enableClock(byte clock);
+	static void enableAccumulatorClock(boolean val); // ===== [Add] 讀 ACC_MEM 用 =====
 	
 	/* LDE micro-code management. */
 	static void manageLDE();
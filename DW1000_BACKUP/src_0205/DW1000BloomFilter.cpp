@@ -0,0 +1,144 @@
+/*
+ * @file DW1000BloomFilter.cpp
+ * 固定記憶體的 blocked Bloom filter，說明見 DW1000BloomFilter.h
+ */
+
+#include "DW1000BloomFilter.h"
+#include <string.h>
+#include <math.h>
+
+DW1000BloomFilter::DW1000BloomFilter() {
+	setFalsePositiveRate(BLOOM_DEFAULT_FP_RATE);
+}
+
+void DW1000BloomFilter::setFalsePositiveRate(float rate) {
+	if (!(rate > 0.0f)) rate = BLOOM_DEFAULT_FP_RATE;
+	if (rate > 0.5f) rate = 0.5f;
+	_fpRate = rate;
+
+	// 查詢時兩個世代都要看，誤判率約為單一世代的 2 倍 -> 每個世代以 p/2 設計
+	const float genRate = rate * 0.5f;
+
+	// 最佳 k = -log2(p)
+	int k = (int)(-logf(genRate) / logf(2.0f) + 0.5f);
+	if (k < 1) k = 1;
+	if (k > BLOOM_MAX_HASHES) k = BLOOM_MAX_HASHES;
+	_hashes = (uint8_t)k;
+
+	// 每世代容量：找最大的 n 使 blocked 版本的誤判率 <= genRate。
+	// 各 block 負載不均，不能用一般 Bloom 的 m * ln2^2 / -ln(p)（k 越大差越多），用二分搜尋算精確值
+	uint32_t lo = 1, hi = (uint32_t)BLOOM_BLOCKS * BLOOM_BLOCK_BITS;
+	while (lo < hi) {
+		uint32_t mid = lo + (hi - lo + 1) / 2;
+		if (blockedFalsePositive(mid, _hashes) <= genRate) lo = mid;
+		else hi = mid - 1;
+	}
+	_capacity = lo;
+
+	clear();
+}
+
+// n 個 key 平均分到 BLOOM_BLOCKS 個 block（每個 block 的 key 數 ~ Poisson(n / BLOOM_BLOCKS)），
+// 查一個新 key 時 k 個 bit 都已經被設的機率
+float DW1000BloomFilter::blockedFalsePositive(uint32_t n, uint8_t k) {
+	// 只在 setFalsePositiveRate() 時算：用 double + log 空間的 Poisson 項，λ 大時 exp(-λ) 不會 underflow
+	const double lambda = (double)n / (double)BLOOM_BLOCKS;
+	const double logKeep = log(1.0 - 1.0 / (double)BLOOM_BLOCK_BITS);   // 一個 bit 沒被某次 hash 設到
+	const double spread = 10.0 * sqrt(lambda) + 20.0;
+	const uint32_t jMin = (lambda > spread) ? (uint32_t)(lambda - spread) : 0;
+	const uint32_t jMax = (uint32_t)(lambda + spread);
+	double fp = 0.0;
+	for (uint32_t j = jMin; j <= jMax; j++) {
+		double pj = exp(-lambda + (double)j * log(lambda > 0.0 ? lambda : 1.0) - lgamma((double)j + 1.0));
+		fp += pj * pow(1.0 - exp((double)k * (double)j * logKeep), (double)k);
+	}
+	return (float)fp;
+}
+
+void DW1000BloomFilter::clear() {
+	memset(_bits, 0, sizeof(_bits));
+	_current = 0;
+	_count   = 0;
+	_total   = 0;
+}
+
+static inline uint64_t splitmix64(uint64_t x) {
+	x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ull;
+	x ^= x >> 27; x *= 0x94d049bb133111ebull;
+	x ^= x >> 31;
+	return x;
+}
+
+// 64-bit FNV-1a + splitmix64 finalizer：高 32 bit 選 block，整個值當 bit 位置的種子
+void DW1000BloomFilter::hashKey(const uint8_t* key, size_t n, uint32_t* block, uint64_t* seed) {
+	uint64_t h = 14695981039346656037ull;
+	for (size_t i = 0; i < n; i++) {
+		h ^= key[i];
+		h *= 1099511628211ull;
+	}
+	h = splitmix64(h);
+
+	*block = (uint32_t)(((h >> 32) * (uint64_t)BLOOM_BLOCKS) >> 32); // 不用除法的 range reduction
+	*seed  = h;
+}
+
+// block 內的 k 個 bit 位置：每 64 bit 切 7 個 9-bit（512 bits）位置，不夠再 splitmix 一次。
+// 不用 double hashing（h1 + i*h2）：512 bits 裡起點差一個步長的兩個 key 會共用 k-1 個 bit，誤判率壓不下去
+void DW1000BloomFilter::bitPositions(uint64_t seed, uint8_t k, uint16_t pos[BLOOM_MAX_HASHES]) {
+	uint64_t x = 0;
+	for (uint8_t i = 0; i < k; i++) {
+		if (i % 7 == 0) {
+			seed += 0x9e3779b97f4a7c15ull;
+			x = splitmix64(seed);
+		}
+		pos[i] = (uint16_t)(x & (BLOOM_BLOCK_BITS - 1));
+		x >>= 9;
+	}
+}
+
+bool DW1000BloomFilter::testBlock(uint8_t gen, uint32_t block, const uint16_t* pos) const {
+	const uint64_t* w = _bits[gen][block];
+	for (uint8_t i = 0; i < _hashes; i++) {
+		if ((w[pos[i] >> 6] & (1ull << (pos[i] & 63))) == 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool DW1000BloomFilter::mightContain(const uint8_t* key, size_t n) const {
+	uint32_t block;
+	uint64_t seed;
+	uint16_t pos[BLOOM_MAX_HASHES];
+	hashKey(key, n, &block, &seed);
+	bitPositions(seed, _hashes, pos);
+	return testBlock(_current, block, pos) || testBlock(_current ^ 1, block, pos);
+}
+
+bool DW1000BloomFilter::insertIfNew(const uint8_t* key, size_t n) {
+	uint32_t block;
+	uint64_t seed;
+	uint16_t pos[BLOOM_MAX_HASHES];
+	hashKey(key, n, &block, &seed);
+	bitPositions(seed, _hashes, pos);
+
+	// 兩個世代都要查：剛輪替完時，上一個世代仍在視窗內
+	if (testBlock(_current, block, pos) || testBlock(_current ^ 1, block, pos)) {
+		return false;
+	}
+
+	// 目前世代滿了：清掉較舊的世代並輪替（一次 memset，時間固定）
+	if (_count >= _capacity) {
+		_current ^= 1;
+		memset(_bits[_current], 0, sizeof(_bits[_current]));
+		_count = 0;
+	}
+
+	uint64_t* w = _bits[_current][block];
+	for (uint8_t i = 0; i < _hashes; i++) {
+		w[pos[i] >> 6] |= (1ull << (pos[i] & 63));
+	}
+	_count++;
+	_total++;
+	return true;
+}
@@ -0,0 +1,67 @@
+/*
+ * @file DW1000BloomFilter.h
+ * 固定記憶體的 blocked Bloom filter（IV_MODE_RAND_UNIQUE 查重用）
+ *
+ * - 每個 key 只落在一個 64-byte block（512 bits）裡，k 個 bit 都在同一條 cache line
+ * - 記憶體分成兩個世代（generation）：目前世代裝滿設計容量後，清掉舊世代並輪替
+ *   -> 誤判率維持在設定值附近，而且沒有 session 長度上限
+ *   -> 代價：只保證「最近 1~2 個世代」內不重複（隨機 96-bit IV 在世代外撞到的機率可忽略）
+ * - 沒有 false negative：回報「新的」就一定沒在視窗內出現過；
+ *   false positive 只會讓呼叫端多抽一次亂數，不影響正確性
+ */
+
+#ifndef _DW1000BloomFilter_H_INCLUDED
+#define _DW1000BloomFilter_H_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 總記憶體（KB，兩個世代合計）
+#ifndef BLOOM_SIZE_KB
+#define BLOOM_SIZE_KB 8
+#endif
+// 預設誤判率（可用 setFalsePositiveRate() 在執行期改）
+#ifndef BLOOM_DEFAULT_FP_RATE
+#define BLOOM_DEFAULT_FP_RATE 0.001f
+#endif
+
+#define BLOOM_BLOCK_WORDS 8                                   // 8 x 64 bit = 512 bits = 64 bytes
+#define BLOOM_BLOCK_BITS  (BLOOM_BLOCK_WORDS * 64)
+#define BLOOM_BLOCKS      ((BLOOM_SIZE_KB * 1024u) / 2u / (BLOOM_BLOCK_WORDS * 8u)) // 每個世代的 block 數
+#define BLOOM_MAX_HASHES  16
+
+class DW1000BloomFilter {
+public:
+	DW1000BloomFilter();
+
+	// 依誤判率重新計算 k 與每世代容量，並清空
+	void setFalsePositiveRate(float rate);
+	void clear();
+
+	// true = 新 key（已記錄）；false = 可能重複（含 false positive）
+	bool insertIfNew(const uint8_t* key, size_t n);
+	bool mightContain(const uint8_t* key, size_t n) const;
+
+	float    getFalsePositiveRate() const { return _fpRate; }
+	uint8_t  getHashCount() const { return _hashes; }
+	uint32_t getCapacity() const { return _capacity; }  // 每個世代
+	uint32_t getCount() const { return _count; }        // 目前世代已插入
+	uint32_t getTotalInserted() const { return _total; }
+	static size_t getMemoryBytes() { return sizeof(_bits); }
+
+private:
+	uint64_t _bits[2][BLOOM_BLOCKS][BLOOM_BLOCK_WORDS];
+	uint8_t  _current;   // 目前寫入的世代
+	uint8_t  _hashes;    // k
+	uint32_t _capacity;  // 每個世代可插入筆數（達到就輪替）
+	uint32_t _count;
+	uint32_t _total;
+	float    _fpRate;
+
+	static float blockedFalsePositive(uint32_t n, uint8_t k);
+	static void hashKey(const uint8_t* key, size_t n, uint32_t* block, uint64_t* seed);
+	static void bitPositions(uint64_t seed, uint8_t k, uint16_t pos[BLOOM_MAX_HASHES]);
+	bool testBlock(uint8_t gen, uint32_t block, const uint16_t* pos) const;
+};
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ * @file DW1000Cmac.cpp
+ * AES-128 CMAC（RFC 4493），說明見 DW1000Cmac.h
+ */
+
+#include "DW1000Cmac.h"
+#include <string.h>
+
+DW1000Cmac::DW1000Cmac() {
+	_ready = false;
+	memset(_k1, 0, sizeof(_k1));
+	memset(_k2, 0, sizeof(_k2));
+}
+
+DW1000Cmac::~DW1000Cmac() {
+	memset(_k1, 0, sizeof(_k1));
+	memset(_k2, 0, sizeof(_k2));
+}
+
+bool DW1000Cmac::encryptBlock(const uint8_t in[CMAC_BLOCK_LEN], uint8_t out[CMAC_BLOCK_LEN]) {
+	return _aes.encryptBlock(in, out) == 0;
+}
+
+// 子金鑰推導：左移 1 bit，最高位原本是 1 就 xor Rb(0x87)
+void DW1000Cmac::shiftLeftXor(uint8_t out[CMAC_BLOCK_LEN], const uint8_t in[CMAC_BLOCK_LEN]) {
+	uint8_t carry = 0;
+	for (int i = CMAC_BLOCK_LEN - 1; i >= 0; i--) {
+		uint8_t b = in[i];
+		out[i] = (uint8_t)((b << 1) | carry);
+		carry = b >> 7;
+	}
+	out[CMAC_BLOCK_LEN - 1] ^= (uint8_t)(0x87 & (0 - carry)); // 不用分支
+}
+
+bool DW1000Cmac::setKey(const uint8_t key[CMAC_KEY_LEN]) {
+	_ready = false;
+	if (!_aes.setKey(key, CMAC_KEY_LEN * 8)) {
+		return false;
+	}
+	uint8_t zero[CMAC_BLOCK_LEN] = {0};
+	uint8_t L[CMAC_BLOCK_LEN];
+	if (!encryptBlock(zero, L)) {
+		return false;
+	}
+	shiftLeftXor(_k1, L);
+	shiftLeftXor(_k2, _k1);
+	_ready = true;
+	return true;
+}
+
+bool DW1000Cmac::compute(const uint8_t* msg, size_t n, uint8_t* tag, size_t tagLen) {
+	if (!_ready || tagLen == 0 || tagLen > CMAC_BLOCK_LEN) {
+		return false;
+	}
+
+	size_t blocks = (n + CMAC_BLOCK_LEN - 1) / CMAC_BLOCK_LEN;
+	bool lastComplete = (n > 0) && (n % CMAC_BLOCK_LEN == 0);
+	if (blocks == 0) blocks = 1;
+
+	uint8_t x[CMAC_BLOCK_LEN] = {0};
+	uint8_t y[CMAC_BLOCK_LEN];
+
+	// 前 blocks-1 個完整 block：CBC-MAC
+	for (size_t b = 0; b + 1 < blocks; b++) {
+		for (int i = 0; i < CMAC_BLOCK_LEN; i++) y[i] = x[i] ^ msg[b * CMAC_BLOCK_LEN + i];
+		if (!encryptBlock(y, x)) return false;
+	}
+
+	// 最後一個 block：完整就 xor K1，不完整就補 10..0 再 xor K2
+	uint8_t last[CMAC_BLOCK_LEN];
+	size_t off = (blocks - 1) * CMAC_BLOCK_LEN;
+	if (lastComplete) {
+		for (int i = 0; i < CMAC_BLOCK_LEN; i++) last[i] = msg[off + i] ^ _k1[i];
+	} else {
+		size_t rem = n - off;
+		memset(last, 0, sizeof(last));
+		if (rem > 0) memcpy(last, msg + off, rem);
+		last[rem] = 0x80;
+		for (int i = 0; i < CMAC_BLOCK_LEN; i++) last[i] ^= _k2[i];
+	}
+	for (int i = 0; i < CMAC_BLOCK_LEN; i++) y[i] = x[i] ^ last[i];
+	if (!encryptBlock(y, x)) return false;
+
+	memcpy(tag, x, tagLen);
+	return true;
+}
+
+bool DW1000Cmac::verify(const uint8_t* msg, size_t n, const uint8_t* tag, size_t tagLen) {
+	uint8_t expect[CMAC_BLOCK_LEN];
+	if (!compute(msg, n, expect, tagLen)) {
+		return false;
+	}
+	uint8_t diff = 0;
+	for (size_t i = 0; i < tagLen; i++) diff |= (uint8_t)(expect[i] ^ tag[i]);
+	return diff == 0;
+}
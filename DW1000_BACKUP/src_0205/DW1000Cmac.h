@@ -0,0 +1,44 @@
+/*
+ * @file DW1000Cmac.h
+ * AES-128 CMAC（RFC 4493），可截短輸出；用於 RANGE 封包的時間戳驗證
+ *
+ * setKey() 只做一次：AES key schedule 與 CMAC 子金鑰 K1/K2 都先算好存著，
+ * 之後每個封包只需要 ceil(n/16) 次 AES block 加密（後端見 DW1000Crypto.h）。
+ */
+
+#ifndef _DW1000Cmac_H_INCLUDED
+#define _DW1000Cmac_H_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "DW1000Crypto.h"
+
+#define CMAC_BLOCK_LEN 16
+#define CMAC_KEY_LEN   16
+
+class DW1000Cmac {
+public:
+	DW1000Cmac();
+	~DW1000Cmac();
+
+	// 預先展開 key schedule + 子金鑰；AES 後端失敗時回 false
+	bool setKey(const uint8_t key[CMAC_KEY_LEN]);
+	bool isReady() const { return _ready; }
+
+	// tagLen 1..16（截短 = 取前 tagLen bytes）
+	bool compute(const uint8_t* msg, size_t n, uint8_t* tag, size_t tagLen);
+	// 比對時間固定（不因第一個不同的 byte 提早結束）
+	bool verify(const uint8_t* msg, size_t n, const uint8_t* tag, size_t tagLen);
+
+private:
+	bool    _ready;
+	uint8_t _k1[CMAC_BLOCK_LEN];
+	uint8_t _k2[CMAC_BLOCK_LEN];
+	DW1000Crypto _aes;   // block cipher 走 DW1000Crypto 後端
+
+	bool encryptBlock(const uint8_t in[CMAC_BLOCK_LEN], uint8_t out[CMAC_BLOCK_LEN]);
+	static void shiftLeftXor(uint8_t out[CMAC_BLOCK_LEN], const uint8_t in[CMAC_BLOCK_LEN]);
+};
+
+#endif
@@ -94,6 +94,7 @@
 #define RXRFTO_BIT 17
 #define RXPTO_BIT 21
 #define RXSFDTO_BIT 26
+#define HPDWARN_BIT 27 // ===== [Add] delayed TX/RX 的時間已經過了（差超過半個 40-bit 週期） =====
 #define LDEERR_BIT 18
 #define RFPLL_LL_BIT 24
 #define CLKPLL_LL_BIT 25
@@ -114,6 +115,10 @@
 #define FP_AMPL1_SUB 0x07
 #define LEN_RX_STAMP LEN_STAMP
 #define LEN_FP_AMPL1 2
+// ===== [Add] first path index（10.6 定點數，單位：accumulator sample） =====
+#define FP_INDEX_SUB 0x05
+#define LEN_FP_INDEX 2
+// ========= [End Add] =========
 
 // RX frame quality
 #define RX_FQUAL 0x12
@@ -127,6 +132,14 @@
 #define LEN_FP_AMPL3 2
 #define LEN_CIR_PWR 2
 
+// ===== [Add] accumulator memory（CIR，格式見 UWBCir.h） =====
+#define ACC_MEM 0x25
+// PMSC_CTRL0：讀 ACC_MEM 前要開 FACE（bit 6）/ AMCE（bit 15），RXCLKS 強制 125 MHz PLL
+#define PMSC_CTRL0_ACC_MASK 0xB3    // byte 0 保留的 bits（RXCLKS[3:2]、FACE[6] 以外）
+#define PMSC_CTRL0_ACC_ON   0x48    // FACE + RXCLKS = 10
+#define AMCE_BIT 15
+// ========= [End Add] =========
+
 // TX timestamp register
 #define TX_TIME 0x17
 #define LEN_TX_TIME 10
@@ -199,6 +212,11 @@
 #define LEN_DRX_TUNE2 4
 #define LEN_DRX_TUNE4H 2
 
+// ===== [Add] carrier recovery integrator（21-bit 有號，換算見 UWBClockOffset.h） =====
+#define DRX_CAR_INT_SUB 0x28
+#define LEN_DRX_CAR_INT 3
+// ========= [End Add] =========
+
 // LDE_CFG1 (for re-tuning only)
 #define LDE_IF 0x2E
 #define LDE_CFG1_SUB 0x0806
@@ -0,0 +1,101 @@
+/*
+ * @file DW1000Crypto.h
+ * AES / AES-GCM 後端介面（編譯期選擇），RANGE_REPORT 加密與 RANGE CMAC 共用
+ *
+ * UWB_CRYPTO_BACKEND：
+ *   - UWB_CRYPTO_BACKEND_MBEDTLS  : mbedTLS 軟體 AES-GCM（ESP32 預設，與原本行為相同）
+ *   - UWB_CRYPTO_BACKEND_ESP32_HW : ESP32 AES 硬體加速器做 block 加密，CTR/GHASH 在 CPU 上算
+ *   - UWB_CRYPTO_BACKEND_PORTABLE : 純 C++ byte-oriented AES + bitwise GHASH（host 預設）；
+ *                                   SubBytes 仍查 256-byte S-box（只省掉 4KB T-table，不是 table-free / constant-time）
+ *
+ * 金鑰只展開一次（setKey），之後每個封包直接用；回傳值沿用 mbedTLS 的錯誤碼，
+ * 方便和舊的 debug 輸出對照（0 = 成功）。
+ */
+
+#ifndef _DW1000Crypto_H_INCLUDED
+#define _DW1000Crypto_H_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define UWB_CRYPTO_BACKEND_PORTABLE 0
+#define UWB_CRYPTO_BACKEND_MBEDTLS  1
+#define UWB_CRYPTO_BACKEND_ESP32_HW 2
+
+#ifndef UWB_CRYPTO_BACKEND
+#if defined(ARDUINO_ARCH_ESP32)
+#define UWB_CRYPTO_BACKEND UWB_CRYPTO_BACKEND_MBEDTLS
+#else
+#define UWB_CRYPTO_BACKEND UWB_CRYPTO_BACKEND_PORTABLE
+#endif
+#endif
+
+#if (UWB_CRYPTO_BACKEND == UWB_CRYPTO_BACKEND_ESP32_HW) && !defined(ARDUINO_ARCH_ESP32)
+#error "UWB_CRYPTO_BACKEND_ESP32_HW needs ARDUINO_ARCH_ESP32"
+#endif
+
+#if UWB_CRYPTO_BACKEND == UWB_CRYPTO_BACKEND_MBEDTLS
+#include "mbedtls/aes.h"
+#include "mbedtls/gcm.h"
+#elif UWB_CRYPTO_BACKEND == UWB_CRYPTO_BACKEND_ESP32_HW
+#if defined(__has_include) && __has_include("aes/esp_aes.h")
+#include "aes/esp_aes.h"      // ESP-IDF 4.x 之後
+#else
+#include "hwcrypto/aes.h"     // 舊版 arduino-esp32
+#endif
+#endif
+
+#define CRYPTO_BLOCK_LEN 16
+
+// 錯誤碼（數值同 mbedTLS）
+#define CRYPTO_ERR_AUTH_FAILED -0x0012
+#define CRYPTO_ERR_BAD_INPUT   -0x0014
+#define CRYPTO_ERR_NOT_READY   -0x0016
+
+class DW1000Crypto {
+public:
+	DW1000Crypto();
+	~DW1000Crypto();
+
+	// keyBits = 128 / 192 / 256；成功回 true
+	bool setKey(const uint8_t* key, size_t keyBits);
+	bool isReady() const { return _ready; }
+
+	// 單一 block AES 加密（CMAC 用）
+	int encryptBlock(const uint8_t in[CRYPTO_BLOCK_LEN], uint8_t out[CRYPTO_BLOCK_LEN]);
+
+	// AES-GCM；tagLen 4..16
+	int gcmEncrypt(const uint8_t* iv, size_t ivLen, const uint8_t* aad, size_t aadLen,
+	               const uint8_t* input, size_t n, uint8_t* output, uint8_t* tag, size_t tagLen);
+	// TAG 不對回 CRYPTO_ERR_AUTH_FAILED，且 output 會被清成 0
+	int gcmDecrypt(const uint8_t* iv, size_t ivLen, const uint8_t* aad, size_t aadLen,
+	               const uint8_t* input, size_t n, uint8_t* output, const uint8_t* tag, size_t tagLen);
+
+	static const char* backendName();
+	// 已知答案測試：FIPS-197 AES-128、GCM spec Test Case 2 (AES-128) / 14 (AES-256)
+	static bool selfTest();
+
+private:
+	bool _ready;
+
+#if UWB_CRYPTO_BACKEND == UWB_CRYPTO_BACKEND_MBEDTLS
+	mbedtls_aes_context _aes;
+	mbedtls_gcm_context _gcm;
+#else
+#if UWB_CRYPTO_BACKEND == UWB_CRYPTO_BACKEND_ESP32_HW
+	esp_aes_context _aes;
+#else
+	uint8_t _roundKey[240];   // 最多 15 個 round key（AES-256）
+	uint8_t _rounds;
+#endif
+	uint8_t _h[CRYPTO_BLOCK_LEN];  // GHASH 子金鑰 H = E(K, 0^128)
+
+	void gcmStart(const uint8_t* iv, size_t ivLen, uint8_t j0[CRYPTO_BLOCK_LEN]);
+	void gcmCtr(const uint8_t j0[CRYPTO_BLOCK_LEN], const uint8_t* in, size_t n, uint8_t* out);
+	void gcmTag(const uint8_t j0[CRYPTO_BLOCK_LEN], const uint8_t* aad, size_t aadLen,
+	            const uint8_t* ct, size_t n, uint8_t tag[CRYPTO_BLOCK_LEN]);
+	void ghashUpdate(uint8_t y[CRYPTO_BLOCK_LEN], const uint8_t* p, size_t n);
+#endif
+};
+
+#endif
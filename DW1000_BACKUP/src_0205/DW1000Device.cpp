@@ -28,6 +28,8 @@
 //Constructor and destructor
 DW1000Device::DW1000Device() {
 	randomShortAddress();
+	_rangeOutlier = false; // ===== [Add] =====
+	pollRound = 0;        // ===== [Add] =====
 }
 
 DW1000Device::DW1000Device(byte deviceAddress[], boolean shortOne) {
@@ -40,6 +42,8 @@ DW1000Device::DW1000Device(byte deviceAddress[], boolean shortOne) {
 		//we have a short address (2 bytes)
 		setShortAddress(deviceAddress);
 	}
+	_rangeOutlier = false; // ===== [Add] =====
+	pollRound = 0;        // ===== [Add] =====
 }
 
 DW1000Device::DW1000Device(byte deviceAddress[], byte shortAddress[]) {
@@ -47,6 +51,8 @@ DW1000Device::DW1000Device(byte deviceAddress[], byte shortAddress[]) {
 	setAddress(deviceAddress);
 	//we set the 2 bytes address
 	setShortAddress(shortAddress);
+	_rangeOutlier = false; // ===== [Add] =====
+	pollRound = 0;        // ===== [Add] =====
 }
 
 DW1000Device::~DW1000Device() {
@@ -29,6 +29,8 @@
 
 #include "DW1000Time.h"
 #include "DW1000Mac.h"
+#include "UWBHampel.h"
+#include "UWBClockOffset.h"
 
 class DW1000Mac;
 
@@ -88,6 +90,22 @@ public:
 	
 	void    noteActivity();
 	boolean isInactive();
+	
+	// ===== [Add] RANGE MAC 的新鮮度：ANCHOR 記下 TAG 最近一個 POLL 帶的 round 編號，驗 RANGE MAC 時一起算 =====
+	uint32_t pollRound;
+	// ========= [End Add] =========
+
+	// ===== [Add] Range 離群值過濾（Hampel，設定見 DW1000Ranging::useRangeOutlierFilter） =====
+	// 狀態只有陣列與索引，device 被 memcpy 進 _networkDevices 也沒問題
+	UWBHampel rangeHampel;
+	void    setRangeOutlier(boolean outlier) { _rangeOutlier = outlier; }
+	boolean isRangeOutlier() { return _rangeOutlier; }   // 最近一筆 range 是否被換成 median
+	// ========= [End Add] =========
+
+	// ===== [Add] 對方相對自己的時鐘頻偏（ppm，每收到對方一個封包由 DW1000Ranging 更新） =====
+	UWBClockOffsetFilter clockOffset;
+	float getClockOffsetPpm() { return clockOffset.ppm(); }
+	// ========= [End Add] =========
 
 
 private:
@@ -103,6 +121,8 @@ private:
 	int16_t _FPPower;
 	int16_t _quality;
 	
+	boolean _rangeOutlier; // ===== [Add] =====
+	
 	void randomShortAddress();
 	
 };
@@ -0,0 +1,159 @@
+/*
+ * @file DW1000Nonce.cpp
+ * AES-GCM Nonce(IV) 產生器（IV_MODE_BOOT_COUNTER 用），格式說明見 DW1000Nonce.h
+ */
+
+#include "DW1000Nonce.h"
+#include <string.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Preferences.h>   // NVS
+#include "esp_system.h"    // esp_random()
+#elif !defined(ARDUINO)
+#include <stdio.h>         // host：用檔案模擬 NVS
+#include <time.h>
+#endif
+
+DW1000NonceClass DW1000Nonce;
+
+bool     DW1000NonceClass::_ready   = false;
+uint32_t DW1000NonceClass::_boot    = 0;
+uint32_t DW1000NonceClass::_perBoot = 0;
+uint32_t DW1000NonceClass::_salt    = 0;
+
+bool DW1000NonceClass::begin() {
+	if (_ready) {
+		return true; // 本次開機已經保留過 boot 值
+	}
+	_ready = reserveBoot();
+	return _ready;
+}
+
+bool DW1000NonceClass::next(uint8_t outIV[NONCE_IV_LEN]) {
+	if (!_ready) {
+		return false;
+	}
+	if (_perBoot == 0xFFFFFFFFu) {
+		// 本次 boot 的 2^32 個 IV 已用完：再保留一個新的 boot 值（O(1)，只多一次寫入）
+		if (!reserveBoot()) {
+			_ready = false;
+			return false;
+		}
+	}
+
+	uint32_t ctr = _perBoot++;
+	// little-endian 寫入，IV[0..7] = (boot << 32 | perBoot)
+	for (uint8_t i = 0; i < 4; i++) {
+		outIV[i]     = (uint8_t)(ctr >> (8 * i));
+		outIV[4 + i] = (uint8_t)(_boot >> (8 * i));
+		outIV[8 + i] = (uint8_t)(_salt >> (8 * i));
+	}
+	return true;
+}
+
+bool DW1000NonceClass::reserveBoot() {
+	uint32_t stored = 0;
+	if (!loadBoot(&stored)) {
+		return false;
+	}
+	if (stored == 0xFFFFFFFFu) {
+		return false; // 開機計數器用盡：同一把 key 不能再保證 IV 不重複
+	}
+	// 先寫回再使用：寫入失敗就不能用（避免下次開機重用同一個 boot 值）
+	if (!storeBoot(stored + 1)) {
+		return false;
+	}
+	_boot    = stored + 1;
+	_perBoot = 0;
+	_salt    = randomSalt();
+	return true;
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+bool DW1000NonceClass::loadBoot(uint32_t* value) {
+	Preferences prefs;
+	if (!prefs.begin(NONCE_NVS_NAMESPACE, false)) {
+		return false;
+	}
+	*value = prefs.getUInt(NONCE_NVS_KEY, 0);
+	prefs.end();
+	return true;
+}
+
+bool DW1000NonceClass::storeBoot(uint32_t value) {
+	Preferences prefs;
+	if (!prefs.begin(NONCE_NVS_NAMESPACE, false)) {
+		return false;
+	}
+	size_t n = prefs.putUInt(NONCE_NVS_KEY, value);
+	prefs.end();
+	return n == sizeof(uint32_t);
+}
+
+uint32_t DW1000NonceClass::randomSalt() {
+	return esp_random();
+}
+
+#elif !defined(ARDUINO)
+
+// host：檔案內容就是 4 bytes little-endian 的 boot 值；檔案不存在視為 0
+bool DW1000NonceClass::loadBoot(uint32_t* value) {
+	*value = 0;
+	FILE* f = fopen(NONCE_BOOT_FILE, "rb");
+	if (f == NULL) {
+		return true;
+	}
+	uint8_t b[4];
+	size_t n = fread(b, 1, sizeof(b), f);
+	fclose(f);
+	if (n != sizeof(b)) {
+		return false; // 檔案損毀：不要猜，直接拒絕
+	}
+	*value = (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+	return true;
+}
+
+bool DW1000NonceClass::storeBoot(uint32_t value) {
+	FILE* f = fopen(NONCE_BOOT_FILE, "wb");
+	if (f == NULL) {
+		return false;
+	}
+	uint8_t b[4] = {(uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24)};
+	bool ok = (fwrite(b, 1, sizeof(b), f) == sizeof(b));
+	ok = (fflush(f) == 0) && ok;
+	ok = (fclose(f) == 0) && ok;
+	return ok;
+}
+
+uint32_t DW1000NonceClass::randomSalt() {
+	uint32_t salt = 0;
+	FILE* f = fopen("/dev/urandom", "rb");
+	if (f != NULL) {
+		size_t n = fread(&salt, 1, sizeof(salt), f);
+		fclose(f);
+		if (n == sizeof(salt)) {
+			return salt;
+		}
+	}
+	return (uint32_t)time(NULL) ^ (uint32_t)clock();
+}
+
+#else
+
+// 其他 Arduino 平台：沒有可用的持久化儲存，無法保證跨開機不重複 -> begin() 失敗
+bool DW1000NonceClass::loadBoot(uint32_t* value) {
+	*value = 0;
+	return false;
+}
+
+bool DW1000NonceClass::storeBoot(uint32_t value) {
+	(void)value;
+	return false;
+}
+
+uint32_t DW1000NonceClass::randomSalt() {
+	return 0;
+}
+
+#endif
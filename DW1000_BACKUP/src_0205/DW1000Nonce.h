@@ -0,0 +1,64 @@
+/*
+ * @file DW1000Nonce.h
+ * AES-GCM Nonce(IV) 產生器（IV_MODE_BOOT_COUNTER 用）
+ *
+ * IV(12 bytes) = [perBoot:4][boot:4][salt:4]（皆為 little-endian）
+ *   - boot    ：開機計數器，每次開機先 +1 並寫回持久化儲存（ESP32 = NVS，host = 檔案）
+ *   - perBoot ：本次開機內的封包計數器，每包 +1；用完 2^32 個就再保留一個新的 boot 值
+ *   - salt    ：每次保留 boot 值時重新抽的亂數（讓共用同一把 key 的裝置不容易撞到同一組 IV）
+ *
+ * (boot, perBoot) 這一對在同一台裝置上永不重複，所以不需要查重表：
+ * 產生一個 IV 是 O(1) 時間、固定記憶體，也沒有 session 長度上限。
+ * IV[0..7] 當作 little-endian uint64 就是 (boot << 32 | perBoot)，會單調遞增。
+ */
+
+#ifndef _DW1000Nonce_H_INCLUDED
+#define _DW1000Nonce_H_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+
+// IV 長度（需與 ENC_IV_LEN 一致）
+#define NONCE_IV_LEN 12
+
+// ESP32：NVS namespace / key
+#ifndef NONCE_NVS_NAMESPACE
+#define NONCE_NVS_NAMESPACE "uwb_nonce"
+#endif
+#ifndef NONCE_NVS_KEY
+#define NONCE_NVS_KEY "boot"
+#endif
+
+// host（非 Arduino）：用檔案模擬 NVS
+#ifndef NONCE_BOOT_FILE
+#define NONCE_BOOT_FILE "uwb_boot_counter.bin"
+#endif
+
+class DW1000NonceClass {
+public:
+	// 讀取持久化的開機計數器並 +1（寫回成功才算數）；成功回 true
+	static bool begin();
+	// 產生下一個 IV；未 begin() 或計數器用盡時回 false
+	static bool next(uint8_t outIV[NONCE_IV_LEN]);
+
+	static bool     isReady() { return _ready; }
+	static uint32_t getBootCounter() { return _boot; }
+	static uint32_t getPerBootCounter() { return _perBoot; }
+	static uint32_t getSalt() { return _salt; }
+
+private:
+	static bool     _ready;
+	static uint32_t _boot;
+	static uint32_t _perBoot;
+	static uint32_t _salt;
+
+	// 保留一個新的 boot 值（先寫回儲存再使用，斷電也不會重用）
+	static bool     reserveBoot();
+	static bool     loadBoot(uint32_t* value);
+	static bool     storeBoot(uint32_t value);
+	static uint32_t randomSalt();
+};
+
+extern DW1000NonceClass DW1000Nonce;
+
+#endif
@@ -29,13 +29,12 @@
 
 #include "DW1000Ranging.h"
 #include "DW1000Device.h"
+#include "DW1000Nonce.h"
+#include "DW1000Cmac.h"
 
 // ===== [Add] Encryption includes =====
-// ESP32 才有用到 mbedTLS AES-GCM；非 ESP32 直接略過以保持可編譯
-#if defined(ARDUINO_ARCH_ESP32)
-#include "mbedtls/gcm.h"     // AES-GCM      
-#include "mbedtls/cipher.h"  // cipher helper
-#endif
+// AES-GCM 走 DW1000Crypto（編譯期選後端：mbedTLS / ESP32 HW AES / portable）
+#include "DW1000Crypto.h"
 
 // 32 bytes = 256-bit AES key（示範用 key，可自行更換）
 // static：只在本 .cpp 可見，避免 multiple definition
@@ -46,6 +45,23 @@ static const uint8_t UWB_AES_KEY[32] = {
   0x18,0x19,0x1A,0x1B, 0x1C,0x1D,0x1E,0x1F
 };
 
+// 16 bytes = 128-bit CMAC key（RANGE 封包驗證用；與 GCM key 分開，避免同一把 key 兩種用途）
+static const uint8_t UWB_MAC_KEY[16] = {
+  0x20,0x21,0x22,0x23, 0x24,0x25,0x26,0x27,
+  0x28,0x29,0x2A,0x2B, 0x2C,0x2D,0x2E,0x2F
+};
+// key schedule + 子金鑰只在開啟時算一次
+static DW1000Cmac _rangeCmac;
+
+// RANGE_REPORT 的 AES-GCM context：第一次用到才展開 key，之後每包共用
+static DW1000Crypto _reportGcm;
+static bool reportGcmReady() {
+  if (!_reportGcm.isReady()) {
+    _reportGcm.setKey(UWB_AES_KEY, 256);
+  }
+  return _reportGcm.isReady();
+}
+
 // 除錯工具：印出 bytes 的 HEX（用於檢查 key/IV/nonce/tag/密文）
 static bool _encDbgKeyPrinted = false;
 static void dumpHex(const char* label, const uint8_t* p, size_t n) {
@@ -57,6 +73,69 @@ static void dumpHex(const char* label, const uint8_t* p, size_t n) {
   }
   Serial.println();
 }
+
+// AAD = [msgid][anchor short addr][ivMode][IV[0..7]]：讓密文綁定送方、IV 模式與 counter（收方用 MAC header 的來源位址重建）
+static void buildReportAAD(uint8_t aad[ENC_AAD_LEN], const byte anchorShortAddress[2], uint8_t ivMode, const uint8_t iv[ENC_IV_LEN]) {
+  aad[0] = RANGE_REPORT;
+  aad[1] = anchorShortAddress[0];
+  aad[2] = anchorShortAddress[1];
+  aad[3] = ivMode;
+  memcpy(aad + 4, iv, 8);
+}
+
+// IV[0..7] 當 little-endian uint64：BOOT_COUNTER 模式下跨開機單調遞增（COUNTER 只在同一次開機內）
+static uint64_t ivSequence(const uint8_t iv[ENC_IV_LEN]) {
+  uint64_t seq = 0;
+  for (int i = 7; i >= 0; i--) {
+    seq = (seq << 8) | iv[i];
+  }
+  return seq;
+}
+
+// 防重送表：每個 anchor short address 最後接受的 (boot, perBoot)，只收比它新的序號
+// 不放在 DW1000Device：inactive 被移除再加回來時 device 的狀態會重來，錄下來的舊 RANGE_REPORT 就能再用一次；
+// 這張表不隨 device 增減、也不重設（BOOT_COUNTER 跨開機單調）。同一台 anchor 一輪只回一包，不會亂序
+struct ReplayEntry {
+  uint16_t shortAddress;
+  uint32_t boot;
+  uint32_t counter;   // perBoot
+};
+static ReplayEntry _replayTable[REPLAY_TABLE_SIZE];
+static uint8_t     _replayTableUsed = 0;
+
+static ReplayEntry* replayFind(uint16_t shortAddress) {
+  for (uint8_t i = 0; i < _replayTableUsed; i++) {
+    if (_replayTable[i].shortAddress == shortAddress) return &_replayTable[i];
+  }
+  return NULL;
+}
+
+// true = 比這台 anchor 上次接受的序號新（沒見過的 anchor 也算，但表滿了就不收）
+static bool replayIsFresh(uint16_t shortAddress, uint64_t seq) {
+  const ReplayEntry* e = replayFind(shortAddress);
+  if (e == NULL) return _replayTableUsed < REPLAY_TABLE_SIZE;
+  return seq > (((uint64_t)e->boot << 32) | e->counter);
+}
+
+// 只在 GCM TAG 驗證成功後呼叫（偽造封包不會推動序號）
+static void replayAccept(uint16_t shortAddress, uint64_t seq) {
+  ReplayEntry* e = replayFind(shortAddress);
+  if (e == NULL) {
+    if (_replayTableUsed >= REPLAY_TABLE_SIZE) return;
+    e = &_replayTable[_replayTableUsed++];
+    e->shortAddress = shortAddress;
+  }
+  e->boot    = (uint32_t)(seq >> 32);
+  e->counter = (uint32_t)seq;
+}
+
+// 除錯工具：IV 模式名稱
+static const char* ivModeName(uint8_t mode) {
+  if (mode == IV_MODE_COUNTER)      return "COUNTER";
+  if (mode == IV_MODE_RAND_UNIQUE)  return "RAND_UNIQUE";
+  if (mode == IV_MODE_BOOT_COUNTER) return "BOOT_COUNTER";
+  return "UNKNOWN";
+}
 // ========= [End Add] =========
 
 
@@ -66,6 +145,19 @@ static void dumpHex(const char* label, const uint8_t* p, size_t n) {
 #if defined(ARDUINO_ARCH_ESP32)
 #include "esp_system.h" // for esp_random()
 
+#if IV_UNIQ_FILTER == IV_UNIQ_FILTER_BLOOM
+// Bloom 版：固定 BLOOM_SIZE_KB，insert 時間固定，沒有包數上限（誤判只會讓 IV 重抽）
+#include "DW1000BloomFilter.h"
+static DW1000BloomFilter _iv_bloom;
+
+static void iv_table_clear() {
+  _iv_bloom.clear();
+}
+
+static bool iv_table_insert_if_new(const uint8_t iv[ENC_IV_LEN]) {
+  return _iv_bloom.insertIfNew(iv, ENC_IV_LEN);
+}
+#else
 // RAM 注意：IV_UNIQ_TABLE_SIZE=4096 時約 52KB（iv + flag）
 static uint8_t  _iv_used[IV_UNIQ_TABLE_SIZE][ENC_IV_LEN];
 static uint8_t  _iv_used_flag[IV_UNIQ_TABLE_SIZE];
@@ -114,6 +206,7 @@ static bool iv_table_insert_if_new(const uint8_t iv[ENC_IV_LEN]) {
 
   return false; // 理論上不該走到這（表滿/探測完）
 }
+#endif
 
 // 生成唯一亂數 IV：成功回 true；失敗回 false（極端：表滿或碰撞過多）
 static bool gen_unique_random_iv(uint8_t outIV[ENC_IV_LEN]) {
@@ -157,6 +250,20 @@ volatile byte    DW1000RangingClass::_expectedMsgId;
 volatile boolean DW1000RangingClass::_useRangeFilter = false;
 uint16_t DW1000RangingClass::_rangeFilterValue = 15;
 
+// ===== [Add] range 離群值過濾（Hampel） =====
+DW1000RangingClass::RangeOutlierConfig DW1000RangingClass::_rangeOutlierDefault = {0, false, HAMPEL_DEFAULT_WINDOW, HAMPEL_DEFAULT_K};
+DW1000RangingClass::RangeOutlierConfig DW1000RangingClass::_rangeOutlierOverride[RANGE_OUTLIER_OVERRIDES];
+// ========= [End Add] =========
+boolean DW1000RangingClass::_useSingleSided = false; // ===== [Add] SS-TWR =====
+// ===== [Add] 從 RX timestamp 排程回覆 =====
+boolean  DW1000RangingClass::_useRxTimestampReply = true;
+uint32_t DW1000RangingClass::_lateReplies         = 0;
+// ========= [End Add] =========
+// ===== [Add] 自動 crystal trim =====
+uint16_t    DW1000RangingClass::_xtalTrimReference = 0;
+UWBXtalTrim DW1000RangingClass::_xtalTrim;
+// ========= [End Add] =========
+
 // message sent/received state
 volatile boolean DW1000RangingClass::_sentAck     = false;
 volatile boolean DW1000RangingClass::_receivedAck = false;
@@ -170,14 +277,28 @@ boolean          DW1000RangingClass::_protocolFailed = false;
 boolean  DW1000RangingClass::_isEncryptionEnabled = false;        // 預設 false
 // 2. 負載：Padding 長度
 uint8_t  DW1000RangingClass::_paddingLength = 0;                  // 預設 0
-// 3. IV 產生模式 (mode: IV_MODE_COUNTER / IV_MODE_RAND_UNIQUE)
+// 3. IV 產生模式 (mode: IV_MODE_COUNTER / IV_MODE_RAND_UNIQUE / IV_MODE_BOOT_COUNTER)
 uint8_t  DW1000RangingClass::_ivMode = IV_MODE_COUNTER;           // 預設 counter
 // 3-1. 初始 IV 計數器值 (only for IV_MODE_COUNTER)
 uint32_t DW1000RangingClass::_expIVCounter = 0;                   // 預設 0
 // 4. 除錯模式開關 (logging：印出 key、IV、nonce 等資訊)
 boolean  DW1000RangingClass::_isEncryptionDebugEnabled = false;   // 預設 false
+// 5. 防重送開關
+boolean  DW1000RangingClass::_isReplayProtectionEnabled = false;  // 預設 false
+uint32_t DW1000RangingClass::_replayModeWarnMs = 0;
+// 6. RANGE 封包驗證開關
+boolean  DW1000RangingClass::_isRangeAuthEnabled = false;         // 預設 false
 // ======== [End Add] =========
 
+// ===== [Add] 本輪 POLL/RANGE 的 anchor =====
+uint8_t  DW1000RangingClass::_roundDevices[MAX_DEVICES];
+uint8_t  DW1000RangingClass::_roundCount = 0;
+uint8_t  DW1000RangingClass::_roundSingleSided = 0;
+uint8_t  DW1000RangingClass::_roundStart = 0;
+uint32_t DW1000RangingClass::_rangeRound = 0;
+uint32_t DW1000RangingClass::_rangeCapWarnMs = 0;
+// ========= [End Add] =========
+
 // timestamps to remember
 int32_t            DW1000RangingClass::timer           = 0;
 int16_t            DW1000RangingClass::counterForBlink = 0; // TODO 8 bit?
@@ -398,6 +519,7 @@ boolean DW1000RangingClass::addNetworkDevices(DW1000Device* device) {
 }
 
 void DW1000RangingClass::removeNetworkDevices(int16_t index) {
+	_roundCount = 0; // ===== [Add] index 會位移，進行中的一輪作廢（下一個 timerTick 重新 POLL） =====
 	//if we have just 1 element
 	if(_networkDevicesNumber == 1) {
 		_networkDevicesNumber = 0;
@@ -435,7 +557,7 @@ void DW1000RangingClass::setEncryptionFlag(boolean enable) {
 void DW1000RangingClass::setPaddingLength(uint8_t nBytes) {
   _paddingLength = nBytes;
 }
-// 3. 設定 IV 產生模式 (mode: IV_MODE_COUNTER / IV_MODE_RAND_UNIQUE)
+// 3. 設定 IV 產生模式 (mode: IV_MODE_COUNTER / IV_MODE_RAND_UNIQUE / IV_MODE_BOOT_COUNTER)
 void DW1000RangingClass::setIVMode(uint8_t mode) {
   _ivMode = mode;
 
@@ -445,15 +567,38 @@ void DW1000RangingClass::setIVMode(uint8_t mode) {
   }
 #endif
 
+  // BOOT_COUNTER：開機後第一次切到此模式時，從 NVS 保留一個 boot 值（只寫一次 flash）
+  bool nonceOk = true;
+  if (_ivMode == IV_MODE_BOOT_COUNTER) {
+    nonceOk = DW1000Nonce.begin();
+  }
+
   if (_isEncryptionDebugEnabled) {
     Serial.print("[ENC] setIVMode = ");
-    Serial.println((_ivMode == IV_MODE_COUNTER) ? "COUNTER" : "RAND_UNIQUE");
+    Serial.println(ivModeName(_ivMode));
 #if defined(ARDUINO_ARCH_ESP32)
     if (_ivMode == IV_MODE_RAND_UNIQUE) {
+#if IV_UNIQ_FILTER == IV_UNIQ_FILTER_BLOOM
+      Serial.print("[ENC] IV bloom bytes/k/capacity = ");
+      Serial.print((uint32_t)DW1000BloomFilter::getMemoryBytes());
+      Serial.print("/");
+      Serial.print(_iv_bloom.getHashCount());
+      Serial.print("/");
+      Serial.println(_iv_bloom.getCapacity());
+#else
       Serial.print("[ENC] IV_UNIQ_TABLE_SIZE = ");
       Serial.println(IV_UNIQ_TABLE_SIZE);
+#endif
     }
 #endif
+    if (_ivMode == IV_MODE_BOOT_COUNTER) {
+      if (nonceOk) {
+        Serial.print("[ENC] bootCounter = ");
+        Serial.println(DW1000Nonce.getBootCounter());
+      } else {
+        Serial.println("[ENC][WARN] boot counter unavailable (no persistent storage).");
+      }
+    }
   }
 }
 // 3-1. 設定初始 IV 計數器值 (only for IV_MODE_COUNTER)
@@ -468,13 +613,45 @@ void DW1000RangingClass::setIVCounter(uint32_t start) {
     }
   }
 }
+// 3-2. 設定 Bloom filter 誤判率 (only for IV_MODE_RAND_UNIQUE + IV_UNIQ_FILTER_BLOOM)
+void DW1000RangingClass::setIVBloomFalsePositiveRate(float rate) {
+#if defined(ARDUINO_ARCH_ESP32) && (IV_UNIQ_FILTER == IV_UNIQ_FILTER_BLOOM)
+  _iv_bloom.setFalsePositiveRate(rate); // 會重算 k/容量並清空
+#else
+  (void)rate;
+  if (_isEncryptionDebugEnabled) {
+    Serial.println("[ENC][WARN] setIVBloomFalsePositiveRate() ignored because IV_UNIQ_FILTER is not BLOOM.");
+  }
+#endif
+}
 // 4. 除錯模式開關 (logging：印出 key、IV、nonce 等資訊)
 void DW1000RangingClass::setEncryptionDebugFlag(boolean enable) {
   _isEncryptionDebugEnabled = enable;
   if (!enable) {
     _encDbgKeyPrinted = false; // 關掉後重開，允許再印一次 key
+  } else {
+    // 印出目前編譯進來的 AES 後端，並跑一次已知答案測試
+    Serial.print("[ENC] crypto backend = ");
+    Serial.print(DW1000Crypto::backendName());
+    Serial.print(", selfTest = ");
+    Serial.println(DW1000Crypto::selfTest() ? "PASS" : "FAIL");
   }
 }
+// 6. RANGE 封包驗證開關
+void DW1000RangingClass::setRangeAuthFlag(boolean enable) {
+  _isRangeAuthEnabled = enable;
+  if (enable && !_rangeCmac.isReady()) {
+    if (!_rangeCmac.setKey(UWB_MAC_KEY)) {
+      // AES 後端失敗：TAG 送出的 RANGE 沒有 MAC，ANCHOR 會全部判定失敗
+      Serial.println("[MAC][WARN] CMAC key setup failed.");
+    }
+  }
+}
+// 5. 防重送開關
+void DW1000RangingClass::setReplayProtectionFlag(boolean enable) {
+  _isReplayProtectionEnabled = enable;
+  // 不清防重送表：關閉期間沒有推動序號，重新開啟時舊的序號照樣擋得住
+}
 // ========= [End Add] =========
 
 DW1000Device* DW1000RangingClass::searchDistantDevice(byte shortAddress[]) {
@@ -712,6 +889,12 @@ void DW1000RangingClass::loop() {
 							_protocolFailed = false;          // 收到 POLL 視為重新開始流程：清掉 fail
 							
 							DW1000.getReceiveTimestamp(myDistantDevice->timePollReceived);  // 記下 POLL RX timestamp
+							// ===== [Add] round 編號（接在 anchor 列表後面），驗 RANGE MAC 用 =====
+							if(_isRangeAuthEnabled && SHORT_MAC_LEN+2+4*numberDevices+RANGE_ROUND_LEN <= LEN_DATA) {
+								memcpy(&myDistantDevice->pollRound, data+SHORT_MAC_LEN+2+4*numberDevices, RANGE_ROUND_LEN);
+							}
+							// ========= [End Add] =========
+							updateClockOffset(myDistantDevice);                             // ===== [Add] TAG 時鐘頻偏 =====
 							myDistantDevice->noteActivity();                                // 更新此 device 的活躍狀態
 
 							_expectedMsgId = RANGE;           // 下一步要等 RANGE
@@ -740,9 +923,29 @@ void DW1000RangingClass::loop() {
 						if(shortAddress[0] == _currentShortAddress[0] && shortAddress[1] == _currentShortAddress[1]) {
 
 							DW1000.getReceiveTimestamp(myDistantDevice->timeRangeReceived);
+							updateClockOffset(myDistantDevice); // ===== [Add] TAG 時鐘頻偏 =====
 							noteActivity();
 							_expectedMsgId = POLL; // RANGE 處理完後下一輪回到等 POLL
 							
+							// RANGE 驗證：MAC 蓋住 header + 所有 anchor 的時間戳（不只自己的那段）+ 這輪 POLL 的 round 編號
+							// round 不在 RANGE 裡傳送：先把 MAC 拿出來，再把自己收到的 round 放在 macOff 一起驗
+							if(!_protocolFailed && _isRangeAuthEnabled) {
+								const uint16_t macOff = SHORT_MAC_LEN + 2 + 17 * (uint16_t)numberDevices;
+								byte rxMac[RANGE_MAC_LEN];
+								boolean fits = (macOff + RANGE_MAC_LEN <= LEN_DATA);
+								if(fits) {
+									memcpy(rxMac, data + macOff, RANGE_MAC_LEN);
+									memcpy(data + macOff, &myDistantDevice->pollRound, RANGE_ROUND_LEN);
+								}
+								if(!fits
+								   || !_rangeCmac.verify(data, macOff + RANGE_ROUND_LEN, rxMac, RANGE_MAC_LEN)) {
+									if (_isEncryptionDebugEnabled) {
+										Serial.println("[MAC][RX][DROP] RANGE auth failed");
+									}
+									_protocolFailed = true; // 走 RANGE_FAILED，不計算距離
+								}
+							}
+							
 							if(!_protocolFailed) {
 								// 從 RANGE payload 取回 TAG 填的三個 timestamp（POLL sent / POLL_ACK recv / RANGE sent）
 								myDistantDevice->timePollSent.setTimestamp(data+SHORT_MAC_LEN+4+17*i);
@@ -755,6 +958,10 @@ void DW1000RangingClass::loop() {
 								
 								float distance = myTOF.getAsMeters();            // TOF -> meters
 
+								// ===== [Add] 離群值過濾放在 EMA 前面：spike 先換成 median，不會被 EMA 拖很多筆 =====
+								distance = applyRangeOutlierFilter(myDistantDevice, distance);
+								// ========= [End Add] =========
+
 								// range filter：用上一筆距離做簡單濾波（略過第一筆）
 								if (_useRangeFilter) {
 									//Skip first range
@@ -806,12 +1013,46 @@ void DW1000RangingClass::loop() {
 				if(messageType == POLL_ACK) {
 					// 收到某一台 anchor 的 POLL_ACK：記 RX timestamp
 					DW1000.getReceiveTimestamp(myDistantDevice->timePollAckReceived);
+					updateClockOffset(myDistantDevice); // ===== [Add] ANCHOR 時鐘頻偏 =====
 					myDistantDevice->noteActivity();
 					
-					// 若已收到最後一台（以 index 判斷）：開始送 RANGE(broadcast)
-					if(myDistantDevice->getIndex() == _networkDevicesNumber-1) {
-						_expectedMsgId = RANGE_REPORT;
-						transmitRange(nullptr); // broadcast RANGE 給所有 anchor
+					// ===== [Add] SS-TWR：用 POLL_ACK 帶的時間直接算距離，這台不放進 RANGE =====
+					if(_useSingleSided) {
+						DW1000Time myTOF;
+						for(uint8_t j = 0; j < _roundCount; j++) {
+							if(_roundDevices[j] == myDistantDevice->getIndex()
+							   && !(_roundSingleSided & (1u << j))
+							   && computeRangeSingleSided(myDistantDevice, &myTOF)) {
+								_roundSingleSided |= (uint8_t)(1u << j);
+								float distance = applyRangeOutlierFilter(myDistantDevice, myTOF.getAsMeters());
+								if (_useRangeFilter && myDistantDevice->getRange() != 0.0f) {
+									distance = filterValue(distance, myDistantDevice->getRange(), _rangeFilterValue);
+								}
+								myDistantDevice->setRange(distance);
+								myDistantDevice->setRXPower(DW1000.getReceivePower());
+								myDistantDevice->setFPPower(DW1000.getFirstPathPower());
+								myDistantDevice->setQuality(DW1000.getReceiveQuality());
+								_lastDistantDevice = myDistantDevice->getIndex();
+								if(_handleNewRange != 0) {
+									(*_handleNewRange)();
+								}
+								break;
+							}
+						}
+					}
+					// ========= [End Add] =========
+					
+					// 若已收到本輪最後一台（以 index 判斷）：開始送 RANGE(broadcast)
+					// ===== [Update] 本輪可能只 POLL 部分 anchor（見 selectRoundDevices） =====
+					if(_roundCount > 0 && myDistantDevice->getIndex() == _roundDevices[_roundCount-1]) {
+					// ========= [End Update] =========
+						if(_roundSingleSided == (uint8_t)((1u << _roundCount) - 1)) {
+							// ===== [Add] 全部 anchor 都用 SS-TWR 算完：這輪不送 RANGE =====
+							_expectedMsgId = POLL_ACK;
+						} else {
+							_expectedMsgId = RANGE_REPORT;
+							transmitRange(nullptr); // broadcast RANGE 給所有 anchor
+						}
 					}
 				}
 
@@ -854,7 +1095,7 @@ void DW1000RangingClass::loop() {
 				// 新版 payload 格式（自描述）：
 				//   [ver:1][plen:1][payload:plen]
 				//   - ver==0x00   ：明文（payload 是 ASCII 距離字串，可能含 padding '0'）
-				//   - ver==ENC_VER：加密（payload = IV + TAG + CT；解密後得到 ASCII 距離字串）
+				//   - ver==ENC_VER：加密（payload = ivMode + IV + TAG + CT；解密後得到 ASCII 距離字串）
 				else if(messageType == RANGE_REPORT) {
 
 					const int payloadStart = SHORT_MAC_LEN + 1;  // [ver] 的位置（msgid 後面第一個 byte）
@@ -871,6 +1112,7 @@ void DW1000RangingClass::loop() {
 
 					float curRange = 0.0f;
 					float curRXPower = DW1000.getReceivePower(); // RXPower 改由「此刻接收」直接量測
+					float curFPPower = DW1000.getFirstPathPower(); // First Path Power 也一起量（遙測 / NLOS 判斷用）
 					bool ok = false;                             // 是否成功解析/解密距離
 
 					if (ver == 0x00) {
@@ -886,16 +1128,16 @@ void DW1000RangingClass::loop() {
 					} 
 					else if (ver == ENC_VER) {
 
-						#if defined(ARDUINO_ARCH_ESP32)
-						// 加密：payload = IV(12) + TAG(16) + CT(ctLen)
-						if (plen < (ENC_IV_LEN + ENC_TAG_LEN + 1)) {
+						// 加密：payload = ivMode(1) + IV(12) + TAG(16) + CT(ctLen)
+						if (plen < (1 + ENC_IV_LEN + ENC_TAG_LEN + 1)) {
 							return; // 至少要有 1 byte CT
 						}
-						const int ivOff  = p0;                            // IV 起點
-						const int tagOff = p0 + ENC_IV_LEN;               // TAG 起點
-						const int ctOff  = p0 + ENC_IV_LEN + ENC_TAG_LEN; // CT 起點
+						const uint8_t ivMode = data[p0];                      // anchor 的 IV 模式（在 AAD 裡，改了 GCM 會失敗）
+						const int ivOff  = p0 + 1;                            // IV 起點
+						const int tagOff = ivOff + ENC_IV_LEN;                // TAG 起點
+						const int ctOff  = ivOff + ENC_IV_LEN + ENC_TAG_LEN;  // CT 起點
 
-						int ctLen = (int)plen - (ENC_IV_LEN + ENC_TAG_LEN);
+						int ctLen = (int)plen - (1 + ENC_IV_LEN + ENC_TAG_LEN);
 						if (ctLen < 1) return;
 
 						// decrypted 緩衝 128 bytes：超過就拒收（避免硬截短造成資料不一致）
@@ -907,13 +1149,46 @@ void DW1000RangingClass::loop() {
 							return;
 						}
 
+						// 防重送：只有 BOOT_COUNTER 的序號跨開機單調，其他模式沒辦法判斷新舊 -> 拒收並提醒（不需開 debug）
+						if (_isReplayProtectionEnabled && ivMode != IV_MODE_BOOT_COUNTER) {
+							if (_replayModeWarnMs == 0 || millis() - _replayModeWarnMs >= 5000) {
+								_replayModeWarnMs = millis() | 1;
+								Serial.print("[ENC][WARN] replay protection needs IV_MODE_BOOT_COUNTER on the anchor, dropping reports from ");
+								Serial.print(myDistantDevice->getShortAddress(), HEX);
+								Serial.print(" (mode ");
+								Serial.print(ivModeName(ivMode));
+								Serial.println(")");
+							}
+							return;
+						}
+
+						// 防重送（1/2）：先用序號擋掉不比上次新的封包，不必做 GCM
+						const uint64_t ivSeq = ivSequence(&data[ivOff]);
+						if (_isReplayProtectionEnabled && !replayIsFresh(myDistantDevice->getShortAddress(), ivSeq)) {
+							if (replayFind(myDistantDevice->getShortAddress()) == NULL) {
+								// 表滿了：這台 anchor 一直收不到，不需開 debug 就提醒
+								if (_replayModeWarnMs == 0 || millis() - _replayModeWarnMs >= 5000) {
+									_replayModeWarnMs = millis() | 1;
+									Serial.print("[ENC][WARN] replay table full (REPLAY_TABLE_SIZE), dropping reports from ");
+									Serial.println(myDistantDevice->getShortAddress(), HEX);
+								}
+							} else if (_isEncryptionDebugEnabled) {
+								Serial.println("[ENC][RX][DROP] replayed or stale IV");
+							}
+							return;
+						}
+
+						// AAD：用 MAC header 的來源位址（anchor）+ IV 模式 + IV 前 8 bytes 重建
+						uint8_t aad[ENC_AAD_LEN];
+						buildReportAAD(aad, address, ivMode, &data[ivOff]);
+
 						unsigned char decrypted[128];
 						memset(decrypted, 0, sizeof(decrypted));
 
-						// AES-GCM 驗證 + 解密（auth_decrypt：TAG 不對就會 fail）
-						mbedtls_gcm_context gcm;
-						mbedtls_gcm_init(&gcm);
-						mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, UWB_AES_KEY, 256);
+						// AES-GCM 驗證 + 解密（TAG 不對就會 fail）
+						if (!reportGcmReady()) {
+							return;
+						}
 
 						if (_isEncryptionDebugEnabled) {
 							dumpHex("[ENC][RX] IV  = ", (const uint8_t*)(&data[ivOff]), ENC_IV_LEN);
@@ -921,18 +1196,19 @@ void DW1000RangingClass::loop() {
 							dumpHex("[ENC][RX] CT  = ", (const uint8_t*)(&data[ctOff]), (size_t)ctLen);
 						}
 
-						int ret = mbedtls_gcm_auth_decrypt(
-							&gcm,
-							(size_t)ctLen,
-							(const unsigned char*)(&data[ivOff]), ENC_IV_LEN,
-							NULL, 0, // AAD（目前未使用）
-							(const unsigned char*)(&data[tagOff]), ENC_TAG_LEN,
-							(const unsigned char*)(&data[ctOff]),
-							decrypted
+						int ret = _reportGcm.gcmDecrypt(
+							(const uint8_t*)(&data[ivOff]), ENC_IV_LEN,
+							aad, ENC_AAD_LEN, // AAD：msgid + anchor short addr + counter
+							(const uint8_t*)(&data[ctOff]), (size_t)ctLen,
+							decrypted,
+							(const uint8_t*)(&data[tagOff]), ENC_TAG_LEN
 						);
-						mbedtls_gcm_free(&gcm);
 
 						if (ret == 0) {
+							// 防重送（2/2）：TAG 驗證通過才推動視窗
+							if (_isReplayProtectionEnabled) {
+								replayAccept(myDistantDevice->getShortAddress(), ivSeq);
+							}
 							// 解密成功：decrypted 是 ASCII 距離字串
 							decrypted[ctLen] = '\0';
 							if (_isEncryptionDebugEnabled) {
@@ -949,10 +1225,6 @@ void DW1000RangingClass::loop() {
 							}
 							ok = false;
 						}
-
-						#else
-						ok = false; // 非 ESP32：不支援 mbedtls-gcm，直接不解密
-						#endif
 					} 
 					else {
 						ok = false; // 未知 ver：直接視為不支援
@@ -962,6 +1234,10 @@ void DW1000RangingClass::loop() {
 						return;
 					}
 
+					// ===== [Add] 離群值過濾（在 EMA 前面） =====
+					curRange = applyRangeOutlierFilter(myDistantDevice, curRange);
+					// ========= [End Add] =========
+
 					// range filter：與原版一致（略過第一筆）
 					if (_useRangeFilter) {
 						if (myDistantDevice->getRange() != 0.0f) {
@@ -972,6 +1248,7 @@ void DW1000RangingClass::loop() {
 					// 更新此 device 的距離與 RXPower（交給上層 callback 使用）
 					myDistantDevice->setRange(curRange);
 					myDistantDevice->setRXPower(curRXPower);
+					myDistantDevice->setFPPower(curFPPower);
 
 					_lastDistantDevice = myDistantDevice->getIndex();
 					if(_handleNewRange != 0) {
@@ -1004,11 +1281,75 @@ void DW1000RangingClass::setRangeFilterValue(uint16_t newValue) {
 	}
 }
 
+// ===== [Add] range 離群值過濾（Hampel） =====
+void DW1000RangingClass::useRangeOutlierFilter(boolean enabled, uint8_t window, float k) {
+	_rangeOutlierDefault.enabled = enabled;
+	_rangeOutlierDefault.window  = hampelClampWindow(window);   // 存夾過的值，applyRangeOutlierFilter 才不會每筆都 configure
+	_rangeOutlierDefault.k       = k;
+}
+
+// 個別 anchor 的設定（例如已知常被遮蔽的那顆用比較小的 k）；表滿了回傳 false
+boolean DW1000RangingClass::setRangeOutlierFilter(uint16_t shortAddress, boolean enabled, uint8_t window, float k) {
+	RangeOutlierConfig* freeSlot = 0;
+	for (uint8_t i = 0; i < RANGE_OUTLIER_OVERRIDES; i++) {
+		RangeOutlierConfig* c = &_rangeOutlierOverride[i];
+		if (c->shortAddress == shortAddress) {
+			freeSlot = c;
+			break;
+		}
+		if (c->shortAddress == 0 && freeSlot == 0) {
+			freeSlot = c;
+		}
+	}
+	if (freeSlot == 0 || shortAddress == 0) {
+		return false;
+	}
+	freeSlot->shortAddress = shortAddress;
+	freeSlot->enabled      = enabled;
+	freeSlot->window       = hampelClampWindow(window);
+	freeSlot->k            = k;
+	return true;
+}
+
+void DW1000RangingClass::clearRangeOutlierFilter(uint16_t shortAddress) {
+	for (uint8_t i = 0; i < RANGE_OUTLIER_OVERRIDES; i++) {
+		if (_rangeOutlierOverride[i].shortAddress == shortAddress) {
+			_rangeOutlierOverride[i].shortAddress = 0;
+		}
+	}
+}
+// ========= [End Add] =========
+
 
 /* ###########################################################################
  * #### Private methods and Handlers for transmit & Receive reply ############
  * ######################################################################### */
 
+// ===== [Add] range 離群值過濾（Hampel） =====
+// 每個 device 有自己的 UWBHampel；設定（window / k）改了才重新 configure（會清掉視窗）
+float DW1000RangingClass::applyRangeOutlierFilter(DW1000Device* device, float range) {
+	const RangeOutlierConfig* cfg = &_rangeOutlierDefault;
+	const uint16_t shortAddress = device->getShortAddress();
+	for (uint8_t i = 0; i < RANGE_OUTLIER_OVERRIDES; i++) {
+		if (_rangeOutlierOverride[i].shortAddress != 0 && _rangeOutlierOverride[i].shortAddress == shortAddress) {
+			cfg = &_rangeOutlierOverride[i];
+			break;
+		}
+	}
+	if (!cfg->enabled) {
+		device->setRangeOutlier(false);
+		return range;
+	}
+	if (device->rangeHampel.window() != cfg->window || device->rangeHampel.k() != cfg->k) {
+		device->rangeHampel.configure(cfg->window, cfg->k);
+	}
+	bool outlier = false;
+	float filtered = device->rangeHampel.filter(range, &outlier);
+	device->setRangeOutlier(outlier);
+	return filtered;
+}
+// ========= [End Add] =========
+
 
 void DW1000RangingClass::handleSent() {
 	// status change on sent success
@@ -1084,6 +1425,28 @@ void DW1000RangingClass::transmit(byte datas[], DW1000Time time) {
 	DW1000.startTransmit();
 }
 
+// ===== [Add] 從 RX timestamp 排程回覆 =====
+DW1000Time DW1000RangingClass::scheduleReply(const DW1000Time& reference, uint16_t delayUs) {
+	DW1000Time deltaTime = DW1000Time(delayUs, DW1000Time::MICROSECONDS);
+	if(_useRxTimestampReply) {
+		DW1000Time txTime;
+		if(DW1000.setDelayFrom(reference, deltaTime, &txTime)) {
+			return txTime;
+		}
+		// loop() 太晚才處理到這個封包：退回「現在 + delay」，這次交換還是完成得了
+		_lateReplies++;
+	}
+	return DW1000.setDelay(deltaTime);
+}
+
+void DW1000RangingClass::checkLateReply() {
+	// 送出指令時時間已經過了：不取消的話 chip 要等一整圈 40-bit timer（約 17 s）才送
+	if(DW1000.cancelLateTransmit()) {
+		_lateReplies++;
+	}
+}
+// ========= [End Add] =========
+
 void DW1000RangingClass::transmitBlink() {
 	transmitInit();
 	_globalMac.generateBlinkFrame(data, _currentAddress, _currentShortAddress);
@@ -1102,32 +1465,78 @@ void DW1000RangingClass::transmitRangingInit(DW1000Device* myDistantDevice) {
 	transmit(data);
 }
 
+// ===== [Add] 挑本輪要 POLL/RANGE 的 anchor =====
+// RANGE 驗證關閉：全部（和原版一樣）。開啟時 RANGE 只放得下 RANGE_AUTH_MAX_DEVICES 台 + MAC，
+// anchor 比這多就每輪從 _roundStart 開始輪流挑，每台都還是會被量到（頻率降低），不會因為沒回應被當成 inactive
+void DW1000RangingClass::selectRoundDevices() {
+	uint8_t n = _networkDevicesNumber;
+	if(!_isRangeAuthEnabled || n <= RANGE_AUTH_MAX_DEVICES) {
+		for(uint8_t i = 0; i < n; i++) {
+			_roundDevices[i] = i;
+		}
+		_roundCount = n;
+		return;
+	}
+	if(_roundStart >= n) {
+		_roundStart = 0;
+	}
+	// 列表最後一台 replyTime 最長、最晚回 POLL_ACK，由它觸發 RANGE（和 index 大小無關）
+	uint8_t k = 0;
+	for(; k < RANGE_AUTH_MAX_DEVICES; k++) {
+		_roundDevices[k] = (uint8_t)((_roundStart + k) % n);
+	}
+	_roundCount = k;
+	_roundStart = (uint8_t)((_roundStart + RANGE_AUTH_MAX_DEVICES) % n);
+	// 不需要開 debug 也要看得到（每 10 秒最多一次）
+	if(_rangeCapWarnMs == 0 || millis() - _rangeCapWarnMs >= 10000) {
+		_rangeCapWarnMs = millis() | 1;
+		Serial.print("[MAC][WARN] ");
+		Serial.print(n);
+		Serial.print(" anchors but RANGE with MAC fits ");
+		Serial.print(RANGE_AUTH_MAX_DEVICES);
+		Serial.println(", ranging them in turns");
+	}
+}
+// ========= [End Add] =========
+
 void DW1000RangingClass::transmitPoll(DW1000Device* myDistantDevice) {
 	
 	transmitInit();
 	
 	if(myDistantDevice == nullptr) {
+		// ===== [Update] 只 POLL 本輪的 anchor（RANGE 驗證開啟時可能是部分） =====
+		selectRoundDevices();
+		_roundSingleSided = 0;
+		
 		//we need to set our timerDelay:
-		_timerDelay = DEFAULT_TIMER_DELAY+(uint16_t)(_networkDevicesNumber*3*DEFAULT_REPLY_DELAY_TIME/1000);
+		_timerDelay = DEFAULT_TIMER_DELAY+(uint16_t)(_roundCount*3*DEFAULT_REPLY_DELAY_TIME/1000);
 		
 		byte shortBroadcast[2] = {0xFF, 0xFF};
 		_globalMac.generateShortMACFrame(data, _currentShortAddress, shortBroadcast);
 		data[SHORT_MAC_LEN]   = POLL;
 		//we enter the number of devices
-		data[SHORT_MAC_LEN+1] = _networkDevicesNumber;
+		data[SHORT_MAC_LEN+1] = _roundCount;
 		
-		for(uint8_t i = 0; i < _networkDevicesNumber; i++) {
+		for(uint8_t j = 0; j < _roundCount; j++) {
+			DW1000Device* device = &_networkDevices[_roundDevices[j]];
 			//each devices have a different reply delay time.
-			_networkDevices[i].setReplyTime((2*i+1)*DEFAULT_REPLY_DELAY_TIME);
+			device->setReplyTime((2*j+1)*DEFAULT_REPLY_DELAY_TIME);
 			//we write the short address of our device:
-			memcpy(data+SHORT_MAC_LEN+2+4*i, _networkDevices[i].getByteShortAddress(), 2);
+			memcpy(data+SHORT_MAC_LEN+2+4*j, device->getByteShortAddress(), 2);
 			
 			//we add the replyTime
-			uint16_t replyTime = _networkDevices[i].getReplyTime();
-			memcpy(data+SHORT_MAC_LEN+2+2+4*i, &replyTime, 2);
+			uint16_t replyTime = device->getReplyTime();
+			memcpy(data+SHORT_MAC_LEN+2+2+4*j, &replyTime, 2);
 			
 		}
 		
+		// round 編號接在列表後面（舊版 anchor 不會讀這幾個 byte）
+		if(_isRangeAuthEnabled) {
+			_rangeRound++;
+			memcpy(data+SHORT_MAC_LEN+2+4*_roundCount, &_rangeRound, RANGE_ROUND_LEN);
+		}
+		// ========= [End Update] =========
+		
 		copyShortAddress(_lastSentToShortAddress, shortBroadcast);
 		
 	}
@@ -1154,9 +1563,25 @@ void DW1000RangingClass::transmitPollAck(DW1000Device* myDistantDevice) {
 	_globalMac.generateShortMACFrame(data, _currentShortAddress, myDistantDevice->getByteShortAddress());
 	data[SHORT_MAC_LEN] = POLL_ACK;
 	// delay the same amount as ranging tag
-	DW1000Time deltaTime = DW1000Time(_replyDelayTimeUS, DW1000Time::MICROSECONDS);
+	// ===== [Update] 從 POLL 的 RX timestamp 起算（timePollAckSent 仍在 TX 完成後讀實際值） =====
 	copyShortAddress(_lastSentToShortAddress, myDistantDevice->getByteShortAddress());
-	transmit(data, deltaTime);
+	DW1000Time timePollAckSent = scheduleReply(myDistantDevice->timePollReceived, _replyDelayTimeUS);
+	// ========= [End Update] =========
+	// ===== [Add] SS-TWR：POLL 的 RX 時間 + 這個 POLL_ACK 排定的 TX 時間（含天線延遲），TAG 收到就能算距離 =====
+	data[SHORT_MAC_LEN+1] = POLL_ACK_TIMES;
+	myDistantDevice->timePollReceived.getTimestamp(data+SHORT_MAC_LEN+2);
+	timePollAckSent.wrap().getTimestamp(data+SHORT_MAC_LEN+2+LEN_STAMP);
+	if(_isRangeAuthEnabled) {
+		// 同 RANGE：round 暫放在 macOff 一起算，再被 MAC 蓋掉
+		const uint16_t macOff = SHORT_MAC_LEN + 1 + POLL_ACK_TIMES_LEN;
+		byte tag[RANGE_MAC_LEN];
+		memcpy(data + macOff, &myDistantDevice->pollRound, RANGE_ROUND_LEN);
+		_rangeCmac.compute(data, macOff + RANGE_ROUND_LEN, tag, RANGE_MAC_LEN);
+		memcpy(data + macOff, tag, RANGE_MAC_LEN);
+	}
+	// ========= [End Add] =========
+	transmit(data);
+	checkLateReply(); // ===== [Add] =====
 }
 
 void DW1000RangingClass::transmitRange(DW1000Device* myDistantDevice) {
@@ -1165,31 +1590,69 @@ void DW1000RangingClass::transmitRange(DW1000Device* myDistantDevice) {
 	
 	
 	if(myDistantDevice == nullptr) {
+		// ===== [Update] 只送本輪 POLL 過的 anchor（見 selectRoundDevices） =====
 		//we need to set our timerDelay:
-		_timerDelay = DEFAULT_TIMER_DELAY+(uint16_t)(_networkDevicesNumber*3*DEFAULT_REPLY_DELAY_TIME/1000);
+		_timerDelay = DEFAULT_TIMER_DELAY+(uint16_t)(_roundCount*3*DEFAULT_REPLY_DELAY_TIME/1000);
 		
 		byte shortBroadcast[2] = {0xFF, 0xFF};
 		_globalMac.generateShortMACFrame(data, _currentShortAddress, shortBroadcast);
 		data[SHORT_MAC_LEN]   = RANGE;
-		//we enter the number of devices
-		data[SHORT_MAC_LEN+1] = _networkDevicesNumber;
 		
 		// delay sending the message and remember expected future sent timestamp
-		DW1000Time deltaTime     = DW1000Time(DEFAULT_REPLY_DELAY_TIME, DW1000Time::MICROSECONDS);
-		DW1000Time timeRangeSent = DW1000.setDelay(deltaTime);
+		// 從本輪最後一個 POLL_ACK 的 RX timestamp 起算
+		DW1000Time timeRangeSent = scheduleReply(_networkDevices[_roundDevices[_roundCount-1]].timePollAckReceived, DEFAULT_REPLY_DELAY_TIME);
 		
-		for(uint8_t i = 0; i < _networkDevicesNumber; i++) {
+		// 這輪已經用 SS-TWR 算出距離的 anchor 不放進 RANGE
+		uint8_t k = 0;
+		for(uint8_t j = 0; j < _roundCount; j++) {
+			if(_roundSingleSided & (1u << j)) {
+				continue;
+			}
+			DW1000Device* device = &_networkDevices[_roundDevices[j]];
 			//we write the short address of our device:
-			memcpy(data+SHORT_MAC_LEN+2+17*i, _networkDevices[i].getByteShortAddress(), 2);
+			memcpy(data+SHORT_MAC_LEN+2+17*k, device->getByteShortAddress(), 2);
 			
 			
 			//we get the device which correspond to the message which was sent (need to be filtered by MAC address)
-			_networkDevices[i].timeRangeSent = timeRangeSent;
-			_networkDevices[i].timePollSent.getTimestamp(data+SHORT_MAC_LEN+4+17*i);
-			_networkDevices[i].timePollAckReceived.getTimestamp(data+SHORT_MAC_LEN+9+17*i);
-			_networkDevices[i].timeRangeSent.getTimestamp(data+SHORT_MAC_LEN+14+17*i);
-			
+			device->timeRangeSent = timeRangeSent;
+			device->timePollSent.getTimestamp(data+SHORT_MAC_LEN+4+17*k);
+			device->timePollAckReceived.getTimestamp(data+SHORT_MAC_LEN+9+17*k);
+			device->timeRangeSent.getTimestamp(data+SHORT_MAC_LEN+14+17*k);
+			k++;
 		}
+		//we enter the number of devices
+		data[SHORT_MAC_LEN+1] = k;
+		// ========= [End Update] =========
+		
+		// ===== [Add] RANGE MAC =====
+		// 附在最後一筆之後：CMAC(header + msgid + 數量 + 全部時間戳 + POLL 的 round 編號)，截短成 RANGE_MAC_LEN
+		// round 不放進 RANGE：先暫放在 macOff 算 MAC，再被 MAC 蓋掉；anchor 用自己從 POLL 收到的 round 驗
+		// selectRoundDevices 保證 macOff + RANGE_MAC_LEN <= LEN_DATA
+		if(_isRangeAuthEnabled) {
+			const uint16_t macOff = SHORT_MAC_LEN + 2 + 17 * (uint16_t)k;
+			if(macOff + RANGE_MAC_LEN <= LEN_DATA) {
+#if defined(ARDUINO_ARCH_ESP32)
+				uint32_t c0 = ESP.getCycleCount();
+#endif
+				byte tag[RANGE_MAC_LEN];
+				memcpy(data + macOff, &_rangeRound, RANGE_ROUND_LEN);
+				_rangeCmac.compute(data, macOff + RANGE_ROUND_LEN, tag, RANGE_MAC_LEN);
+				memcpy(data + macOff, tag, RANGE_MAC_LEN);
+#if defined(ARDUINO_ARCH_ESP32)
+				if (_isEncryptionDebugEnabled) {
+					// 每包額外延遲（CPU cycles），用來評估全部 anchor 開啟前的時間預算
+					Serial.print("[MAC][TX] bytes/cycles = ");
+					Serial.print(macOff);
+					Serial.print("/");
+					Serial.println(ESP.getCycleCount() - c0);
+				}
+#endif
+			}
+			else {
+				Serial.println("[MAC][TX][WARN] RANGE too long for MAC, sent without it");
+			}
+		}
+		// ========= [End Add] =========
 		
 		copyShortAddress(_lastSentToShortAddress, shortBroadcast);
 		
@@ -1209,6 +1672,7 @@ void DW1000RangingClass::transmitRange(DW1000Device* myDistantDevice) {
 	
 	
 	transmit(data);
+	checkLateReply(); // ===== [Add] =====
 }
 
 
@@ -1275,11 +1739,9 @@ void DW1000RangingClass::transmitRangeReport(DW1000Device* myDistantDevice) {
     if (maxPayload < 0) maxPayload = 0;
 
     if (_isEncryptionEnabled) {
-		
-		#if defined(ARDUINO_ARCH_ESP32)
 
-		// payload = IV(12) + TAG(16) + CIPHERTEXT(plainLen)
-		int maxPlain = maxPayload - (ENC_IV_LEN + ENC_TAG_LEN); // 留出 IV+TAG 後，明文最多可加密多少
+		// payload = ivMode(1) + IV(12) + TAG(16) + CIPHERTEXT(plainLen)
+		int maxPlain = maxPayload - (1 + ENC_IV_LEN + ENC_TAG_LEN); // 留出 ivMode+IV+TAG 後，明文最多可加密多少
 		if (maxPlain < 0) maxPlain = 0;
 
 		if (plainLen > maxPlain) {                       // 若明文太長，截短以免塞不下
@@ -1321,6 +1783,16 @@ void DW1000RangingClass::transmitRangeReport(DW1000Device* myDistantDevice) {
 			return;
 			#endif
 
+		} else if (_ivMode == IV_MODE_BOOT_COUNTER) {
+			// BOOT_COUNTER：IV = [perBoot][boot][salt]，O(1) 產生、不需查重表
+			if (!DW1000Nonce.next(iv)) {
+				// 同 RAND_UNIQUE：失敗就丟包，不 fallback 成別的模式
+				if (_isEncryptionDebugEnabled) {
+					Serial.println("[ENC][TX][DROP] Boot-counter IV unavailable (no NVS or counter exhausted).");
+				}
+				return;
+			}
+
 		} else {
 			// 不認得的模式：保守用 COUNTER（避免 iv 未初始化造成重複）
 			usedCtr = _expIVCounter;
@@ -1336,21 +1808,23 @@ void DW1000RangingClass::transmitRangeReport(DW1000Device* myDistantDevice) {
 			plainBuf[plainLen] = '\0';
 		}
 
+		// AAD：msgid + 自己的 short address + IV 模式 + IV 前 8 bytes（counter）
+		// 不認得的模式實際上是用 COUNTER 產生的，照實標成 COUNTER
+		const uint8_t ivModeTag = (_ivMode == IV_MODE_RAND_UNIQUE || _ivMode == IV_MODE_BOOT_COUNTER) ? _ivMode : IV_MODE_COUNTER;
+		uint8_t aad[ENC_AAD_LEN];
+		buildReportAAD(aad, _currentShortAddress, ivModeTag, iv);
+
 		// AES-GCM 加密：plainBuf -> cipher，同時輸出 tag
-		mbedtls_gcm_context gcm;
-		mbedtls_gcm_init(&gcm);
-		mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, UWB_AES_KEY, 256);
-
-		int ret = mbedtls_gcm_crypt_and_tag(
-			&gcm, MBEDTLS_GCM_ENCRYPT,
-			(size_t)plainLen,
-			iv, ENC_IV_LEN,                               // nonce/IV（12 bytes）
-			NULL, 0,                                      // AAD：目前未使用
-			(const unsigned char*)plainBuf,               // input plaintext
-			cipher,                                       // output ciphertext
-			ENC_TAG_LEN, tag                              // output tag
-		);
-		mbedtls_gcm_free(&gcm);
+		int ret = reportGcmReady() ? 0 : CRYPTO_ERR_NOT_READY;
+		if (ret == 0) {
+			ret = _reportGcm.gcmEncrypt(
+				iv, ENC_IV_LEN,                               // nonce/IV（12 bytes）
+				aad, ENC_AAD_LEN,                             // AAD：msgid + anchor short addr + counter
+				(const uint8_t*)plainBuf, (size_t)plainLen,   // input plaintext
+				cipher,                                       // output ciphertext
+				tag, ENC_TAG_LEN                              // output tag
+			);
+		}
 
 		if (ret != 0) {
 			// 加密失敗：退回明文（避免整個 ranging 因加密掛掉）
@@ -1363,12 +1837,13 @@ void DW1000RangingClass::transmitRangeReport(DW1000Device* myDistantDevice) {
 			idx += copyLen;
 			data[plenPos] = (uint8_t)copyLen;                // 回填 payload_len
 		} else {
-			// 加密成功：payload = IV + TAG + CIPHERTEXT
+			// 加密成功：payload = ivMode + IV + TAG + CIPHERTEXT
+			data[idx++] = ivModeTag;
 			memcpy(&data[idx], iv, ENC_IV_LEN);   idx += ENC_IV_LEN;
 			memcpy(&data[idx], tag, ENC_TAG_LEN); idx += ENC_TAG_LEN;
 			memcpy(&data[idx], cipher, (size_t)plainLen); idx += plainLen;
 
-			data[plenPos] = (uint8_t)(ENC_IV_LEN + ENC_TAG_LEN + plainLen); // 回填 payload_len
+			data[plenPos] = (uint8_t)(1 + ENC_IV_LEN + ENC_TAG_LEN + plainLen); // 回填 payload_len
 
 			// debug：印出 key/IV/plain/tag/cipher（用於驗證格式與解密一致）
 			if (_isEncryptionDebugEnabled) {
@@ -1378,11 +1853,16 @@ void DW1000RangingClass::transmitRangeReport(DW1000Device* myDistantDevice) {
 				}
 
 				Serial.print("[ENC][TX] ivMode = ");
-				Serial.println((_ivMode == IV_MODE_COUNTER) ? "COUNTER" : "RAND_UNIQUE");
+				Serial.println(ivModeName(_ivMode));
 				
 				if (_ivMode == IV_MODE_COUNTER) {
 					Serial.print("[ENC][TX] ivCounter = ");
 					Serial.println(usedCtr);                // 方便核對 counter 是否連續/不跳號
+				} else if (_ivMode == IV_MODE_BOOT_COUNTER) {
+					Serial.print("[ENC][TX] boot/perBoot = ");
+					Serial.print(DW1000Nonce.getBootCounter());
+					Serial.print("/");
+					Serial.println(DW1000Nonce.getPerBootCounter() - 1);
 				} else {
 					Serial.println("[ENC][TX] ivCounter = (n/a)");
 				}
@@ -1394,16 +1874,6 @@ void DW1000RangingClass::transmitRangeReport(DW1000Device* myDistantDevice) {
 				dumpHex("[ENC][TX] CT  = ", cipher, (size_t)plainLen);
 			}
 		}
-		#else
-		// 非 ESP32：沒有 mbedtls AES-GCM，強制當明文送（保持可編譯/可跑）
-		data[verPos] = 0x00;
-
-		int copyLen = plainLen;
-		if (copyLen > maxPayload) copyLen = maxPayload;
-
-		memcpy(&data[idx], plainBuf, (size_t)copyLen); idx += copyLen;
-		data[plenPos] = (uint8_t)copyLen;
-		#endif
 
 	} else {
 		// 明文 payload = plainBuf bytes（不含 '\0'）
@@ -1424,9 +1894,10 @@ void DW1000RangingClass::transmitRangeReport(DW1000Device* myDistantDevice) {
 */
 	// 變長度發送（不再硬塞 LEN_DATA）
 	copyShortAddress(_lastSentToShortAddress, myDistantDevice->getByteShortAddress()); // 記住這次送給誰（供 _sentAck 使用）
-	DW1000.setDelay(DW1000Time(_replyDelayTimeUS, DW1000Time::MICROSECONDS));          // 設定回覆延遲（符合 ranging 時序）
+	scheduleReply(myDistantDevice->timeRangeReceived, _replyDelayTimeUS);              // ===== [Update] 從 RANGE 的 RX timestamp 起算回覆延遲 =====
 	DW1000.setData(data, (uint16_t)idx);                                               // 用 idx 當「實際封包長度」
 	DW1000.startTransmit();                                                            // 送出 RANGE_REPORT
+	checkLateReply();                                                                  // ===== [Add] =====
 }
 	// ========= [End Add] =========
 
@@ -1482,6 +1953,91 @@ void DW1000RangingClass::computeRangeAsymmetric(DW1000Device* myDistantDevice, D
 	 */
 }
 
+// ===== [Add] SS-TWR 與時鐘頻偏 =====
+// TAG 收到 POLL_ACK 時（data 是這個 POLL_ACK）：round1 = POLL 送出 -> POLL_ACK 收到（TAG 的時鐘），
+// reply1 = anchor 在 POLL_ACK 帶的 POLL RX -> POLL_ACK TX（anchor 的時鐘），用 TAG 量到的頻偏換到 TAG 的時鐘。
+// 1 ppm 的頻偏誤差約造成 reply * 0.5e-6 的 TOF 誤差，所以頻偏要先收斂（clockOffset.valid()）。
+// POLL_ACK 沒帶時間（舊版 anchor）、MAC 不對或時間不合理時回 false，這台照舊走 RANGE / RANGE_REPORT。
+boolean DW1000RangingClass::computeRangeSingleSided(DW1000Device* myDistantDevice, DW1000Time* myTOF) {
+	if(!myDistantDevice->clockOffset.valid() || data[SHORT_MAC_LEN+1] != POLL_ACK_TIMES) {
+		return false;
+	}
+	if(_isRangeAuthEnabled) {
+		// anchor 用它從 POLL 收到的 round 算 MAC：舊一輪的 POLL_ACK 重送過來驗不過
+		const uint16_t macOff = SHORT_MAC_LEN + 1 + POLL_ACK_TIMES_LEN;
+		byte rxMac[RANGE_MAC_LEN];
+		memcpy(rxMac, data + macOff, RANGE_MAC_LEN);
+		memcpy(data + macOff, &_rangeRound, RANGE_ROUND_LEN);
+		if(!_rangeCmac.verify(data, macOff + RANGE_ROUND_LEN, rxMac, RANGE_MAC_LEN)) {
+			if (_isEncryptionDebugEnabled) {
+				Serial.println("[MAC][RX][DROP] POLL_ACK auth failed");
+			}
+			return false;
+		}
+	}
+	DW1000Time pollReceived, pollAckSent;
+	pollReceived.setTimestamp(data+SHORT_MAC_LEN+2);
+	pollAckSent.setTimestamp(data+SHORT_MAC_LEN+2+LEN_STAMP);
+	DW1000Time round1 = (myDistantDevice->timePollAckReceived-myDistantDevice->timePollSent).wrap();
+	DW1000Time reply1 = (pollAckSent-pollReceived).wrap();
+	if(reply1.getTimestamp() <= 0 || round1.getTimestamp() <= reply1.getTimestamp()) {
+		return false;
+	}
+	myTOF->setTimestamp(singleSidedTof(round1.getTimestamp(), reply1.getTimestamp(), myDistantDevice->getClockOffsetPpm()));
+	return true;
+}
+
+// 每收到對方一個封包更新一次；一定要在下一次 receive 開始前（DRX_CAR_INT 會被下一個封包覆蓋）
+void DW1000RangingClass::updateClockOffset(DW1000Device* myDistantDevice) {
+	const float ppm = DW1000.getClockOffsetPpm();
+	myDistantDevice->clockOffset.update(ppm);
+
+	if (_xtalTrimReference == 0 || myDistantDevice->getShortAddress() != _xtalTrimReference) {
+		return;
+	}
+	if (_xtalTrim.update(ppm)) {
+		DW1000.setXtalTrim(_xtalTrim.trim());
+		// 自己的時鐘變了：所有 peer 的頻偏估計都要重來
+		for (uint8_t i = 0; i < _networkDevicesNumber; i++) {
+			_networkDevices[i].clockOffset.reset();
+		}
+	}
+	_xtalTrim.storeIfChanged();
+}
+
+void DW1000RangingClass::useXtalTrim(uint16_t referenceShortAddress) {
+	_xtalTrimReference = referenceShortAddress;
+	if (referenceShortAddress == 0) {
+		return;
+	}
+	uint8_t trim;
+	if (UWBXtalTrim::load(&trim)) {
+		DW1000.setXtalTrim(trim);
+		_xtalTrim.begin(trim, true);
+	} else {
+		_xtalTrim.begin(DW1000.getXtalTrim());
+	}
+}
+// ========= [End Add] =========
+
+// ===== [Add] 執行中切換 ANCHOR / TAG =====
+void DW1000RangingClass::setRole(int16_t type) {
+	if (type != ANCHOR && type != TAG) {
+		return;
+	}
+	// 舊角色的 device（TAG 的 anchor 列表 / ANCHOR 的 tag）和進行中的交換都不要了
+	_networkDevicesNumber = 0;
+	_roundCount = 0;
+	_sentAck = false;
+	_receivedAck = false;
+	_type = type;
+	_expectedMsgId = (type == ANCHOR) ? POLL : POLL_ACK;
+	counterForBlink = 0;   // TAG：下一個 timerTick 馬上 BLINK
+	receiver();
+	noteActivity();
+}
+// ========= [End Add] =========
+
 
 /* FOR DEBUGGING*/
 void DW1000RangingClass::visualizeDatas(byte datas[]) {
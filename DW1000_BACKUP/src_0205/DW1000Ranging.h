@@ -35,6 +35,7 @@
 #include "DW1000Time.h"
 #include "DW1000Device.h" 
 #include "DW1000Mac.h"
+#include "UWBXtalTrim.h" // ===== [Add] =====
 
 // messages used in the ranging protocol
 #define POLL 0
@@ -57,9 +58,30 @@
 #define ENC_TAG_LEN 16
 #endif
 // Encryption version
+// 0x01：AAD 為空（舊版）
+// 0x02：AAD = [msgid:1][anchor short addr:2][IV[0..7]:8]（綁定送方與 counter）
+// 0x03：payload 前面多 1 byte IV 模式（TAG 才知道 IV[0..7] 是不是單調序號），AAD 也包含它：
+//       AAD = [msgid:1][anchor short addr:2][ivMode:1][IV[0..7]:8]
 #ifndef ENC_VER
-#define ENC_VER 0x01
+#define ENC_VER 0x03
 #endif
+// AAD 長度
+#define ENC_AAD_LEN 12
+
+// RANGE 封包 MAC（AES-128 CMAC 截短），附在最後一筆 anchor 資料之後
+#ifndef RANGE_MAC_LEN
+#define RANGE_MAC_LEN 8
+#endif
+// RANGE 帶 MAC 時一輪最多能放幾台 anchor（每台 17 bytes，MAC 要塞在 LEN_DATA 之內）
+// 超過的話 TAG 每輪輪流挑這麼多台 POLL/RANGE
+#define RANGE_AUTH_MAX_DEVICES ((LEN_DATA - SHORT_MAC_LEN - 2 - RANGE_MAC_LEN) / 17)
+// POLL 在 anchor 列表後面多帶 4 bytes round 編號（little-endian），RANGE MAC 把它一起算進去
+#define RANGE_ROUND_LEN 4
+// POLL_ACK 帶給 TAG 做 SS-TWR 的時間（anchor 時鐘）：[POLL_ACK_TIMES][POLL RX 5 bytes][POLL_ACK TX 5 bytes]，
+// RANGE 驗證開啟時後面接 MAC（含 POLL 的 round 編號，算法同 RANGE）
+// 標記 byte：舊版 anchor 在這個位置留的是上一個 POLL 的 anchor 數（<= MAX_DEVICES），不會是 0xA5
+#define POLL_ACK_TIMES     0xA5
+#define POLL_ACK_TIMES_LEN (1 + 2 * LEN_STAMP)
 // IV 產生模式
 #ifndef IV_MODE_COUNTER
 #define IV_MODE_COUNTER 0
@@ -68,6 +90,11 @@
 #ifndef IV_MODE_RAND_UNIQUE
 #define IV_MODE_RAND_UNIQUE 1
 #endif
+// 開機計數器 IV 模式：[perBoot:4][boot:4][salt:4]，boot 存在 NVS（見 DW1000Nonce.h）
+// O(1)、固定記憶體、沒有 session 長度上限（取代 IV_MODE_RAND_UNIQUE 的查重表）
+#ifndef IV_MODE_BOOT_COUNTER
+#define IV_MODE_BOOT_COUNTER 2
+#endif
 
 // 唯一亂數 IV 的表容量（一次 session 內最多記錄幾個 IV）
 // 4096 筆約佔：4096*12 + 4096*1 ≈ 53KB（ESP32 通常 OK）
@@ -75,6 +102,21 @@
 #ifndef IV_UNIQ_TABLE_SIZE
 #define IV_UNIQ_TABLE_SIZE 4096
 #endif
+
+// 唯一亂數 IV 的查重方式（編譯期選擇）
+//   TABLE：精確查重表，最多 IV_UNIQ_TABLE_SIZE 包，滿了之後 RANGE_REPORT 全部丟包
+//   BLOOM：blocked Bloom filter（BLOOM_SIZE_KB，見 DW1000BloomFilter.h），可設誤判率、沒有包數上限
+#define IV_UNIQ_FILTER_TABLE 0
+#define IV_UNIQ_FILTER_BLOOM 1
+#ifndef IV_UNIQ_FILTER
+#define IV_UNIQ_FILTER IV_UNIQ_FILTER_TABLE
+#endif
+// ========= [End Add] =========
+
+// ===== [Add] 防重送表大小：最多記幾台 anchor 的最後序號（滿了之後新的 anchor 的 RANGE_REPORT 會被拒收） =====
+#ifndef REPLAY_TABLE_SIZE
+#define REPLAY_TABLE_SIZE 16
+#endif
 // ========= [End Add] =========
 
 //Max devices we put in the networkDevices array ! Each DW1000Device is 74 Bytes in SRAM memory for now.
@@ -83,8 +125,15 @@
 // 意義：_networkDevices[] 可同時管理的裝置上限（TAG/ANCHOR 數量上限）
 // 調大可同時管理更多裝置，代價是 SRAM 增加
 #define MAX_DEVICES 7
+
 // ========= [End Update] =========
 
+// ===== [Add] 可以個別設定離群值過濾的 anchor 數 =====
+#ifndef RANGE_OUTLIER_OVERRIDES
+#define RANGE_OUTLIER_OVERRIDES 8
+#endif
+// ========= [End Add] =========
+
 //Default Pin for module:
 #define DEFAULT_RST_PIN 9
 #define DEFAULT_SPI_SS_PIN 10
@@ -93,7 +142,11 @@
 //in ms
 #define DEFAULT_RESET_PERIOD 200
 //in us
+// ===== [Update] 可在編譯時改小（回覆改從 RX timestamp 排程後，sub-ms 也排得到；所有 node 要用同一個值） =====
+#ifndef DEFAULT_REPLY_DELAY_TIME
 #define DEFAULT_REPLY_DELAY_TIME 7000
+#endif
+// ========= [End Update] =========
 
 //sketch type (anchor or tag)
 #define TAG 0
@@ -134,12 +187,25 @@ public:
 	void setEncryptionFlag(boolean enable);      // 預設 false
 	// 2. 負載：設定 Padding 長度
 	void setPaddingLength(uint8_t nBytes);       // 預設 0
-	// 3. 設定 IV 產生模式 (mode: IV_MODE_COUNTER / IV_MODE_RAND_UNIQUE)
+	// 3. 設定 IV 產生模式 (mode: IV_MODE_COUNTER / IV_MODE_RAND_UNIQUE / IV_MODE_BOOT_COUNTER)
 	void setIVMode(uint8_t mode);                // 預設 IV_MODE_COUNTER
 	// 3-1. 設定初始 IV 計數器值 (only for IV_MODE_COUNTER)
 	void setIVCounter(uint32_t start);           // 預設 0
+	// 3-2. 設定 Bloom filter 誤判率 (only for IV_MODE_RAND_UNIQUE + IV_UNIQ_FILTER_BLOOM)
+	void setIVBloomFalsePositiveRate(float rate); // 預設 BLOOM_DEFAULT_FP_RATE
 	// 4. 除錯模式開關 (logging：印出 key、IV、nonce 等資訊)
 	void setEncryptionDebugFlag(boolean enable); // 預設 false
+	// 5. 防重送開關（TAG 收 RANGE_REPORT：每個 anchor short address 記最後接受的 (boot, perBoot) = IV[0..7]，
+	//    只收更新的；表有 REPLAY_TABLE_SIZE 格，device 被移除也保留、不重設）
+	//    只有 IV_MODE_BOOT_COUNTER 跨開機也單調（COUNTER 重開機從頭算、RAND_UNIQUE 沒有順序）：
+	//    開啟時只收 anchor 用 BOOT_COUNTER 加密的 RANGE_REPORT，其他模式的 anchor 會被拒收並印警告
+	void setReplayProtectionFlag(boolean enable); // 預設 false
+	// 6. RANGE 封包驗證開關（TAG 附 CMAC、ANCHOR 驗證；兩端要一致）
+	//    保護 timePollSent / timePollAckReceived / timeRangeSent 不被竄改
+	//    MAC 也蓋住 POLL 帶的 round 編號：上一輪錄下的 RANGE 單獨重送會驗不過，
+	//    但整組 POLL + RANGE 一起重送還是擋不住（要每台 anchor 回一個 nonce，90 bytes 放不下 4 台以上）
+	//    開啟時一輪最多 RANGE_AUTH_MAX_DEVICES（4）台 anchor，更多台就輪流量
+	void setRangeAuthFlag(boolean enable);        // 預設 false
 	// ========= [End Add] =========
 
 	//getters
@@ -155,6 +221,35 @@ public:
 	static void useRangeFilter(boolean enabled);
 	// Used for the smoothing algorithm (Exponential Moving Average). newValue must be >= 2. Default 15.
 	static void setRangeFilterValue(uint16_t newValue);
+	// ===== [Add] Range 離群值過濾（Hampel：|r - median| > k * sigma 換成 median，在 EMA 之前） =====
+	// 所有 anchor 的預設值；window 1..HAMPEL_MAX_WINDOW 筆
+	static void useRangeOutlierFilter(boolean enabled, uint8_t window = HAMPEL_DEFAULT_WINDOW, float k = HAMPEL_DEFAULT_K);
+	// 指定 short address 的設定（覆蓋預設值，例如某個 anchor 常有反射就把 k 調小）；表滿回 false
+	static boolean setRangeOutlierFilter(uint16_t shortAddress, boolean enabled, uint8_t window, float k);
+	static void clearRangeOutlierFilter(uint16_t shortAddress);
+	// ========= [End Add] =========
+	// ===== [Add] TAG 用 SS-TWR：收到 POLL_ACK 就算距離，這台 anchor 不用再走 RANGE / RANGE_REPORT =====
+	// anchor 一律在 POLL_ACK 放 POLL 的 RX 時間和排定的 TX 時間（setDelayFrom），只需要 TAG 端開啟；
+	// reply 用 TAG 自己量的 carrier integrator 頻偏換成 TAG 的時鐘。
+	// 頻偏估計還沒收斂（前 CLOCK_OFFSET_WARMUP 個封包）或 POLL_ACK 沒帶時間 / MAC 不對的 anchor，這輪仍用 asymmetric TW-TWR
+	static void useSingleSidedRanging(boolean enabled) { _useSingleSided = enabled; }
+	// ========= [End Add] =========
+	// ===== [Add] 自動 crystal trim：對齊 referenceShortAddress 那台的時鐘（0 = 關閉），說明見 UWBXtalTrim.h =====
+	// 開啟時先套用上次存的 trim；之後每收到 reference 一個封包更新一次，lock 後存回 NVS
+	static void useXtalTrim(uint16_t referenceShortAddress);
+	static const UWBXtalTrim& getXtalTrimState() { return _xtalTrim; }
+	// ========= [End Add] =========
+	// ===== [Add] 執行中切換 ANCHOR / TAG（pairwise 校正：每台輪流當 TAG 去量其他台） =====
+	// 清掉 device list，重新開始 receiver；TAG 會在下一個 timerTick 送 BLINK
+	static void    setRole(int16_t type);
+	static int16_t getRole() { return _type; }
+	// ========= [End Add] =========
+	// ===== [Add] POLL_ACK / RANGE / RANGE_REPORT 從收到的 RX timestamp 起算回覆時間（預設開啟） =====
+	// 關閉 = 原本的 setDelay(現在 + replyTime)；來不及（剩不到 DW1000_DELAYED_TX_MIN_SLACK_US）時也退回原本的方式
+	static void     useRxTimestampReply(boolean enabled) { _useRxTimestampReply = enabled; }
+	static float    getLastReplySlackUs() { return DW1000.getDelaySlackUs(); }   // 最近一次回覆排程剩下的時間（us）
+	static uint32_t getLateReplyCount() { return _lateReplies; }               // 來不及、退回或取消的次數
+	// ========= [End Add] =========
 	
 	//Handlers:
 	static void attachNewRange(void (* handleNewRange)(void)) { _handleNewRange = handleNewRange; };
@@ -209,12 +304,27 @@ private:
 	static boolean  _isEncryptionEnabled;        // 預設 false
 	// 2. 負載：Padding 長度
 	static uint8_t  _paddingLength;              // 預設 0
-	// 3. IV 產生模式 (mode: IV_MODE_COUNTER / IV_MODE_RAND_UNIQUE)
+	// 3. IV 產生模式 (mode: IV_MODE_COUNTER / IV_MODE_RAND_UNIQUE / IV_MODE_BOOT_COUNTER)
 	static uint8_t  _ivMode;                     // 預設 IV_MODE_COUNTER
 	// 3-1. 初始 IV 計數器值 (only for IV_MODE_COUNTER)
 	static uint32_t _expIVCounter;               // 預設 0
 	// 4. 除錯模式開關 (logging：印出 key、IV、nonce 等資訊)
 	static boolean  _isEncryptionDebugEnabled;   // 預設 false
+	// 5. 防重送開關
+	static boolean  _isReplayProtectionEnabled;  // 預設 false
+	static uint32_t _replayModeWarnMs;           // ===== [Add] 上次印防重送警告（anchor IV 模式不對 / 表滿了）的時間 =====
+	// 6. RANGE 封包驗證開關
+	static boolean  _isRangeAuthEnabled;         // 預設 false
+	// ========= [End Add] =========
+
+	// ===== [Add] 本輪 POLL/RANGE 的 anchor（TAG 端；RANGE 驗證開啟時最多 RANGE_AUTH_MAX_DEVICES 台） =====
+	static uint8_t  _roundDevices[MAX_DEVICES];  // 本輪 anchor 在 _networkDevices 的 index
+	static uint8_t  _roundCount;                 // 0 = 沒有進行中的一輪
+	static uint8_t  _roundSingleSided;           // bit j = _roundDevices[j] 這輪已用 SS-TWR 算出距離（不放進 RANGE）
+	static uint8_t  _roundStart;                 // 下一輪從哪台開始（輪流）
+	static uint32_t _rangeRound;                 // POLL 的 round 編號
+	static uint32_t _rangeCapWarnMs;             // 上次印「anchor 太多、改成輪流」的時間
+	static void selectRoundDevices();
 	// ========= [End Add] =========
 
 	// reset line to the chip
@@ -233,6 +343,26 @@ private:
 	//ranging filter
 	static volatile boolean _useRangeFilter;
 	static uint16_t         _rangeFilterValue;
+	// ===== [Add] Range 離群值過濾設定 =====
+	struct RangeOutlierConfig {
+		uint16_t shortAddress;   // 0 = 空
+		boolean  enabled;
+		uint8_t  window;
+		float    k;
+	};
+	static RangeOutlierConfig _rangeOutlierDefault;
+	static RangeOutlierConfig _rangeOutlierOverride[RANGE_OUTLIER_OVERRIDES];
+	static float applyRangeOutlierFilter(DW1000Device* device, float range);
+	// ========= [End Add] =========
+	static boolean _useSingleSided; // ===== [Add] =====
+	// ===== [Add] 從 RX timestamp 排程回覆 =====
+	static boolean  _useRxTimestampReply;
+	static uint32_t _lateReplies;
+	// ========= [End Add] =========
+	// ===== [Add] 自動 crystal trim =====
+	static uint16_t    _xtalTrimReference;
+	static UWBXtalTrim _xtalTrim;
+	// ========= [End Add] =========
 	//_bias correction
 	static char  _bias_RSL[17]; // TODO remove or use
 	//17*2=34 bytes in SRAM
@@ -256,6 +386,8 @@ private:
 	static void transmitInit();
 	static void transmit(byte datas[]);
 	static void transmit(byte datas[], DW1000Time time);
+	static DW1000Time scheduleReply(const DW1000Time& reference, uint16_t delayUs); // ===== [Add] 回傳預計 TX timestamp =====
+	static void       checkLateReply();                                             // ===== [Add] startTransmit 後呼叫 =====
 	static void transmitBlink();
 	static void transmitRangingInit(DW1000Device* myDistantDevice);
 	static void transmitPollAck(DW1000Device* myDistantDevice);
@@ -269,6 +401,8 @@ private:
 	
 	//methods for range computation
 	static void computeRangeAsymmetric(DW1000Device* myDistantDevice, DW1000Time* myTOF);
+	static boolean computeRangeSingleSided(DW1000Device* myDistantDevice, DW1000Time* myTOF); // ===== [Add] =====
+	static void updateClockOffset(DW1000Device* myDistantDevice);                          // ===== [Add] =====
 	
 	static void timerTick();
 	
@@ -0,0 +1,160 @@
+/*
+ * @file UWBAnchorLayout.cpp
+ * Anchor 座標表的解析 / 格式化 / 儲存，說明見 UWBAnchorLayout.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "UWBAnchorLayout.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Preferences.h>   // NVS
+#endif
+
+bool UWBAnchorLayout::add(uint16_t id, float x, float y, float z) {
+	int slot = slotOf(id);
+	if (slot < 0) {
+		if (_count >= LAYOUT_MAX_ANCHORS) {
+			return false;
+		}
+		slot = _count++;
+		_id[slot] = id;
+	}
+	_pos[slot][0] = x;
+	_pos[slot][1] = y;
+	_pos[slot][2] = z;
+	return true;
+}
+
+int UWBAnchorLayout::slotOf(uint16_t id) const {
+	for (uint8_t i = 0; i < _count; i++) {
+		if (_id[i] == id) return i;
+	}
+	return -1;
+}
+
+bool UWBAnchorLayout::parse(const char* text, size_t len) {
+	UWBAnchorLayout tmp;
+	char line[64];
+	size_t i = 0;
+	while (i < len && text[i] != '\0') {
+		// 取一行（太長的行截斷）
+		size_t n = 0;
+		while (i < len && text[i] != '\0' && text[i] != '\n') {
+			if (n < sizeof(line) - 1) line[n++] = text[i];
+			i++;
+		}
+		if (i < len && text[i] == '\n') i++;
+		line[n] = '\0';
+		if (line[0] == '#' || strncmp(line, LAYOUT_MAGIC, strlen(LAYOUT_MAGIC)) == 0) continue;
+
+		// strtof 而不是 sscanf("%f")：AVR 的 sscanf 沒有浮點
+		char* p;
+		char* end;
+		unsigned long id = strtoul(line, &p, 16);
+		if (p == line || id > 0xFFFF) continue;
+		float v[3];
+		int k;
+		for (k = 0; k < 3; k++) {
+			v[k] = strtof(p, &end);
+			if (end == p) break;
+			p = end;
+		}
+		if (k < 3) continue;
+		if (!tmp.add((uint16_t)id, v[0], v[1], v[2])) return false;   // anchor 太多：整份不用
+	}
+	if (tmp._count == 0) return false;
+	*this = tmp;
+	return true;
+}
+
+int UWBAnchorLayout::format(char* out, size_t cap) const {
+	size_t n = 0;
+	int w = snprintf(out, cap, "%s\n", LAYOUT_MAGIC);
+	if (w < 0 || (size_t)w >= cap) return -1;
+	n = (size_t)w;
+	for (uint8_t i = 0; i < _count; i++) {
+		// %f 在部分 Arduino 平台沒有：拆成整數 mm 輸出
+		char pos[3][24];
+		for (int c = 0; c < 3; c++) {
+			long mm = (long)(_pos[i][c] * 1000.0f + (_pos[i][c] < 0.0f ? -0.5f : 0.5f));
+			const char* sign = (mm < 0) ? "-" : "";
+			if (mm < 0) mm = -mm;
+			snprintf(pos[c], sizeof(pos[c]), "%s%ld.%03ld", sign, mm / 1000, mm % 1000);
+		}
+		w = snprintf(out + n, cap - n, "%X %s %s %s\n", (unsigned)_id[i], pos[0], pos[1], pos[2]);
+		if (w < 0 || (size_t)w >= cap - n) return -1;
+		n += (size_t)w;
+	}
+	return (int)n;
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+bool UWBAnchorLayout::load() {
+	Preferences prefs;
+	if (!prefs.begin(LAYOUT_NVS_NAMESPACE, true)) {
+		return false;
+	}
+	char text[LAYOUT_TEXT_MAX];
+	size_t n = prefs.getBytes(LAYOUT_NVS_KEY, text, sizeof(text));
+	prefs.end();
+	return n > 0 && parse(text, n);
+}
+
+bool UWBAnchorLayout::store() const {
+	char text[LAYOUT_TEXT_MAX];
+	int n = format(text, sizeof(text));
+	if (n <= 0) {
+		return false;
+	}
+	Preferences prefs;
+	if (!prefs.begin(LAYOUT_NVS_NAMESPACE, false)) {
+		return false;
+	}
+	size_t w = prefs.putBytes(LAYOUT_NVS_KEY, text, (size_t)n);
+	prefs.end();
+	return w == (size_t)n;
+}
+
+#elif !defined(ARDUINO)
+
+bool UWBAnchorLayout::load() {
+	FILE* f = fopen(LAYOUT_FILE, "rb");
+	if (f == NULL) {
+		return false;
+	}
+	char text[LAYOUT_TEXT_MAX];
+	size_t n = fread(text, 1, sizeof(text), f);
+	fclose(f);
+	return n > 0 && parse(text, n);
+}
+
+bool UWBAnchorLayout::store() const {
+	char text[LAYOUT_TEXT_MAX];
+	int n = format(text, sizeof(text));
+	if (n <= 0) {
+		return false;
+	}
+	FILE* f = fopen(LAYOUT_FILE, "wb");
+	if (f == NULL) {
+		return false;
+	}
+	bool ok = fwrite(text, 1, (size_t)n, f) == (size_t)n;
+	return (fclose(f) == 0) && ok;
+}
+
+#else
+
+// 其他 Arduino 平台沒有 NVS：每次開機都要下載（或用編譯進去的座標）
+bool UWBAnchorLayout::load() {
+	return false;
+}
+
+bool UWBAnchorLayout::store() const {
+	return false;
+}
+
+#endif
@@ -0,0 +1,72 @@
+/*
+ * @file UWBAnchorLayout.h
+ * Anchor 座標表（short address -> x, y, z），tag 開機時從 host 下載，不必每個場地重新編譯 anchor_matrix
+ *
+ * 文字格式和 UWB_Host_Server/anchors.txt 相同：每行「short address(16 進位) x y z」，# 開頭是註解。
+ * host 端 UWB_Anchor_Survey 用 anchor 互量的距離算出座標後寫成這個格式，並用 UDP 提供下載：
+ *   tag -> host : LAYOUT_REQUEST
+ *   host -> tag : LAYOUT_MAGIC 一行 + 座標表（一個 datagram）
+ * 下載成功後存進 NVS（ESP32）/ 檔案（host），之後 host 沒開也能用上次的座標。
+ *
+ * 只有解析 / 格式化 / 儲存；網路收送由 sketch 做（library 不依賴 WiFi）。
+ */
+
+#ifndef _UWBAnchorLayout_H_INCLUDED
+#define _UWBAnchorLayout_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef LAYOUT_MAX_ANCHORS
+#define LAYOUT_MAX_ANCHORS 8          // <= MLAT_MAX_ANCHORS（slot = 表中的順序）
+#endif
+
+#ifndef LAYOUT_PORT
+#define LAYOUT_PORT 8002              // host 提供下載的 UDP port（遙測是 8001）
+#endif
+
+#define LAYOUT_REQUEST "LAYOUT?"
+#define LAYOUT_MAGIC   "LAYOUT"
+#define LAYOUT_TEXT_MAX (16 + LAYOUT_MAX_ANCHORS * 40)   // format() 需要的 buffer 大小
+
+#ifndef LAYOUT_NVS_NAMESPACE
+#define LAYOUT_NVS_NAMESPACE "uwb_layout"
+#endif
+#ifndef LAYOUT_NVS_KEY
+#define LAYOUT_NVS_KEY "anchors"
+#endif
+#ifndef LAYOUT_FILE
+#define LAYOUT_FILE "uwb_layout.txt"
+#endif
+
+class UWBAnchorLayout {
+public:
+	UWBAnchorLayout() { clear(); }
+
+	void clear() { _count = 0; }
+	// 加一個 anchor；同一個位址再加一次 = 更新座標；表滿回 false
+	bool add(uint16_t id, float x, float y, float z);
+
+	// 解析文字（anchors.txt 格式，可以有 LAYOUT_MAGIC 那一行）；成功解到 >= 1 個 anchor 回傳 true
+	// 解析失敗時原本的內容不變
+	bool parse(const char* text, size_t len);
+	// 輸出成文字（第一行 LAYOUT_MAGIC）；回傳長度，buffer 不夠回 -1
+	int format(char* out, size_t cap) const;
+
+	uint8_t      count() const { return _count; }
+	uint16_t     id(uint8_t slot) const { return _id[slot]; }
+	const float* position(uint8_t slot) const { return _pos[slot]; }
+	// short address -> slot，沒有回 -1
+	int          slotOf(uint16_t id) const;
+
+	// 持久化（ESP32 NVS / host 檔案）；沒有存過或內容壞掉時 load 回傳 false
+	bool load();
+	bool store() const;
+
+private:
+	uint8_t  _count;
+	uint16_t _id[LAYOUT_MAX_ANCHORS];
+	float    _pos[LAYOUT_MAX_ANCHORS][3];
+};
+
+#endif
@@ -0,0 +1,168 @@
+/*
+ * @file UWBAntennaCal.cpp
+ * 批次平均 + 回歸的 antenna delay 校正，說明見 UWBAntennaCal.h
+ */
+
+#include <math.h>
+
+#include "UWBAntennaCal.h"
+
+#define ANTCAL_MIN_SIGMA 0.005f   // m：單筆雜訊下限（量化過的 range 標準差可能算成 0）
+
+void UWBAntennaCal::begin(float targetDistance, uint16_t initialDelay, uint8_t batchSize, float targetCi) {
+	_target = targetDistance;
+	_targetCi = targetCi;
+	_delay = initialDelay;
+	if (batchSize < 3) batchSize = 3;
+	if (batchSize > ANTCAL_MAX_BATCH) batchSize = ANTCAL_MAX_BATCH;
+	_batchSize = batchSize;
+	_n = 0;
+	_skip = 0;                 // 呼叫前就已經 setAntennaDelay(initialDelay)，第一批不用丟
+	_nHist = 0;
+	_done = false;
+	_ci = -1.0f;
+	_lastErr = 0.0f;
+	_slope = ANTCAL_SEED_SLOPE;
+	_used = 0;
+	_stepCount = 0;
+}
+
+static void sortFloats(float* v, uint8_t n) {
+	for (uint8_t i = 1; i < n; i++) {
+		float x = v[i];
+		int8_t j = (int8_t)i - 1;
+		while (j >= 0 && v[j] > x) {
+			v[j + 1] = v[j];
+			j--;
+		}
+		v[j + 1] = x;
+	}
+}
+
+bool UWBAntennaCal::summarize(float* mean, float* s2, uint8_t* count) {
+	float s[ANTCAL_MAX_BATCH];
+	for (uint8_t i = 0; i < _n; i++) s[i] = _batch[i];
+	sortFloats(s, _n);
+	const float med = (_n & 1) ? s[_n / 2] : 0.5f * (s[_n / 2 - 1] + s[_n / 2]);
+	for (uint8_t i = 0; i < _n; i++) s[i] = fabsf(_batch[i] - med);
+	sortFloats(s, _n);
+	const float mad = (_n & 1) ? s[_n / 2] : 0.5f * (s[_n / 2 - 1] + s[_n / 2]);
+	float gate = (_n <= 5 ? 5.0f : 3.0f) * 1.4826f * mad;
+	if (gate < 3.0f * ANTCAL_MIN_SIGMA) gate = 3.0f * ANTCAL_MIN_SIGMA;
+
+	float sum = 0.0f, sum2 = 0.0f;
+	uint8_t k = 0;
+	for (uint8_t i = 0; i < _n; i++) {
+		const float x = _batch[i] - med;
+		if (fabsf(x) > gate) continue;
+		sum += x;
+		sum2 += x * x;
+		k++;
+	}
+	if (k < 2) return false;
+	const float m = sum / k;
+	float sd2 = (sum2 - k * m * m) / (float)(k - 1);
+	if (sd2 < ANTCAL_MIN_SIGMA * ANTCAL_MIN_SIGMA) sd2 = ANTCAL_MIN_SIGMA * ANTCAL_MIN_SIGMA;
+	*mean = med + m - _target;
+	*s2 = sd2;
+	*count = k;
+	return true;
+}
+
+float UWBAntennaCal::nextDelay(float* ci) {
+	// pooled 單筆變異數
+	float ss = 0.0f, dof = 0.0f;
+	for (uint8_t i = 0; i < _nHist; i++) {
+		ss += (float)(_histN[i] - 1) * _histS2[i];
+		dof += (float)(_histN[i] - 1);
+	}
+	const float s2 = ss / dof;
+
+	// 加權（1 / 平均值的變異數 = 筆數 / s2）平均與回歸，x 以加權平均為中心，截距與斜率不相關
+	float sw = 0.0f, sx = 0.0f, sy = 0.0f;
+	for (uint8_t i = 0; i < _nHist; i++) {
+		const float w = (float)_histN[i] / s2;
+		sw += w;
+		sx += w * _histDelay[i];
+		sy += w * _histErr[i];
+	}
+	const float xm = sx / sw, ym = sy / sw;
+	float sxx = 0.0f, sxy = 0.0f;
+	for (uint8_t i = 0; i < _nHist; i++) {
+		const float w = (float)_histN[i] / s2;
+		const float dx = _histDelay[i] - xm;
+		sxx += w * dx * dx;
+		sxy += w * dx * (_histErr[i] - ym);
+	}
+
+	// 斜率：預設斜率當 prior（標準差 ANTCAL_SLOPE_PRIOR 倍），和回歸合併（變異數倒數加權）；
+	// 只有一批、或 delay 差太小時就是 prior，var(b) 也不會是 0（CI 要算進斜率的不確定）
+	const float sd0 = ANTCAL_SLOPE_PRIOR * ANTCAL_SEED_SLOPE;
+	const float p0 = 1.0f / (sd0 * sd0);
+	const float b = (sxy + p0 * ANTCAL_SEED_SLOPE) / (sxx + p0);
+	const float varB = 1.0f / (sxx + p0);
+	_slope = b;
+	const float root = xm - ym / b;
+	// delta method：var(root) = var(ym) / b^2 + (ym / b^2)^2 var(b)
+	const float varRoot = (1.0f / sw) / (b * b) + (ym / (b * b)) * (ym / (b * b)) * varB;
+	// 變異數是估出來的（batch 小時自由度少）：用 t 分布 97.5% 分位數（Cornish-Fisher 展開到 1 / dof^2），不用 1.96
+	*ci = (1.96f + 2.37f / dof + 2.82f / (dof * dof)) * sqrtf(varRoot);
+	return root;
+}
+
+bool UWBAntennaCal::addRange(float range) {
+	if (_done) return false;
+	if (_skip > 0) {
+		_skip--;
+		return false;
+	}
+	_used++;
+	_batch[_n++] = range;
+	if (_n < _batchSize) return false;
+
+	float err, s2;
+	uint8_t k;
+	const bool ok = summarize(&err, &s2, &k);
+	_n = 0;
+	if (!ok) return false;   // 這批幾乎都是離群值：重收一批
+
+	if (_nHist == ANTCAL_HISTORY) {
+		for (uint8_t i = 1; i < ANTCAL_HISTORY; i++) {
+			_histDelay[i - 1] = _histDelay[i];
+			_histErr[i - 1] = _histErr[i];
+			_histS2[i - 1] = _histS2[i];
+			_histN[i - 1] = _histN[i];
+		}
+		_nHist--;
+	}
+	_histDelay[_nHist] = (float)_delay;
+	_histErr[_nHist] = err;
+	_histS2[_nHist] = s2;
+	_histN[_nHist] = k;
+	_nHist++;
+	_lastErr = err;
+	_stepCount++;
+
+	float ci;
+	float next = nextDelay(&ci);
+	_ci = ci;
+	if (next > (float)_delay + ANTCAL_MAX_JUMP) next = (float)_delay + ANTCAL_MAX_JUMP;
+	if (next < (float)_delay - ANTCAL_MAX_JUMP) next = (float)_delay - ANTCAL_MAX_JUMP;
+	if (next < 0.0f) next = 0.0f;
+	if (next > 65535.0f) next = 65535.0f;
+	const uint16_t rounded = (uint16_t)lroundf(next);
+
+	// 序列停止：CI 夠窄，而且這一步要調的量在 CI 以內（和目前的 delay 統計上分不出來）就結束，
+	// 結果用回歸的 root；不必等調整量 < 1 tick（那要把 CI 收到 1 tick 左右，筆數多很多）
+	if (ci <= _targetCi && fabsf(next - (float)_delay) <= (ci > 1.0f ? ci : 1.0f)) {
+		_done = true;
+		if (rounded == _delay) return false;
+		_delay = rounded;
+		return true;
+	}
+	if (_stepCount >= ANTCAL_MAX_STEPS) _done = true;
+	if (rounded == _delay) return false;     // 位置對了但 CI 還太寬：同一個 delay 再收一批
+	_delay = rounded;
+	_skip = ANTCAL_SKIP;
+	return true;
+}
@@ -0,0 +1,111 @@
+/*
+ * @file UWBAntennaCal.h
+ * Antenna delay 校正：已知距離下，找讓平均量測誤差 = 0 的 antenna delay
+ *
+ * 原本 ESP32_anchor_autocalibrate 每一筆 range 就調一次 delay（二分搜尋，變號才減半），
+ * 單筆雜訊 / 偶發的反射就會讓方向判斷錯，要很多筆才收斂。這裡：
+ *   - 每個 delay 收一批（batch）range，先用 median / MAD 去掉離群值再取平均，得到 (delay, 誤差, 標準誤)
+ *   - 誤差對 delay 幾乎是線性的（1 tick ≈ 15.65 ps，anchor 端 delay +1 約讓 range -4.69 mm），
+ *     所以用所有批次做加權線性回歸 err = a + b * delay，下一個 delay = -a / b（secant 的多點版本）；
+ *     預設斜率 ANTCAL_SEED_SLOPE 當 prior（相對標準差 ANTCAL_SLOPE_PRIOR）和回歸斜率合併，
+ *     只有一批時斜率就是 prior，CI 也算進斜率的不確定
+ *   - 單筆雜訊的變異數用所有批次合併估（pooled，每批只有幾筆時單批的估計太不穩），
+ *     每批平均值的變異數 = pooled / 該批筆數，當回歸的權重
+ *   - 信賴區間：回歸的 root 用 delta method 算標準差，乘 t 分位數（pooled 的自由度，Cornish-Fisher 近似）→ 95% CI（tick）
+ *   - 序列停止：CI 半寬 <= ANTCAL_TARGET_CI、而且這一步的調整量在 CI 以內就結束，結果是回歸的 root；
+ *     雜訊小的幾批就停，雜訊大的才多收（預設 5 cm 雜訊約 10 筆，比二分搜尋的 11..12 筆少，
+ *     見 UWB_Host_Server/UWB_AntennaCal_Sim.cpp）
+ *
+ * 用法：begin() 後每筆 range 呼叫 addRange()，回傳 true 表示要把 antennaDelay() 寫進 DW1000.setAntennaDelay()；
+ * isDone() 之後 antennaDelay() 就是結果、confidence() 是 CI 半寬。
+ */
+
+#ifndef _UWBAntennaCal_H_INCLUDED
+#define _UWBAntennaCal_H_INCLUDED
+
+#include <stdint.h>
+
+#ifndef ANTCAL_MAX_BATCH
+#define ANTCAL_MAX_BATCH 64
+#endif
+
+#ifndef ANTCAL_DEFAULT_BATCH
+#define ANTCAL_DEFAULT_BATCH 4
+#endif
+
+#ifndef ANTCAL_HISTORY
+#define ANTCAL_HISTORY 8              // 回歸最多用最近幾批
+#endif
+
+#ifndef ANTCAL_SKIP
+#define ANTCAL_SKIP 2                 // 改 delay 後丟掉的筆數（那一輪的 timestamp 可能用舊 delay）
+#endif
+
+#define ANTCAL_SEED_SLOPE (-0.00469f)  // m / tick（anchor 端 delay 對 range 的影響）
+
+#ifndef ANTCAL_SLOPE_PRIOR
+#define ANTCAL_SLOPE_PRIOR 0.1f       // 預設斜率的相對標準差（各 anchor 實際斜率約 +-10%）
+#endif
+
+#ifndef ANTCAL_TARGET_CI
+#define ANTCAL_TARGET_CI 15.0f        // tick（約 7 cm）；5 cm 雜訊約 10 筆、誤差 RMS 約 4 tick；6 tick 約 30 筆，2 tick 約 150 筆
+#endif
+
+#ifndef ANTCAL_MAX_STEPS
+#define ANTCAL_MAX_STEPS 12
+#endif
+
+#ifndef ANTCAL_MAX_JUMP
+#define ANTCAL_MAX_JUMP 400           // 一步最多調幾個 tick（第一批很離譜時不要跳出合理範圍）
+#endif
+
+class UWBAntennaCal {
+public:
+	UWBAntennaCal() { begin(1.0f, 16384); }
+
+	// targetCi：CI 半寬（tick）到這個以內、而且這一步的調整量在 CI 以內就結束
+	// 呼叫前先 DW1000.setAntennaDelay(initialDelay)：第一批直接用，不丟 ANTCAL_SKIP 筆
+	void begin(float targetDistance, uint16_t initialDelay, uint8_t batchSize = ANTCAL_DEFAULT_BATCH,
+	           float targetCi = ANTCAL_TARGET_CI);
+
+	// 加一筆量到的距離（m）；回傳 true = delay 改了，要套用 delay()
+	bool addRange(float range);
+
+	bool     isDone() const { return _done; }
+	uint16_t antennaDelay() const { return _delay; }
+	float    confidence() const { return _ci; }          // 95% CI 半寬（tick），還沒算出來是 -1
+	float    lastError() const { return _lastErr; }      // 最近一批的平均誤差（m）
+	float    slope() const { return _slope; }            // 目前估計的 m / tick（回歸和預設斜率 prior 合併）
+	uint8_t  steps() const { return _stepCount; }        // 已完成幾批
+	uint16_t rangesUsed() const { return _used; }
+
+private:
+	float    _target;
+	float    _targetCi;
+	uint16_t _delay;
+	uint8_t  _batchSize;
+	uint8_t  _n;
+	uint8_t  _skip;
+	float    _batch[ANTCAL_MAX_BATCH];
+
+	// 每批的結果
+	uint8_t  _nHist;
+	float    _histDelay[ANTCAL_HISTORY];
+	float    _histErr[ANTCAL_HISTORY];
+	float    _histS2[ANTCAL_HISTORY];    // 該批單筆的樣本變異數
+	uint8_t  _histN[ANTCAL_HISTORY];     // 該批去掉離群值後的筆數
+
+	bool     _done;
+	float    _ci;
+	float    _lastErr;
+	float    _slope;
+	uint16_t _used;
+	uint8_t  _stepCount;
+
+	// 一批 -> 去掉離群值後的平均、樣本變異數與筆數
+	bool summarize(float* mean, float* s2, uint8_t* count);
+	// 用歷史資料算下一個 delay 與 CI
+	float nextDelay(float* ci);
+};
+
+#endif
@@ -0,0 +1,47 @@
+/*
+ * @file UWBCir.cpp
+ * CIR 格式轉換與 leading-edge 偵測，說明見 UWBCir.h
+ */
+
+#include <math.h>
+
+#include "UWBCir.h"
+
+void cirUnpack(const uint8_t* raw, uint16_t n, CirSample* out) {
+	for (uint16_t i = 0; i < n; i++) {
+		const uint8_t* p = raw + i * CIR_BYTES_PER_SAMPLE;
+		out[i].re = (int16_t)((uint16_t)p[0] | ((uint16_t)p[1] << 8));
+		out[i].im = (int16_t)((uint16_t)p[2] | ((uint16_t)p[3] << 8));
+	}
+}
+
+float cirMagnitude(const CirSample& s) {
+	const float re = (float)s.re, im = (float)s.im;
+	return sqrtf(re * re + im * im);
+}
+
+float cirLeadingEdge(const CirSample* s, uint16_t n, uint16_t base, float noise) {
+	if (n < 2) return -1.0f;
+
+	float peak = 0.0f;
+	for (uint16_t i = 0; i < n; i++) {
+		const float m = cirMagnitude(s[i]);
+		if (m > peak) peak = m;
+	}
+	float threshold = CIR_LDE_NOISE_K * noise;
+	if (threshold < CIR_LDE_PEAK_FRAC * peak) threshold = CIR_LDE_PEAK_FRAC * peak;
+	if (peak < threshold) return -1.0f;   // 整個視窗都在雜訊裡
+
+	float prev = cirMagnitude(s[0]);
+	if (prev >= threshold) return -1.0f;  // 視窗開頭就超過門檻：真正的 edge 在更前面，不要亂修
+	for (uint16_t i = 1; i < n; i++) {
+		const float m = cirMagnitude(s[i]);
+		if (m >= threshold) {
+			// prev < threshold <= m：線性內插出跨過門檻的位置
+			const float frac = (threshold - prev) / (m - prev);
+			return (float)base + (float)(i - 1) + frac;
+		}
+		prev = m;
+	}
+	return -1.0f;
+}
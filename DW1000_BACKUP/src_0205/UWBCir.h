@@ -0,0 +1,57 @@
+/*
+ * @file UWBCir.h
+ * DW1000 accumulator（channel impulse response, CIR）的資料格式與 leading-edge 偵測
+ *
+ * ACC_MEM（0x25）每個 sample 4 bytes：16-bit real + 16-bit imaginary（little-endian、有號），
+ * 間隔約 1.0016 ns（= 64 個 DW1000 timestamp tick）；16 MHz PRF 共 992 個、64 MHz PRF 共 1016 個。
+ * 晶片的 LDE 把 first path 位置寫在 FP_INDEX（10.6 定點數，單位 sample），RX timestamp 就對應這個位置。
+ *
+ * cirLeadingEdge()：從 FP_INDEX 前面幾個 sample 開始往後找，第一個振幅超過門檻的 sample，
+ * 再和前一個 sample 做線性內插得到小數位置（sub-sample）。門檻取
+ *   max(CIR_LDE_NOISE_K * STD_NOISE, CIR_LDE_PEAK_FRAC * 視窗內最大振幅)
+ * 新的位置和 FP_INDEX 的差 * CIR_TICKS_PER_SAMPLE 就是 RX timestamp 要修正的 tick 數。
+ *
+ * 這裡只有純計算（host 也能編），讀暫存器的部分在 DW1000Class::readAccumulator()。
+ */
+
+#ifndef _UWBCir_H_INCLUDED
+#define _UWBCir_H_INCLUDED
+
+#include <stdint.h>
+
+#define CIR_SAMPLES_16MHZ    992
+#define CIR_SAMPLES_64MHZ    1016
+#define CIR_BYTES_PER_SAMPLE 4
+#define CIR_TICKS_PER_SAMPLE 64      // 1 sample ≈ 1.0016 ns = 64 * 15.65 ps
+
+#ifndef CIR_LDE_SEARCH_BACK
+#define CIR_LDE_SEARCH_BACK 8        // 從 FP_INDEX 往前幾個 sample 開始找
+#endif
+
+#ifndef CIR_LDE_SEARCH_AHEAD
+#define CIR_LDE_SEARCH_AHEAD 8       // 往後最多找幾個 sample（也用來估峰值）
+#endif
+
+#ifndef CIR_LDE_NOISE_K
+#define CIR_LDE_NOISE_K 6.0f         // 門檻 = 幾倍 noise std
+#endif
+
+#ifndef CIR_LDE_PEAK_FRAC
+#define CIR_LDE_PEAK_FRAC 0.25f      // 門檻下限 = 峰值的幾成（雜訊很小時避免抓到旁瓣）
+#endif
+
+struct CirSample {
+	int16_t re;
+	int16_t im;
+};
+
+// raw（ACC_MEM 讀出來的 bytes，已去掉 dummy byte）轉成 n 個 sample
+void cirUnpack(const uint8_t* raw, uint16_t n, CirSample* out);
+
+float cirMagnitude(const CirSample& s);
+
+// s[0..n) 是 accumulator index base 開始的連續 sample；noise = STD_NOISE。
+// 回傳 leading edge 的小數 index（絕對位置，和 FP_INDEX 同單位），找不到回傳 -1
+float cirLeadingEdge(const CirSample* s, uint16_t n, uint16_t base, float noise);
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ * @file UWBClockOffset.cpp
+ * carrier integrator 換算 ppm 與每個 peer 的頻偏平滑，說明見 UWBClockOffset.h
+ */
+
+#include <math.h>
+
+#include "UWBClockOffset.h"
+
+#define CAR_INT_HZ_PER_LSB       (998.4e6 / 2.0 / 1024.0 / 131072.0)
+#define CAR_INT_HZ_PER_LSB_110KB (998.4e6 / 2.0 / 8192.0 / 131072.0)
+
+int32_t carrierIntegratorDecode(const uint8_t data[3]) {
+	uint32_t v = (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)(data[2] & 0x1F) << 16);
+	if (v & (1UL << (CAR_INT_BITS - 1))) v |= ~((1UL << CAR_INT_BITS) - 1);   // sign extend
+	return (int32_t)v;
+}
+
+float carrierIntegratorToPpm(int32_t raw, uint8_t channel, bool is110kbps) {
+	double carrierHz;
+	switch (channel) {
+		case 1: carrierHz = 3494.4e6; break;
+		case 2:
+		case 4: carrierHz = 3993.6e6; break;
+		case 3: carrierHz = 4492.8e6; break;
+		case 5:
+		case 7: carrierHz = 6489.6e6; break;
+		default: return 0.0f;
+	}
+	const double hz = (double)raw * (is110kbps ? CAR_INT_HZ_PER_LSB_110KB : CAR_INT_HZ_PER_LSB);
+	return (float)(hz * (-1.0e6 / carrierHz));
+}
+
+int64_t singleSidedTof(int64_t round, int64_t reply, float ppm) {
+	const double tof = ((double)round - (double)reply / (1.0 + (double)ppm * 1.0e-6)) / 2.0;
+	return (int64_t)(tof + (tof >= 0.0 ? 0.5 : -0.5));
+}
+
+void UWBClockOffsetFilter::reset() {
+	_ppm = 0.0f;
+	_n = 0;
+	_rejects = 0;
+}
+
+bool UWBClockOffsetFilter::update(float ppm) {
+	if (_n < CLOCK_OFFSET_WARMUP) {
+		_n++;
+		_ppm += (ppm - _ppm) / (float)_n;   // 累計平均
+		return true;
+	}
+	if (fabsf(ppm - _ppm) > CLOCK_OFFSET_GATE_PPM) {
+		if (++_rejects >= CLOCK_OFFSET_MAX_REJECTS) {
+			reset();
+			_n = 1;
+			_ppm = ppm;
+		}
+		return false;
+	}
+	_rejects = 0;
+	_ppm += CLOCK_OFFSET_ALPHA * (ppm - _ppm);
+	if (_n < 0xFFFF) _n++;
+	return true;
+}
@@ -0,0 +1,71 @@
+/*
+ * @file UWBClockOffset.h
+ * 用 DW1000 carrier integrator（DRX_CAR_INT）估對方和自己的時鐘頻偏（ppm），並對每個 peer 做平滑
+ *
+ * 收到封包時，接收端的 carrier recovery loop 會把「對方載波相對本地」的頻率差積分在 DRX_CAR_INT
+ * （reg 0x27:0x28，21-bit 有號數）。換算（DW1000 user manual 7.2.40.11 / Decawave API）：
+ *   Hz  = raw * 998.4e6 / 2 / 1024 / 2^17        （110 kb/s 時 / 8192 而不是 / 1024）
+ *   ppm = Hz * (-1e6 / 載波頻率)                  （ch1 3494.4、ch2/4 3993.6、ch3 4492.8、ch5/7 6489.6 MHz）
+ * 正的 ppm 代表對方的時鐘比自己快。
+ *
+ * UWBClockOffsetFilter：每個 peer 一個。前 CLOCK_OFFSET_WARMUP 筆用平均，之後用 EMA；
+ * 和目前估計差超過 CLOCK_OFFSET_GATE_PPM 的單筆（封包太弱、integrator 還沒收斂）不採用，
+ * 連續 CLOCK_OFFSET_MAX_REJECTS 筆都被擋代表真的變了（換了對象 / 溫度跳動），重新開始。
+ *
+ * 用途：SS-TWR 的 reply time 換到同一個時鐘（singleSidedTof，TAG 收到 POLL_ACK 時用）、
+ * 以及 crystal trim 判斷。
+ */
+
+#ifndef _UWBClockOffset_H_INCLUDED
+#define _UWBClockOffset_H_INCLUDED
+
+#include <stdint.h>
+
+#define CAR_INT_BITS 21
+
+#ifndef CLOCK_OFFSET_ALPHA
+#define CLOCK_OFFSET_ALPHA 0.1f        // EMA 係數（新值的權重）
+#endif
+
+#ifndef CLOCK_OFFSET_WARMUP
+#define CLOCK_OFFSET_WARMUP 8          // 前幾筆直接平均
+#endif
+
+#ifndef CLOCK_OFFSET_GATE_PPM
+#define CLOCK_OFFSET_GATE_PPM 3.0f     // 單筆和估計差超過這個就不採用
+#endif
+
+#ifndef CLOCK_OFFSET_MAX_REJECTS
+#define CLOCK_OFFSET_MAX_REJECTS 5
+#endif
+
+// DRX_CAR_INT 的 3 bytes（little-endian）-> 21-bit 有號數
+int32_t carrierIntegratorDecode(const uint8_t data[3]);
+
+// raw -> ppm；channel 1..7，is110kbps = 目前 data rate 是 110 kb/s。不支援的 channel 回傳 0
+float carrierIntegratorToPpm(int32_t raw, uint8_t channel, bool is110kbps);
+
+// SS-TWR 的 TOF（自己的 tick）：round = 自己量的「送出 -> 收到回覆」，reply = 對方量的「收到 -> 送出回覆」，
+// ppm = 對方相對自己的頻偏。對方的 tick 換成自己的：reply / (1 + ppm * 1e-6)
+int64_t singleSidedTof(int64_t round, int64_t reply, float ppm);
+
+class UWBClockOffsetFilter {
+public:
+	UWBClockOffsetFilter() { reset(); }
+
+	void reset();
+
+	// 加入一筆 ppm；被 gate 擋掉時回傳 false
+	bool update(float ppm);
+
+	float ppm() const { return _ppm; }
+	bool valid() const { return _n >= CLOCK_OFFSET_WARMUP; }
+	uint16_t count() const { return _n; }
+
+private:
+	float    _ppm;
+	uint16_t _n;
+	uint8_t  _rejects;
+};
+
+#endif
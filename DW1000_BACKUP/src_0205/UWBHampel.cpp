@@ -0,0 +1,151 @@
+/*
+ * @file UWBHampel.cpp
+ * 串流 median / Hampel 離群值過濾，說明見 UWBHampel.h
+ */
+
+#include <math.h>
+
+#include "UWBHampel.h"
+
+// ===== UWBMedianWindow =====
+
+void UWBMedianWindow::begin(uint8_t window) {
+	_w = hampelClampWindow(window);
+	_n = 0;
+	_head = 0;
+	_nLo = 0;
+	_nHi = 0;
+}
+
+bool UWBMedianWindow::less(uint8_t heap, uint8_t a, uint8_t b) const {
+	return (heap == 0) ? (_v[a] > _v[b]) : (_v[a] < _v[b]);
+}
+
+void UWBMedianWindow::place(uint8_t heap, uint8_t pos, uint8_t slot) {
+	if (heap == 0)
+		_lo[pos] = slot;
+	else
+		_hi[pos] = slot;
+	_heapOf[slot] = heap;
+	_pos[slot] = pos;
+}
+
+void UWBMedianWindow::siftUp(uint8_t heap, uint8_t pos) {
+	uint8_t* h = (heap == 0) ? _lo : _hi;
+	while (pos > 0) {
+		uint8_t parent = (pos - 1) / 2;
+		if (!less(heap, h[pos], h[parent])) break;
+		uint8_t a = h[pos], b = h[parent];
+		place(heap, parent, a);
+		place(heap, pos, b);
+		pos = parent;
+	}
+}
+
+void UWBMedianWindow::siftDown(uint8_t heap, uint8_t pos) {
+	uint8_t* h = (heap == 0) ? _lo : _hi;
+	const uint8_t n = (heap == 0) ? _nLo : _nHi;
+	for (;;) {
+		uint8_t best = pos;
+		uint8_t l = 2 * pos + 1, r = 2 * pos + 2;
+		if (l < n && less(heap, h[l], h[best])) best = l;
+		if (r < n && less(heap, h[r], h[best])) best = r;
+		if (best == pos) break;
+		uint8_t a = h[pos], b = h[best];
+		place(heap, best, a);
+		place(heap, pos, b);
+		pos = best;
+	}
+}
+
+void UWBMedianWindow::insertSlot(uint8_t heap, uint8_t slot) {
+	uint8_t pos = (heap == 0) ? _nLo++ : _nHi++;
+	place(heap, pos, slot);
+	siftUp(heap, pos);
+}
+
+uint8_t UWBMedianWindow::popTop(uint8_t heap) {
+	uint8_t* h = (heap == 0) ? _lo : _hi;
+	uint8_t top = h[0];
+	uint8_t n = (heap == 0) ? --_nLo : --_nHi;
+	if (n > 0) {
+		place(heap, 0, h[n]);
+		siftDown(heap, 0);
+	}
+	return top;
+}
+
+// 只有一個值變動時，最多交換一次兩個 heap 的頂端就能恢復 max(lo) <= min(hi)
+void UWBMedianWindow::fixTops() {
+	if (_nLo == 0 || _nHi == 0 || _v[_lo[0]] <= _v[_hi[0]]) return;
+	uint8_t a = _lo[0], b = _hi[0];
+	place(0, 0, b);
+	place(1, 0, a);
+	siftDown(0, 0);
+	siftDown(1, 0);
+}
+
+void UWBMedianWindow::push(float x) {
+	const uint8_t slot = _head;
+	_head = (uint8_t)((_head + 1) % _w);
+	_v[slot] = x;
+
+	if (_n < _w) {
+		_n++;
+		if (_nLo == 0 || x <= _v[_lo[0]])
+			insertSlot(0, slot);
+		else
+			insertSlot(1, slot);
+		if (_nLo > _nHi + 1) insertSlot(1, popTop(0));
+		else if (_nHi > _nLo) insertSlot(0, popTop(1));
+		return;
+	}
+
+	// 視窗滿了：這個 slot 原本是最舊的一筆，直接在它所在的 heap 裡改值
+	const uint8_t heap = _heapOf[slot];
+	siftUp(heap, _pos[slot]);
+	siftDown(heap, _pos[slot]);
+	fixTops();
+}
+
+float UWBMedianWindow::median() const {
+	if (_n == 0) return 0.0f;
+	if (_nLo > _nHi) return _v[_lo[0]];
+	return 0.5f * (_v[_lo[0]] + _v[_hi[0]]);
+}
+
+// ===== UWBHampel =====
+
+void UWBHampel::configure(uint8_t window, float k, float minSigma) {
+	_x.begin(window);
+	_dev.begin(window);
+	_k = k;
+	_minSigma = minSigma;
+	_outliers = 0;
+}
+
+void UWBHampel::reset() {
+	_x.begin(_x.window());
+	_dev.begin(_dev.window());
+}
+
+float UWBHampel::filter(float x, bool* outlier) {
+	bool out = false;
+	float y = x;
+	if (_x.count() >= 3) {
+		const float med = _x.median();
+		float sigma = 1.4826f * _dev.median();
+		if (sigma < _minSigma) sigma = _minSigma;
+		const float dev = fabsf(x - med);
+		if (dev > _k * sigma) {
+			out = true;
+			y = med;
+			_outliers++;
+		}
+		_dev.push(dev);
+	}
+	// 原始值照樣進視窗：真的移動了（不是 spike）的話，過半數之後 median 就會跟上
+	_x.push(x);
+	if (outlier != 0) *outlier = out;
+	return y;
+}
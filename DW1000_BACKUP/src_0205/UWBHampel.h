@@ -0,0 +1,89 @@
+/*
+ * @file UWBHampel.h
+ * 每個 anchor 的 range 離群值過濾：固定視窗的串流 median + Hampel 判斷
+ *
+ * UWBMedianWindow：最近 w 筆的 median，用「有索引的雙 heap」（下半部 max-heap、上半部 min-heap）
+ *   - 每筆新值直接覆蓋視窗裡最舊那筆在 heap 中的位置，再 sift + 必要時交換兩個 heap 的頂端
+ *   - push O(log w)、median O(1)；只有陣列和 uint8_t 索引，沒有指標（DW1000Device 會被 memcpy）
+ *
+ * UWBHampel：|x - median| > k * 1.4826 * MAD 視為離群值，輸出換成 median。
+ *   MAD 用第二個 UWBMedianWindow 記「每筆進來時相對當時 median 的偏差」，是 MAD 的串流近似，
+ *   同樣 O(log w)（精確 MAD 每筆都要 O(w) 重算）。minSigma 避免 range 量化後 MAD = 0 把每筆都判成離群。
+ */
+
+#ifndef _UWBHampel_H_INCLUDED
+#define _UWBHampel_H_INCLUDED
+
+#include <stdint.h>
+
+#ifndef HAMPEL_MAX_WINDOW
+#define HAMPEL_MAX_WINDOW 15
+#endif
+
+#define HAMPEL_DEFAULT_WINDOW    7
+#define HAMPEL_DEFAULT_K         3.0f
+#define HAMPEL_DEFAULT_MIN_SIGMA 0.05f   // m
+
+#if HAMPEL_MAX_WINDOW > 127
+#error "HAMPEL_MAX_WINDOW must be <= 127"
+#endif
+
+// begin() / configure() 實際用的視窗大小（夾在 1..HAMPEL_MAX_WINDOW）；
+// 呼叫端存設定時也先夾過，之後才能直接和 window() 比較
+static inline uint8_t hampelClampWindow(uint8_t window) {
+	if (window < 1) return 1;
+	if (window > HAMPEL_MAX_WINDOW) return HAMPEL_MAX_WINDOW;
+	return window;
+}
+
+class UWBMedianWindow {
+public:
+	UWBMedianWindow() { begin(HAMPEL_DEFAULT_WINDOW); }
+
+	void begin(uint8_t window);
+	void push(float x);
+	float median() const;
+	uint8_t count() const { return _n; }
+	uint8_t window() const { return _w; }
+
+private:
+	float   _v[HAMPEL_MAX_WINDOW];      // 依到達順序的環狀 buffer
+	uint8_t _heapOf[HAMPEL_MAX_WINDOW]; // 0 = lo（max-heap），1 = hi（min-heap）
+	uint8_t _pos[HAMPEL_MAX_WINDOW];    // 在該 heap 陣列中的位置
+	uint8_t _lo[HAMPEL_MAX_WINDOW];     // heap 內容 = _v 的 slot
+	uint8_t _hi[HAMPEL_MAX_WINDOW];
+	uint8_t _nLo, _nHi;                 // 維持 _nLo == _nHi 或 _nLo == _nHi + 1
+	uint8_t _head, _n, _w;
+
+	bool less(uint8_t heap, uint8_t a, uint8_t b) const;   // heap 順序：a 應該在 b 上面
+	void place(uint8_t heap, uint8_t pos, uint8_t slot);
+	void siftUp(uint8_t heap, uint8_t pos);
+	void siftDown(uint8_t heap, uint8_t pos);
+	void insertSlot(uint8_t heap, uint8_t slot);
+	uint8_t popTop(uint8_t heap);
+	void fixTops();
+};
+
+class UWBHampel {
+public:
+	UWBHampel() { configure(HAMPEL_DEFAULT_WINDOW, HAMPEL_DEFAULT_K, HAMPEL_DEFAULT_MIN_SIGMA); }
+
+	void configure(uint8_t window, float k, float minSigma = HAMPEL_DEFAULT_MIN_SIGMA);
+	void reset();
+
+	// 回傳過濾後的值；outlier 可為 0
+	float filter(float x, bool* outlier);
+
+	uint8_t window() const { return _x.window(); }
+	float k() const { return _k; }
+	uint32_t outliers() const { return _outliers; }
+
+private:
+	UWBMedianWindow _x;
+	UWBMedianWindow _dev;
+	float    _k;
+	float    _minSigma;
+	uint32_t _outliers;
+};
+
+#endif
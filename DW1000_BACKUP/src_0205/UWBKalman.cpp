@@ -0,0 +1,127 @@
+/*
+ * @file UWBKalman.cpp
+ * 等速度 Kalman filter，說明見 UWBKalman.h
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "UWBKalman.h"
+
+// 兩筆 range 間隔超過這個就只預測到這麼長（例如 tag 停了很久），避免 P 爆掉
+#define KF_MAX_DT 1.0f
+
+UWBKalman::UWBKalman(uint8_t dim) {
+	_dim = (dim == 2) ? 2 : 3;
+	_n = 2 * _dim;
+	_init = false;
+	_lastMs = 0;
+	_gate = KF_DEFAULT_GATE;
+	_rejectRun = 0;
+	setNoise(KF_DEFAULT_ACCEL_SIGMA, KF_DEFAULT_RANGE_SIGMA);
+	memset(_x, 0, sizeof(_x));
+	memset(_P, 0, sizeof(_P));
+}
+
+void UWBKalman::setNoise(float accelSigma, float rangeSigma) {
+	_q = accelSigma * accelSigma;
+	_r = rangeSigma * rangeSigma;
+}
+
+void UWBKalman::reset(const float pos[3], float posSigma, uint32_t nowMs) {
+	memset(_x, 0, sizeof(_x));
+	memset(_P, 0, sizeof(_P));
+	for (uint8_t i = 0; i < _dim; i++) {
+		_x[i] = pos[i];
+		_P[i][i] = posSigma * posSigma;
+		_P[_dim + i][_dim + i] = 1.0f;   // 初始速度未知：1 (m/s)^2
+	}
+	_lastMs = nowMs;
+	_rejectRun = 0;
+	_init = true;
+}
+
+void UWBKalman::predict(uint32_t nowMs) {
+	if (!_init) return;
+	float dt = (uint32_t)(nowMs - _lastMs) * 0.001f;
+	_lastMs = nowMs;
+	if (dt <= 0.0f) return;
+	if (dt > KF_MAX_DT) dt = KF_MAX_DT;
+
+	// 每個軸的 (p, v) 只和自己耦合：x = F x，P = F P F^T + Q，F = [1 dt; 0 1]
+	const uint8_t d = _dim;
+	for (uint8_t i = 0; i < d; i++) _x[i] += dt * _x[d + i];
+
+	// P = F P F^T：先左乘（列 i += dt * 列 d+i），再右乘（行 j += dt * 行 d+j）
+	for (uint8_t i = 0; i < d; i++)
+		for (uint8_t j = 0; j < _n; j++) _P[i][j] += dt * _P[d + i][j];
+	for (uint8_t j = 0; j < d; j++)
+		for (uint8_t i = 0; i < _n; i++) _P[i][j] += dt * _P[i][d + j];
+
+	// 白色加速度雜訊：Q = q [dt^4/4 dt^3/2; dt^3/2 dt^2]
+	const float dt2 = dt * dt;
+	const float qpp = _q * dt2 * dt2 * 0.25f, qpv = _q * dt2 * dt * 0.5f, qvv = _q * dt2;
+	for (uint8_t i = 0; i < d; i++) {
+		_P[i][i] += qpp;
+		_P[i][d + i] += qpv;
+		_P[d + i][i] += qpv;
+		_P[d + i][d + i] += qvv;
+	}
+}
+
+bool UWBKalman::updateRange(const float anchor[3], float range, uint32_t nowMs, float weight) {
+	if (!_init) return false;
+	predict(nowMs);
+
+	// h(x) = |p - a|，H = [u^T, 0]，u = (p - a) / |p - a|（2D 時 tag z = 0）
+	float u[3] = {_x[0] - anchor[0], _x[1] - anchor[1], (_dim == 3 ? _x[2] : 0.0f) - anchor[2]};
+	float pred = sqrtf(u[0] * u[0] + u[1] * u[1] + u[2] * u[2]);
+	if (pred < 1.0e-3f) return false;   // 剛好在 anchor 上，沒有方向
+	for (uint8_t i = 0; i < 3; i++) u[i] /= pred;
+
+	// PH^T（H 只有前 dim 個非 0）
+	float ph[KF_MAX_STATE];
+	for (uint8_t i = 0; i < _n; i++) {
+		float s = 0.0f;
+		for (uint8_t k = 0; k < _dim; k++) s += _P[i][k] * u[k];
+		ph[i] = s;
+	}
+	float s = _r / (weight > 0.01f ? weight : 0.01f);
+	for (uint8_t k = 0; k < _dim; k++) s += u[k] * ph[k];
+
+	const float innov = range - pred;
+	if (innov * innov > _gate * _gate * s) {
+		_rejectRun++;
+		return false;
+	}
+	_rejectRun = 0;
+
+	// K = PH^T / s；x += K innov；P -= K (HP) = P - ph ph^T / s
+	const float inv = 1.0f / s;
+	for (uint8_t i = 0; i < _n; i++) _x[i] += ph[i] * inv * innov;
+	for (uint8_t i = 0; i < _n; i++)
+		for (uint8_t j = 0; j <= i; j++) {
+			float v = _P[i][j] - ph[i] * ph[j] * inv;
+			_P[i][j] = v;
+			_P[j][i] = v;   // 保持對稱
+		}
+	return true;
+}
+
+void UWBKalman::getPosition(float pos[3]) const {
+	pos[0] = _x[0];
+	pos[1] = _x[1];
+	pos[2] = (_dim == 3) ? _x[2] : 0.0f;
+}
+
+void UWBKalman::getVelocity(float vel[3]) const {
+	vel[0] = _x[_dim];
+	vel[1] = _x[_dim + 1];
+	vel[2] = (_dim == 3) ? _x[5] : 0.0f;
+}
+
+float UWBKalman::positionSigma() const {
+	float t = 0.0f;
+	for (uint8_t i = 0; i < _dim; i++) t += _P[i][i];
+	return sqrtf(t);
+}
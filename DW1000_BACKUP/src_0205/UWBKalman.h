@@ -0,0 +1,70 @@
+/*
+ * @file UWBKalman.h
+ * TAG 端位置追蹤：等速度（constant velocity）Kalman filter，一筆 range 進來就更新一次
+ *
+ * 取代「每個 anchor 各自 EMA（filterValue）+ fresh_link 三筆平均」的作法：
+ *   - 狀態在位置空間 [p, v]，用運動模型預測，不是把每個 range 各自延遲平滑
+ *   - sequential update：每收到一個 anchor 的 range 就做一次 EKF 更新（h = |p - a|），不用等 4 個 anchor 都到齊
+ *   - innovation gate：和預測差太多（> gate 個 sigma）的 range 直接丟掉（NLOS / 反射）
+ *
+ * 全部 float、固定大小（2D 4 個狀態 / 3D 6 個），不配置記憶體；ESP32 上 predict + update 約數十 µs。
+ * 初始位置由呼叫端給（通常是 UWBMultilateration 的第一個解）。
+ */
+
+#ifndef _UWBKalman_H_INCLUDED
+#define _UWBKalman_H_INCLUDED
+
+#include <stdint.h>
+
+#define KF_MAX_STATE 6
+
+#ifndef KF_DEFAULT_ACCEL_SIGMA
+#define KF_DEFAULT_ACCEL_SIGMA 1.0f    // m/s^2，走路的人約 0.5 ~ 2
+#endif
+
+#ifndef KF_DEFAULT_RANGE_SIGMA
+#define KF_DEFAULT_RANGE_SIGMA 0.10f   // m，DW1000 LOS 約 5 ~ 10 cm
+#endif
+
+#ifndef KF_DEFAULT_GATE
+#define KF_DEFAULT_GATE 4.0f           // innovation 超過幾個 sigma 就丟掉
+#endif
+
+class UWBKalman {
+public:
+	explicit UWBKalman(uint8_t dim = 3);
+
+	void setNoise(float accelSigma, float rangeSigma);
+	void setGate(float sigmas) { _gate = sigmas; }
+
+	// 以已知位置（m）開始追蹤，速度設 0；posSigma = 初始位置的標準差（m）
+	void reset(const float pos[3], float posSigma, uint32_t nowMs);
+	bool isInitialized() const { return _init; }
+
+	// 推進到 nowMs（updateRange 會自己呼叫，一般不用單獨叫）
+	void predict(uint32_t nowMs);
+
+	// 一個 anchor 的 range（m）；anchor = (x, y, z)。2D 時 tag z 視為 0（同 trilat2D_4A）。
+	// weight 0..1（例如 UWBMultilateration::powerWeight），量測雜訊變成 rangeSigma^2 / weight。
+	// 回傳 false = 沒初始化或被 gate 擋掉
+	bool updateRange(const float anchor[3], float range, uint32_t nowMs, float weight = 1.0f);
+
+	void getPosition(float pos[3]) const;
+	void getVelocity(float vel[3]) const;
+	float positionSigma() const;                    // sqrt(trace(P_pos))
+	uint16_t rejectedInRow() const { return _rejectRun; }   // 連續被 gate 擋掉的筆數（太多表示該重新初始化）
+
+private:
+	uint8_t  _dim;
+	uint8_t  _n;                 // 狀態數 = 2 * dim
+	bool     _init;
+	uint32_t _lastMs;
+	float    _q;                 // accel sigma^2
+	float    _r;                 // range sigma^2
+	float    _gate;
+	uint16_t _rejectRun;
+	float    _x[KF_MAX_STATE];   // [p0..p(dim-1), v0..v(dim-1)]
+	float    _P[KF_MAX_STATE][KF_MAX_STATE];
+};
+
+#endif
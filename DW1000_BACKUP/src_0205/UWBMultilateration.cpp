@@ -0,0 +1,289 @@
+/*
+ * @file UWBMultilateration.cpp
+ * K 個 anchor 的線性最小平方定位，說明見 UWBMultilateration.h
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "UWBMultilateration.h"
+#include "UWBNlos.h"
+
+// Cholesky pivot 下限（m^2）：小於這個表示 anchor 共線 / 共面，同原本 det < 1e-4 的檢查
+#define MLAT_PIVOT_MIN 1.0e-4f
+
+// powerWeight() 的門檻（dBm）
+#define MLAT_FP_GOOD_DBM   -85.0f
+#define MLAT_FP_WEAK_DBM  -105.0f
+#define MLAT_WEIGHT_MIN      0.1f
+
+UWBMultilateration::UWBMultilateration(uint8_t dim) {
+	_dim = (dim == 2) ? 2 : 3;
+	_anchorMask = 0;
+	memset(_anchor, 0, sizeof(_anchor));
+	_hits = 0;
+	_misses = 0;
+	_refineMaxIter = MLAT_REFINE_MAX_ITER;
+	_refineTol = MLAT_REFINE_TOL;
+	invalidate();
+}
+
+void UWBMultilateration::invalidate() {
+	_tick = 0;
+	memset(_cacheUsed, 0, sizeof(_cacheUsed));
+}
+
+void UWBMultilateration::setDimension(uint8_t dim) {
+	_dim = (dim == 2) ? 2 : 3;
+	invalidate();
+}
+
+bool UWBMultilateration::setAnchor(uint8_t slot, float x, float y, float z) {
+	if (slot >= MLAT_MAX_ANCHORS) return false;
+	_anchor[slot][0] = x;
+	_anchor[slot][1] = y;
+	_anchor[slot][2] = z;
+	_anchorMask |= (uint16_t)(1u << slot);
+	invalidate();
+	return true;
+}
+
+void UWBMultilateration::clearAnchor(uint8_t slot) {
+	if (slot >= MLAT_MAX_ANCHORS) return;
+	_anchorMask &= (uint16_t)~(1u << slot);
+	invalidate();
+}
+
+bool UWBMultilateration::factorize(uint16_t mask, MlatFactor* f) const {
+	f->mask = mask;
+	f->dim = _dim;
+	f->k = 0;
+	f->ok = false;
+	if ((mask & _anchorMask) != mask) return false;   // 用到沒設定座標的 anchor
+	for (uint8_t s = 0; s < MLAT_MAX_ANCHORS; s++)
+		if (mask & (1u << s)) f->slot[f->k++] = s;
+	if (f->k < _dim + 1) return false;
+
+	// A^T A（對稱，只算下三角）
+	const float* a0 = _anchor[f->slot[0]];
+	float ata[3][3] = {{0}};
+	for (uint8_t i = 1; i < f->k; i++) {
+		const float* ai = _anchor[f->slot[i]];
+		float r[3] = {ai[0] - a0[0], ai[1] - a0[1], ai[2] - a0[2]};
+		for (uint8_t p = 0; p < _dim; p++)
+			for (uint8_t q = 0; q <= p; q++) ata[p][q] += r[p] * r[q];
+	}
+
+	// Cholesky：A^T A = L L^T
+	float L[3][3] = {{0}};
+	for (uint8_t p = 0; p < _dim; p++) {
+		for (uint8_t q = 0; q <= p; q++) {
+			float s = ata[p][q];
+			for (uint8_t t = 0; t < q; t++) s -= L[p][t] * L[q][t];
+			if (p == q) {
+				if (s < MLAT_PIVOT_MIN) return false;
+				L[p][p] = sqrtf(s);
+			} else {
+				L[p][q] = s / L[q][q];
+			}
+		}
+	}
+	f->L[0] = L[0][0];
+	f->L[1] = L[1][0];
+	f->L[2] = L[1][1];
+	f->L[3] = L[2][0];
+	f->L[4] = L[2][1];
+	f->L[5] = L[2][2];
+	f->ok = true;
+	return true;
+}
+
+bool UWBMultilateration::solve(const MlatFactor& f, const float* d, float pos[3], float* rmse) const {
+	if (!f.ok) return false;
+	const uint8_t dim = f.dim;
+	const float* a0 = _anchor[f.slot[0]];
+	const float d0 = d[f.slot[0]];
+	const float k0 = a0[0] * a0[0] + a0[1] * a0[1] + (dim == 3 ? a0[2] * a0[2] : 0.0f);
+
+	// rhs = 0.5 A^T b
+	float rhs[3] = {0.0f, 0.0f, 0.0f};
+	for (uint8_t i = 1; i < f.k; i++) {
+		const float* ai = _anchor[f.slot[i]];
+		const float di = d[f.slot[i]];
+		float ki = ai[0] * ai[0] + ai[1] * ai[1] + (dim == 3 ? ai[2] * ai[2] : 0.0f);
+		float b = 0.5f * (d0 * d0 - di * di + ki - k0);
+		rhs[0] += (ai[0] - a0[0]) * b;
+		rhs[1] += (ai[1] - a0[1]) * b;
+		if (dim == 3) rhs[2] += (ai[2] - a0[2]) * b;
+	}
+
+	// L y = rhs，L^T p = y
+	float y[3], p[3] = {0.0f, 0.0f, 0.0f};
+	y[0] = rhs[0] / f.L[0];
+	y[1] = (rhs[1] - f.L[1] * y[0]) / f.L[2];
+	if (dim == 3) {
+		y[2] = (rhs[2] - f.L[3] * y[0] - f.L[4] * y[1]) / f.L[5];
+		p[2] = y[2] / f.L[5];
+		p[1] = (y[1] - f.L[4] * p[2]) / f.L[2];
+		p[0] = (y[0] - f.L[1] * p[1] - f.L[3] * p[2]) / f.L[0];
+	} else {
+		p[1] = y[1] / f.L[2];
+		p[0] = (y[0] - f.L[1] * p[1]) / f.L[0];
+	}
+
+	if (rmse != 0) {
+		// 量測距離和算出位置的距離差（2D 時 anchor z 照算，同 trilat2D_4A）
+		float e = 0.0f;
+		for (uint8_t i = 0; i < f.k; i++) {
+			const float* ai = _anchor[f.slot[i]];
+			float dx = ai[0] - p[0], dy = ai[1] - p[1], dz = ai[2] - p[2];
+			float r = d[f.slot[i]] - sqrtf(dx * dx + dy * dy + dz * dz);
+			e += r * r;
+		}
+		*rmse = sqrtf(e / (float)f.k);
+	}
+	pos[0] = p[0];
+	pos[1] = p[1];
+	pos[2] = p[2];
+	return true;
+}
+
+bool UWBMultilateration::solve(uint16_t mask, const float* d, float pos[3], float* rmse) {
+	uint8_t victim = 0;
+	for (uint8_t i = 0; i < MLAT_CACHE_SIZE; i++) {
+		if (_cacheUsed[i] != 0 && _cache[i].mask == mask) {
+			_cacheUsed[i] = ++_tick;
+			_hits++;
+			return solve(_cache[i], d, pos, rmse);
+		}
+		if (_cacheUsed[i] < _cacheUsed[victim]) victim = i;   // 最久沒用的（空的是 0）
+	}
+	_misses++;
+	factorize(mask, &_cache[victim]);
+	_cacheUsed[victim] = ++_tick;
+	return solve(_cache[victim], d, pos, rmse);
+}
+
+// 3x3（或 2x2）對稱正定系統 N x = g，就地 Cholesky；N 只用下三角
+static bool solveSpd(uint8_t dim, float N[3][3], const float g[3], float x[3]) {
+	float L[3][3] = {{0}};
+	for (uint8_t p = 0; p < dim; p++) {
+		for (uint8_t q = 0; q <= p; q++) {
+			float s = N[p][q];
+			for (uint8_t t = 0; t < q; t++) s -= L[p][t] * L[q][t];
+			if (p == q) {
+				if (s <= 0.0f) return false;
+				L[p][p] = sqrtf(s);
+			} else {
+				L[p][q] = s / L[q][q];
+			}
+		}
+	}
+	float y[3];
+	for (uint8_t p = 0; p < dim; p++) {
+		float s = g[p];
+		for (uint8_t t = 0; t < p; t++) s -= L[p][t] * y[t];
+		y[p] = s / L[p][p];
+	}
+	for (int p = dim - 1; p >= 0; p--) {
+		float s = y[p];
+		for (uint8_t t = p + 1; t < dim; t++) s -= L[t][p] * x[t];
+		x[p] = s / L[p][p];
+	}
+	return true;
+}
+
+uint8_t UWBMultilateration::refine(const MlatFactor& f, const float* d, const float* w, float pos[3], float* rmse) const {
+	if (!f.ok || _refineMaxIter == 0) return 0;
+	const uint8_t dim = f.dim;
+	float p[3] = {pos[0], pos[1], (dim == 3) ? pos[2] : 0.0f};   // 2D：tag z 固定 0
+	float lambda = 1.0e-3f;
+	uint8_t it = 0;
+
+	// 目前位置的加權殘差平方和
+	float cost = 0.0f;
+	for (uint8_t i = 0; i < f.k; i++) {
+		const float* ai = _anchor[f.slot[i]];
+		float dx = p[0] - ai[0], dy = p[1] - ai[1], dz = p[2] - ai[2];
+		float r = d[f.slot[i]] - sqrtf(dx * dx + dy * dy + dz * dz);
+		cost += (w ? w[f.slot[i]] : 1.0f) * r * r;
+	}
+
+	while (it < _refineMaxIter) {
+		it++;
+		// J^T W J 與 J^T W r；J 的第 i 列 = (p - a_i) / |p - a_i|
+		float N[3][3] = {{0}}, g[3] = {0.0f, 0.0f, 0.0f};
+		for (uint8_t i = 0; i < f.k; i++) {
+			const float* ai = _anchor[f.slot[i]];
+			float u[3] = {p[0] - ai[0], p[1] - ai[1], p[2] - ai[2]};
+			float dist = sqrtf(u[0] * u[0] + u[1] * u[1] + u[2] * u[2]);
+			if (dist < 1.0e-3f) continue;   // 剛好在 anchor 上：這個 anchor 沒有方向資訊
+			float wi = w ? w[f.slot[i]] : 1.0f;
+			float r = d[f.slot[i]] - dist;
+			for (uint8_t a = 0; a < dim; a++) {
+				u[a] /= dist;
+				g[a] += wi * u[a] * r;
+				for (uint8_t b = 0; b <= a; b++) N[a][b] += wi * u[a] * u[b];
+			}
+		}
+		for (uint8_t a = 0; a < dim; a++) N[a][a] *= 1.0f + lambda;   // LM 阻尼（Marquardt scaling）
+
+		float step[3] = {0.0f, 0.0f, 0.0f};
+		if (!solveSpd(dim, N, g, step)) break;
+		float q[3] = {p[0] + step[0], p[1] + step[1], p[2] + step[2]};
+		float newCost = 0.0f;
+		for (uint8_t i = 0; i < f.k; i++) {
+			const float* ai = _anchor[f.slot[i]];
+			float dx = q[0] - ai[0], dy = q[1] - ai[1], dz = q[2] - ai[2];
+			float r = d[f.slot[i]] - sqrtf(dx * dx + dy * dy + dz * dz);
+			newCost += (w ? w[f.slot[i]] : 1.0f) * r * r;
+		}
+		if (newCost < cost) {
+			p[0] = q[0];
+			p[1] = q[1];
+			p[2] = q[2];
+			cost = newCost;
+			lambda *= 0.1f;
+			if (step[0] * step[0] + step[1] * step[1] + step[2] * step[2] < _refineTol * _refineTol) break;
+		} else {
+			lambda *= 10.0f;   // 這步變差：退回原點，加大阻尼再試
+		}
+	}
+
+	pos[0] = p[0];
+	pos[1] = p[1];
+	pos[2] = p[2];
+	if (rmse != 0) {
+		float e = 0.0f;
+		for (uint8_t i = 0; i < f.k; i++) {
+			const float* ai = _anchor[f.slot[i]];
+			float dx = ai[0] - p[0], dy = ai[1] - p[1], dz = ai[2] - p[2];
+			float r = d[f.slot[i]] - sqrtf(dx * dx + dy * dy + dz * dz);
+			e += r * r;
+		}
+		*rmse = sqrtf(e / (float)f.k);
+	}
+	return it;
+}
+
+bool UWBMultilateration::solveRefined(uint16_t mask, const float* d, const float* w, float pos[3], float* rmse, uint8_t* iters) {
+	if (iters != 0) *iters = 0;
+	if (!solve(mask, d, pos, rmse)) return false;
+	// solve(mask) 剛把這組放進快取（或命中），再找一次不會 miss
+	for (uint8_t i = 0; i < MLAT_CACHE_SIZE; i++) {
+		if (_cacheUsed[i] != 0 && _cache[i].mask == mask) {
+			uint8_t n = refine(_cache[i], d, w, pos, rmse);
+			if (iters != 0) *iters = n;
+			break;
+		}
+	}
+	return true;
+}
+
+float UWBMultilateration::powerWeight(float rxPower, float fpPower, float quality) {
+	float w = (fpPower - MLAT_FP_WEAK_DBM) / (MLAT_FP_GOOD_DBM - MLAT_FP_WEAK_DBM);
+	if (w > 1.0f) w = 1.0f;
+	w *= UWBNlos::weight(rxPower, fpPower, quality);
+	if (w < MLAT_WEIGHT_MIN) w = MLAT_WEIGHT_MIN;
+	return w;
+}
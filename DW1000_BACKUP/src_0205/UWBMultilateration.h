@@ -0,0 +1,119 @@
+/*
+ * @file UWBMultilateration.h
+ * K 個 anchor 的線性最小平方定位（trilat2D_4A / trilat3D_4A 的一般化）
+ *
+ * 方法同原本：以第一個 anchor 的方程式去減其他 anchor，得到 A p = b / 2，
+ *   A 的第 i 列 = a_i - a_0，b_i = d_0^2 - d_i^2 + |a_i|^2 - |a_0|^2
+ * 用 normal equation (A^T A) p = 0.5 A^T b 求解；A^T A 只和「用到哪幾個 anchor」有關，
+ * 所以對每個 anchor 子集合做一次 Cholesky 分解並快取，anchor 組合沒變時每次 solve 只剩兩次三角代換。
+ *
+ * anchor 以 slot（0..MLAT_MAX_ANCHORS-1）編號，一組量測用 bit mask 表示有哪些 slot。
+ * 2D 至少 3 個 anchor，3D 至少 4 個；2D 時 anchor 的 z 只用在 rmse（tag z 視為 0，同 trilat2D_4A）。
+ *
+ * refine()：以線性解為起點，做加權 Gauss-Newton / Levenberg-Marquardt，直接最小化
+ *   sum w_i (d_i - |p - a_i|)^2，不再經過「減 anchor 0」的線性化（那一步會放大雜訊，Z 尤其明顯）。
+ *   權重 w_i 可用 powerWeight(getRXPower(), getFPPower()) 算；迭代次數有上限（setRefineLimits），
+ *   每次迭代是 2K 個 sqrt（Jacobian 與試走一步後的 cost）加一個 3x3 Cholesky。host（x86，-O2）K = 4 時
+ *   每次約 0.3 µs、平均 3..4 次（UWB_Host_Server/UWB_Multilateration_Test.cpp -B）；ESP32 上沒有實測，
+ *   以 240 MHz 單精度 FPU 估大約慢一個數量級（每個 fix 數十 µs 以內），仍遠小於 tag 一輪 ranging 的時間。
+ *
+ * 多執行緒用法（host）：factorize() 和 solve(const MlatFactor&, ...) 都是 const，
+ * 事先分解好的 MlatFactor 可以多個 thread 共用；solve(mask, ...) 會更新快取，只能單一 thread 用。
+ */
+
+#ifndef _UWBMultilateration_H_INCLUDED
+#define _UWBMultilateration_H_INCLUDED
+
+#include <stdint.h>
+
+#ifndef MLAT_MAX_ANCHORS
+#define MLAT_MAX_ANCHORS 16      // slot mask 是 uint16_t
+#endif
+
+#ifndef MLAT_CACHE_SIZE
+#define MLAT_CACHE_SIZE 4        // 快取幾組 anchor 子集合的分解（LRU）
+#endif
+
+#ifndef MLAT_REFINE_MAX_ITER
+#define MLAT_REFINE_MAX_ITER 5   // refine() 預設迭代上限
+#endif
+
+#ifndef MLAT_REFINE_TOL
+#define MLAT_REFINE_TOL 0.001f   // 位移小於 1 mm 就停
+#endif
+
+#if MLAT_MAX_ANCHORS > 16
+#error "MLAT_MAX_ANCHORS must be <= 16"
+#endif
+
+// 某一組 anchor 的分解結果
+struct MlatFactor {
+	uint16_t mask;
+	uint8_t  dim;
+	uint8_t  k;                          // anchor 數
+	uint8_t  slot[MLAT_MAX_ANCHORS];     // mask 展開後的 slot（由小到大，slot[0] 為參考 anchor）
+	float    L[6];                       // A^T A = L L^T，下三角 row-major（2D 只用前 3 個）
+	bool     ok;                         // false = anchor 太少或幾何退化（共線 / 共面）
+};
+
+class UWBMultilateration {
+public:
+	explicit UWBMultilateration(uint8_t dim = 3);
+
+	void setDimension(uint8_t dim);
+	uint8_t getDimension() const { return _dim; }
+	uint8_t minAnchors() const { return _dim + 1; }
+
+	// 設定 / 移除 anchor 座標（m）；會清掉快取
+	bool setAnchor(uint8_t slot, float x, float y, float z);
+	void clearAnchor(uint8_t slot);
+	uint16_t anchorMask() const { return _anchorMask; }
+	const float* anchor(uint8_t slot) const { return _anchor[slot]; }
+
+	// 分解某一組 anchor（不動快取）
+	bool factorize(uint16_t mask, MlatFactor* f) const;
+
+	// d[slot] = 到該 anchor 的距離（m），只讀 f.mask 裡的 slot；pos 一律 3 個元素（2D 時 pos[2] = 0）
+	bool solve(const MlatFactor& f, const float* d, float pos[3], float* rmse) const;
+
+	// 同上，但分解結果從快取拿（anchor 組合沒變就不會重算）
+	bool solve(uint16_t mask, const float* d, float pos[3], float* rmse);
+
+	// 加權非線性精修；pos 進來是起點（通常是 solve() 的結果），出去是精修後的位置。
+	// w[slot] 為 0..1 的權重，w = 0 代表不用 w；回傳實際迭代次數（0 = 沒做，例如 anchor 不夠）
+	uint8_t refine(const MlatFactor& f, const float* d, const float* w, float pos[3], float* rmse) const;
+
+	// solve(mask) + refine()；iters 可為 0
+	bool solveRefined(uint16_t mask, const float* d, const float* w, float pos[3], float* rmse, uint8_t* iters = 0);
+
+	void setRefineLimits(uint8_t maxIter, float tolM) {
+		_refineMaxIter = maxIter;
+		_refineTol = tolM;
+	}
+
+	// 訊號品質 -> 權重：first path 越強越可信（-85 dBm 以上 1.0，-105 dBm 以下 0.1，中間線性）；
+	// 再乘上 UWBNlos::weight()（RX - FP 6..10 dB 之間從 1 降到 NLOS_WEIGHT_MIN），quality 可省略
+	static float powerWeight(float rxPower, float fpPower, float quality = -1.0f);
+
+	// 快取統計（debug 用）
+	uint32_t cacheHits() const { return _hits; }
+	uint32_t cacheMisses() const { return _misses; }
+
+private:
+	uint8_t  _dim;
+	uint16_t _anchorMask;
+	float    _anchor[MLAT_MAX_ANCHORS][3];
+
+	MlatFactor _cache[MLAT_CACHE_SIZE];
+	uint32_t   _cacheUsed[MLAT_CACHE_SIZE];   // 0 = 空
+	uint32_t   _tick;
+	uint32_t   _hits;
+	uint32_t   _misses;
+
+	uint8_t    _refineMaxIter;
+	float      _refineTol;
+
+	void invalidate();
+};
+
+#endif
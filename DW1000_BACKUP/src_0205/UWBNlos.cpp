@@ -0,0 +1,27 @@
+/*
+ * @file UWBNlos.cpp
+ * RX / FP power 的 NLOS 判斷，說明見 UWBNlos.h
+ */
+
+#include "UWBNlos.h"
+
+// x 在 lo..hi 之間線性對應到 0..1（lo > hi 時反過來）
+static float ramp(float x, float lo, float hi) {
+	float t = (x - lo) / (hi - lo);
+	if (t < 0.0f) t = 0.0f;
+	if (t > 1.0f) t = 1.0f;
+	return t;
+}
+
+float UWBNlos::probability(float rxPower, float fpPower, float quality) {
+	float p = ramp(rxPower - fpPower, NLOS_LOS_DB, NLOS_NLOS_DB);
+	if (quality > 0.0f) {
+		const float q = ramp(quality, NLOS_QUALITY_GOOD, NLOS_QUALITY_LOW);
+		if (q > p) p = q;
+	}
+	return p;
+}
+
+float UWBNlos::weight(float rxPower, float fpPower, float quality) {
+	return 1.0f - probability(rxPower, fpPower, quality) * (1.0f - NLOS_WEIGHT_MIN);
+}
@@ -0,0 +1,56 @@
+/*
+ * @file UWBNlos.h
+ * 用 RX power 和 first-path power 的差判斷一筆 range 是不是 NLOS，轉成 0..1 的可信度權重
+ *
+ * LOS 時能量大多集中在 first path，RX - FP 只有幾 dB；first path 被擋（人、牆）時
+ * 主要能量來自反射，RX - FP 變大，而且 range 通常偏長（走的是反射路徑）。
+ * DW1000 應用文件的經驗值：RX - FP < 6 dB 多半是 LOS，> 10 dB 多半是 NLOS，中間線性內插成機率。
+ *
+ * 另外可選用 CIR 特徵：getReceiveQuality()（FP_AMPL2 / STD_NOISE，first path 振幅相對雜訊），
+ * 太低代表 first path 幾乎埋在雜訊裡，leading edge 容易抓錯；兩個特徵取較大的 NLOS 機率。
+ * quality <= 0 當作沒有（tag 端從 RANGE_REPORT 只拿得到 RX / FP）。
+ *
+ * 權重：weight = 1 - p * (1 - NLOS_WEIGHT_MIN)；UWBMultilateration::powerWeight() 和
+ * UWBKalman::updateRange() 的 weight 都從這裡來。
+ */
+
+#ifndef _UWBNlos_H_INCLUDED
+#define _UWBNlos_H_INCLUDED
+
+#include <stdint.h>
+
+#ifndef NLOS_LOS_DB
+#define NLOS_LOS_DB 6.0f           // RX - FP 小於等於這個：p = 0
+#endif
+
+#ifndef NLOS_NLOS_DB
+#define NLOS_NLOS_DB 10.0f         // RX - FP 大於等於這個：p = 1
+#endif
+
+#ifndef NLOS_QUALITY_LOW
+#define NLOS_QUALITY_LOW 2.0f      // FP_AMPL2 / STD_NOISE 小於等於這個：p = 1
+#endif
+
+#ifndef NLOS_QUALITY_GOOD
+#define NLOS_QUALITY_GOOD 6.0f     // 大於等於這個：CIR 特徵不加分
+#endif
+
+#ifndef NLOS_WEIGHT_MIN
+#define NLOS_WEIGHT_MIN 0.1f       // 確定是 NLOS 的權重（不給 0，anchor 不夠時仍可解）
+#endif
+
+class UWBNlos {
+public:
+	// NLOS 機率 0..1；quality 可省略
+	static float probability(float rxPower, float fpPower, float quality = -1.0f);
+
+	// 可信度權重 NLOS_WEIGHT_MIN..1
+	static float weight(float rxPower, float fpPower, float quality = -1.0f);
+
+	// p >= 0.5 視為 NLOS（印 log / 統計用）
+	static bool isNlos(float rxPower, float fpPower, float quality = -1.0f) {
+		return probability(rxPower, fpPower, quality) >= 0.5f;
+	}
+};
+
+#endif
@@ -0,0 +1,116 @@
+/*
+ * @file UWBRangeBuffer.cpp
+ * 每個 anchor 的 range 歷史與時間對齊，說明見 UWBRangeBuffer.h
+ */
+
+#include <string.h>
+
+#include "UWBRangeBuffer.h"
+
+UWBRangeBuffer::UWBRangeBuffer() {
+	_maxAge = RB_DEFAULT_MAX_AGE;
+	clear();
+}
+
+void UWBRangeBuffer::clear() {
+	memset(_a, 0, sizeof(_a));
+	_latest = 0;
+	_hasLatest = false;
+}
+
+void UWBRangeBuffer::clear(uint8_t slot) {
+	if (slot >= RB_MAX_ANCHORS) return;
+	memset(&_a[slot], 0, sizeof(Anchor));
+}
+
+float UWBRangeBuffer::elapsed(uint64_t a, uint64_t b) {
+	uint64_t d = (a - b) & RB_TIME_MASK;
+	int64_t s = (d & 0x8000000000ULL) ? (int64_t)d - (int64_t)(RB_TIME_MASK + 1) : (int64_t)d;
+	return (float)((double)s * RB_TICK_SECONDS);
+}
+
+// 時間原點移到 newBase：t' = t - D，sum 跟著平移（O(1)）
+void UWBRangeBuffer::rebase(Anchor& a, uint64_t newBase) {
+	const float D = elapsed(newBase, a.base);
+	const float n = (float)a.n;
+	a.stt = a.stt - 2.0f * D * a.st + n * D * D;
+	a.str = a.str - D * a.sr;
+	a.st  = a.st - n * D;
+	a.base = newBase;
+}
+
+bool UWBRangeBuffer::push(uint8_t slot, uint64_t dwTime, float range) {
+	if (slot >= RB_MAX_ANCHORS) return false;
+	dwTime &= RB_TIME_MASK;
+	Anchor& a = _a[slot];
+
+	if (a.n > 0) {
+		float gap = elapsed(dwTime, a.base);
+		// 時間倒退（重複 / 亂序）或停了太久：舊的視窗不能用
+		if (gap <= 0.0f || gap > _maxAge) memset(&a, 0, sizeof(Anchor));
+	}
+	if (a.n == 0) {
+		a.base = dwTime;
+	} else {
+		rebase(a, dwTime);
+	}
+
+	if (a.n == RB_HISTORY) {
+		// 移除最舊的一筆（就是這次要覆蓋的位置）
+		const float t = elapsed(a.t[a.head], a.base);
+		const float r = a.r[a.head];
+		a.st -= t;
+		a.sr -= r;
+		a.stt -= t * t;
+		a.str -= t * r;
+		a.n--;
+	}
+	// 新的一筆 t = 0（就是 base）
+	a.t[a.head] = dwTime;
+	a.r[a.head] = range;
+	a.head = (a.head + 1) % RB_HISTORY;
+	a.n++;
+	a.sr += range;
+
+	if (a.head == 0) {
+		// 每繞一圈用存著的樣本重算一次 sums，float 加加減減的誤差不會一直累積（平均每筆仍是 O(1)）
+		a.st = a.sr = a.stt = a.str = 0.0f;
+		for (uint8_t i = 0; i < a.n; i++) {
+			const float t = elapsed(a.t[i], a.base);
+			a.st += t;
+			a.sr += a.r[i];
+			a.stt += t * t;
+			a.str += t * a.r[i];
+		}
+	}
+
+	if (!_hasLatest || elapsed(dwTime, _latest) > 0.0f) {
+		_latest = dwTime;
+		_hasLatest = true;
+	}
+	return true;
+}
+
+uint16_t UWBRangeBuffer::alignTo(uint64_t epoch, float* d) const {
+	uint16_t mask = 0;
+	for (uint8_t s = 0; s < RB_MAX_ANCHORS; s++) {
+		const Anchor& a = _a[s];
+		if (a.n == 0) continue;
+		const float te = elapsed(epoch, a.base);   // epoch 相對最新一筆（通常 >= 0）
+		if (te > _maxAge || te < -_maxAge) continue;
+
+		const float n = (float)a.n;
+		const float last = a.r[(a.head + RB_HISTORY - 1) % RB_HISTORY];
+		float den = n * a.stt - a.st * a.st;
+		if (a.n < 2 || den <= 1.0e-9f) {
+			d[s] = last;   // 只有一筆（或時間都一樣）：不外插
+		} else {
+			float slope = (n * a.str - a.st * a.sr) / den;
+			if (slope > RB_MAX_SPEED) slope = RB_MAX_SPEED;
+			if (slope < -RB_MAX_SPEED) slope = -RB_MAX_SPEED;
+			d[s] = a.sr / n + slope * (te - a.st / n);
+		}
+		mask |= (uint16_t)(1u << s);
+	}
+	return mask;
+}
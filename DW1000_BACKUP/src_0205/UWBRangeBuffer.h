@@ -0,0 +1,78 @@
+/*
+ * @file UWBRangeBuffer.h
+ * 每個 anchor 保留最近幾筆 range（含 DW1000 timestamp），解算前把所有 anchor 的距離外插到同一個時間點
+ *
+ * 原本 tag 只記「每個 anchor 最後一筆距離」，只要都還沒超過 ANCHOR_DISTANCE_EXPIRED（5 s）就拿來解，
+ * 移動中的 tag 這幾筆距離可能差好幾秒。這裡每個 anchor 存最近 RB_HISTORY 筆，
+ * 對 range(t) 做滑動視窗的線性最小平方（running sums，每筆 O(1) 加入 / 移除），
+ * alignTo(epoch) 用擬合的直線把每個 anchor 的距離推到同一個 epoch。
+ *
+ * 時間用 DW1000 40-bit timestamp（1 tick = 1 / (128 * 499.2 MHz) ≈ 15.65 ps，約 17.2 s 繞回一次）；
+ * 相減一律取 40-bit 差再轉成有號數，所以繞回不影響（前提是 maxAge 遠小於 17 s）。
+ * 記憶體固定：RB_MAX_ANCHORS x RB_HISTORY 筆。
+ */
+
+#ifndef _UWBRangeBuffer_H_INCLUDED
+#define _UWBRangeBuffer_H_INCLUDED
+
+#include <stdint.h>
+
+#ifndef RB_MAX_ANCHORS
+#define RB_MAX_ANCHORS 8
+#endif
+
+#ifndef RB_HISTORY
+#define RB_HISTORY 4             // 每個 anchor 的視窗長度（筆）
+#endif
+
+#ifndef RB_DEFAULT_MAX_AGE
+#define RB_DEFAULT_MAX_AGE 0.5f  // 秒：比 epoch 舊這麼多的 anchor 不用；視窗內相隔這麼久也會重來
+#endif
+
+#ifndef RB_MAX_SPEED
+#define RB_MAX_SPEED 5.0f        // m/s：擬合出來的距離變化率上限（雜訊造成的斜率不會外插太遠）
+#endif
+
+#define RB_TICK_SECONDS 1.5650040064103e-11   // DW1000 timestamp 1 tick（秒）
+#define RB_TIME_MASK    0xFFFFFFFFFFULL       // 40 bits
+
+class UWBRangeBuffer {
+public:
+	UWBRangeBuffer();
+
+	void setMaxAge(float seconds) { _maxAge = seconds; }
+	void clear();
+	void clear(uint8_t slot);
+
+	// 加入一筆：slot = anchor 編號（0..RB_MAX_ANCHORS-1），dwTime = 這筆 range 的 DW1000 timestamp
+	bool push(uint8_t slot, uint64_t dwTime, float range);
+
+	// 所有 anchor 裡最新的 timestamp（通常當 epoch 用）
+	uint64_t latest() const { return _latest; }
+
+	// 把每個 anchor 的距離外插到 epoch，寫進 d[slot]；回傳有效的 slot mask
+	// （最新一筆比 epoch 舊超過 maxAge 的 anchor 不算）
+	uint16_t alignTo(uint64_t epoch, float* d) const;
+
+	// 兩個 40-bit timestamp 的差（a - b，秒），處理繞回
+	static float elapsed(uint64_t a, uint64_t b);
+
+private:
+	struct Anchor {
+		uint64_t t[RB_HISTORY];   // 原始 timestamp
+		float    r[RB_HISTORY];
+		uint8_t  head;            // 下一筆寫入位置
+		uint8_t  n;
+		uint64_t base;            // running sums 的時間原點（= 最新一筆）
+		float    st, sr, stt, str;   // sum t, sum r, sum t^2, sum t*r（t 相對 base，秒）
+	};
+
+	Anchor   _a[RB_MAX_ANCHORS];
+	uint64_t _latest;
+	bool     _hasLatest;
+	float    _maxAge;
+
+	static void rebase(Anchor& a, uint64_t newBase);
+};
+
+#endif
@@ -0,0 +1,111 @@
+/*
+ * @file UWBTelemetry.cpp
+ * 二進位遙測格式編解碼，格式見 UWBTelemetry.h
+ */
+
+#include "UWBTelemetry.h"
+
+static inline void put16(uint8_t* p, uint16_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put32(uint8_t* p, uint32_t v)
+{
+	for (uint8_t i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static inline uint16_t get16(const uint8_t* p)
+{
+	return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+static inline uint32_t get32(const uint8_t* p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void uwbTelemetryPutHeader(uint8_t* buf, const UWBTelemetryHeader* h)
+{
+	buf[0] = UWB_TELEM_MAGIC0;
+	buf[1] = UWB_TELEM_MAGIC1;
+	buf[2] = UWB_TELEM_VERSION;
+	buf[3] = h->count;
+	put16(&buf[4], h->tagId);
+	put32(&buf[6], h->seq);
+	for (uint8_t i = 0; i < 5; i++) buf[10 + i] = (uint8_t)(h->dwTime >> (8 * i)); // 40-bit
+	buf[15] = h->flags;
+}
+
+void uwbTelemetryPutRecord(uint8_t* buf, uint8_t i, const UWBTelemetryRecord* r)
+{
+	uint8_t* p = buf + UWB_TELEM_LEN(i);
+	put16(&p[0], r->anchor);
+	put32(&p[2], (uint32_t)r->rangeMm);
+	put16(&p[6], (uint16_t)r->rxPower);
+	put16(&p[8], (uint16_t)r->fpPower);
+}
+
+int uwbTelemetryEncode(const UWBTelemetryHeader* h, const UWBTelemetryRecord* r, uint8_t n,
+                       uint8_t* buf, size_t len)
+{
+	if (buf == NULL || len < (size_t)UWB_TELEM_LEN(n))
+		return -1;
+
+	UWBTelemetryHeader hh = *h;
+	hh.count = n;
+	for (uint8_t i = 0; i < n; i++)
+		uwbTelemetryPutRecord(buf, i, &r[i]);
+	uwbTelemetryPutHeader(buf, &hh);
+	return UWB_TELEM_LEN(n);
+}
+
+int uwbTelemetryDecodeHeader(const uint8_t* buf, size_t len, UWBTelemetryHeader* h)
+{
+	if (len < UWB_TELEM_HEADER_LEN)
+		return UWB_TELEM_ERR_SHORT;
+	if (buf[0] != UWB_TELEM_MAGIC0 || buf[1] != UWB_TELEM_MAGIC1)
+		return UWB_TELEM_ERR_MAGIC;
+	if (buf[2] != UWB_TELEM_VERSION)
+		return UWB_TELEM_ERR_VERSION;
+
+	h->version = buf[2];
+	h->count   = buf[3];
+	h->tagId   = get16(&buf[4]);
+	h->seq     = get32(&buf[6]);
+	h->dwTime  = 0;
+	for (uint8_t i = 0; i < 5; i++) h->dwTime |= (uint64_t)buf[10 + i] << (8 * i);
+	h->flags   = buf[15];
+
+	if (len < (size_t)UWB_TELEM_LEN(h->count))
+		return UWB_TELEM_ERR_SHORT;
+	return UWB_TELEM_OK;
+}
+
+void uwbTelemetryGetRecord(const uint8_t* buf, uint8_t i, UWBTelemetryRecord* r)
+{
+	const uint8_t* p = buf + UWB_TELEM_LEN(i);
+	r->anchor  = get16(&p[0]);
+	r->rangeMm = (int32_t)get32(&p[2]);
+	r->rxPower = (int16_t)get16(&p[6]);
+	r->fpPower = (int16_t)get16(&p[8]);
+}
+
+int32_t uwbTelemetryMeterToMm(float m)
+{
+	float mm = m * 1000.0f;
+	if (mm != mm) return UWB_TELEM_RANGE_INVALID;   // NaN：轉型是 undefined behavior
+	if (mm >= 2147483647.0f) return INT32_MAX;
+	if (mm <= -2147483647.0f) return INT32_MIN + 1;
+	return (int32_t)(mm + (mm >= 0 ? 0.5f : -0.5f));
+}
+
+int16_t uwbTelemetryDbmToCenti(float dbm)
+{
+	float c = dbm * 100.0f;
+	if (c != c) return UWB_TELEM_POWER_INVALID;
+	if (c >= 32767.0f) return INT16_MAX;
+	if (c <= -32767.0f) return INT16_MIN + 1;
+	return (int16_t)(c + (c >= 0 ? 0.5f : -0.5f));
+}
@@ -0,0 +1,74 @@
+/*
+ * @file UWBTelemetry.h
+ * TAG -> host 的二進位 UDP 遙測格式（取代 JSON 文字），tag 韌體與 host 程式共用同一份編解碼
+ *
+ * 一個 datagram = header(16) + count * record(10)，全部 little-endian：
+ *   header : [magic 'U' 'W'][version:1][count:1][tagId:2][seq:4][dwTime:5][flags:1]
+ *   record : [anchor:2][range_mm:4 signed][rx_cdBm:2 signed][fp_cdBm:2 signed]
+ * dwTime 是 DW1000 40-bit 系統時間（15.65 ps/tick），host 可用來排序與對齊；
+ * 功率以 0.01 dBm 為單位。3 個 anchor = 46 bytes（同內容 JSON 約 110 bytes）。
+ * range_mm 和 JSON 的 R 一樣是 tag 端 link 表的 range[0]（最近 3 筆平均），不是單筆原始距離。
+ *
+ * 不依賴 Arduino，host 端直接和這兩個檔案一起編譯即可解碼。
+ */
+
+#ifndef _UWBTelemetry_H_INCLUDED
+#define _UWBTelemetry_H_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define UWB_TELEM_MAGIC0      'U'
+#define UWB_TELEM_MAGIC1      'W'
+#define UWB_TELEM_VERSION     1
+#define UWB_TELEM_HEADER_LEN  16
+#define UWB_TELEM_RECORD_LEN  10
+#define UWB_TELEM_MAX_RECORDS 255
+#define UWB_TELEM_LEN(n)      (UWB_TELEM_HEADER_LEN + (n) * UWB_TELEM_RECORD_LEN)
+
+// 解碼錯誤碼
+#define UWB_TELEM_OK           0
+#define UWB_TELEM_ERR_SHORT   -1   // 長度不足
+#define UWB_TELEM_ERR_MAGIC   -2   // 不是遙測封包（例如舊版 JSON）
+#define UWB_TELEM_ERR_VERSION -3   // 不支援的版本
+
+// 沒有值（float 是 NaN）時填的 sentinel；正常值飽和在 MIN + 1 .. MAX，不會和它撞
+#define UWB_TELEM_RANGE_INVALID INT32_MIN
+#define UWB_TELEM_POWER_INVALID INT16_MIN
+
+struct UWBTelemetryHeader
+{
+	uint8_t  version;
+	uint8_t  count;    // record 數
+	uint16_t tagId;    // tag short address
+	uint32_t seq;      // 每送一個 datagram +1，host 用來算掉包
+	uint64_t dwTime;   // DW1000 40-bit timestamp
+	uint8_t  flags;    // 保留，目前為 0
+};
+
+struct UWBTelemetryRecord
+{
+	uint16_t anchor;   // anchor short address
+	int32_t  rangeMm;
+	int16_t  rxPower;  // 0.01 dBm
+	int16_t  fpPower;  // 0.01 dBm
+};
+
+// 編碼：header.count 由 n 決定；回傳寫入 bytes，buffer 不夠回傳 -1
+int uwbTelemetryEncode(const UWBTelemetryHeader* h, const UWBTelemetryRecord* r, uint8_t n,
+                       uint8_t* buf, size_t len);
+// 寫入單一 record（tag 邊收邊填用）；i 從 0 開始，buf 指向 datagram 起點
+void uwbTelemetryPutRecord(uint8_t* buf, uint8_t i, const UWBTelemetryRecord* r);
+// 寫入 header（record 全部填完再寫，count 才正確）
+void uwbTelemetryPutHeader(uint8_t* buf, const UWBTelemetryHeader* h);
+
+// 解碼 header，並確認 len 足夠放 count 筆 record；回傳 UWB_TELEM_OK 或錯誤碼
+int uwbTelemetryDecodeHeader(const uint8_t* buf, size_t len, UWBTelemetryHeader* h);
+// 解碼第 i 筆 record（呼叫前需先通過 uwbTelemetryDecodeHeader）
+void uwbTelemetryGetRecord(const uint8_t* buf, uint8_t i, UWBTelemetryRecord* r);
+
+// float 換算（tag 端）：超出範圍時飽和到 MIN + 1 .. MAX，NaN 回 UWB_TELEM_RANGE_INVALID / UWB_TELEM_POWER_INVALID
+int32_t uwbTelemetryMeterToMm(float m);
+int16_t uwbTelemetryDbmToCenti(float dbm);
+
+#endif
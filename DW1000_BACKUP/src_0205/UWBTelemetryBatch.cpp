@@ -0,0 +1,118 @@
+/*
+ * @file UWBTelemetryBatch.cpp
+ * TAG 端遙測批次，說明見 UWBTelemetryBatch.h
+ */
+
+#include "UWBTelemetryBatch.h"
+
+UWBTelemetryBatch::UWBTelemetryBatch() {
+	_tagId = 0;
+	_maxRecords   = UWB_BATCH_DEFAULT_RECORDS;
+	_maxAgeMs     = UWB_BATCH_DEFAULT_AGE_MS;
+	_flushOnRound = true;
+	_roundSize    = 0;
+	begin(0);
+}
+
+void UWBTelemetryBatch::begin(uint16_t tagId) {
+	_tagId      = tagId;
+	_head       = 0;
+	_count      = 0;
+	_roundCount = 0;
+	_roundEnd   = 0;
+	_seq        = 0;
+	_dropped    = 0;
+}
+
+void UWBTelemetryBatch::setFlushPolicy(uint8_t maxRecords, uint16_t maxAgeMs, bool flushOnRound) {
+	_maxRecords   = maxRecords;
+	_maxAgeMs     = maxAgeMs;
+	_flushOnRound = flushOnRound;
+}
+
+void UWBTelemetryBatch::setRoundSize(uint8_t anchors) {
+	_roundSize = (anchors > UWB_BATCH_MAX_ROUND) ? UWB_BATCH_MAX_ROUND : anchors;
+}
+
+bool UWBTelemetryBatch::push(const UWBTelemetryRecord* r, uint32_t nowMs, uint64_t dwTime) {
+	bool kept = true;
+	if (_count == UWB_BATCH_CAPACITY) {
+		// 滿了：丟最舊的（新資料比較有價值）
+		_head = (uint8_t)((_head + 1) % UWB_BATCH_CAPACITY);
+		_count--;
+		_dropped++;
+		if (_roundEnd > 0) _roundEnd--;
+		kept = false;
+	}
+	uint8_t i = (uint8_t)((_head + _count) % UWB_BATCH_CAPACITY);
+	_ring[i]   = *r;
+	_ms[i]     = nowMs;
+	_dwTime[i] = dwTime;
+	_count++;
+
+	// 一輪結束判斷：同一個 anchor 再出現 -> 上一輪已結束；或已收滿 roundSize 個 anchor
+	bool seen = false;
+	for (uint8_t k = 0; k < _roundCount; k++) {
+		if (_round[k] == r->anchor) {
+			seen = true;
+			break;
+		}
+	}
+	if (seen) {
+		_roundEnd   = (uint8_t)(_count - 1);   // 新的這筆屬於下一輪
+		_roundCount = 0;
+	}
+	if (_roundCount < UWB_BATCH_MAX_ROUND) {
+		_round[_roundCount++] = r->anchor;
+	}
+	if (_roundSize > 0 && _roundCount >= _roundSize) {
+		_roundEnd   = _count;
+		_roundCount = 0;
+	}
+	return kept;
+}
+
+bool UWBTelemetryBatch::due(uint32_t nowMs) const {
+	if (_count == 0) {
+		return false;
+	}
+	if (_maxRecords > 0 && _count >= _maxRecords) {
+		return true;
+	}
+	if (_maxAgeMs > 0 && (uint32_t)(nowMs - _ms[_head]) >= _maxAgeMs) {
+		return true;
+	}
+	return _flushOnRound && _roundEnd > 0;
+}
+
+int UWBTelemetryBatch::flush(uint8_t* buf, size_t len) {
+	if (_count == 0) {
+		return 0;
+	}
+	if (len < (size_t)UWB_TELEM_LEN(1)) {
+		return -1;
+	}
+
+	uint8_t n = _count;
+	if (_maxRecords > 0 && n > _maxRecords) n = _maxRecords;
+	if (_flushOnRound && _roundEnd > 0 && n > _roundEnd) n = _roundEnd; // 只送完整的一輪
+	while (n > 0 && len < (size_t)UWB_TELEM_LEN(n)) n--;
+
+	UWBTelemetryHeader h;
+	h.version = UWB_TELEM_VERSION;
+	h.count   = n;
+	h.tagId   = _tagId;
+	h.seq     = _seq++;
+	h.dwTime  = _dwTime[_head];
+	h.flags   = 0;
+
+	for (uint8_t k = 0; k < n; k++) {
+		uwbTelemetryPutRecord(buf, k, &_ring[(_head + k) % UWB_BATCH_CAPACITY]);
+	}
+	uwbTelemetryPutHeader(buf, &h);
+
+	_head  = (uint8_t)((_head + n) % UWB_BATCH_CAPACITY);
+	_count = (uint8_t)(_count - n);
+	_roundEnd = (_roundEnd > n) ? (uint8_t)(_roundEnd - n) : 0;
+	return UWB_TELEM_LEN(n);
+}
@@ -0,0 +1,70 @@
+/*
+ * @file UWBTelemetryBatch.h
+ * TAG 端遙測批次：newRange() 只把 record 放進 ring（不碰網路），loop() 再依 flush 條件打包送出
+ *
+ * flush 條件（任一成立）：
+ *   - size  ：待送筆數 >= maxRecords
+ *   - age   ：最舊一筆已等待 >= maxAgeMs
+ *   - round ：一輪 ranging 完成（所有 anchor 都回報過一次；同一個 anchor 再次出現也視為新的一輪）
+ * ring 滿了就丟最舊的一筆並計數（getDropped），不會擋住 ranging。
+ */
+
+#ifndef _UWBTelemetryBatch_H_INCLUDED
+#define _UWBTelemetryBatch_H_INCLUDED
+
+#include "UWBTelemetry.h"
+
+// ring 容量（筆）
+#ifndef UWB_BATCH_CAPACITY
+#define UWB_BATCH_CAPACITY 32
+#endif
+// 一輪最多追蹤幾個 anchor
+#ifndef UWB_BATCH_MAX_ROUND
+#define UWB_BATCH_MAX_ROUND 16
+#endif
+// 預設 flush 條件：最多 16 筆 / 100 ms（與舊版固定 100 ms 送一次相同）/ 每輪完成就送
+#define UWB_BATCH_DEFAULT_RECORDS 16
+#define UWB_BATCH_DEFAULT_AGE_MS  100
+
+class UWBTelemetryBatch {
+public:
+	UWBTelemetryBatch();
+
+	void begin(uint16_t tagId);
+	// maxRecords = 0 表示不用 size 條件；maxAgeMs = 0 表示不用 age 條件
+	void setFlushPolicy(uint8_t maxRecords, uint16_t maxAgeMs, bool flushOnRound);
+	// 目前 anchor 數（0 = 只靠「anchor 重複出現」判斷一輪結束）
+	void setRoundSize(uint8_t anchors);
+
+	// ranging callback 裡呼叫：只做複製，O(1)；ring 滿時丟最舊一筆並回傳 false
+	bool push(const UWBTelemetryRecord* r, uint32_t nowMs, uint64_t dwTime);
+	// loop() 裡呼叫
+	bool due(uint32_t nowMs) const;
+	// 打包最多 maxRecords 筆（buffer 放不下就更少）；回傳 datagram bytes，沒資料回傳 0
+	int  flush(uint8_t* buf, size_t len);
+
+	uint8_t  getPending() const { return _count; }
+	uint32_t getDropped() const { return _dropped; }
+	uint32_t getSeq() const { return _seq; }
+
+private:
+	UWBTelemetryRecord _ring[UWB_BATCH_CAPACITY];
+	uint32_t _ms[UWB_BATCH_CAPACITY];       // push 時間（age 條件用）
+	uint64_t _dwTime[UWB_BATCH_CAPACITY];   // DW1000 時間（datagram header 用第一筆的）
+	uint8_t  _head;                         // 最舊一筆
+	uint8_t  _count;
+
+	uint16_t _round[UWB_BATCH_MAX_ROUND];   // 這一輪已回報的 anchor
+	uint8_t  _roundCount;
+	uint8_t  _roundSize;
+	uint8_t  _roundEnd;                     // 已完成的輪次佔 ring 前幾筆（0 = 還沒有完成的輪）
+
+	uint16_t _tagId;
+	uint32_t _seq;
+	uint32_t _dropped;
+	uint8_t  _maxRecords;
+	uint16_t _maxAgeMs;
+	bool     _flushOnRound;
+};
+
+#endif
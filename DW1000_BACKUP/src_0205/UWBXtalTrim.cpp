@@ -0,0 +1,155 @@
+/*
+ * @file UWBXtalTrim.cpp
+ * crystal trim 自動調整，說明見 UWBXtalTrim.h
+ */
+
+#include <math.h>
+
+#include "UWBXtalTrim.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Preferences.h>   // NVS
+#elif !defined(ARDUINO)
+#include <stdio.h>         // host：用檔案模擬 NVS
+#endif
+
+void UWBXtalTrim::begin(uint8_t trim, bool stored) {
+	_trim = (trim > XTAL_TRIM_MAX) ? XTAL_TRIM_MAX : trim;
+	_stored = stored ? _trim : 0xFF;
+	_locked = false;
+	_skip = XTAL_TRIM_SETTLE;
+	_n = 0;
+	_sum = 0.0f;
+	_lastAvg = 0.0f;
+	_prevAvg = 0.0f;
+	_prevStep = 0;
+	_ppmPerStep = XTAL_TRIM_PPM_PER_STEP;
+}
+
+bool UWBXtalTrim::update(float ppm) {
+	if (_skip > 0) {
+		_skip--;
+		return false;
+	}
+	_sum += ppm;
+	if (++_n < XTAL_TRIM_WINDOW) return false;
+
+	const float avg = _sum / (float)_n;
+	_n = 0;
+	_sum = 0.0f;
+	_lastAvg = avg;
+
+	// 上次調整的效果 -> 重新估斜率（secant）；雜訊太大（變化不到 0.3 格）就不更新
+	if (_prevStep != 0) {
+		const float slope = (avg - _prevAvg) / (float)_prevStep;
+		if (fabsf(slope) > 0.3f * XTAL_TRIM_PPM_PER_STEP) {
+			float s = fabsf(slope);
+			if (s > 3.0f * XTAL_TRIM_PPM_PER_STEP) s = 3.0f * XTAL_TRIM_PPM_PER_STEP;
+			if ((slope > 0.0f) == (_ppmPerStep > 0.0f)) {
+				_ppmPerStep = 0.5f * (_ppmPerStep + (slope > 0.0f ? s : -s));
+			} else {
+				_ppmPerStep = (slope > 0.0f) ? s : -s;   // 方向估反了
+			}
+		}
+		_prevStep = 0;
+	}
+
+	const float mag = fabsf(avg);
+	if (_locked) {
+		if (mag <= XTAL_TRIM_ENTER_PPM) return false;
+		_locked = false;
+	} else if (mag <= XTAL_TRIM_EXIT_PPM) {
+		_locked = true;
+		return false;
+	}
+
+	// 讓 avg 變成 0 要調幾格
+	int step = (int)lroundf(-avg / _ppmPerStep);
+	if (step == 0) step = ((-avg / _ppmPerStep) > 0.0f) ? 1 : -1;
+	if (step > XTAL_TRIM_MAX_STEP) step = XTAL_TRIM_MAX_STEP;
+	if (step < -XTAL_TRIM_MAX_STEP) step = -XTAL_TRIM_MAX_STEP;
+	int next = (int)_trim + step;
+	if (next < 0) next = 0;
+	if (next > XTAL_TRIM_MAX) next = XTAL_TRIM_MAX;
+	if (next == (int)_trim) return false;   // 已經到邊界
+
+	_prevStep = (int8_t)(next - (int)_trim);
+	_prevAvg = avg;
+	_trim = (uint8_t)next;
+	_skip = XTAL_TRIM_SETTLE;
+	return true;
+}
+
+bool UWBXtalTrim::storeIfChanged() {
+	if (!_locked || _trim == _stored) return false;
+	if (!store(_trim)) return false;
+	_stored = _trim;
+	return true;
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+bool UWBXtalTrim::load(uint8_t* trim) {
+	Preferences prefs;
+	if (!prefs.begin(XTAL_TRIM_NVS_NAMESPACE, true)) {
+		return false;
+	}
+	uint8_t v = prefs.getUChar(XTAL_TRIM_NVS_KEY, 0xFF);
+	prefs.end();
+	if (v > XTAL_TRIM_MAX) {
+		return false;
+	}
+	*trim = v;
+	return true;
+}
+
+bool UWBXtalTrim::store(uint8_t trim) {
+	Preferences prefs;
+	if (!prefs.begin(XTAL_TRIM_NVS_NAMESPACE, false)) {
+		return false;
+	}
+	size_t n = prefs.putUChar(XTAL_TRIM_NVS_KEY, trim);
+	prefs.end();
+	return n == 1;
+}
+
+#elif !defined(ARDUINO)
+
+// host：檔案內容就是 1 byte 的 trim
+bool UWBXtalTrim::load(uint8_t* trim) {
+	FILE* f = fopen(XTAL_TRIM_FILE, "rb");
+	if (f == NULL) {
+		return false;
+	}
+	int v = fgetc(f);
+	fclose(f);
+	if (v < 0 || v > XTAL_TRIM_MAX) {
+		return false;
+	}
+	*trim = (uint8_t)v;
+	return true;
+}
+
+bool UWBXtalTrim::store(uint8_t trim) {
+	FILE* f = fopen(XTAL_TRIM_FILE, "wb");
+	if (f == NULL) {
+		return false;
+	}
+	bool ok = fputc(trim, f) == trim;
+	return (fclose(f) == 0) && ok;
+}
+
+#else
+
+// 其他 Arduino 平台沒有 NVS：不保存，每次開機重新調
+bool UWBXtalTrim::load(uint8_t* trim) {
+	(void)trim;
+	return false;
+}
+
+bool UWBXtalTrim::store(uint8_t trim) {
+	(void)trim;
+	return false;
+}
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ * @file UWBXtalTrim.h
+ * 自動調整 DW1000 crystal trim（FS_XTALT，0..31），讓自己的時鐘對齊 reference anchor
+ *
+ * 輸入：每收到 reference anchor 一個封包，用 carrier integrator 量到的「reference 相對自己」ppm
+ *   （DW1000Class::getClockOffsetPpm()）。trim 加 1 約讓自己慢 XTAL_TRIM_PPM_PER_STEP ppm，
+ *   也就是量到的 ppm 變大；實際斜率每顆 crystal 不同，每次調整後用前後兩個視窗的平均重新估（secant），
+ *   方向估反了也會自己修正。
+ *
+ * 流程：
+ *   - 每次 trim 改變後先丟掉 XTAL_TRIM_SETTLE 筆（PLL / integrator 重新收斂），再收 XTAL_TRIM_WINDOW 筆取平均
+ *   - |平均| > XTAL_TRIM_ENTER_PPM 才調（hysteresis：已經 lock 時要超過 ENTER 才重新開始調，
+ *     調整中要降到 XTAL_TRIM_EXIT_PPM 以內才算 lock），一次最多 XTAL_TRIM_MAX_STEP 格
+ *   - lock 後 trim 和已儲存的不同才寫回（ESP32 = NVS，host = 檔案），不會每個視窗都寫 flash
+ *
+ * 只有計算和儲存；寫暫存器由呼叫端做（DW1000Ranging::useXtalTrim() 會接好）。
+ */
+
+#ifndef _UWBXtalTrim_H_INCLUDED
+#define _UWBXtalTrim_H_INCLUDED
+
+#include <stdint.h>
+
+#define XTAL_TRIM_MAX      31
+#define XTAL_TRIM_DEFAULT  0x10          // OTP 沒有值時 DW1000Class::tune() 用的中間值
+
+#ifndef XTAL_TRIM_PPM_PER_STEP
+#define XTAL_TRIM_PPM_PER_STEP 1.5f      // 典型值（datasheet：約 ±25 ppm / 32 格）
+#endif
+
+#ifndef XTAL_TRIM_WINDOW
+#define XTAL_TRIM_WINDOW 16              // 幾筆平均一次
+#endif
+
+#ifndef XTAL_TRIM_SETTLE
+#define XTAL_TRIM_SETTLE 2               // trim 改變後丟掉的筆數
+#endif
+
+#ifndef XTAL_TRIM_ENTER_PPM
+#define XTAL_TRIM_ENTER_PPM 1.0f         // lock 中超過這個才重新調
+#endif
+
+#ifndef XTAL_TRIM_EXIT_PPM
+#define XTAL_TRIM_EXIT_PPM 0.8f          // 調整中降到這個以內就 lock（要 > 半格，否則可能一直來回）
+#endif
+
+#ifndef XTAL_TRIM_MAX_STEP
+#define XTAL_TRIM_MAX_STEP 3
+#endif
+
+#ifndef XTAL_TRIM_NVS_NAMESPACE
+#define XTAL_TRIM_NVS_NAMESPACE "uwb_xtal"
+#endif
+#ifndef XTAL_TRIM_NVS_KEY
+#define XTAL_TRIM_NVS_KEY "trim"
+#endif
+#ifndef XTAL_TRIM_FILE
+#define XTAL_TRIM_FILE "uwb_xtal_trim.bin"
+#endif
+
+class UWBXtalTrim {
+public:
+	UWBXtalTrim() { begin(XTAL_TRIM_DEFAULT); }
+
+	// 目前 chip 上的 trim（通常是 load() 回來的值或 OTP 值）；stored = 這個值已經存過了
+	void begin(uint8_t trim, bool stored = false);
+
+	// 加入一筆 reference 相對自己的 ppm；trim 需要改變時回傳 true，新值在 trim()
+	bool update(float ppm);
+
+	uint8_t trim() const { return _trim; }
+	bool    isLocked() const { return _locked; }
+	float   lastAverage() const { return _lastAvg; }   // 最近一個視窗的平均 ppm
+	float   ppmPerStep() const { return _ppmPerStep; }
+
+	// lock 且 trim 和已儲存的不同時寫回；有寫回傳 true
+	bool storeIfChanged();
+
+	// 持久化（ESP32 NVS / host 檔案）；沒有存過時 load 回傳 false
+	static bool load(uint8_t* trim);
+	static bool store(uint8_t trim);
+
+private:
+	uint8_t  _trim;
+	uint8_t  _stored;         // 0xFF = 還沒存過 / 不知道
+	bool     _locked;
+	uint8_t  _skip;
+	uint8_t  _n;
+	float    _sum;
+	float    _lastAvg;
+	float    _prevAvg;        // 上一個視窗（上一次 trim 時）的平均
+	int8_t   _prevStep;       // 上一次調了幾格（0 = 還沒調過）
+	float    _ppmPerStep;     // 估計的 d(ppm)/d(trim)
+};
+
+#endif
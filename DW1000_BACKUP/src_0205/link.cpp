@@ -1,20 +1,62 @@
 #include "link.h"
+#include <math.h>
 
 //#define SERIAL_DEBUG
 
+// 固定容量的 anchor 表：entry 緊密排在陣列前 count 格，位址用 hash index 直接找到槽位
+// head 是表頭（anchor_addr = 0），init_link() 回傳它；其餘 API 用 p 找回整張表
+struct MyLinkTable
+{
+    struct MyLink head;                      // 必須是第一個成員
+    struct MyLink entry[LINK_MAX_ANCHORS];
+    uint8_t count;
+    uint8_t index[LINK_INDEX_SIZE];          // LINK_INDEX_EMPTY = 空
+};
+
+#define LINK_INDEX_EMPTY 0xFF
+
+static struct MyLinkTable link_table;
+
+static inline struct MyLinkTable *link_table_of(struct MyLink *p)
+{
+    return (struct MyLinkTable *)p;
+}
+
+static inline uint8_t link_hash(uint16_t addr)
+{
+    // Fibonacci hashing：乘法後把高位折回低位
+    uint16_t x = (uint16_t)(addr * 40503u);
+    return (uint8_t)((x ^ (x >> 8)) & (LINK_INDEX_SIZE - 1));
+}
+
+// 回傳 addr 所在的 index 槽（找不到則回傳應插入的空槽）
+static uint8_t link_probe(struct MyLinkTable *t, uint16_t addr)
+{
+    uint8_t h = link_hash(addr);
+    while (t->index[h] != LINK_INDEX_EMPTY && t->entry[t->index[h]].anchor_addr != addr)
+    {
+        h = (h + 1) & (LINK_INDEX_SIZE - 1);
+    }
+    return h;
+}
+
+// entry 的 next 串成一條，舊的「while (temp->next != NULL)」走訪方式照樣可用
+static void link_chain(struct MyLinkTable *t, uint8_t i)
+{
+    t->entry[i].next = (i + 1 < t->count) ? &t->entry[i + 1] : NULL;
+}
+
 struct MyLink *init_link()
 {
 #ifdef SERIAL_DEBUG
     Serial.println("init_link");
 #endif
-    struct MyLink *p = (struct MyLink *)malloc(sizeof(struct MyLink));
-    p->next = NULL;
-    p->anchor_addr = 0;
-    p->range[0] = 0.0;
-    p->range[1] = 0.0;
-    p->range[2] = 0.0;
-
-    return p;
+    struct MyLinkTable *t = &link_table;
+    memset(t, 0, sizeof(*t));
+    memset(t->index, LINK_INDEX_EMPTY, sizeof(t->index));
+    t->head.next = NULL;
+
+    return &t->head;
 }
 
 void add_link(struct MyLink *p, uint16_t addr)
@@ -22,63 +64,65 @@ void add_link(struct MyLink *p, uint16_t addr)
 #ifdef SERIAL_DEBUG
     Serial.println("add_link");
 #endif
-    struct MyLink *temp = p;
-    //Find struct MyLink end
-    while (temp->next != NULL)
+    if (addr == 0)
+        return;
+
+    struct MyLinkTable *t = link_table_of(p);
+    uint8_t h = link_probe(t, addr);
+    if (t->index[h] != LINK_INDEX_EMPTY)
     {
-        temp = temp->next;
+        return; // 已經在表內
+    }
+    if (t->count >= LINK_MAX_ANCHORS)
+    {
+        Serial.println("add_link:table full");
+        return;
     }
 
-    Serial.println("add_link:find struct MyLink end");
-    //Create a anchor
-    struct MyLink *a = (struct MyLink *)malloc(sizeof(struct MyLink));
+    //Create a anchor in the next free slot
+    uint8_t i = t->count++;
+    struct MyLink *a = &t->entry[i];
     a->anchor_addr = addr;
     a->range[0] = 0.0;
     a->range[1] = 0.0;
     a->range[2] = 0.0;
     a->dbm = 0.0;
+    a->fp_dbm = 0.0;
     a->next = NULL;
+    t->index[h] = i;
 
-    //Add anchor to end of struct MyLink
-    temp->next = a;
+    //Add anchor to end of chain
+    if (i == 0)
+        t->head.next = a;
+    else
+        link_chain(t, i - 1);
 
     return;
 }
 
 struct MyLink *find_link(struct MyLink *p, uint16_t addr)
 {
-#ifdef SERIAL_DEBUG
-    Serial.println("find_link");
-#endif
     if (addr == 0)
-    {
-        Serial.println("find_link:Input addr is 0");
         return NULL;
-    }
 
-    if (p->next == NULL)
+    struct MyLinkTable *t = link_table_of(p);
+    uint8_t slot = t->index[link_probe(t, addr)];
+    if (slot == LINK_INDEX_EMPTY)
     {
-        Serial.println("find_link:Link is empty");
+#ifdef SERIAL_DEBUG
+        Serial.println("find_link:Can't find addr");
+#endif
         return NULL;
     }
-
-    struct MyLink *temp = p;
-    //Find target struct MyLink or struct MyLink end
-    while (temp->next != NULL)
-    {
-        temp = temp->next;
-        if (temp->anchor_addr == addr)
-        {
-            // Serial.println("find_link:Find addr");
-            return temp;
-        }
-    }
-
-    Serial.println("find_link:Can't find addr");
-    return NULL;
+    return &t->entry[slot];
 }
 
 void fresh_link(struct MyLink *p, uint16_t addr, float range, float dbm)
+{
+    fresh_link(p, addr, range, dbm, NAN); // 沒給 FP power：保留原值
+}
+
+void fresh_link(struct MyLink *p, uint16_t addr, float range, float dbm, float fp_dbm)
 {
 #ifdef SERIAL_DEBUG
     Serial.println("fresh_link");
@@ -91,11 +135,15 @@ void fresh_link(struct MyLink *p, uint16_t addr, float range, float dbm)
 
         temp->range[0] = (range + temp->range[1] + temp->range[2]) / 3;
         temp->dbm = dbm;
+        if (!isnan(fp_dbm))
+            temp->fp_dbm = fp_dbm;
         return;
     }
     else
     {
+#ifdef SERIAL_DEBUG
         Serial.println("fresh_link:Fresh fail");
+#endif
         return;
     }
 }
@@ -127,18 +175,27 @@ void delete_link(struct MyLink *p, uint16_t addr)
     if (addr == 0)
         return;
 
-    struct MyLink *temp = p;
-    while (temp->next != NULL)
-    {
-        if (temp->next->anchor_addr == addr)
-        {
-            struct MyLink *del = temp->next;
-            temp->next = del->next;
-            free(del);
-            return;
-        }
-        temp = temp->next;
-    }
+    struct MyLinkTable *t = link_table_of(p);
+    uint8_t slot = t->index[link_probe(t, addr)];
+    if (slot == LINK_INDEX_EMPTY)
+        return;
+
+    // 最後一筆搬進被刪的槽位，陣列保持緊密
+    uint8_t last = --t->count;
+    if (slot != last)
+        t->entry[slot] = t->entry[last];
+    memset(&t->entry[last], 0, sizeof(struct MyLink));
+
+    if (slot < t->count)
+        link_chain(t, slot);
+    if (t->count > 0)
+        link_chain(t, t->count - 1);
+    t->head.next = (t->count > 0) ? &t->entry[0] : NULL;
+
+    // 刪除很少發生（anchor 離線），直接重建 index，省掉 open addressing 的刪除處理
+    memset(t->index, LINK_INDEX_EMPTY, sizeof(t->index));
+    for (uint8_t i = 0; i < t->count; i++)
+        t->index[link_probe(t, t->entry[i].anchor_addr)] = i;
     return;
 }
 
@@ -163,4 +220,107 @@ void make_link_json(struct MyLink *p, String *s)
     }
     *s += "]}";
     // Serial.println(*s);
-}
\ No newline at end of file
+}
+
+
+static char *put_hex(char *o, uint16_t v)
+{
+    // 同 "%X"：不補 0
+    static const char digits[] = "0123456789ABCDEF";
+    char tmp[4];
+    uint8_t n = 0;
+    do
+    {
+        tmp[n++] = digits[v & 0xF];
+        v >>= 4;
+    } while (v != 0);
+    while (n > 0)
+        *o++ = tmp[--n];
+    return o;
+}
+
+static char *put_mm(char *o, float range)
+{
+    // NaN 照 String 版 sprintf 印 "nan"；超出 int32 的 mm 飽和（LINK_JSON_ENTRY_MAX 以 -2147483.648 計）
+    if (isnan(range))
+    {
+        memcpy(o, "nan", 3);
+        return o + 3;
+    }
+    // m -> mm 四捨五入，之後全部整數運算
+    float x = range * 1000.0f + (range >= 0 ? 0.5f : -0.5f);
+    int32_t mm;
+    if (x >= 2147483647.0f)
+        mm = INT32_MAX;
+    else if (x <= -2147483648.0f)
+        mm = INT32_MIN;
+    else
+        mm = (int32_t)x;
+    uint32_t u = (uint32_t)mm;
+    if (mm < 0)
+    {
+        *o++ = '-';
+        u = 0u - u;
+    }
+    uint32_t m = u / 1000, frac = u % 1000;
+    char tmp[10];
+    uint8_t n = 0;
+    do
+    {
+        tmp[n++] = (char)('0' + m % 10);
+        m /= 10;
+    } while (m != 0);
+    while (n > 0)
+        *o++ = tmp[--n];
+    *o++ = '.';
+    *o++ = (char)('0' + frac / 100);
+    *o++ = (char)('0' + frac / 10 % 10);
+    *o++ = (char)('0' + frac % 10);
+    return o;
+}
+
+int make_link_json(struct MyLink *p, char *buf, size_t len)
+{
+#ifdef SERIAL_DEBUG
+    Serial.println("make_link_json");
+#endif
+    static const char head[] = "{\"links\":[";
+    static const char tail[] = "]}";
+    if (buf == NULL || len == 0)
+        return -1;
+
+    size_t n = sizeof(head) - 1;
+    if (n + sizeof(tail) > len)
+    {
+        buf[0] = '\0';
+        return -1;
+    }
+    memcpy(buf, head, n);
+
+    struct MyLink *temp = p;
+    while (temp->next != NULL)
+    {
+        temp = temp->next;
+        char link_json[LINK_JSON_ENTRY_MAX];
+        char *o = link_json;
+        memcpy(o, "{\"A\":\"", 6);
+        o = put_hex(o + 6, temp->anchor_addr);
+        memcpy(o, "\",\"R\":\"", 7);
+        o = put_mm(o + 7, temp->range[0]);
+        *o++ = '"';
+        *o++ = '}';
+        if (temp->next != NULL)
+            *o++ = ',';
+
+        size_t m = (size_t)(o - link_json);
+        if (n + m + sizeof(tail) > len)
+        {
+            buf[0] = '\0';
+            return -1;
+        }
+        memcpy(buf + n, link_json, m);
+        n += m;
+    }
+    memcpy(buf + n, tail, sizeof(tail)); // 含 '\0'
+    return (int)(n + sizeof(tail) - 1);
+}
@@ -1,17 +1,37 @@
 #include <Arduino.h>
 
+// anchor 表容量（固定大小，init 之後不再配置記憶體）
+#ifndef LINK_MAX_ANCHORS
+#define LINK_MAX_ANCHORS 16
+#endif
+// 位址 -> 槽位的 hash index，2 的次方且 >= 2 * LINK_MAX_ANCHORS
+#ifndef LINK_INDEX_SIZE
+#define LINK_INDEX_SIZE 32
+#endif
+#if (LINK_MAX_ANCHORS > 127) || (LINK_INDEX_SIZE < 2 * LINK_MAX_ANCHORS) || (LINK_INDEX_SIZE & (LINK_INDEX_SIZE - 1))
+#error "link.h: need LINK_MAX_ANCHORS <= 127 and LINK_INDEX_SIZE a power of 2 >= 2 * LINK_MAX_ANCHORS"
+#endif
+
 struct MyLink
 {
     uint16_t anchor_addr;
     float range[3];
     float dbm;
-    struct MyLink *next;
+    float fp_dbm;        // First Path Power
+    struct MyLink *next; // 指向表內下一個使用中的 anchor（走訪用，不是 malloc 出來的）
 };
 
 struct MyLink *init_link();
 void add_link(struct MyLink *p, uint16_t addr);
 struct MyLink *find_link(struct MyLink *p, uint16_t addr);
 void fresh_link(struct MyLink *p, uint16_t addr, float range, float dbm);
+void fresh_link(struct MyLink *p, uint16_t addr, float range, float dbm, float fp_dbm);
 void print_link(struct MyLink *p);
 void delete_link(struct MyLink *p, uint16_t addr);
-void make_link_json(struct MyLink *p,String *s);
\ No newline at end of file
+void make_link_json(struct MyLink *p,String *s);
+
+// 寫進呼叫端的固定 buffer（不配置記憶體、不做 float 轉字串），R 以整數 mm 換成 "m.mmm"
+// 回傳寫入的 bytes（不含結尾 '\0'）；buffer 不夠時回傳 -1 且 buf 為空字串
+#define LINK_JSON_ENTRY_MAX 40   // {"A":"FFFF","R":"-2147483.648"},
+#define LINK_JSON_MAX (16 + LINK_MAX_ANCHORS * LINK_JSON_ENTRY_MAX)
+int make_link_json(struct MyLink *p, char *buf, size_t len);
@@ -0,0 +1,106 @@
+// Pairwise calibration: every node (all anchors + the tag) runs this sketch at the same time.
+// Each node is an anchor most of the time and, at random intervals, becomes a tag for a short
+// while to range every other node. All pairwise ranges are printed on Serial:
+//   DLY,<own short address>,<antenna delay used>
+//   RNG,<own short address>,<other short address>,<range m>
+// Concatenate the serial logs of all boards and solve every antenna delay at once on the host:
+//   UWB_Host_Server/UWB_Delay_Solver.cpp (node positions in anchors.txt format, tag included)
+// This replaces running ESP32_anchor_autocalibrate once per anchor.
+
+// user input required, unique to each node:
+// 1) address (leftmost two bytes become the short address = id in the position file)
+
+#include <SPI.h>
+#include "DW1000Ranging.h"
+#include "DW1000.h"
+
+// ESP32_UWB pin definitions
+
+#define SPI_SCK 18
+#define SPI_MISO 19
+#define SPI_MOSI 23
+#define DW_CS 4
+
+// connection pins
+const uint8_t PIN_RST = 27; // reset pin
+const uint8_t PIN_IRQ = 34; // irq pin
+const uint8_t PIN_SS = 4;   // spi select pin
+
+char this_node_addr[] = "81:00:22:EA:82:60:3B:9C";
+
+// all nodes measure with the same delay; the solver reports the new value for each node
+uint16_t this_node_Adelay = 16384;
+
+// 當 TAG 的時間與當 ANCHOR 的時間（亂數，避免兩台一直同時當 TAG）
+#define TAG_PERIOD_MS        1500
+#define ANCHOR_PERIOD_MIN_MS 2000
+#define ANCHOR_PERIOD_MAX_MS 8000
+
+uint16_t self_short = 0;
+unsigned long role_until = 0;
+unsigned long rng_count = 0;
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial);
+  //init the configuration
+  SPI.begin(SPI_SCK, SPI_MISO, SPI_MOSI);
+  DW1000Ranging.initCommunication(PIN_RST, PIN_SS, PIN_IRQ); //Reset, CS, IRQ pin
+
+  DW1000.setAntennaDelay(this_node_Adelay);
+
+  DW1000Ranging.attachNewRange(newRange);
+  DW1000Ranging.attachNewDevice(newDevice);
+  DW1000Ranging.attachInactiveDevice(inactiveDevice);
+  // raw ranges only: the solver does its own outlier rejection and averaging
+  //DW1000Ranging.useRangeFilter(true);
+
+  //start the module as anchor, don't assign random short address
+  DW1000Ranging.startAsAnchor(this_node_addr, DW1000.MODE_LONGDATA_RANGE_LOWPOWER, false);
+
+  byte *sa = DW1000Ranging.getCurrentShortAddress();
+  self_short = (uint16_t)(sa[1] << 8 | sa[0]);
+  randomSeed(self_short ^ micros());
+  Serial.print("DLY,"); Serial.print(self_short, HEX);
+  Serial.print(","); Serial.println(this_node_Adelay);
+  role_until = millis() + random(ANCHOR_PERIOD_MIN_MS, ANCHOR_PERIOD_MAX_MS);
+}
+
+void loop()
+{
+  DW1000Ranging.loop();
+
+  if ((long)(millis() - role_until) >= 0) {
+    if (DW1000Ranging.getRole() == ANCHOR) {
+      DW1000Ranging.setRole(TAG);
+      role_until = millis() + TAG_PERIOD_MS;
+    } else {
+      DW1000Ranging.setRole(ANCHOR);
+      role_until = millis() + random(ANCHOR_PERIOD_MIN_MS, ANCHOR_PERIOD_MAX_MS);
+      Serial.print("# ranges "); Serial.println(rng_count);
+    }
+  }
+}
+
+void newRange()
+{
+  // 只在當 TAG 時印：同一次交換 ANCHOR 端也會算出 range，兩邊都印會重複
+  if (DW1000Ranging.getRole() != TAG) return;
+  rng_count++;
+  Serial.print("RNG,"); Serial.print(self_short, HEX);
+  Serial.print(","); Serial.print(DW1000Ranging.getDistantDevice()->getShortAddress(), HEX);
+  Serial.print(","); Serial.println(DW1000Ranging.getDistantDevice()->getRange(), 3);
+}
+
+void newDevice(DW1000Device *device)
+{
+  Serial.print("# device added: ");
+  Serial.println(device->getShortAddress(), HEX);
+}
+
+void inactiveDevice(DW1000Device *device)
+{
+  Serial.print("# delete inactive device: ");
+  Serial.println(device->getShortAddress(), HEX);
+}
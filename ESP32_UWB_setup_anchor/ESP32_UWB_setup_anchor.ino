@@ -50,10 +50,13 @@ void setup()
   DW1000Ranging.setEncryptionFlag(true);
   DW1000Ranging.setEncryptionDebugFlag(true);
   DW1000Ranging.setIVCounter(0);
-  DW1000Ranging.setIVMode(IV_MODE_RAND_UNIQUE); // IV
+  DW1000Ranging.setIVMode(IV_MODE_RAND_UNIQUE); // IV（tag 開防重送時要改成 IV_MODE_BOOT_COUNTER）
   DW1000Ranging.setPaddingLength(16); // Padding
   */
 
+  // ----- RANGE 時間戳驗證 (CMAC，tag 端也要一起開) -----
+  // DW1000Ranging.setRangeAuthFlag(true);
+
   // ----- Encryption:False ----- 
   /*
   DW1000Ranging.setEncryptionFlag(false);
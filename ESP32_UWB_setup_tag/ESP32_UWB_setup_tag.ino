@@ -5,9 +5,10 @@
 #include <SPI.h>
 #include "DW1000Ranging.h"
 #include "DW1000.h"
+#include "UWBTelemetryBatch.h"
 #include <WiFiUdp.h>
 #include <WiFi.h>
-#include "ㄋ.h"
+#include "link.h"
 
 #define SPI_SCK 18
 #define SPI_MISO 19
@@ -36,9 +37,21 @@ const char *host = "192.168.2.109";
 const int port = 8001;
 WiFiUDP udp;
 
+// 1 = 二進位遙測（UWBTelemetry.h，含 RX / FP power），0 = 舊的 JSON 文字
+#define TELEMETRY_BINARY 1
+// 二進位遙測的 flush 條件：最多幾筆 / 最久等幾 ms / 一輪 anchor 收齊就送
+#define BATCH_MAX_RECORDS 16
+#define BATCH_MAX_AGE_MS  100
+#define BATCH_ON_ROUND    true
+// 每次 newRange 都印 Serial（會拖慢 ranging，只在除錯時打開）
+//#define RANGE_SERIAL_DEBUG
+
 struct MyLink *uwb_data;
 long runtime = 0;
-String all_json = "";
+char all_json[LINK_JSON_MAX]; // 固定 buffer，loop() 裡不再配置記憶體
+uint8_t telemetry[UWB_TELEM_LEN(BATCH_MAX_RECORDS)];
+UWBTelemetryBatch batch;   // newRange() 只放進 ring，loop() 才送 UDP
+uint8_t anchor_count = 0;
 
 void setup()
 {
@@ -61,6 +74,10 @@ void setup()
 
   // 除錯模式 (印出 KEY / IV / TAG / CT 等資訊)
   DW1000Ranging.setEncryptionDebugFlag(false);
+  // 防重送 (anchor 端必須用 IV_MODE_BOOT_COUNTER，其他 IV 模式的 RANGE_REPORT 會被拒收並印警告)
+  // DW1000Ranging.setReplayProtectionFlag(true);
+  // RANGE 時間戳驗證 (CMAC，anchor 端也要一起開；一輪最多量 4 台 anchor，更多台會輪流)
+  // DW1000Ranging.setRangeAuthFlag(true);
 
   //init the configuration
   SPI.begin(SPI_SCK, SPI_MISO, SPI_MOSI);
@@ -74,43 +91,79 @@ void setup()
   DW1000Ranging.startAsTag(tag_addr, DW1000.MODE_LONGDATA_RANGE_LOWPOWER, false);
 
   uwb_data = init_link();
+
+  byte *sa = DW1000Ranging.getCurrentShortAddress();
+  batch.begin((uint16_t)(sa[1] << 8 | sa[0]));
+  batch.setFlushPolicy(BATCH_MAX_RECORDS, BATCH_MAX_AGE_MS, BATCH_ON_ROUND);
 }
 
 void loop()
 {
   DW1000Ranging.loop();
+#if TELEMETRY_BINARY
+  // ranging 處理完才送，UDP 不在 ranging callback 裡
+  while (batch.due(millis()))
+    {
+        int len = batch.flush(telemetry, sizeof(telemetry));
+        if (len <= 0)
+            break;
+        send_udp((const char *)telemetry, len);
+    }
+#else
   if ((millis() - runtime) > 100)
     {
-        make_link_json(uwb_data, &all_json);
-        send_udp(&all_json);
+        int len = make_link_json(uwb_data, all_json, sizeof(all_json));
+        send_udp(all_json, len);
         runtime = millis();
     }
+#endif
 }
 
-float lastTime = 0;
+// ===== [Update] millis() 用 uint32_t（原本 float：約 4.6 小時後 24-bit 尾數就不夠、差值變 0 或跳動），
+//               同一個 now 給 timeDiff 和 batch.push =====
+uint32_t lastTime = 0;
 
 void newRange()
 {
   // calculate time difference
-  float nowTime = millis();
-  float timeDiff = 0;
-  if(lastTime != 0) timeDiff = nowTime - lastTime;
-  lastTime = nowTime;
+  uint32_t now = millis();
+  uint32_t timeDiff = 0;
+  if(lastTime != 0) timeDiff = now - lastTime;   // uint32_t 相減：millis() 繞回也對
+  lastTime = now;
+// ========= [End Update] =========
 
   // variable
   auto ShortAddress = DW1000Ranging.getDistantDevice()->getShortAddress();
   auto Range = DW1000Ranging.getDistantDevice()->getRange();
   auto RXPower = DW1000Ranging.getDistantDevice()->getRXPower();
+  auto FPPower = DW1000Ranging.getDistantDevice()->getFPPower();
 
+#ifdef RANGE_SERIAL_DEBUG
   Serial.print(timeDiff);
   Serial.print(",");
   Serial.print(Range);
   Serial.print(",");
-  Serial.print(timeDiff,6);
+  Serial.print((float)timeDiff,6);   // ===== [Update] 整數的第二個參數是進位制，轉 float 才是小數位數 =====
   Serial.print(",");
   Serial.println(0);
-
-  fresh_link(uwb_data, ShortAddress, Range, RXPower);
+#else
+  (void)timeDiff;
+#endif
+
+  fresh_link(uwb_data, ShortAddress, Range, RXPower, FPPower);
+
+#if TELEMETRY_BINARY
+  // 和 JSON 的 R 一樣送 fresh_link 之後的 3 筆平均 range[0]（表滿沒收進來的 anchor 才送原始值）
+  struct MyLink *link = find_link(uwb_data, ShortAddress);
+  UWBTelemetryRecord r;
+  r.anchor = ShortAddress;
+  r.rangeMm = uwbTelemetryMeterToMm(link != NULL ? link->range[0] : Range);
+  r.rxPower = uwbTelemetryDbmToCenti(RXPower);
+  r.fpPower = uwbTelemetryDbmToCenti(FPPower);
+  DW1000Time rxTime;
+  DW1000.getReceiveTimestamp(rxTime); // 這筆 RANGE_REPORT 的接收時間
+  batch.push(&r, now, (uint64_t)rxTime.getTimestamp());
+#endif
 }
 
 void newDevice(DW1000Device *device)
@@ -119,6 +172,7 @@ void newDevice(DW1000Device *device)
   Serial.println(device->getShortAddress(), HEX);
 
   add_link(uwb_data, device->getShortAddress());
+  batch.setRoundSize(++anchor_count);
 }
 
 void inactiveDevice(DW1000Device *device)
@@ -127,24 +181,25 @@ void inactiveDevice(DW1000Device *device)
   Serial.println(device->getShortAddress(), HEX);
 
   delete_link(uwb_data, device->getShortAddress());
+  if (anchor_count > 0)
+    batch.setRoundSize(--anchor_count);
 }
 
-void send_udp(String *msg_json)
+void send_udp(const char *msg_json, int len)
 {
     if (WiFi.status() != WL_CONNECTED) {
         Serial.println("WiFi not connected, skip send");
         return;
     }
 
-    int len = msg_json->length();
-    if (len == 0) {
-        Serial.println("Empty JSON, skip");
+    if (len <= 0) {
+        Serial.println("Empty packet, skip");
         return;
     }
 
     // start packet to host:port
     udp.beginPacket(host, port);
-    udp.print(*msg_json);
+    udp.write((const uint8_t *)msg_json, (size_t)len);
     udp.endPacket();
-    //Serial.println(*msg_json);
+    //Serial.println(msg_json);
 }
\ No newline at end of file
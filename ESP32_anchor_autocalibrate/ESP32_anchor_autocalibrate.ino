@@ -1,5 +1,7 @@
 // This program calibrates an ESP32_UWB module intended for use as a fixed anchor point
 // uses binary search to find anchor antenna delay to calibrate against a known distance
+// ===== [Update] 改用 UWBAntennaCal：每個 delay 收一批 range（去離群值後平均），
+//               用回歸更新 delay，最後印出結果與 95% 信賴區間 =====
 //
 // modified version of Thomas Trojer's DW1000 library is required!
 
@@ -15,6 +17,7 @@
 #include <SPI.h>
 #include "DW1000Ranging.h"
 #include "DW1000.h"
+#include "UWBAntennaCal.h"
 
 // ESP32_UWB pin definitions
 
@@ -33,7 +36,11 @@ char this_anchor_addr[] = "84:00:22:EA:82:60:3B:9C";
 float this_anchor_target_distance = 7; //measured distance to anchor in m
 
 uint16_t this_anchor_Adelay = 16600; //starting value
-uint16_t Adelay_delta = 100; //initial binary search step size
+// ===== [Update] 原版：uint16_t Adelay_delta = 100; //initial binary search step size =====
+uint8_t calibration_batch = ANTCAL_DEFAULT_BATCH; // 每個 delay 收幾筆 range
+float calibration_ci = ANTCAL_TARGET_CI;          // 95% CI 半寬（tick）到這個以內就停；要更準就調小（筆數約和平方成反比）
+UWBAntennaCal calibration;
+// ========= [End Update] =========
 
 
 void setup()
@@ -49,6 +56,7 @@ void setup()
   Serial.print("Measured distance "); Serial.println(this_anchor_target_distance);
   
   DW1000.setAntennaDelay(this_anchor_Adelay);
+  calibration.begin(this_anchor_target_distance, this_anchor_Adelay, calibration_batch, calibration_ci);
 
   DW1000Ranging.attachNewRange(newRange);
   DW1000Ranging.attachNewDevice(newDevice);
@@ -66,36 +74,36 @@ void loop()
   DW1000Ranging.loop();
 }
 
+// ===== [Update] 原版每筆 range 就用二分搜尋調一次 Adelay（變號才減半，Adelay_delta < 3 結束）=====
 void newRange()
 {
-  static float last_delta = 0.0;
-  Serial.print(DW1000Ranging.getDistantDevice()->getShortAddress(), DEC);
-
-    float dist = DW1000Ranging.getDistantDevice()->getRange();
-
-  Serial.print(",");
-  Serial.print(dist); 
-  if (Adelay_delta < 3) {
-    Serial.print(", final Adelay ");
-    Serial.println(this_anchor_Adelay);
-//    Serial.print("Check: stored Adelay = ");
-//    Serial.println(DW1000.getAntennaDelay());
+  float dist = DW1000Ranging.getDistantDevice()->getRange();
+  uint8_t steps = calibration.steps();
+  bool changed = calibration.addRange(dist);
+
+  if (calibration.steps() != steps) {
+    // 一批收完：印這批的平均誤差、目前的 delay 與信賴區間
+    Serial.print(DW1000Ranging.getDistantDevice()->getShortAddress(), DEC);
+    Serial.print(", step "); Serial.print(calibration.steps());
+    Serial.print(", error "); Serial.print(calibration.lastError(), 3);
+    Serial.print(" m, Adelay = "); Serial.print(calibration.antennaDelay());
+    Serial.print(" +/- "); Serial.println(calibration.confidence(), 1);
+  }
+  if (changed) {
+    this_anchor_Adelay = calibration.antennaDelay();
+    DW1000.setAntennaDelay(this_anchor_Adelay);
+  }
+  if (calibration.isDone()) {
+    Serial.print("final Adelay ");
+    Serial.print(calibration.antennaDelay());
+    Serial.print(" +/- ");
+    Serial.print(calibration.confidence(), 1);
+    Serial.print(" (95%), ranges used ");
+    Serial.println(calibration.rangesUsed());
     while(1);  //done calibrating
   }
-
-  float this_delta = dist - this_anchor_target_distance;  //error in measured distance
-
-  if ( this_delta * last_delta < 0.0) Adelay_delta = Adelay_delta / 2; //sign changed, reduce step size
-    last_delta = this_delta;
-  
-  if (this_delta > 0.0 ) this_anchor_Adelay += Adelay_delta; //new trial Adelay
-  else this_anchor_Adelay -= Adelay_delta;
-  
-  Serial.print(", Adelay = ");
-  Serial.println (this_anchor_Adelay);
-//  DW1000Ranging.initCommunication(PIN_RST, PIN_SS, PIN_IRQ); //Reset, CS, IRQ pin
-  DW1000.setAntennaDelay(this_anchor_Adelay);
 }
+// ========= [End Update] =========
 
 void newDevice(DW1000Device *device)
 {
@@ -75,8 +75,8 @@ Debug parsing（從裝置的 debug log 推出實驗模式）
 - _RE_IVMODE_2：對應在 TX 時印的 log
 - _RE_IVCTR  ：擷取 counter 模式的 ivCounter
 """
-_RE_IVMODE_1 = re.compile(r"\[ENC\]\s*setIVMode\s*=\s*(COUNTER|RAND_UNIQUE)")
-_RE_IVMODE_2 = re.compile(r"\[ENC\]\[TX\]\s*ivMode\s*=\s*(COUNTER|RAND_UNIQUE)")
+_RE_IVMODE_1 = re.compile(r"\[ENC\]\s*setIVMode\s*=\s*(BOOT_COUNTER|COUNTER|RAND_UNIQUE)")
+_RE_IVMODE_2 = re.compile(r"\[ENC\]\[TX\]\s*ivMode\s*=\s*(BOOT_COUNTER|COUNTER|RAND_UNIQUE)")
 _RE_IVCTR = re.compile(r"ivCounter\s*=\s*(\d+)")
 
 
@@ -34,7 +34,7 @@ void setup()
 
     DW1000Ranging.setIVCounter(0); // Counter IV 起始值
 
-    DW1000Ranging.setIVMode(IV_MODE_RAND_UNIQUE); // IV_MODE_COUNTER (4byte + 0), IV_MODE_RAND_UNIQUE (12byte亂數)
+    DW1000Ranging.setIVMode(IV_MODE_RAND_UNIQUE); // IV_MODE_COUNTER (4byte + 0), IV_MODE_RAND_UNIQUE (12byte亂數), IV_MODE_BOOT_COUNTER (NVS開機計數+計數+salt，tag 開防重送時必須用這個)
 
     DW1000Ranging.setPaddingLength(4); // padding
 
@@ -0,0 +1,81 @@
+/*
+
+AES-GCM 後端延遲量測（不需要 UWB 模組，只要 ESP32）
+
+後端在編譯期選擇（整個 library 要一起重編）：
+  PlatformIO : build_flags = -DUWB_CRYPTO_BACKEND=2   (0 = portable, 1 = mbedtls, 2 = ESP32 HW AES)
+  Arduino IDE: 直接改 DW1000Crypto.h 裡 UWB_CRYPTO_BACKEND 的預設值
+
+輸出格式（一行一筆，方便貼進報表）：
+  BENCH,<backend>,<padding>,<plainLen>,<enc_us>,<dec_us>
+padding 與 UWB_Reports/Encryption_<N>padding_*.png 相同，明文 = 距離字串(5 bytes) + padding
+
+*/
+
+#include "DW1000Crypto.h"
+
+#define BENCH_ROUNDS 2000
+#define BASE_LEN     5     // "12.34"
+
+static const uint8_t BENCH_KEY[32] = {
+  0x00,0x01,0x02,0x03, 0x04,0x05,0x06,0x07,
+  0x08,0x09,0x0A,0x0B, 0x0C,0x0D,0x0E,0x0F,
+  0x10,0x11,0x12,0x13, 0x14,0x15,0x16,0x17,
+  0x18,0x19,0x1A,0x1B, 0x1C,0x1D,0x1E,0x1F
+};
+static const uint8_t PADDINGS[] = {0, 1, 2, 4, 8, 16, 24, 32, 44};
+
+DW1000Crypto gcm;
+
+void setup()
+{
+    Serial.begin(115200);
+    delay(1000);
+
+    Serial.print("backend = ");
+    Serial.println(DW1000Crypto::backendName());
+    Serial.print("selfTest = ");
+    Serial.println(DW1000Crypto::selfTest() ? "PASS" : "FAIL");
+
+    gcm.setKey(BENCH_KEY, 256);
+}
+
+void loop()
+{
+    uint8_t iv[12] = {0};
+    uint8_t aad[11] = {0};
+    uint8_t plain[64];
+    uint8_t cipher[64];
+    uint8_t back[64];
+    uint8_t tag[16];
+
+    memset(plain, '0', sizeof(plain));
+
+    for (uint8_t p = 0; p < sizeof(PADDINGS); p++) {
+        size_t n = BASE_LEN + PADDINGS[p];
+
+        unsigned long t0 = micros();
+        for (uint16_t i = 0; i < BENCH_ROUNDS; i++) {
+            memcpy(iv, &i, sizeof(i)); // 每次換 IV，和實際送包一樣
+            gcm.gcmEncrypt(iv, sizeof(iv), aad, sizeof(aad), plain, n, cipher, tag, sizeof(tag));
+        }
+        unsigned long t1 = micros();
+        for (uint16_t i = 0; i < BENCH_ROUNDS; i++) {
+            gcm.gcmDecrypt(iv, sizeof(iv), aad, sizeof(aad), cipher, n, back, tag, sizeof(tag));
+        }
+        unsigned long t2 = micros();
+
+        Serial.print("BENCH,");
+        Serial.print(DW1000Crypto::backendName());
+        Serial.print(",");
+        Serial.print(PADDINGS[p]);
+        Serial.print(",");
+        Serial.print(n);
+        Serial.print(",");
+        Serial.print((float)(t1 - t0) / BENCH_ROUNDS, 2);
+        Serial.print(",");
+        Serial.println((float)(t2 - t1) / BENCH_ROUNDS, 2);
+    }
+
+    delay(5000);
+}
@@ -9,6 +9,26 @@
 #include <SPI.h>
 #include "DW1000Ranging.h"
 #include "DW1000.h"
+// ===== [Add] K 個 anchor 的最小平方解（取代 trilat2D_4A，少一個 anchor 也能定位） =====
+#include "UWBMultilateration.h"
+// ========= [End Add] =========
+// ===== [Add] 各 anchor 的 range 依 DW1000 timestamp 外插到同一時間點再解（移動中的 tag 比較準） =====
+#define TIME_ALIGN_RANGES
+#include "UWBRangeBuffer.h"
+// ========= [End Add] =========
+// ===== [Add] anchor 座標從 host 下載（UWB_Anchor_Survey -S），不必每個場地重新編譯 anchor_matrix =====
+#include "UWBAnchorLayout.h"
+#define LAYOUT_DOWNLOAD    // 註解掉 = 只用 NVS 裡上次下載的座標，沒有就用下面的 anchor_matrix
+#ifdef LAYOUT_DOWNLOAD
+#include <WiFi.h>
+#include <WiFiUdp.h>
+const char *ssid = "PSS";
+const char *password = "047611137";
+const char *layout_host = "192.168.2.109";
+#define LAYOUT_TIMEOUT_MS 1000   // 每次等回覆多久
+#define LAYOUT_TRIES 3
+#endif
+// ========= [End Add] =========
 
 #define DEBUG_TRILAT   //prints in trilateration code
 //#define DEBUG_DIST     //print anchor distances
@@ -28,7 +48,7 @@ const uint8_t PIN_SS = 4;   // spi select pin
 char tag_addr[] = "7D:00:22:EA:82:60:3B:9C";
 
 // variables for position determination
-#define N_ANCHORS 4
+#define N_ANCHORS 4   //compiled-in anchors, used when no layout was downloaded (see UWBAnchorLayout)
 #define ANCHOR_DISTANCE_EXPIRED 5000   //measurements older than this are ignore (milliseconds) 
 
 // global variables, input and output 
@@ -39,18 +59,47 @@ float anchor_matrix[N_ANCHORS][3] = { //list of anchor coordinates, relative to
   {3.71, -0.3, 0.6}, //Anchor labeled #3
   { -0.56, 4.88, 0.15} //Anchor labeled #4
 };  //Z values are ignored in this code, except to compute RMS distance error
+// ===== [Add] anchor_matrix 每一列的 short address；實際使用的座標在 layout（slot = 表中的順序） =====
+uint16_t anchor_id[N_ANCHORS] = {0x81, 0x82, 0x83, 0x84};
+UWBAnchorLayout layout;
+// ========= [End Add] =========
 
-uint32_t last_anchor_update[N_ANCHORS] = {0}; //millis() value last time anchor was seen
-float last_anchor_distance[N_ANCHORS] = {0.0}; //most recent distance reports
+// ===== [Update] 陣列大小改成 LAYOUT_MAX_ANCHORS（下載的座標表可以超過 N_ANCHORS 台） =====
+uint32_t last_anchor_update[LAYOUT_MAX_ANCHORS] = {0}; //millis() value last time anchor was seen
+float last_anchor_distance[LAYOUT_MAX_ANCHORS] = {0.0}; //most recent distance reports
+// ========= [End Update] =========
 
 float current_tag_position[2] = {0.0, 0.0}; //global current position (meters with respect to anchor origin)
 float current_distance_rmse = 0.0;  //rms error in distance calc => crude measure of position error (meters).  Needs to be better characterized
 
+// ===== [Add] solver：每種 anchor 組合的分解只算一次（2D 至少 3 個 anchor） =====
+UWBMultilateration mlat(2);
+// ========= [End Add] =========
+
+#ifdef TIME_ALIGN_RANGES
+// ===== [Add] 每個 anchor 最近幾筆 range；解算時全部推到最新一筆的時間 =====
+#define RANGE_ALIGN_MAX_AGE 1.0f   // 秒：比最新一筆舊超過這個的 anchor 不用（取代 5 s 的 ANCHOR_DISTANCE_EXPIRED）
+UWBRangeBuffer range_buffer;
+float aligned_distance[RB_MAX_ANCHORS];
+// ========= [End Add] =========
+#endif
+
 void setup()
 {
   Serial.begin(115200);
   delay(1000);
 
+  // ===== [Update] anchor 座標：下載 -> NVS -> 編譯進去的 anchor_matrix，交給 solver，slot = layout 的順序 =====
+  loadLayout();
+  for (int i = 0; i < layout.count(); i++) {
+    const float *p = layout.position(i);
+    mlat.setAnchor(i, p[0], p[1], p[2]);
+  }
+  // ========= [End Update] =========
+#ifdef TIME_ALIGN_RANGES
+  range_buffer.setMaxAge(RANGE_ALIGN_MAX_AGE);
+#endif
+
   //initialize configuration
   SPI.begin(SPI_SCK, SPI_MISO, SPI_MOSI);
   DW1000Ranging.initCommunication(PIN_RST, PIN_SS, PIN_IRQ); //Reset, CS, IRQ pin
@@ -74,28 +123,43 @@ void loop()
 
 void newRange()
 {
-  int i;  //index of this anchor, expecting values 1 to 7
-  int index = DW1000Ranging.getDistantDevice()->getShortAddress() & 0x07;
+  int i;
 
+  // ===== [Update] 原版：index = short address & 0x07（1 到 N_ANCHORS）；改成查 layout，index = slot + 1 =====
+  int index = layout.slotOf(DW1000Ranging.getDistantDevice()->getShortAddress()) + 1;
   if (index > 0) {
+  // ========= [End Update] =========
     last_anchor_update[index - 1] = millis();  //decrement index for array index
     float range = DW1000Ranging.getDistantDevice()->getRange();
     last_anchor_distance[index - 1] = range;
     if (range < 0.0 || range > 30.0)     last_anchor_update[index - 1] = 0;  //error or out of bounds, ignore this measurement
+#ifdef TIME_ALIGN_RANGES
+    // ===== [Add] 這筆 range 的時間 = RANGE_REPORT 的接收 timestamp =====
+    else {
+      DW1000Time rxTime;
+      DW1000.getReceiveTimestamp(rxTime);
+      range_buffer.push(index - 1, (uint64_t)rxTime.getTimestamp(), range);
+    }
+    // ========= [End Add] =========
+#endif
   }
 
   int detected = 0;
+  uint16_t mask = 0; // ===== [Add] 哪些 anchor 的距離還有效 =====
 
   //reject old measurements
-  for (i = 0; i < N_ANCHORS; i++) {
+  for (i = 0; i < layout.count(); i++) {
     if (millis() - last_anchor_update[i] > ANCHOR_DISTANCE_EXPIRED) last_anchor_update[i] = 0; //not from this one
-    if (last_anchor_update[i] > 0) detected++;
+    if (last_anchor_update[i] > 0) {
+      detected++;
+      mask |= (1u << i);
+    }
   }
 
 #ifdef DEBUG_DIST
     // print distance and age of measurement
     uint32_t current_time = millis();
-    for (i = 0; i < N_ANCHORS; i++) {
+    for (i = 0; i < layout.count(); i++) {
       Serial.print(i+1); //ID
       Serial.print("> ");
       Serial.print(last_anchor_distance[i]);
@@ -104,9 +168,21 @@ void newRange()
     }
 #endif
 
-  if ( detected == 4) { //four measurements minimum
+  // ===== [Add] 外插到同一時間點；太舊的 anchor 從 mask 拿掉 =====
+#ifdef TIME_ALIGN_RANGES
+  mask &= range_buffer.alignTo(range_buffer.latest(), aligned_distance);
+  detected = 0;
+  for (i = 0; i < layout.count(); i++)
+    if (mask & (1u << i)) detected++;
+  const float *solve_distance = aligned_distance;
+#else
+  const float *solve_distance = last_anchor_distance;
+#endif
+  // ========= [End Add] =========
+
+  if (detected >= mlat.minAnchors()) { //three measurements minimum
 
-    trilat2D_4A();
+    if (!trilat2D_4A(mask, solve_distance)) return;
 
     //output the values (X, Y and error estimate)
     Serial.print("P= ");
@@ -130,23 +206,11 @@ void inactiveDevice(DW1000Device *device)
   Serial.println(device->getShortAddress(), HEX);
 }
 
-int trilat2D_4A(void) {
-
-  // for method see technical paper at
-  // https://www.th-luebeck.de/fileadmin/media_cosa/Dateien/Veroeffentlichungen/Sammlung/TR-2-2015-least-sqaures-with-ToA.pdf
-  // S. James Remington 1/2022
-  //
-  // A nice feature of this method is that the normal matrix depends only on the anchor arrangement
-  // and needs to be inverted only once. Hence, the position calculation should be robust.
-  //
-  static bool first = true;  //first time through, some preliminary work
-  float d[N_ANCHORS]; //temp vector, distances from anchors
+// ===== [Add] 改用 UWBMultilateration：mask 內的 anchor 數 >= 3 即可；d[i] = 第 i 個 anchor 的距離 =====
+// 方法同原本（以 anchor 0 相減的線性最小平方），anchor z 只用在 rmse；分解結果依 anchor 組合快取
+int trilat2D_4A(uint16_t mask, const float *d) {
 
-  static float A[N_ANCHORS - 1][2], Ainv[2][2], b[N_ANCHORS - 1], kv[N_ANCHORS]; //calculated in first call, used in later calls
-
-  int i, j, k;
-  // copy distances to local storage
-  for (i = 0; i < N_ANCHORS; i++) d[i] = last_anchor_distance[i];
+  float posn[3], rmse;
 
 #ifdef DEBUG_TRILAT
   char line[60];
@@ -154,87 +218,98 @@ int trilat2D_4A(void) {
   Serial.println(line);
 #endif
 
-  if (first) {  //intermediate fixed vectors
-    first = false;
-
-    float x[N_ANCHORS], y[N_ANCHORS]; //intermediate vectors
-
-    for (i = 0; i < N_ANCHORS; i++) {
-      x[i] = anchor_matrix[i][0];
-      y[i] = anchor_matrix[i][1];
-      kv[i] = x[i] * x[i] + y[i] * y[i];
-    }
-
-    // set up least squares equation
+  if (!mlat.solve(mask, d, posn, &rmse)) {
+    Serial.println("***Singular matrix, check anchor coordinates***");
+    return 0;
+  }
+  current_tag_position[0] = posn[0];
+  current_tag_position[1] = posn[1];
+  current_distance_rmse = rmse;
 
-    for (i = 1; i < N_ANCHORS; i++) {
-      A[i - 1][0] = x[i] - x[0];
-      A[i - 1][1] = y[i] - y[0];
-#ifdef DEBUG_TRILAT
-      snprintf(line, sizeof line, "A  %5.2f %5.2f", A[i - 1][0], A[i - 1][1]);
-      Serial.println(line);
-#endif
-    }
-    float ATA[2][2];  //calculate A transpose A
-    // Cij = sum(k) (Aki*Akj)
-    for (i = 0; i < 2; i++) {
-      for (j = 0; j < 2; j++) {
-        ATA[i][j] = 0.0;
-        for (k = 0; k < N_ANCHORS - 1; k++) ATA[i][j] += A[k][i] * A[k][j];
-      }
-    }
-#ifdef DEBUG_TRILAT
-    snprintf(line, sizeof line, "ATA %5.2f %5.2f\n    %5.2f %5.2f", ATA[0][0], ATA[0][1], ATA[1][0], ATA[1][1]);
-    Serial.println(line);
-#endif
+  return 1;
+}  //end trilat2D_4A
+// ========= [End Add] =========
 
-    //invert ATA
-    float det = ATA[0][0] * ATA[1][1] - ATA[1][0] * ATA[0][1];
-    if (fabs(det) < 1.0E-4) {
-      Serial.println("***Singular matrix, check anchor coordinates***");
-      while (1) delay(1); //hang
-    }
-    det = 1.0 / det;
-    //scale adjoint
-    Ainv[0][0] =  det * ATA[1][1];
-    Ainv[0][1] = -det * ATA[0][1];
-    Ainv[1][0] = -det * ATA[1][0];
-    Ainv[1][1] =  det * ATA[0][0];
-#ifdef DEBUG_TRILAT
-    snprintf(line, sizeof line, "Ainv %7.4f %7.4f\n     %7.4f %7.4f", Ainv[0][0], Ainv[0][1], Ainv[1][0], Ainv[1][1]);
-    Serial.println(line);
-    snprintf(line, sizeof line, "det Ainv %8.3e", det);
-    Serial.println(line);
+// ===== [Add] anchor 座標表：host 下載成功就存進 NVS；失敗用 NVS 裡上次的；都沒有用 anchor_matrix =====
+void loadLayout()
+{
+#ifdef LAYOUT_DOWNLOAD
+  if (downloadLayout()) {
+    if (!layout.store()) Serial.println("layout: NVS store failed");
+    printLayout("downloaded");
+    return;
+  }
 #endif
-
-  } //end if (first);
-
-  //least squares solution for position
-  //solve:  (x,y) = 0.5*(Ainv AT b)
-
-  for (i = 1; i < N_ANCHORS; i++) {
-    b[i - 1] = d[0] * d[0] - d[i] * d[i] + kv[i] - kv[0];
+  if (layout.load()) {
+    printLayout("from NVS");
+    return;
   }
-
-  float ATb[2] = {0.0}; //A transpose b
-  for (i = 0; i < N_ANCHORS - 1; i++) {
-    ATb[0] += A[i][0] * b[i];
-    ATb[1] += A[i][1] * b[i];
+  layout.clear();
+  for (int i = 0; i < N_ANCHORS; i++) {
+    layout.add(anchor_id[i], anchor_matrix[i][0], anchor_matrix[i][1], anchor_matrix[i][2]);
   }
+  printLayout("compiled-in");
+}
 
-  current_tag_position[0] = 0.5 * (Ainv[0][0] * ATb[0] + Ainv[0][1] * ATb[1]);
-  current_tag_position[1] = 0.5 * (Ainv[1][0] * ATb[0] + Ainv[1][1] * ATb[1]);
-
-  // calculate rms error for distances
-  float rmse = 0.0, dc0 = 0.0, dc1 = 0.0, dc2 = 0.0;
-  for (i = 0; i < N_ANCHORS; i++) {
-    dc0 = current_tag_position[0] - anchor_matrix[i][0];
-    dc1 = current_tag_position[1] - anchor_matrix[i][1];
-    dc2 = anchor_matrix[i][2]; //include known Z coordinate of anchor
-    dc0 = d[i] - sqrt(dc0 * dc0 + dc1 * dc1 + dc2 * dc2);
-    rmse += dc0 * dc0;
+void printLayout(const char *source)
+{
+  Serial.print("anchor layout (");
+  Serial.print(source);
+  Serial.println("):");
+  for (int i = 0; i < layout.count(); i++) {
+    const float *p = layout.position(i);
+    Serial.print(layout.id(i), HEX);
+    Serial.write(' ');
+    Serial.print(p[0]);
+    Serial.write(',');
+    Serial.print(p[1]);
+    Serial.write(',');
+    Serial.println(p[2]);
   }
-  current_distance_rmse = sqrt(rmse / ((float)N_ANCHORS));
+}
 
-  return 1;
-}  //end trilat2D_3A
+#ifdef LAYOUT_DOWNLOAD
+// 送 LAYOUT_REQUEST 給 host，等回覆（LAYOUT_MAGIC 開頭）；WiFi 連不上或沒回覆就回 false
+bool downloadLayout()
+{
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(ssid, password);
+  uint32_t t0 = millis();
+  while (WiFi.status() != WL_CONNECTED) {
+    if (millis() - t0 > 10000) {
+      Serial.println("layout: WiFi not connected");
+      WiFi.disconnect(true);
+      return false;
+    }
+    delay(200);
+  }
+  WiFiUDP udp;
+  udp.begin(LAYOUT_PORT);
+  bool ok = false;
+  char text[LAYOUT_TEXT_MAX];
+  for (int t = 0; t < LAYOUT_TRIES && !ok; t++) {
+    udp.beginPacket(layout_host, LAYOUT_PORT);
+    udp.write((const uint8_t *)LAYOUT_REQUEST, strlen(LAYOUT_REQUEST));
+    udp.endPacket();
+    uint32_t t1 = millis();
+    while (millis() - t1 < LAYOUT_TIMEOUT_MS) {
+      int len = udp.parsePacket();
+      if (len <= 0) {
+        delay(10);
+        continue;
+      }
+      len = udp.read((uint8_t *)text, sizeof(text) - 1);
+      if (len > 0 && strncmp(text, LAYOUT_MAGIC, strlen(LAYOUT_MAGIC)) == 0) {
+        text[len] = '\0';
+        ok = layout.parse(text, len);
+        break;
+      }
+    }
+  }
+  udp.stop();
+  WiFi.disconnect(true);   // 只在開機時用，之後不佔 2.4 GHz
+  if (!ok) Serial.println("layout: no reply from host");
+  return ok;
+}
+#endif
+// ========= [End Add] =========
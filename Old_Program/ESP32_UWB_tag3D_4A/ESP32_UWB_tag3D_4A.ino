@@ -8,11 +8,29 @@
 #include <SPI.h>
 #include "DW1000Ranging.h"
 #include "DW1000.h"
-#include "util/m33v3.h"   //matrix and vector macro library, all loops unrolled
+// ===== [Add] K 個 anchor 的最小平方解（取代 trilat3D_4A，少一個 anchor 也能定位） =====
+#include "UWBMultilateration.h"
+#include "UWBKalman.h"
+// ========= [End Add] =========
+// ===== [Add] anchor 座標從 host 下載（UWB_Anchor_Survey -S），不必每個場地重新編譯 anchor_matrix =====
+#include "UWBAnchorLayout.h"
+#define LAYOUT_DOWNLOAD    // 註解掉 = 只用 NVS 裡上次下載的座標，沒有就用下面的 anchor_matrix
+#ifdef LAYOUT_DOWNLOAD
+#include <WiFi.h>
+#include <WiFiUdp.h>
+const char *ssid = "PSS";
+const char *password = "047611137";
+const char *layout_host = "192.168.2.109";
+#define LAYOUT_TIMEOUT_MS 1000   // 每次等回覆多久
+#define LAYOUT_TRIES 3
+#endif
+// ========= [End Add] =========
 
 //#define DEBUG_TRILAT   //debug output in trilateration code
 //#define DEBUG_DISTANCES   //print collected anchor distances for algorithm
 //#define DEBUG_ANCHOR_ID  // print anchor IDs and raw distances
+#define REFINE_POSITION    // ===== [Add] 線性解之後做加權 Gauss-Newton 精修（Z 誤差明顯變小） =====
+#define KALMAN_TRACKING    // ===== [Add] 初始化後每筆 range 直接更新 Kalman filter，不必等 4 個 anchor =====
 
 #define SPI_SCK 18
 #define SPI_MISO 19
@@ -32,7 +50,7 @@ float current_tag_position[3] = {0}; //tag current position (meters with respect
 float current_distance_rmse = 0.0;  //error in distance calculations. Crude measure of coordinate error (needs to be characterized)
 
 // variables for position determination
-#define N_ANCHORS 4   //THIS VERSION WORKS ONLY WITH 4 ANCHORS. May be generalized to 5 or more.
+#define N_ANCHORS 4   //compiled-in anchors, used when no layout was downloaded (see UWBAnchorLayout)
 #define ANCHOR_DISTANCE_EXPIRED 5000   //measurements older than this are ignore (milliseconds)
 
 float anchor_matrix[N_ANCHORS][3] = { //list of anchor coordinates
@@ -41,15 +59,38 @@ float anchor_matrix[N_ANCHORS][3] = { //list of anchor coordinates
   {3.71, -0.3, 0.61},
   { -0.56, 4.88, 0.15}
 };
-
-uint32_t last_anchor_update[N_ANCHORS] = {0}; //millis() value last time anchor was seen
-float last_anchor_distance[N_ANCHORS] = {0.0}; //most recent distance reports
+// ===== [Add] anchor_matrix 每一列的 short address；實際使用的座標在 layout（slot = 表中的順序） =====
+uint16_t anchor_id[N_ANCHORS] = {0x81, 0x82, 0x83, 0x84};
+UWBAnchorLayout layout;
+// ========= [End Add] =========
+
+// ===== [Update] 陣列大小改成 LAYOUT_MAX_ANCHORS（下載的座標表可以超過 N_ANCHORS 台） =====
+uint32_t last_anchor_update[LAYOUT_MAX_ANCHORS] = {0}; //millis() value last time anchor was seen
+float last_anchor_distance[LAYOUT_MAX_ANCHORS] = {0.0}; //most recent distance reports
+float last_anchor_weight[LAYOUT_MAX_ANCHORS] = {0.0};   // ===== [Add] 訊號品質權重（RX / FP power） =====
+// ========= [End Update] =========
+
+// ===== [Add] solver：每種 anchor 組合的分解只算一次 =====
+UWBMultilateration mlat(3);
+#ifdef KALMAN_TRACKING
+#define KF_REINIT_REJECTS 8   // 連續這麼多筆被 gate 擋掉 => 用 LS 解重新初始化
+UWBKalman kf(3);
+#endif
+// ========= [End Add] =========
 
 void setup()
 {
   Serial.begin(115200);
   delay(1000);
 
+  // ===== [Update] anchor 座標：下載 -> NVS -> 編譯進去的 anchor_matrix，交給 solver，slot = layout 的順序 =====
+  loadLayout();
+  for (int i = 0; i < layout.count(); i++) {
+    const float *p = layout.position(i);
+    mlat.setAnchor(i, p[0], p[1], p[2]);
+  }
+  // ========= [End Update] =========
+
   //initialize configuration
   SPI.begin(SPI_SCK, SPI_MISO, SPI_MOSI);
   DW1000Ranging.initCommunication(PIN_RST, PIN_SS, PIN_IRQ); //Reset, CS, IRQ pin
@@ -75,12 +116,17 @@ void newRange()
 {
   int i;
 
-  //index of this anchor, expecting values 1 to 4
-  int index = DW1000Ranging.getDistantDevice()->getShortAddress() & 0x07; //expect devices 1 to 7
-  if (index > 0 && index < 5) {
+  // ===== [Update] 原版：index = short address & 0x07（1 到 4）；改成查 layout，index = slot + 1 =====
+  int index = layout.slotOf(DW1000Ranging.getDistantDevice()->getShortAddress()) + 1;
+  if (index > 0) {
+  // ========= [End Update] =========
     last_anchor_update[index - 1] = millis();  //(-1) => array index
     float range = DW1000Ranging.getDistantDevice()->getRange();
     last_anchor_distance[index-1] = range;
+    // ===== [Add] 權重：first path 越強越可信 =====
+    last_anchor_weight[index - 1] = UWBMultilateration::powerWeight(DW1000Ranging.getDistantDevice()->getRXPower(),
+                                                                    DW1000Ranging.getDistantDevice()->getFPPower());
+    // ========= [End Add] =========
     if (range < 0.0 || range > 30.0)     last_anchor_update[index - 1] = 0;  //sanity check, ignore this measurement
   }
 
@@ -89,27 +135,53 @@ void newRange()
   Serial.print(" ");;
   Serial.println(range);
 #endif
+
+  // ===== [Add] Kalman 追蹤中：這一筆 range 直接更新，不用做 LS =====
+#ifdef KALMAN_TRACKING
+  if (kf.isInitialized()) {
+    // 不認得的 anchor 或距離不合理：不更新，但也不能往下做 LS / reset
+    if (index > 0 && last_anchor_update[index - 1] > 0
+        && kf.updateRange(layout.position(index - 1), last_anchor_distance[index - 1], millis(), last_anchor_weight[index - 1])) {
+      kf.getPosition(current_tag_position);
+      Serial.print("K= ");  //tracked position, position sigma
+      Serial.print(current_tag_position[0]);
+      Serial.write(',');
+      Serial.print(current_tag_position[1]);
+      Serial.write(',');
+      Serial.print(current_tag_position[2]);
+      Serial.write(',');
+      Serial.println(kf.positionSigma());
+    }
+    if (kf.rejectedInRow() < KF_REINIT_REJECTS) return;
+    // 只有連續被擋太多次（跟丟了）才往下用 LS 重新初始化
+  }
+#endif
+  // ========= [End Add] =========
   //check for four measurements within the last interval
   int detected = 0;  //count anchors recently seen
+  uint16_t mask = 0; // ===== [Add] 哪些 anchor 的距離還有效 =====
 
-  for (i = 0; i < N_ANCHORS; i++) {
+  for (i = 0; i < layout.count(); i++) {
 
     if (millis() - last_anchor_update[i] > ANCHOR_DISTANCE_EXPIRED) last_anchor_update[i] = 0; //not from this one
-    if (last_anchor_update[i] > 0) detected++;
+    if (last_anchor_update[i] > 0) {
+      detected++;
+      mask |= (1u << i);
+    }
   }
-  if ( (detected == N_ANCHORS)) { //four recent measurements
+  if (detected >= mlat.minAnchors()) { //four or more recent measurements
 
 #ifdef DEBUG_DISTANCES
     // print distance and age of measurement
     uint32_t current_time = millis();
-    for (i = 0; i < N_ANCHORS; i++) {
+    for (i = 0; i < layout.count(); i++) {
       Serial.print(last_anchor_distance[i]);
       Serial.print("\t");
       Serial.println(current_time - last_anchor_update[i]); //age in millis
     }
 #endif
 
-    trilat3D_4A();
+    if (!trilat3D_4A(mask)) return;
     Serial.print("P= ");  //result
     Serial.print(current_tag_position[0]);
     Serial.write(',');
@@ -118,6 +190,9 @@ void newRange()
     Serial.print(current_tag_position[2]);
     Serial.write(',');
     Serial.println(current_distance_rmse);
+#ifdef KALMAN_TRACKING
+    kf.reset(current_tag_position, current_distance_rmse + 0.1f, millis());   // ===== [Add] LS 解當初始值 =====
+#endif
   }
 }  //end newRange
 
@@ -133,94 +208,120 @@ void inactiveDevice(DW1000Device *device)
   Serial.println(device->getShortAddress(), HEX);
 }
 
-int trilat3D_4A(void) {
-
-  // for method see technical paper at
-  // https://www.th-luebeck.de/fileadmin/media_cosa/Dateien/Veroeffentlichungen/Sammlung/TR-2-2015-least-sqaures-with-ToA.pdf
-  // S. J. Remington 1/2022
-  //
-  // A nice feature of this method is that the normal matrix depends only on the anchor arrangement
-  // and needs to be inverted only once. Hence, the position calculation should be robust.
-  //
-  static bool first = true;  //first time through, some preliminary work
-  float b[3], d[N_ANCHORS]; //distances from anchors
+// ===== [Add] 改用 UWBMultilateration：mask 內的 anchor 數 >= 4 即可 =====
+// 方法同原本（以 anchor 0 相減的線性最小平方），分解結果依 anchor 組合快取
+int trilat3D_4A(uint16_t mask) {
 
-  static float Ainv[3][3], k[N_ANCHORS]; //these are calculated only once
-
-  int i;
-  // copy distances to local storage
-  for (i = 0; i < N_ANCHORS; i++) d[i] = last_anchor_distance[i];
+  float posn[3], rmse;
 
 #ifdef DEBUG_TRILAT
   char line[60];
-  snprintf(line, sizeof line, "d: %6.2f %6.2f %6.2f d= %6.2f", d[0], d[1], d[2], d[3]);
+  snprintf(line, sizeof line, "d: %6.2f %6.2f %6.2f d= %6.2f", last_anchor_distance[0], last_anchor_distance[1],
+           last_anchor_distance[2], last_anchor_distance[3]);
   Serial.println(line);
 #endif
 
-  if (first) {  //intermediate fixed vectors
-    first = false;
-
-    float x[N_ANCHORS], y[N_ANCHORS], z[N_ANCHORS]; //intermediate vectors
-    float A[3][3];  //the A matrix for system of equations to solve
-
-    for (i = 0; i < N_ANCHORS; i++) {
-      x[i] = anchor_matrix[i][0];
-      y[i] = anchor_matrix[i][1];
-      z[i] = anchor_matrix[i][2];
-      k[i] = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
-    }
-
-    // set up the A matrix
-    for (i = 1; i < N_ANCHORS; i++) {
-      A[i - 1][0] = x[i] - x[0];
-      A[i - 1][1] = y[i] - y[0];
-      A[i - 1][2] = z[i] - z[0];
-#ifdef DEBUG_TRILAT
-      snprintf(line, sizeof line, "A %6.2f %6.2f %6.2f", A[i - 1][0], A[i - 1][1], A[i - 1][2]);
-      Serial.println(line);
+#ifdef REFINE_POSITION
+  uint8_t iters;
+  bool ok = mlat.solveRefined(mask, last_anchor_distance, last_anchor_weight, posn, &rmse, &iters);
+#else
+  bool ok = mlat.solve(mask, last_anchor_distance, posn, &rmse);
 #endif
-    }
-
-    float det;
-    DETERMINANT_3X3 (det, A);
-
-#ifdef DEBUG_TRILAT
-    //    check solution stability (small or zero)
-    Serial.print("Determinant of A matrix");
-    Serial.println(det);
+  if (!ok) {
+    Serial.println("***Singular matrix, check anchor coordinates***");
+    return 0;
+  }
+#if defined(REFINE_POSITION) && defined(DEBUG_TRILAT)
+  Serial.print("refine iterations: ");
+  Serial.println(iters);
 #endif
-    if (fabs(det) < 1.0e-4) {  //TODO : define as parameter
-      Serial.println("***Singular matrix, check anchor coordinates***");
-      while (1) delay(1); //hang
-    }
-
-    det = 1.0 / det;
-    SCALE_ADJOINT_3X3 (Ainv, det, A);  //Ainv is static
+  for (int i = 0; i < 3; i++) current_tag_position[i] = posn[i];
+  current_distance_rmse = rmse; //copy to global
 
-  } //end if (first)
+  return 1;
+}  //end trilat3D_4A
+// ========= [End Add] =========
 
-  // set up least squares equation
-  for (i = 1; i < 4; i++) {
-    b[i - 1] = d[0] * d[0] - d[i] * d[i] + k[i] - k[0];
+// ===== [Add] anchor 座標表：host 下載成功就存進 NVS；失敗用 NVS 裡上次的；都沒有用 anchor_matrix =====
+void loadLayout()
+{
+#ifdef LAYOUT_DOWNLOAD
+  if (downloadLayout()) {
+    if (!layout.store()) Serial.println("layout: NVS store failed");
+    printLayout("downloaded");
+    return;
   }
+#endif
+  if (layout.load()) {
+    printLayout("from NVS");
+    return;
+  }
+  layout.clear();
+  for (int i = 0; i < N_ANCHORS; i++) {
+    layout.add(anchor_id[i], anchor_matrix[i][0], anchor_matrix[i][1], anchor_matrix[i][2]);
+  }
+  printLayout("compiled-in");
+}
 
-  // solve:  2 A x posn = b
-
-  float posn2[3];
-  MAT_DOT_VEC_3X3(posn2, Ainv, b);
-  // copy to global current_tag_position[]
-  for (i = 0; i < 3; i++) current_tag_position[i] = posn2[i] * 0.5; //remove factor of 2
-
-  //rms error in measured versus calculated distances
-  float x[3] = {0}, rmse = 0.0, dc = 0.0;
-  for (i = 0; i < N_ANCHORS; i++) {
-    x[0] = anchor_matrix[i][0] - current_tag_position[0];
-    x[1] = anchor_matrix[i][1] - current_tag_position[1];
-    x[2] = anchor_matrix[i][2] - current_tag_position[2];
-    dc = sqrt(x[0] * x[0] + x[1] * x[1] + x[2] * x[2]);
-    rmse += (d[i] - dc) * (d[i] - dc);
+void printLayout(const char *source)
+{
+  Serial.print("anchor layout (");
+  Serial.print(source);
+  Serial.println("):");
+  for (int i = 0; i < layout.count(); i++) {
+    const float *p = layout.position(i);
+    Serial.print(layout.id(i), HEX);
+    Serial.write(' ');
+    Serial.print(p[0]);
+    Serial.write(',');
+    Serial.print(p[1]);
+    Serial.write(',');
+    Serial.println(p[2]);
   }
-  current_distance_rmse = sqrt(rmse / ((float)N_ANCHORS)); //copy to global
+}
 
-  return 1;
-}  //end trilat3D_4A
+#ifdef LAYOUT_DOWNLOAD
+// 送 LAYOUT_REQUEST 給 host，等回覆（LAYOUT_MAGIC 開頭）；WiFi 連不上或沒回覆就回 false
+bool downloadLayout()
+{
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(ssid, password);
+  uint32_t t0 = millis();
+  while (WiFi.status() != WL_CONNECTED) {
+    if (millis() - t0 > 10000) {
+      Serial.println("layout: WiFi not connected");
+      WiFi.disconnect(true);
+      return false;
+    }
+    delay(200);
+  }
+  WiFiUDP udp;
+  udp.begin(LAYOUT_PORT);
+  bool ok = false;
+  char text[LAYOUT_TEXT_MAX];
+  for (int t = 0; t < LAYOUT_TRIES && !ok; t++) {
+    udp.beginPacket(layout_host, LAYOUT_PORT);
+    udp.write((const uint8_t *)LAYOUT_REQUEST, strlen(LAYOUT_REQUEST));
+    udp.endPacket();
+    uint32_t t1 = millis();
+    while (millis() - t1 < LAYOUT_TIMEOUT_MS) {
+      int len = udp.parsePacket();
+      if (len <= 0) {
+        delay(10);
+        continue;
+      }
+      len = udp.read((uint8_t *)text, sizeof(text) - 1);
+      if (len > 0 && strncmp(text, LAYOUT_MAGIC, strlen(LAYOUT_MAGIC)) == 0) {
+        text[len] = '\0';
+        ok = layout.parse(text, len);
+        break;
+      }
+    }
+  }
+  udp.stop();
+  WiFi.disconnect(true);   // 只在開機時用，之後不佔 2.4 GHz
+  if (!ok) Serial.println("layout: no reply from host");
+  return ok;
+}
+#endif
+// ========= [End Add] =========
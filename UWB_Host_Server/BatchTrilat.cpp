@@ -0,0 +1,174 @@
+/*
+ * @file BatchTrilat.cpp
+ * SoA 批次定位，說明見 BatchTrilat.h
+ */
+
+#include "BatchTrilat.h"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BATCH_HAVE_X86 1
+#else
+#define BATCH_HAVE_X86 0
+#endif
+
+bool batchTrilatInit(BatchGeometry* g, const float (*anchors)[3], int k, int dim) {
+	g->dim = dim;
+	g->k = k;
+	g->ok = false;
+	if ((dim != 2 && dim != 3) || k < dim + 1 || k > BATCH_MAX_ANCHORS) return false;
+	for (int i = 0; i < k; i++) {
+		g->a[i][0] = anchors[i][0];
+		g->a[i][1] = anchors[i][1];
+		g->a[i][2] = anchors[i][2];
+		g->kv[i] = anchors[i][0] * anchors[i][0] + anchors[i][1] * anchors[i][1] +
+		           (dim == 3 ? anchors[i][2] * anchors[i][2] : 0.0f);
+	}
+
+	// M = 0.5 (A^T A)^-1 A^T，用 double 算（只做一次）
+	const int rows = k - 1;
+	double A[BATCH_MAX_ANCHORS - 1][3] = {{0}};
+	for (int i = 1; i < k; i++)
+		for (int c = 0; c < dim; c++) A[i - 1][c] = (double)anchors[i][c] - anchors[0][c];
+	double n[3][3] = {{0}}, inv[3][3];
+	for (int r = 0; r < dim; r++)
+		for (int c = 0; c < dim; c++)
+			for (int i = 0; i < rows; i++) n[r][c] += A[i][r] * A[i][c];
+	if (dim == 2) {
+		double det = n[0][0] * n[1][1] - n[0][1] * n[1][0];
+		if (fabs(det) < 1.0e-4) return false;
+		inv[0][0] =  n[1][1] / det;
+		inv[0][1] = -n[0][1] / det;
+		inv[1][0] = -n[1][0] / det;
+		inv[1][1] =  n[0][0] / det;
+	} else {
+		double c00 = n[1][1] * n[2][2] - n[1][2] * n[2][1];
+		double c01 = n[1][2] * n[2][0] - n[1][0] * n[2][2];
+		double c02 = n[1][0] * n[2][1] - n[1][1] * n[2][0];
+		double det = n[0][0] * c00 + n[0][1] * c01 + n[0][2] * c02;
+		if (fabs(det) < 1.0e-4) return false;
+		inv[0][0] = c00 / det;
+		inv[0][1] = (n[0][2] * n[2][1] - n[0][1] * n[2][2]) / det;
+		inv[0][2] = (n[0][1] * n[1][2] - n[0][2] * n[1][1]) / det;
+		inv[1][0] = c01 / det;
+		inv[1][1] = (n[0][0] * n[2][2] - n[0][2] * n[2][0]) / det;
+		inv[1][2] = (n[0][2] * n[1][0] - n[0][0] * n[1][2]) / det;
+		inv[2][0] = c02 / det;
+		inv[2][1] = (n[0][1] * n[2][0] - n[0][0] * n[2][1]) / det;
+		inv[2][2] = (n[0][0] * n[1][1] - n[0][1] * n[1][0]) / det;
+	}
+	for (int r = 0; r < 3; r++)
+		for (int i = 0; i < BATCH_MAX_ANCHORS - 1; i++) g->M[r][i] = 0.0f;
+	for (int r = 0; r < dim; r++)
+		for (int i = 0; i < rows; i++) {
+			double s = 0.0;
+			for (int c = 0; c < dim; c++) s += inv[r][c] * A[i][c];
+			g->M[r][i] = (float)(0.5 * s);
+		}
+	g->ok = true;
+	return true;
+}
+
+// 一筆 fix；AVX2 版本逐條對應這裡的運算順序
+static inline void solveOne(const BatchGeometry& g, const float* const* d, size_t j,
+                            float* x, float* y, float* z, float* rmse) {
+	const float d0 = d[0][j];
+	const float t0 = d0 * d0;
+	float p[3] = {0.0f, 0.0f, 0.0f};
+	for (int i = 1; i < g.k; i++) {
+		const float di = d[i][j];
+		const float b = (t0 - di * di) + (g.kv[i] - g.kv[0]);
+		for (int r = 0; r < g.dim; r++) p[r] = p[r] + g.M[r][i - 1] * b;
+	}
+	x[j] = p[0];
+	y[j] = p[1];
+	z[j] = p[2];
+	if (rmse != nullptr) {
+		float e = 0.0f;
+		for (int i = 0; i < g.k; i++) {
+			const float dx = g.a[i][0] - p[0], dy = g.a[i][1] - p[1], dz = g.a[i][2] - p[2];
+			const float r = d[i][j] - sqrtf((dx * dx + dy * dy) + dz * dz);
+			e = e + r * r;
+		}
+		rmse[j] = sqrtf(e / (float)g.k);
+	}
+}
+
+void batchTrilatSolveScalar(const BatchGeometry& g, const float* const* d, size_t n,
+                            float* x, float* y, float* z, float* rmse) {
+	for (size_t j = 0; j < n; j++) solveOne(g, d, j, x, y, z, rmse);
+}
+
+#if BATCH_HAVE_X86
+
+// 8 筆 fix（一個 __m256）
+__attribute__((target("avx2"))) static inline void solve8(const BatchGeometry& g, const float* const* d, size_t j,
+                                                          float* x, float* y, float* z, float* rmse) {
+	const __m256 d0 = _mm256_loadu_ps(d[0] + j);
+	const __m256 t0 = _mm256_mul_ps(d0, d0);
+	__m256 p0 = _mm256_setzero_ps(), p1 = _mm256_setzero_ps(), p2 = _mm256_setzero_ps();
+	for (int i = 1; i < g.k; i++) {
+		const __m256 di = _mm256_loadu_ps(d[i] + j);
+		const __m256 c = _mm256_set1_ps(g.kv[i] - g.kv[0]);
+		const __m256 b = _mm256_add_ps(_mm256_sub_ps(t0, _mm256_mul_ps(di, di)), c);
+		p0 = _mm256_add_ps(p0, _mm256_mul_ps(_mm256_set1_ps(g.M[0][i - 1]), b));
+		p1 = _mm256_add_ps(p1, _mm256_mul_ps(_mm256_set1_ps(g.M[1][i - 1]), b));
+		if (g.dim == 3) p2 = _mm256_add_ps(p2, _mm256_mul_ps(_mm256_set1_ps(g.M[2][i - 1]), b));
+	}
+	_mm256_storeu_ps(x + j, p0);
+	_mm256_storeu_ps(y + j, p1);
+	_mm256_storeu_ps(z + j, p2);
+	if (rmse != nullptr) {
+		__m256 e = _mm256_setzero_ps();
+		for (int i = 0; i < g.k; i++) {
+			const __m256 dx = _mm256_sub_ps(_mm256_set1_ps(g.a[i][0]), p0);
+			const __m256 dy = _mm256_sub_ps(_mm256_set1_ps(g.a[i][1]), p1);
+			const __m256 dz = _mm256_sub_ps(_mm256_set1_ps(g.a[i][2]), p2);
+			const __m256 s = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)),
+			                               _mm256_mul_ps(dz, dz));
+			const __m256 r = _mm256_sub_ps(_mm256_loadu_ps(d[i] + j), _mm256_sqrt_ps(s));
+			e = _mm256_add_ps(e, _mm256_mul_ps(r, r));
+		}
+		_mm256_storeu_ps(rmse + j, _mm256_sqrt_ps(_mm256_div_ps(e, _mm256_set1_ps((float)g.k))));
+	}
+}
+
+__attribute__((target("avx2"))) void batchTrilatSolveAvx2(const BatchGeometry& g, const float* const* d, size_t n,
+                                                          float* x, float* y, float* z, float* rmse) {
+	size_t j = 0;
+	// 一圈 16 筆：兩組獨立的 dependency chain，讓 mul / add 的 latency 疊起來
+	for (; j + 16 <= n; j += 16) {
+		solve8(g, d, j, x, y, z, rmse);
+		solve8(g, d, j + 8, x, y, z, rmse);
+	}
+	for (; j + 8 <= n; j += 8) solve8(g, d, j, x, y, z, rmse);
+	for (; j < n; j++) solveOne(g, d, j, x, y, z, rmse);
+}
+
+bool batchTrilatHasAvx2() {
+	return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+void batchTrilatSolveAvx2(const BatchGeometry& g, const float* const* d, size_t n,
+                          float* x, float* y, float* z, float* rmse) {
+	batchTrilatSolveScalar(g, d, n, x, y, z, rmse);
+}
+
+bool batchTrilatHasAvx2() {
+	return false;
+}
+
+#endif
+
+void batchTrilatSolve(const BatchGeometry& g, const float* const* d, size_t n,
+                      float* x, float* y, float* z, float* rmse) {
+	static const bool avx2 = batchTrilatHasAvx2();
+	if (avx2)
+		batchTrilatSolveAvx2(g, d, n, x, y, z, rmse);
+	else
+		batchTrilatSolveScalar(g, d, n, x, y, z, rmse);
+}
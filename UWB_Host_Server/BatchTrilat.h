@@ -0,0 +1,43 @@
+/*
+ * @file BatchTrilat.h
+ * 離線重播用的批次定位：structure-of-arrays，一次解很多筆同一組 anchor 的 fix
+ *
+ * 數學同 trilat2D_4A / trilat3D_4A（float，以 anchor 0 相減的線性最小平方）：
+ *   b_i = d_0^2 - d_i^2 + k_i - k_0，p = M b，M = 0.5 (A^T A)^-1 A^T 在 init 時算好
+ * 輸入 d[i][n] = 第 n 筆 fix 到第 i 個 anchor 的距離（anchor 為主的 SoA），輸出 x[n] / y[n] / z[n] / rmse[n]。
+ *
+ * batchTrilatSolve() 在執行期挑實作：CPU 有 AVX2 就一次 16 筆（兩組 8 x float），否則用 scalar。
+ * 兩條路徑的運算順序相同，也都不用 FMA，所以結果逐位元相同；和 trilat*_4A 的差異只在
+ * M 是用 double 先算好（原本是 float 反矩陣），誤差在 1e-5 m 等級。
+ */
+
+#ifndef _BatchTrilat_H_INCLUDED
+#define _BatchTrilat_H_INCLUDED
+
+#include <cstddef>
+
+#define BATCH_MAX_ANCHORS 16
+
+struct BatchGeometry {
+	int   dim;                              // 2 or 3
+	int   k;                                // anchor 數
+	bool  ok;
+	float a[BATCH_MAX_ANCHORS][3];
+	float kv[BATCH_MAX_ANCHORS];            // |a_i|^2（2D 只算 x, y，同 trilat2D_4A）
+	float M[3][BATCH_MAX_ANCHORS - 1];
+};
+
+// anchors[i] = 第 i 個 anchor 的 (x, y, z)；anchor 太少或幾何退化回 false
+bool batchTrilatInit(BatchGeometry* g, const float (*anchors)[3], int k, int dim);
+
+// rmse 可為 nullptr；2D 時 z 填 0
+void batchTrilatSolveScalar(const BatchGeometry& g, const float* const* d, size_t n,
+                            float* x, float* y, float* z, float* rmse);
+void batchTrilatSolveAvx2(const BatchGeometry& g, const float* const* d, size_t n,
+                          float* x, float* y, float* z, float* rmse);
+void batchTrilatSolve(const BatchGeometry& g, const float* const* d, size_t n,
+                      float* x, float* y, float* z, float* rmse);
+
+bool batchTrilatHasAvx2();
+
+#endif
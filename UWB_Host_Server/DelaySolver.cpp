@@ -0,0 +1,125 @@
+/*
+ * @file DelaySolver.cpp
+ * pairwise antenna delay 的最小平方解，說明見 DelaySolver.h
+ */
+
+#include "DelaySolver.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "UWBAntennaCal.h"   // ANTCAL_SEED_SLOPE
+
+static double median(std::vector<double> v) {
+	std::sort(v.begin(), v.end());
+	const size_t n = v.size();
+	return (n & 1) ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+}
+
+bool summarizePair(const std::vector<double>& r, PairStat* st) {
+	if (r.empty()) return false;
+	const double med = median(r);
+	std::vector<double> dev(r.size());
+	for (size_t i = 0; i < r.size(); i++) dev[i] = std::fabs(r[i] - med);
+	const double gate = std::max(3.0 * 1.4826 * median(dev), 3.0 * PAIR_MIN_SIGMA);
+	double sum = 0.0, sum2 = 0.0;
+	size_t k = 0;
+	for (double x : r) {
+		if (std::fabs(x - med) > gate) continue;
+		sum += x - med;
+		sum2 += (x - med) * (x - med);
+		k++;
+	}
+	if (k < 2) return false;
+	const double m = sum / k;
+	const double sd2 = std::max((sum2 - k * m * m) / (double)(k - 1), PAIR_MIN_SIGMA * PAIR_MIN_SIGMA);
+	st->used = k;
+	st->rejected = r.size() - k;
+	st->mean = med + m;
+	st->se = std::sqrt(sd2 / k);
+	return true;
+}
+
+// 對稱正定矩陣求反矩陣（Gauss-Jordan，partial pivot）；奇異回 false
+static bool invert(std::vector<std::vector<double>> a, std::vector<std::vector<double>>* inv) {
+	const size_t n = a.size();
+	inv->assign(n, std::vector<double>(n, 0.0));
+	for (size_t i = 0; i < n; i++) (*inv)[i][i] = 1.0;
+	double scale = 0.0;
+	for (size_t i = 0; i < n; i++) scale = std::max(scale, std::fabs(a[i][i]));
+	for (size_t c = 0; c < n; c++) {
+		size_t p = c;
+		for (size_t r = c + 1; r < n; r++)
+			if (std::fabs(a[r][c]) > std::fabs(a[p][c])) p = r;
+		if (std::fabs(a[p][c]) <= 1e-9 * scale) return false;
+		std::swap(a[p], a[c]);
+		std::swap((*inv)[p], (*inv)[c]);
+		const double d = a[c][c];
+		for (size_t j = 0; j < n; j++) {
+			a[c][j] /= d;
+			(*inv)[c][j] /= d;
+		}
+		for (size_t r = 0; r < n; r++) {
+			if (r == c || a[r][c] == 0.0) continue;
+			const double f = a[r][c];
+			for (size_t j = 0; j < n; j++) {
+				a[r][j] -= f * a[c][j];
+				(*inv)[r][j] -= f * (*inv)[c][j];
+			}
+		}
+	}
+	return true;
+}
+
+DelaySolveStatus solveDelays(const std::map<PairKey, PairInput>& pairs, const std::map<uint16_t, double>& usedDelay,
+                             DelaySolution* out) {
+	*out = DelaySolution();
+	// 只解有量到的 node
+	std::map<uint16_t, size_t> index;
+	for (auto& kv : pairs) {
+		for (uint16_t id : {kv.first.first, kv.first.second}) {
+			if (index.count(id)) continue;
+			index[id] = out->ids.size();
+			out->ids.push_back(id);
+		}
+	}
+	const size_t n = out->ids.size();
+	if (n < 3 || pairs.size() < n) return DELAY_SOLVE_TOO_FEW;
+
+	// 正規方程式：sum w (D_i + D_j - y_ij)^2，y_ij 與標準誤都換成 tick
+	const double S = ANTCAL_SEED_SLOPE;
+	std::vector<std::vector<double>> N(n, std::vector<double>(n, 0.0));
+	std::vector<double> b(n, 0.0);
+	for (auto& kv : pairs) {
+		const size_t i = index[kv.first.first], j = index[kv.first.second];
+		const PairStat& st = kv.second.stat;
+		const double y = usedDelay.at(kv.first.first) + usedDelay.at(kv.first.second) + (kv.second.distance - st.mean) / S;
+		const double w = (S * S) / (st.se * st.se);
+		N[i][i] += w;
+		N[j][j] += w;
+		N[i][j] += w;
+		N[j][i] += w;
+		b[i] += w * y;
+		b[j] += w * y;
+	}
+	std::vector<std::vector<double>> C;
+	if (!invert(N, &C)) return DELAY_SOLVE_SINGULAR;
+	out->delay.assign(n, 0.0);
+	for (size_t i = 0; i < n; i++)
+		for (size_t j = 0; j < n; j++) out->delay[i] += C[i][j] * b[j];
+
+	// 套用新 delay 後的殘差（m）與 chi2
+	for (auto& kv : pairs) {
+		const PairStat& st = kv.second.stat;
+		const double r = st.mean - kv.second.distance +
+		                 S * (out->delay[index[kv.first.first]] - usedDelay.at(kv.first.first) +
+		                      out->delay[index[kv.first.second]] - usedDelay.at(kv.first.second));
+		out->residual[kv.first] = r;
+		out->chi2 += (r / st.se) * (r / st.se);
+	}
+	out->dof = pairs.size() - n;
+	const double scale = (out->dof > 0) ? std::max(1.0, out->chi2 / out->dof) : 1.0;
+	out->sd.assign(n, 0.0);
+	for (size_t i = 0; i < n; i++) out->sd[i] = std::sqrt(C[i][i] * scale);
+	return DELAY_SOLVE_OK;
+}
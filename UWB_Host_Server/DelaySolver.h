@@ -0,0 +1,62 @@
+/*
+ * @file DelaySolver.h
+ * pairwise antenna delay 的最小平方解（UWB_Delay_Solver 的核心，UWB_DelaySolver_Sim 也用）
+ *
+ * 模型：range_ij + S * ((D_i - d_i) + (D_j - d_j)) = |p_i - p_j|，S = ANTCAL_SEED_SLOPE
+ *   => D_i + D_j = d_i + d_j + (|p_i - p_j| - range_ij) / S
+ * 每一對先用 median / MAD 去掉離群值再取平均與標準誤（summarizePair），1 / 標準誤^2 當權重解正規方程式（solveDelays）。
+ * 方程式只和 D_i + D_j 有關：至少 3 台，且 pair 圖不能是二分圖（只有 anchor-tag），否則差一個自由度解不出來。
+ */
+
+#ifndef _DelaySolver_H_INCLUDED
+#define _DelaySolver_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#define PAIR_MIN_SIGMA 0.01   // m：單筆雜訊下限（量化過的 range 標準差可能算成 0）
+
+typedef std::pair<uint16_t, uint16_t> PairKey;   // (小的位址, 大的位址)
+
+struct PairStat {
+	size_t used = 0, rejected = 0;
+	double mean = 0.0;     // 去離群值後的平均 range（m）
+	double se = 0.0;       // 平均值的標準誤（m）
+};
+
+// solveDelays() 的輸入：一對的統計 + 已知距離
+struct PairInput {
+	PairStat stat;
+	double   distance = 0.0;   // |p_i - p_j|（m）
+};
+
+struct DelaySolution {
+	std::vector<uint16_t> ids;          // 有量到的 node（依第一次出現的順序）
+	std::vector<double>   delay;        // 新 delay（tick）
+	std::vector<double>   sd;           // 1 sd（tick），reduced chi2 > 1 時照比例放大
+	std::map<PairKey, double> residual; // 套用新 delay 後的殘差（m）
+	double chi2 = 0.0;
+	size_t dof = 0;
+};
+
+enum DelaySolveStatus {
+	DELAY_SOLVE_OK = 0,
+	DELAY_SOLVE_TOO_FEW,     // < 3 台，或 pair 數 < node 數
+	DELAY_SOLVE_SINGULAR,    // 正規方程式奇異（pair 圖是二分圖）
+};
+
+static inline PairKey pairKey(uint16_t a, uint16_t b) {
+	return a < b ? PairKey(a, b) : PairKey(b, a);
+}
+
+// r = 同一對的所有 range（m）；去掉離群值後不到 2 筆回 false
+bool summarizePair(const std::vector<double>& r, PairStat* st);
+
+// usedDelay：每台量測時用的 delay（tick），pairs 裡出現的 node 都要有
+DelaySolveStatus solveDelays(const std::map<PairKey, PairInput>& pairs, const std::map<uint16_t, double>& usedDelay,
+                             DelaySolution* out);
+
+#endif
@@ -0,0 +1,32 @@
+/*
+ * @file HostTest.h
+ * host 端 library 測試共用的檢查巨集（UWB_*_Test.cpp / UWB_*_Bench.cpp）
+ *
+ * 失敗只記錄不中止，跑完用 testSummary() 印結果，main() 回傳它當 exit code（0 = 全部通過）。
+ */
+
+#ifndef _HostTest_H_INCLUDED
+#define _HostTest_H_INCLUDED
+
+#include <cstdio>
+
+static int g_testChecks = 0;
+static int g_testFailures = 0;
+
+#define TEST_CHECK(cond, ...) \
+	do { \
+		g_testChecks++; \
+		if (!(cond)) { \
+			g_testFailures++; \
+			fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+			fprintf(stderr, __VA_ARGS__); \
+			fputc('\n', stderr); \
+		} \
+	} while (0)
+
+static inline int testSummary(const char* name) {
+	printf("%s: %d checks, %d failed -> %s\n", name, g_testChecks, g_testFailures, g_testFailures ? "FAIL" : "PASS");
+	return g_testFailures ? 1 : 0;
+}
+
+#endif
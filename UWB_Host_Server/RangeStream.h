@@ -0,0 +1,26 @@
+/*
+ * @file RangeStream.h
+ * ingest server 輸出的 range 串流格式（檔案 / 下游 solver 共用）
+ *
+ * 檔案 = 連續的 RangeSample（32 bytes，little-endian host），依 hostNs 由小到大排序。
+ */
+
+#ifndef _RangeStream_H_INCLUDED
+#define _RangeStream_H_INCLUDED
+
+#include <cstdint>
+
+struct RangeSample {
+	uint64_t hostNs;    // host 收到 datagram 的時間（CLOCK_MONOTONIC，ns）
+	uint64_t dwTime;    // datagram header 的 DW1000 40-bit timestamp
+	uint32_t seq;       // datagram 序號
+	uint16_t tagId;
+	uint16_t anchor;
+	int32_t  rangeMm;
+	int16_t  rxPower;   // 0.01 dBm
+	int16_t  fpPower;   // 0.01 dBm
+};
+
+static_assert(sizeof(RangeSample) == 32, "RangeSample layout");
+
+#endif
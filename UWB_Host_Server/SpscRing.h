@@ -0,0 +1,72 @@
+/*
+ * @file SpscRing.h
+ * 單一生產者 / 單一消費者的 lock-free ring（host 端 thread 之間交接資料用）
+ *
+ * - 容量固定（2 的次方），建構時一次配置，之後不再配置記憶體
+ * - head / tail 各自放在不同 cache line，避免兩個 thread 互相搶
+ * - 生產者、消費者各只能有一個 thread
+ */
+
+#ifndef _SpscRing_H_INCLUDED
+#define _SpscRing_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+template <typename T>
+class SpscRing {
+public:
+	explicit SpscRing(size_t capacityPow2) : _mask(capacityPow2 - 1), _slots(capacityPow2) {
+		_head.store(0, std::memory_order_relaxed);
+		_tail.store(0, std::memory_order_relaxed);
+	}
+
+	// 生產者：拿到下一個可寫的 slot（滿了回傳 nullptr），寫完呼叫 commit()
+	T* claim() {
+		size_t t = _tail.load(std::memory_order_relaxed);
+		if (t - _headCache > _mask) {
+			_headCache = _head.load(std::memory_order_acquire);
+			if (t - _headCache > _mask) return nullptr;
+		}
+		return &_slots[t & _mask];
+	}
+	void commit() {
+		_tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+	bool push(const T& v) {
+		T* s = claim();
+		if (s == nullptr) return false;
+		*s = v;
+		commit();
+		return true;
+	}
+
+	// 消費者：看最前面一筆（空的回傳 nullptr），用完呼叫 pop()
+	T* front() {
+		size_t h = _head.load(std::memory_order_relaxed);
+		if (h == _tailCache) {
+			_tailCache = _tail.load(std::memory_order_acquire);
+			if (h == _tailCache) return nullptr;
+		}
+		return &_slots[h & _mask];
+	}
+	void pop() {
+		_head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	bool empty() const {
+		return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+	}
+
+private:
+	const size_t _mask;
+	std::vector<T> _slots;
+
+	alignas(64) std::atomic<size_t> _head;   // 消費者寫
+	size_t _tailCache = 0;                   // 消費者看到的 tail
+	alignas(64) std::atomic<size_t> _tail;   // 生產者寫
+	size_t _headCache = 0;                   // 生產者看到的 head
+};
+
+#endif
@@ -0,0 +1,561 @@
+/*
+ * @file UWB_Anchor_Survey.cpp
+ * Anchor 自我測量：用 anchor 之間互量的距離算出每台 anchor 的座標，並用 UDP 提供 tag 下載（UWBAnchorLayout）
+ *
+ * 量測：所有 anchor 跑 ESP32_UWB_pairwise_calibrate.ino（輪流當 TAG 互量），serial log 接在一起當輸入，
+ *       只用 RNG,<自己>,<對方>,<range> 行。antenna delay 要先校正好（UWB_Delay_Solver），否則距離整體偏長。
+ *
+ * 解法：
+ *   1. 每一對 median / MAD 去離群值後取平均與標準誤
+ *   2. classical MDS 初始值：距離平方矩陣雙中心化，取最大的 m 個特徵向量
+ *      （沒量到的 pair 先用最短路徑補，再反覆用 MDS 解出來的距離取代；每台至少要量到 m + 1 台才定得住）
+ *   3. 加權 Levenberg-Marquardt 精修 sum w (|p_i - p_j| - d_ij)^2，只用有量到的 pair，w = 1 / 標準誤^2
+ *   座標系（MDS 只決定到旋轉 / 平移 / 鏡射）：第 1 台 = 原點，第 2 台在 +x 軸上，第 3 台在 y > 0（順序用 -r 指定，
+ *   預設位址由小到大）。
+ *   -m 2（預設）：anchor 常常差不多同高，互量的距離決定不了 z；z 用 -z 檔案給的高度（捲尺量離地高度比量水平座標容易），
+ *                 沒給就全部當 0，只解 x, y。-z 檔每行 "id z" 或 "id x y z"（可以直接用舊的 anchors.txt，只取 z），
+ *                 id 是 16 進位、# 開頭是註解。
+ *   -m 3：x, y, z 都解，第 3 台在 z = 0 平面上，其他 anchor 平均在 z >= 0 那側；anchor 高度差太小時 z 的標準差會很大。
+ *
+ * 輸出：每台座標 ± 標準差（殘差 reduced chi2 > 1 時照比例放大）和每一對的殘差；-o 寫成 anchors.txt 格式。
+ * -S：（解完或讀 -a 的檔案後）在 UDP LAYOUT_PORT 等 tag 的 LAYOUT_REQUEST，回傳座標表（Ctrl+C 結束）。
+ *
+ * 編譯：
+ *   g++ -O2 -std=c++17 -I../DW1000_BACKUP/src_0205 UWB_Anchor_Survey.cpp ../DW1000_BACKUP/src_0205/UWBAnchorLayout.cpp \
+ *       -o uwb_survey
+ * 執行：
+ *   ./uwb_survey -i pairs.log [-m 2|3] [-z heights.txt] [-r 81,82,83] [-x 7D] [-o anchors.txt] [-S [-p 8002]]
+ *   ./uwb_survey -a anchors.txt -S            （只提供下載）
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "UWBAnchorLayout.h"
+
+#define PAIR_MIN_SIGMA 0.01   // m：單筆雜訊下限
+#define LM_MAX_ITERS   100
+
+typedef std::pair<uint16_t, uint16_t> PairKey;   // (小的位址, 大的位址)
+typedef std::vector<std::vector<double>> Matrix;
+
+struct PairStat {
+	size_t used = 0, rejected = 0;
+	double mean = 0.0;     // 去離群值後的平均 range（m）
+	double se = 0.0;       // 平均值的標準誤（m）
+};
+
+static PairKey pairKey(uint16_t a, uint16_t b) {
+	return a < b ? PairKey(a, b) : PairKey(b, a);
+}
+
+static double median(std::vector<double> v) {
+	std::sort(v.begin(), v.end());
+	const size_t n = v.size();
+	return (n & 1) ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+}
+
+static bool summarize(const std::vector<double>& r, PairStat* st) {
+	const double med = median(r);
+	std::vector<double> dev(r.size());
+	for (size_t i = 0; i < r.size(); i++) dev[i] = std::fabs(r[i] - med);
+	const double gate = std::max(3.0 * 1.4826 * median(dev), 3.0 * PAIR_MIN_SIGMA);
+	double sum = 0.0, sum2 = 0.0;
+	size_t k = 0;
+	for (double x : r) {
+		if (std::fabs(x - med) > gate) continue;
+		sum += x - med;
+		sum2 += (x - med) * (x - med);
+		k++;
+	}
+	if (k < 2) return false;
+	const double m = sum / k;
+	const double sd2 = std::max((sum2 - k * m * m) / (double)(k - 1), PAIR_MIN_SIGMA * PAIR_MIN_SIGMA);
+	st->used = k;
+	st->rejected = r.size() - k;
+	st->mean = med + m;
+	st->se = std::sqrt(sd2 / k);
+	return true;
+}
+
+// 反矩陣（Gauss-Jordan，partial pivot）；奇異回 false
+static bool invert(Matrix a, Matrix* inv) {
+	const size_t n = a.size();
+	inv->assign(n, std::vector<double>(n, 0.0));
+	for (size_t i = 0; i < n; i++) (*inv)[i][i] = 1.0;
+	double scale = 0.0;
+	for (size_t i = 0; i < n; i++) scale = std::max(scale, std::fabs(a[i][i]));
+	for (size_t c = 0; c < n; c++) {
+		size_t p = c;
+		for (size_t r = c + 1; r < n; r++)
+			if (std::fabs(a[r][c]) > std::fabs(a[p][c])) p = r;
+		if (std::fabs(a[p][c]) <= 1e-12 * scale) return false;
+		std::swap(a[p], a[c]);
+		std::swap((*inv)[p], (*inv)[c]);
+		const double d = a[c][c];
+		for (size_t j = 0; j < n; j++) {
+			a[c][j] /= d;
+			(*inv)[c][j] /= d;
+		}
+		for (size_t r = 0; r < n; r++) {
+			if (r == c || a[r][c] == 0.0) continue;
+			const double f = a[r][c];
+			for (size_t j = 0; j < n; j++) {
+				a[r][j] -= f * a[c][j];
+				(*inv)[r][j] -= f * (*inv)[c][j];
+			}
+		}
+	}
+	return true;
+}
+
+// 對稱矩陣特徵分解（cyclic Jacobi）：a 會變成對角（特徵值），v 的第 k 行是第 k 個特徵向量
+static void jacobiEigen(Matrix& a, Matrix* v) {
+	const size_t n = a.size();
+	v->assign(n, std::vector<double>(n, 0.0));
+	for (size_t i = 0; i < n; i++) (*v)[i][i] = 1.0;
+	for (int sweep = 0; sweep < 64; sweep++) {
+		double off = 0.0;
+		for (size_t p = 0; p < n; p++)
+			for (size_t q = p + 1; q < n; q++) off += a[p][q] * a[p][q];
+		if (off < 1e-20) break;
+		for (size_t p = 0; p < n; p++) {
+			for (size_t q = p + 1; q < n; q++) {
+				if (std::fabs(a[p][q]) < 1e-300) continue;
+				const double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+				const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+				const double c = 1.0 / std::sqrt(t * t + 1.0), s = t * c;
+				for (size_t k = 0; k < n; k++) {
+					const double akp = a[k][p], akq = a[k][q];
+					a[k][p] = c * akp - s * akq;
+					a[k][q] = s * akp + c * akq;
+				}
+				for (size_t k = 0; k < n; k++) {
+					const double apk = a[p][k], aqk = a[q][k];
+					a[p][k] = c * apk - s * aqk;
+					a[q][k] = s * apk + c * aqk;
+				}
+				for (size_t k = 0; k < n; k++) {
+					const double vkp = (*v)[k][p], vkq = (*v)[k][q];
+					(*v)[k][p] = c * vkp - s * vkq;
+					(*v)[k][q] = s * vkp + c * vkq;
+				}
+			}
+		}
+	}
+}
+
+// classical MDS：完整距離矩陣 -> dim 維座標
+static void classicalMds(const Matrix& d, int dim, std::vector<std::vector<double>>* p) {
+	const size_t n = d.size();
+	Matrix b(n, std::vector<double>(n, 0.0));
+	std::vector<double> row(n, 0.0);
+	double all = 0.0;
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = 0; j < n; j++) row[i] += d[i][j] * d[i][j];
+		all += row[i];
+		row[i] /= n;
+	}
+	all /= (double)(n * n);
+	for (size_t i = 0; i < n; i++)
+		for (size_t j = 0; j < n; j++) b[i][j] = -0.5 * (d[i][j] * d[i][j] - row[i] - row[j] + all);
+	Matrix v;
+	jacobiEigen(b, &v);
+	std::vector<size_t> order(n);
+	for (size_t i = 0; i < n; i++) order[i] = i;
+	std::sort(order.begin(), order.end(), [&](size_t x, size_t y) { return b[x][x] > b[y][y]; });
+	p->assign(n, std::vector<double>(3, 0.0));
+	for (int c = 0; c < dim && c < (int)n; c++) {
+		const double lambda = std::max(b[order[c]][order[c]], 0.0);
+		for (size_t i = 0; i < n; i++) (*p)[i][c] = v[i][order[c]] * std::sqrt(lambda);
+	}
+}
+
+// 轉到固定的座標系：第 0 台 = 原點，第 1 台在 +x，第 2 台在 y > 0（3 維時在 z = 0 平面，其他平均 z >= 0）
+static bool toFrame(std::vector<std::vector<double>>* p, int dim) {
+	std::vector<std::vector<double>>& q = *p;
+	const size_t n = q.size();
+	const std::vector<double> o = q[0];
+	double e[3][3] = {{0}};
+	double v1[3], v2[3];
+	for (int c = 0; c < 3; c++) {
+		v1[c] = (c < dim) ? q[1][c] - o[c] : 0.0;
+		v2[c] = (c < dim) ? q[2][c] - o[c] : 0.0;
+	}
+	double l = std::sqrt(v1[0] * v1[0] + v1[1] * v1[1] + v1[2] * v1[2]);
+	if (l < 1e-6) return false;
+	for (int c = 0; c < 3; c++) e[0][c] = v1[c] / l;
+	const double dot = v2[0] * e[0][0] + v2[1] * e[0][1] + v2[2] * e[0][2];
+	for (int c = 0; c < 3; c++) v2[c] -= dot * e[0][c];
+	l = std::sqrt(v2[0] * v2[0] + v2[1] * v2[1] + v2[2] * v2[2]);
+	if (l < 1e-6) return false;   // 前三台共線
+	for (int c = 0; c < 3; c++) e[1][c] = v2[c] / l;
+	e[2][0] = e[0][1] * e[1][2] - e[0][2] * e[1][1];
+	e[2][1] = e[0][2] * e[1][0] - e[0][0] * e[1][2];
+	e[2][2] = e[0][0] * e[1][1] - e[0][1] * e[1][0];
+	std::vector<std::vector<double>> r(n, std::vector<double>(3, 0.0));
+	double zsum = 0.0;
+	for (size_t i = 0; i < n; i++) {
+		double d[3];
+		for (int c = 0; c < 3; c++) d[c] = (c < dim) ? q[i][c] - o[c] : 0.0;
+		for (int k = 0; k < dim; k++) r[i][k] = d[0] * e[k][0] + d[1] * e[k][1] + d[2] * e[k][2];
+		if (dim == 3) zsum += r[i][2];
+	}
+	for (size_t i = 0; i < n; i++) {
+		if (dim == 3 && zsum < 0.0) r[i][2] = -r[i][2];
+		for (int c = 0; c < dim; c++) q[i][c] = r[i][c];   // 2 維時 z 保持原本的高度
+	}
+	return true;
+}
+
+static bool loadLayoutFile(const char* path, UWBAnchorLayout* layout) {
+	FILE* f = fopen(path, "rb");
+	if (f == nullptr) return false;
+	std::vector<char> text(64 * 1024);
+	size_t n = fread(text.data(), 1, text.size(), f);
+	fclose(f);
+	return layout->parse(text.data(), n);
+}
+
+// -z 檔：每行 "id z" 或 "id x y z"（直接用 anchors.txt 也可以，只取 z）；# 開頭是註解
+static bool loadHeights(const char* path, std::map<uint16_t, double>* height) {
+	FILE* f = fopen(path, "r");
+	if (f == nullptr) return false;
+	char line[256];
+	int lineNo = 0;
+	while (fgets(line, sizeof(line), f)) {
+		lineNo++;
+		const char* p = line + strspn(line, " \t");
+		if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0') continue;
+		unsigned id;
+		double v[3];
+		const int k = sscanf(p, "%x %lf %lf %lf", &id, &v[0], &v[1], &v[2]);
+		if (k == 2 || k == 4) {
+			(*height)[(uint16_t)id] = v[k - 2];
+		} else {
+			fprintf(stderr, "%s:%d: expected \"id z\" or \"id x y z\", ignored\n", path, lineNo);
+		}
+	}
+	fclose(f);
+	return !height->empty();
+}
+
+static int serveLayout(const UWBAnchorLayout& layout, int port) {
+	char text[LAYOUT_TEXT_MAX];
+	const int len = layout.format(text, sizeof(text));
+	if (len <= 0) {
+		fprintf(stderr, "layout does not fit in one reply\n");
+		return 1;
+	}
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0) {
+		perror("socket");
+		return 1;
+	}
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons((uint16_t)port);
+	if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+		perror("bind");
+		return 1;
+	}
+	fprintf(stderr, "*** serving %u anchors on UDP %d ***\n", layout.count(), port);
+	char buf[64];
+	for (;;) {
+		sockaddr_in from;
+		socklen_t fromLen = sizeof(from);
+		ssize_t n = recvfrom(fd, buf, sizeof(buf), 0, (sockaddr*)&from, &fromLen);
+		if (n < 0) {
+			perror("recvfrom");
+			break;
+		}
+		if ((size_t)n < strlen(LAYOUT_REQUEST) || memcmp(buf, LAYOUT_REQUEST, strlen(LAYOUT_REQUEST)) != 0) continue;
+		sendto(fd, text, (size_t)len, 0, (sockaddr*)&from, fromLen);
+		fprintf(stderr, "[LAYOUT] sent to %s:%u\n", inet_ntoa(from.sin_addr), ntohs(from.sin_port));
+	}
+	close(fd);
+	return 1;
+}
+
+int main(int argc, char** argv) {
+	const char* inPath = nullptr;
+	const char* layoutPath = nullptr;
+	const char* heightPath = nullptr;
+	const char* outPath = nullptr;
+	int dim = 2, port = LAYOUT_PORT;
+	size_t minSamples = 10;
+	bool serve = false;
+	std::vector<uint16_t> refOrder;
+	std::set<uint16_t> excluded;
+	int opt;
+	while ((opt = getopt(argc, argv, "i:a:z:o:m:n:r:x:Sp:h")) != -1) {
+		switch (opt) {
+			case 'i': inPath = optarg; break;
+			case 'a': layoutPath = optarg; break;
+			case 'z': heightPath = optarg; break;
+			case 'o': outPath = optarg; break;
+			case 'm': dim = atoi(optarg); break;
+			case 'n': minSamples = (size_t)atol(optarg); break;
+			case 'r': {
+				for (char* t = strtok(optarg, ","); t != nullptr; t = strtok(nullptr, ","))
+					refOrder.push_back((uint16_t)strtoul(t, nullptr, 16));
+				break;
+			}
+			case 'x': excluded.insert((uint16_t)strtoul(optarg, nullptr, 16)); break;
+			case 'S': serve = true; break;
+			case 'p': port = atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s -i pairs.log [-m 2|3] [-z heights.txt] [-r id,id,id] [-x id] [-n min_samples] "
+				                "[-o anchors.txt] [-S [-p port]]\n"
+				                "       %s -a anchors.txt -S [-p port]\n"
+				                "  heights.txt: one \"id z\" or \"id x y z\" per line (hex id, m)\n", argv[0], argv[0]);
+				return 1;
+		}
+	}
+	if (dim != 2 && dim != 3) dim = 2;
+
+	UWBAnchorLayout layout;
+	if (inPath == nullptr) {
+		// 只提供下載
+		if (layoutPath == nullptr || !loadLayoutFile(layoutPath, &layout)) {
+			fprintf(stderr, "need -i pairs.log, or -a anchors.txt to serve\n");
+			return 1;
+		}
+		return serve ? serveLayout(layout, port) : 0;
+	}
+
+	std::map<uint16_t, double> height;
+	if (heightPath != nullptr && !loadHeights(heightPath, &height)) {
+		fprintf(stderr, "cannot load heights from %s\n", heightPath);
+		return 1;
+	}
+
+	// ===== 讀 log，每一對去離群值後取平均 =====
+	FILE* in = (inPath[0] == '-') ? stdin : fopen(inPath, "r");
+	if (in == nullptr) {
+		perror(inPath);
+		return 1;
+	}
+	std::map<PairKey, std::vector<double>> samples;
+	char line[256];
+	while (fgets(line, sizeof(line), in)) {
+		const char* p = strstr(line, "RNG,");
+		unsigned a, b;
+		double r;
+		if (p == nullptr || sscanf(p, "RNG,%x,%x,%lf", &a, &b, &r) != 3 || a == b) continue;
+		if (excluded.count((uint16_t)a) || excluded.count((uint16_t)b)) continue;
+		samples[pairKey((uint16_t)a, (uint16_t)b)].push_back(r);
+	}
+	if (in != stdin) fclose(in);
+	std::map<PairKey, PairStat> pairs;
+	std::set<uint16_t> seen;
+	for (auto& kv : samples) {
+		PairStat st;
+		if (kv.second.size() < minSamples || !summarize(kv.second, &st)) continue;
+		pairs[kv.first] = st;
+		seen.insert(kv.first.first);
+		seen.insert(kv.first.second);
+	}
+
+	// 順序：-r 指定的在前（原點、+x、y > 0），其他依位址
+	std::vector<uint16_t> ids;
+	for (uint16_t id : refOrder)
+		if (seen.count(id) && std::find(ids.begin(), ids.end(), id) == ids.end()) ids.push_back(id);
+	for (uint16_t id : seen)
+		if (std::find(ids.begin(), ids.end(), id) == ids.end()) ids.push_back(id);
+	const size_t n = ids.size();
+	std::map<uint16_t, size_t> index;
+	for (size_t i = 0; i < n; i++) index[ids[i]] = i;
+	const size_t nParams = (dim == 2) ? 2 * n - 3 : 3 * n - 6;
+	printf("anchors=%zu pairs=%zu dim=%d\n", n, pairs.size(), dim);
+	if (n < (size_t)dim + 1 || pairs.size() < nParams) {
+		fprintf(stderr, "need >= %d anchors and >= %zu measured pairs\n", dim + 1, nParams);
+		return 1;
+	}
+	auto z0 = [&](uint16_t id) {
+		auto it = height.find(id);
+		return (dim == 2 && it != height.end()) ? it->second : 0.0;
+	};
+
+	// ===== MDS 初始值：2 維時用水平距離，沒量到的 pair 用最短路徑（Floyd）補 =====
+	const double inf = 1e9;
+	Matrix d(n, std::vector<double>(n, inf));
+	for (size_t i = 0; i < n; i++) d[i][i] = 0.0;
+	for (auto& kv : pairs) {
+		const size_t i = index[kv.first.first], j = index[kv.first.second];
+		double v = kv.second.mean;
+		if (dim == 2) {
+			const double dz = z0(kv.first.first) - z0(kv.first.second);
+			v = std::sqrt(std::max(v * v - dz * dz, 0.0));
+		}
+		d[i][j] = d[j][i] = v;
+	}
+	for (size_t k = 0; k < n; k++)
+		for (size_t i = 0; i < n; i++)
+			for (size_t j = 0; j < n; j++) d[i][j] = std::min(d[i][j], d[i][k] + d[k][j]);
+	for (size_t i = 0; i < n; i++)
+		for (size_t j = 0; j < n; j++)
+			if (d[i][j] >= inf) {
+				fprintf(stderr, "anchor %X is not connected to %X\n", ids[i], ids[j]);
+				return 1;
+			}
+	// 沒量到的 pair：最短路徑只是上限，用「MDS -> 用解出來的距離取代 -> 再 MDS」反覆修正到一致
+	std::vector<std::vector<double>> pos;
+	std::vector<std::vector<bool>> measured(n, std::vector<bool>(n, false));
+	for (auto& kv : pairs) measured[index[kv.first.first]][index[kv.first.second]] = measured[index[kv.first.second]][index[kv.first.first]] = true;
+	for (int it = 0; it < 200; it++) {
+		classicalMds(d, dim, &pos);
+		double change = 0.0;
+		for (size_t i = 0; i < n; i++) {
+			for (size_t j = 0; j < n; j++) {
+				if (i == j || measured[i][j]) continue;
+				double l = 0.0;
+				for (int c = 0; c < dim; c++) l += (pos[i][c] - pos[j][c]) * (pos[i][c] - pos[j][c]);
+				change = std::max(change, std::fabs(std::sqrt(l) - d[i][j]));
+				d[i][j] = std::sqrt(l);
+			}
+		}
+		if (change < 1e-4) break;
+	}
+	for (size_t i = 0; i < n; i++)
+		if (dim == 2) pos[i][2] = z0(ids[i]);
+	if (!toFrame(&pos, dim)) {
+		fprintf(stderr, "first three anchors (%X, %X, %X) are collinear, choose others with -r\n", ids[0], ids[1], ids[2]);
+		return 1;
+	}
+
+	// ===== 加權 LM：未知數 = 座標系固定之外的座標 =====
+	std::vector<std::pair<size_t, int>> param;   // (node, 軸)
+	for (size_t i = 1; i < n; i++)
+		for (int c = 0; c < dim; c++)
+			if (!(i == 1 && c > 0) && !(i == 2 && c > 1)) param.push_back({i, c});
+	std::vector<std::vector<int>> col(n, std::vector<int>(3, -1));
+	for (size_t k = 0; k < param.size(); k++) col[param[k].first][param[k].second] = (int)k;
+
+	auto cost = [&](const std::vector<std::vector<double>>& p) {
+		double s = 0.0;
+		for (auto& kv : pairs) {
+			const std::vector<double>& a = p[index[kv.first.first]];
+			const std::vector<double>& b = p[index[kv.first.second]];
+			const double r = std::sqrt((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2])) -
+			                 kv.second.mean;
+			s += r * r / (kv.second.se * kv.second.se);
+		}
+		return s;
+	};
+	auto normal = [&](const std::vector<std::vector<double>>& p, Matrix* N, std::vector<double>* g) {
+		N->assign(param.size(), std::vector<double>(param.size(), 0.0));
+		g->assign(param.size(), 0.0);
+		for (auto& kv : pairs) {
+			const size_t i = index[kv.first.first], j = index[kv.first.second];
+			double u[3], l = 0.0;
+			for (int c = 0; c < 3; c++) {
+				u[c] = p[i][c] - p[j][c];
+				l += u[c] * u[c];
+			}
+			l = std::max(std::sqrt(l), 1e-6);
+			const double r = l - kv.second.mean, w = 1.0 / (kv.second.se * kv.second.se);
+			// 這一對的 Jacobian：d r / d p_i = u / l，d r / d p_j = -u / l
+			std::vector<std::pair<int, double>> jr;
+			for (int c = 0; c < 3; c++) {
+				if (col[i][c] >= 0) jr.push_back({col[i][c], u[c] / l});
+				if (col[j][c] >= 0) jr.push_back({col[j][c], -u[c] / l});
+			}
+			for (auto& x : jr) {
+				(*g)[x.first] += w * x.second * r;
+				for (auto& y : jr) (*N)[x.first][y.first] += w * x.second * y.second;
+			}
+		}
+	};
+
+	double lambda = 1e-3, c0 = cost(pos);
+	int iters = 0;
+	Matrix N, C;
+	std::vector<double> g;
+	for (; iters < LM_MAX_ITERS; iters++) {
+		normal(pos, &N, &g);
+		Matrix A = N;
+		for (size_t k = 0; k < param.size(); k++) A[k][k] += lambda * std::max(N[k][k], 1e-9);
+		if (!invert(A, &C)) {
+			lambda *= 10.0;
+			continue;
+		}
+		std::vector<std::vector<double>> trial = pos;
+		double step = 0.0;
+		for (size_t k = 0; k < param.size(); k++) {
+			double dk = 0.0;
+			for (size_t m = 0; m < param.size(); m++) dk -= C[k][m] * g[m];
+			trial[param[k].first][param[k].second] += dk;
+			step = std::max(step, std::fabs(dk));
+		}
+		const double c1 = cost(trial);
+		if (c1 < c0) {
+			pos = trial;
+			const bool small = (c0 - c1) < 1e-9 * c0 || step < 1e-6;
+			c0 = c1;
+			lambda = std::max(lambda * 0.3, 1e-9);
+			if (small) break;
+		} else {
+			lambda *= 10.0;
+			if (lambda > 1e9) break;
+		}
+	}
+	normal(pos, &N, &g);
+	const size_t dof = pairs.size() - param.size();
+	const double scale = (dof > 0) ? std::max(1.0, c0 / dof) : 1.0;
+	const bool haveCov = invert(N, &C);
+
+	printf("LM iterations=%d chi2/dof=%.2f (dof %zu)\n\nanchor       x        y        z    sd_x   sd_y   sd_z\n", iters,
+	       dof ? c0 / dof : 0.0, dof);
+	for (size_t i = 0; i < n; i++) {
+		printf("%6X  %7.3f  %7.3f  %7.3f", ids[i], pos[i][0], pos[i][1], pos[i][2]);
+		for (int c = 0; c < 3; c++) {
+			const int k = col[i][c];
+			if (k >= 0 && haveCov) printf("  %5.3f", std::sqrt(C[k][k] * scale));
+			else printf("  %5s", "-");
+		}
+		printf("\n");
+	}
+	printf("\npair    samples  rejected  mean(m)  fitted(m)  residual(m)\n");
+	double ss = 0.0;
+	for (auto& kv : pairs) {
+		const std::vector<double>& a = pos[index[kv.first.first]];
+		const std::vector<double>& b = pos[index[kv.first.second]];
+		const double fit = std::sqrt((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+		ss += (kv.second.mean - fit) * (kv.second.mean - fit);
+		printf("%X-%X  %7zu  %8zu  %7.3f  %9.3f  %+11.3f\n", kv.first.first, kv.first.second, kv.second.used, kv.second.rejected,
+		       kv.second.mean, fit, kv.second.mean - fit);
+	}
+	printf("rms residual = %.3f m%s\n", std::sqrt(ss / pairs.size()),
+	       (dof && c0 / dof > 4.0) ? "  -- large: check NLOS pairs / antenna delays / heights (-z)" : "");
+
+	for (size_t i = 0; i < n; i++) {
+		if (!layout.add(ids[i], (float)pos[i][0], (float)pos[i][1], (float)pos[i][2]))
+			fprintf(stderr, "[SURVEY][WARN] more than LAYOUT_MAX_ANCHORS (%d) anchors, %X not in the layout\n", LAYOUT_MAX_ANCHORS, ids[i]);
+	}
+	if (outPath != nullptr) {
+		FILE* out = fopen(outPath, "w");
+		if (out == nullptr) {
+			perror(outPath);
+			return 1;
+		}
+		fprintf(out, "# anchor短位址(16進位)  x  y  z   （單位 m，UWB_Anchor_Survey 由 anchor 互量距離算出）\n");
+		for (size_t i = 0; i < n; i++) fprintf(out, "%X  %.3f  %.3f  %.3f\n", ids[i], pos[i][0], pos[i][1], pos[i][2]);
+		fclose(out);
+	}
+	return serve ? serveLayout(layout, port) : 0;
+}
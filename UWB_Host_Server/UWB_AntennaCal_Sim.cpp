@@ -0,0 +1,167 @@
+/*
+ * @file UWB_AntennaCal_Sim.cpp
+ * UWBAntennaCal（antenna delay 校正）和原本 ESP32_anchor_autocalibrate 二分搜尋的比較模擬
+ *
+ * 模型：每個 anchor 的真正 delay 在 16400..16800 之間，斜率 ANTCAL_SEED_SLOPE +- 10%，
+ * range = 距離 + (delay - 真正 delay) * 斜率 + 高斯雜訊，-p 比例的 range 多 0.3..2 m（反射）。
+ * 每種設定跑 -n 個隨機 anchor，印用掉幾筆 range（median / p95）、delay 誤差（RMS / p95 / max）、CI 涵蓋率。
+ *
+ * 舊方法：每筆 range 調一次 delay，誤差變號時步長減半，步長 < 3 結束（原 sketch 的做法）。
+ *
+ * 另外跑 batch 8 / CI 6 tick（5 cm 雜訊約 30 筆）和 batch 20 / CI 2 tick（更準，但要約 150 筆）比較。
+ *
+ * 測試（預設 batch / CI，5 cm 與 15 cm 雜訊）：
+ *   1. 5 cm 雜訊時用掉的 range 中位數比舊方法少（序列停止：雜訊大時本來就會多收）
+ *   2. delay 誤差 RMS 小於舊方法的 SIM_RMS_RATIO 倍
+ *   3. 回報的 95% CI 涵蓋真值：5 cm >= SIM_COVERAGE_5CM（300 個 anchor 時 95% 的二項標準差約 1.3%）；
+ *      15 cm 時 0.3 m 左右的反射藏在雜訊裡去不掉、只往同一邊偏，實際約 92%，檢查 >= SIM_COVERAGE_15CM
+ *
+ * 編譯：
+ *   g++ -O2 -std=c++17 -I../DW1000_BACKUP/src_0205 UWB_AntennaCal_Sim.cpp ../DW1000_BACKUP/src_0205/UWBAntennaCal.cpp \
+ *       -o uwb_antennacal_sim
+ * 執行：
+ *   ./uwb_antennacal_sim [-n 300] [-p 0.03]
+ */
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "HostTest.h"
+#include "UWBAntennaCal.h"
+
+#define SIM_DISTANCE   7.0f     // m，和 sketch 的預設一樣
+#define SIM_START      16600    // 起始 delay，和 sketch 的預設一樣
+#define SIM_MAX_RANGES 5000
+#define SIM_RMS_RATIO     0.75
+#define SIM_COVERAGE_5CM  92.0
+#define SIM_COVERAGE_15CM 88.0
+
+struct Anchor {
+	double trueDelay;
+	double slope;      // m / tick
+	double noise;      // m
+	double outliers;   // 比例
+	std::mt19937* rng;
+
+	double range(int delay) {
+		std::normal_distribution<double> n(0.0, noise);
+		std::uniform_real_distribution<double> u(0.0, 1.0);
+		double r = SIM_DISTANCE + (delay - trueDelay) * slope + n(*rng);
+		if (u(*rng) < outliers) r += 0.3 + 1.7 * u(*rng);
+		return r;
+	}
+};
+
+struct Stats {
+	std::vector<double> ranges;
+	std::vector<double> err;   // |delay - 真正 delay|（tick）
+	int covered = 0;
+
+	double medianRanges() const { return pct(ranges, 50); }
+	double rms() const {
+		double s = 0.0;
+		for (double e : err) s += e * e;
+		return sqrt(s / err.size());
+	}
+	static double pct(std::vector<double> v, int p) {
+		std::sort(v.begin(), v.end());
+		return v[std::min(v.size() - 1, v.size() * p / 100)];
+	}
+	void print(const char* name) const {
+		printf("  %-22s ranges median %4.0f p95 %4.0f | delay error rms %5.1f p95 %5.1f max %5.1f ticks", name,
+		       medianRanges(), pct(ranges, 95), rms(), pct(err, 95), pct(err, 100));
+	}
+};
+
+// 原 sketch：每筆 range 調一次，變號才減半
+static void binarySearch(Anchor& a, Stats* st) {
+	int d = SIM_START, step = 100, n = 0;
+	double last = 0.0;
+	while (step >= 3 && n < SIM_MAX_RANGES) {
+		const double e = a.range(d) - SIM_DISTANCE;
+		n++;
+		if (e * last < 0.0) step /= 2;
+		last = e;
+		d += (e > 0.0) ? step : -step;
+	}
+	st->ranges.push_back(n);
+	st->err.push_back(fabs(d - a.trueDelay));
+}
+
+static void calibrate(Anchor& a, uint8_t batch, float targetCi, Stats* st) {
+	UWBAntennaCal c;
+	c.begin(SIM_DISTANCE, SIM_START, batch, targetCi);
+	int d = SIM_START, n = 0;
+	while (!c.isDone() && n < SIM_MAX_RANGES) {
+		n++;
+		if (c.addRange((float)a.range(d))) d = c.antennaDelay();
+	}
+	const double e = fabs(c.antennaDelay() - a.trueDelay);
+	st->ranges.push_back(n);
+	st->err.push_back(e);
+	if (e <= c.confidence() + 0.5) st->covered++;
+}
+
+int main(int argc, char** argv) {
+	int anchors = 300;
+	double outliers = 0.03;
+	int opt;
+	while ((opt = getopt(argc, argv, "n:p:h")) != -1) {
+		switch (opt) {
+			case 'n': anchors = atoi(optarg); break;
+			case 'p': outliers = strtod(optarg, nullptr); break;
+			default:
+				fprintf(stderr, "usage: %s [-n anchors] [-p outlier_rate]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (anchors < 20) anchors = 20;
+
+	struct Config {
+		uint8_t batch;
+		float   ci;
+	};
+	const Config configs[] = {{ANTCAL_DEFAULT_BATCH, ANTCAL_TARGET_CI}, {8, 6.0f}, {20, 2.0f}};
+	for (double noise : {0.05, 0.15}) {
+		printf("noise %.2f m, outliers %.0f%%, %d anchors\n", noise, outliers * 100.0, anchors);
+		std::mt19937 rng(11);
+		std::uniform_real_distribution<double> u(0.0, 1.0);
+		std::vector<Anchor> set;
+		for (int i = 0; i < anchors; i++) {
+			set.push_back({16400.0 + 400.0 * u(rng), ANTCAL_SEED_SLOPE * (0.9 + 0.2 * u(rng)), noise, outliers, &rng});
+		}
+
+		Stats old;
+		for (Anchor& a : set) binarySearch(a, &old);
+		old.print("binary search");
+		printf("\n");
+
+		for (size_t k = 0; k < sizeof(configs) / sizeof(configs[0]); k++) {
+			Stats st;
+			for (Anchor& a : set) calibrate(a, configs[k].batch, configs[k].ci, &st);
+			char name[48];
+			snprintf(name, sizeof(name), "batch %u, CI %.0f%s", configs[k].batch, configs[k].ci, k == 0 ? " (default)" : "");
+			st.print(name);
+			const double coverage = 100.0 * st.covered / anchors;
+			printf(", CI coverage %.1f%%\n", coverage);
+			if (k == 0) {
+				if (noise < 0.1) {
+					TEST_CHECK(st.medianRanges() < old.medianRanges(), "noise %.2f: default uses %.0f ranges, binary search %.0f",
+					           noise, st.medianRanges(), old.medianRanges());
+				}
+				TEST_CHECK(st.rms() < SIM_RMS_RATIO * old.rms(), "noise %.2f: rms %.1f vs binary search %.1f ticks", noise,
+				           st.rms(), old.rms());
+				TEST_CHECK(coverage >= (noise < 0.1 ? SIM_COVERAGE_5CM : SIM_COVERAGE_15CM), "noise %.2f: CI coverage %.1f%%",
+				           noise, coverage);
+			}
+		}
+	}
+	return testSummary("UWB_AntennaCal_Sim");
+}
@@ -0,0 +1,242 @@
+/*
+ * @file UWB_Cir_Test.cpp
+ * DW1000Class::readAccumulator() / refineFirstPath() 與 UWBCir 的 host 測試（DW1000.cpp 接 DW1000RegSim 模擬的 accumulator）
+ *
+ * 測試：
+ *   1. 整段讀取（64 MHz PRF，1016 samples）：每個 sample 和 ACC_MEM 內容一樣、dummy byte 有丟掉、
+ *      每次 burst <= DW1000_ACC_CHUNK 個、讀之前打開 FACE / AMCE、讀完關掉且 PMSC_CTRL0 其他 bits 不動
+ *   2. 邊界：16 MHz PRF 是 992 個、讀到尾端會截斷、offset 超出 / bufferLen = 0 回 0、沒有 handler 時不超過 bufferLen
+ *   3. handler 模式：小 buffer 分段，index 連續、每段 <= bufferLen、內容一樣
+ *   4. cirUnpack / cirMagnitude / cirLeadingEdge：已知斜坡的內插位置、整段雜訊、視窗開頭就超過門檻、n < 2
+ *   5. getFirstPathIndex()：FP_INDEX 10.6 定點數
+ *   6. refineFirstPath()：隨機 channel（first path 位置 / 振幅 / 相位隨機，+3 sample 處 0.6 倍 multipath，雜訊 std 20），
+ *      FP_INDEX 只給整數 sample（模擬 LDE 的粗略位置），比較 FP_INDEX 和 refine 後相對真值的 bias / std（-n 次，預設 20000）
+ *      leading edge 是門檻交叉點，在 pulse 中心之前，所以 refine 後有固定的負 bias（由天線延遲校正吃掉），看的是 std
+ *
+ * 編譯：
+ *   g++ -O2 -Wall -std=c++17 -Ihost_arduino -I../DW1000_BACKUP/src_0205 UWB_Cir_Test.cpp host_arduino/HostArduino.cpp \
+ *       ../DW1000_BACKUP/src_0205/DW1000.cpp ../DW1000_BACKUP/src_0205/DW1000Time.cpp \
+ *       ../DW1000_BACKUP/src_0205/UWBCir.cpp ../DW1000_BACKUP/src_0205/UWBClockOffset.cpp -o uwb_cir_test
+ * 執行：
+ *   ./uwb_cir_test [-n 20000]
+ */
+
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "DW1000.h"
+#include "DW1000RegSim.h"
+#include "HostTest.h"
+
+static void setSample(uint16_t i, int16_t re, int16_t im) {
+	dwSimSet(ACC_MEM, i * CIR_BYTES_PER_SAMPLE, (uint16_t)re, 2);
+	dwSimSet(ACC_MEM, i * CIR_BYTES_PER_SAMPLE + 2, (uint16_t)im, 2);
+}
+
+static CirSample getSample(uint16_t i) {
+	CirSample s;
+	s.re = (int16_t)dwSimGet(ACC_MEM, i * CIR_BYTES_PER_SAMPLE, 2);
+	s.im = (int16_t)dwSimGet(ACC_MEM, i * CIR_BYTES_PER_SAMPLE + 2, 2);
+	return s;
+}
+
+static bool sameSamples(const CirSample* s, uint16_t first, uint16_t n) {
+	for (uint16_t i = 0; i < n; i++) {
+		CirSample w = getSample(first + i);
+		if (s[i].re != w.re || s[i].im != w.im) return false;
+	}
+	return true;
+}
+
+static void fillPattern() {
+	for (uint16_t i = 0; i < CIR_SAMPLES_64MHZ * CIR_BYTES_PER_SAMPLE; i++) dwSimRegs[ACC_MEM][i] = (uint8_t)(i * 7 + 3);
+}
+
+static void testFullRead() {
+	dwSimInstall();
+	DW1000Class::setPulseFrequency(DW1000Class::TX_PULSE_FREQ_64MHZ);
+	fillPattern();
+	dwSimRegs[PMSC][PMSC_CTRL0_SUB] = 0xB3;   // 保留的 bits 全部設起來，看讀完有沒有被改
+	dwSimRegs[PMSC][PMSC_CTRL0_SUB + 1] = 0x02;
+
+	static CirSample all[CIR_SAMPLES_64MHZ];
+	uint16_t n = DW1000Class::readAccumulator(0, 2000, all, CIR_SAMPLES_64MHZ);
+	TEST_CHECK(n == CIR_SAMPLES_64MHZ, "full read returned %u samples", n);
+	TEST_CHECK(sameSamples(all, 0, CIR_SAMPLES_64MHZ), "full read differs from ACC_MEM");
+
+	// 每次 ACC_MEM burst：<= DW1000_ACC_CHUNK 個 sample + dummy，offset 連續
+	unsigned bursts = 0, badBurst = 0;
+	uint16_t nextOff = 0;
+	bool clockOnBeforeRead = false, clockOffAfterRead = false;
+	uint8_t lastPmsc0 = 0, lastPmsc1 = 0;
+	for (const DwSimAccess& a : dwSimLog) {
+		if (a.reg == PMSC && a.write && a.off == PMSC_CTRL0_SUB) {
+			lastPmsc0 = a.data[0];
+			lastPmsc1 = a.data[1];
+			if (bursts == 0) clockOnBeforeRead = (a.data[0] & PMSC_CTRL0_ACC_ON) == PMSC_CTRL0_ACC_ON && (a.data[1] & 0x80);
+		}
+		if (a.reg == ACC_MEM && !a.write) {
+			bursts++;
+			if (a.off != nextOff || a.len > DW1000_ACC_CHUNK * CIR_BYTES_PER_SAMPLE + 1 || (a.len - 1) % CIR_BYTES_PER_SAMPLE) {
+				badBurst++;
+			}
+			nextOff = (uint16_t)(a.off + a.len - 1);
+		}
+	}
+	clockOffAfterRead = (lastPmsc0 & PMSC_CTRL0_ACC_ON) == 0 && (lastPmsc1 & 0x80) == 0;
+	unsigned wantBursts = (CIR_SAMPLES_64MHZ + DW1000_ACC_CHUNK - 1) / DW1000_ACC_CHUNK;
+	TEST_CHECK(bursts == wantBursts && badBurst == 0, "%u bursts (want %u), %u malformed", bursts, wantBursts, badBurst);
+	TEST_CHECK(clockOnBeforeRead, "FACE/AMCE not enabled before the first ACC_MEM read");
+	TEST_CHECK(clockOffAfterRead, "FACE/AMCE still enabled after the read");
+	TEST_CHECK(dwSimRegs[PMSC][PMSC_CTRL0_SUB] == 0xB3 && dwSimRegs[PMSC][PMSC_CTRL0_SUB + 1] == 0x02,
+	           "other PMSC_CTRL0 bits changed: %02X %02X", dwSimRegs[PMSC][PMSC_CTRL0_SUB], dwSimRegs[PMSC][PMSC_CTRL0_SUB + 1]);
+}
+
+static void testBounds() {
+	dwSimInstall();
+	fillPattern();
+	CirSample buf[32];
+
+	DW1000Class::setPulseFrequency(DW1000Class::TX_PULSE_FREQ_16MHZ);
+	TEST_CHECK(DW1000Class::getAccumulatorLength() == CIR_SAMPLES_16MHZ, "16 MHz length %u", DW1000Class::getAccumulatorLength());
+	uint16_t n = DW1000Class::readAccumulator(CIR_SAMPLES_16MHZ - 2, 10, buf, 32);
+	TEST_CHECK(n == 2 && sameSamples(buf, CIR_SAMPLES_16MHZ - 2, 2), "read past the end of a 16 MHz CIR returned %u", n);
+	TEST_CHECK(DW1000Class::readAccumulator(CIR_SAMPLES_16MHZ, 4, buf, 32) == 0, "offset past the end accepted");
+
+	DW1000Class::setPulseFrequency(DW1000Class::TX_PULSE_FREQ_64MHZ);
+	TEST_CHECK(DW1000Class::getAccumulatorLength() == CIR_SAMPLES_64MHZ, "64 MHz length %u", DW1000Class::getAccumulatorLength());
+	TEST_CHECK(DW1000Class::readAccumulator(0, 4, buf, 0) == 0, "bufferLen 0 accepted");
+	dwSimLog.clear();
+	n = DW1000Class::readAccumulator(100, 500, buf, 32);
+	TEST_CHECK(n == 32 && sameSamples(buf, 100, 32), "no-handler read not clipped to bufferLen (%u)", n);
+	TEST_CHECK(dwSimCount(ACC_MEM, false) == 1, "clipped read used %u bursts", dwSimCount(ACC_MEM, false));
+}
+
+static std::vector<CirSample> g_got;
+static uint16_t g_nextIndex;
+static unsigned g_calls, g_badCalls;
+
+static void onChunk(uint16_t index, const CirSample samples[], uint16_t n) {
+	if (index != g_nextIndex || n == 0 || n > 5) g_badCalls++;
+	g_nextIndex = (uint16_t)(index + n);
+	g_got.insert(g_got.end(), samples, samples + n);
+	g_calls++;
+}
+
+static void testHandler() {
+	dwSimInstall();
+	DW1000Class::setPulseFrequency(DW1000Class::TX_PULSE_FREQ_64MHZ);
+	fillPattern();
+	CirSample small[5];
+	g_got.clear();
+	g_nextIndex = 700;
+	g_calls = g_badCalls = 0;
+	uint16_t n = DW1000Class::readAccumulator(700, 500, small, 5, onChunk);
+	TEST_CHECK(n == CIR_SAMPLES_64MHZ - 700 && g_got.size() == n, "handler read returned %u, got %zu", n, g_got.size());
+	TEST_CHECK(g_badCalls == 0 && g_calls == (unsigned)(n + 4) / 5, "%u handler calls, %u out of order or oversized", g_calls, g_badCalls);
+	TEST_CHECK(sameSamples(g_got.data(), 700, (uint16_t)g_got.size()), "handler samples differ from ACC_MEM");
+}
+
+static void testLeadingEdge() {
+	const uint8_t raw[8] = {0x34, 0x12, 0xFE, 0xFF, 0x00, 0x80, 0xFF, 0x7F};
+	CirSample u[2];
+	cirUnpack(raw, 2, u);
+	TEST_CHECK(u[0].re == 0x1234 && u[0].im == -2 && u[1].re == -32768 && u[1].im == 32767, "cirUnpack");
+	CirSample m = {3, -4};
+	TEST_CHECK(cirMagnitude(m) == 5.0f, "cirMagnitude(3, -4) = %f", cirMagnitude(m));
+
+	// 振幅 0, 10, 20, 120, 520, 1000：noise 10 => 門檻 max(60, 250) = 250，在 120 和 520 之間 => 3 + 130/400
+	CirSample ramp[6] = {{0, 0}, {10, 0}, {0, 20}, {120, 0}, {0, -520}, {1000, 0}};
+	float e = cirLeadingEdge(ramp, 6, 100, 10.0f);
+	TEST_CHECK(fabsf(e - (100 + 3 + 130.0f / 400.0f)) < 1e-4f, "ramp edge at %f", e);
+	// 雜訊大：門檻 = 6 * 100 = 600，在 520 和 1000 之間
+	e = cirLeadingEdge(ramp, 6, 0, 100.0f);
+	TEST_CHECK(fabsf(e - (4 + 80.0f / 480.0f)) < 1e-4f, "noise-limited edge at %f", e);
+	TEST_CHECK(cirLeadingEdge(ramp, 6, 0, 500.0f) < 0.0f, "edge found below the noise threshold");
+	TEST_CHECK(cirLeadingEdge(ramp + 4, 2, 0, 10.0f) < 0.0f, "edge found when the window starts above threshold");
+	TEST_CHECK(cirLeadingEdge(ramp, 1, 0, 10.0f) < 0.0f, "edge found in a 1-sample window");
+}
+
+static void testFirstPathIndex() {
+	dwSimInstall();
+	dwSimSet(RX_TIME, FP_INDEX_SUB, (uint16_t)(745.5f * 64), 2);
+	TEST_CHECK(DW1000Class::getFirstPathIndex() == 745.5f, "FP_INDEX decoded as %f", DW1000Class::getFirstPathIndex());
+	dwSimSet(RX_TIME, FP_INDEX_SUB, 0xFFFF, 2);
+	TEST_CHECK(DW1000Class::getFirstPathIndex() == 0xFFFF / 64.0f, "FP_INDEX 0xFFFF decoded as %f", DW1000Class::getFirstPathIndex());
+}
+
+// 升餘弦 pulse，半寬 3 sample
+static double pulse(double x) {
+	return (x > -3 && x < 3) ? pow(cos(x * M_PI / 6), 4) : 0.0;
+}
+
+static void testRefine(uint32_t channels) {
+	dwSimInstall();
+	DW1000Class::setPulseFrequency(DW1000Class::TX_PULSE_FREQ_64MHZ);
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<double> u(0.0, 1.0);
+	std::normal_distribution<double> nz(0.0, 1.0);
+	const double noise = 20;
+	double sumHw = 0, sqHw = 0, sumRef = 0, sqRef = 0;
+	uint32_t ok = 0, fail = 0, badTicks = 0;
+	for (uint32_t c = 0; c < channels; c++) {
+		const double t0 = 740 + u(rng) * 4, amp = 800 + u(rng) * 2000, ph = u(rng) * 2 * M_PI;
+		for (uint16_t i = 700; i < 800; i++) {
+			double p = amp * pulse(i - t0) + 0.6 * amp * pulse(i - t0 - 3);
+			setSample(i, (int16_t)lround(p * cos(ph) + noise * nz(rng)), (int16_t)lround(p * sin(ph) + noise * nz(rng)));
+		}
+		dwSimSet(RX_TIME, FP_INDEX_SUB, (uint16_t)lround((floor(t0) + 1) * 64), 2);
+		dwSimSet(RX_FQUAL, STD_NOISE_SUB, (uint16_t)noise, 2);
+
+		float hw, refined;
+		if (!DW1000Class::refineFirstPath(&hw, &refined)) {
+			fail++;
+			continue;
+		}
+		// RX timestamp 修正量 = (refined - hw) * 64 tick，最多差 CIR_LDE_SEARCH_BACK 個 sample
+		if (fabsf(refined - hw) * CIR_TICKS_PER_SAMPLE > CIR_LDE_SEARCH_BACK * CIR_TICKS_PER_SAMPLE) badTicks++;
+		double eh = hw - t0, er = refined - t0;
+		sumHw += eh;
+		sqHw += eh * eh;
+		sumRef += er;
+		sqRef += er * er;
+		ok++;
+	}
+	const double mHw = sumHw / ok, mRef = sumRef / ok;
+	const double sHw = sqrt(sqHw / ok - mHw * mHw), sRef = sqrt(sqRef / ok - mRef * mRef);
+	const double cmPerSample = 30.03;   // 1.0016 ns * c
+	printf("channels %u, failed %u\n", ok, fail);
+	printf("              bias sample   std sample   std cm\n");
+	printf("FP_INDEX      %11.3f  %11.3f  %7.1f\n", mHw, sHw, sHw * cmPerSample);
+	printf("refined       %11.3f  %11.3f  %7.1f\n", mRef, sRef, sRef * cmPerSample);
+	TEST_CHECK(fail == 0, "%u channels without an edge", fail);
+	TEST_CHECK(badTicks == 0, "%u corrections larger than the search window", badTicks);
+	TEST_CHECK(sRef < sHw / 3, "refined std %.3f not well below FP_INDEX std %.3f", sRef, sHw);
+}
+
+int main(int argc, char** argv) {
+	uint32_t channels = 20000;
+	int opt;
+	while ((opt = getopt(argc, argv, "n:h")) != -1) {
+		switch (opt) {
+			case 'n': channels = (uint32_t)strtoul(optarg, nullptr, 10); break;
+			default:
+				fprintf(stderr, "usage: %s [-n channels]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (channels == 0) channels = 1;
+	testFullRead();
+	testBounds();
+	testHandler();
+	testLeadingEdge();
+	testFirstPathIndex();
+	testRefine(channels);
+	return testSummary("UWB_Cir_Test");
+}
@@ -0,0 +1,214 @@
+/*
+ * @file UWB_ClockOffset_Test.cpp
+ * UWBClockOffset（carrier integrator 換算 ppm、每個 peer 的頻偏平滑、SS-TWR 的 TOF）的 host 單元測試
+ *
+ * 測試：
+ *   1. carrierIntegratorDecode：21-bit 有號數的正負極值、-1、byte 2 高 3 bits 不算、隨機值 round trip
+ *   2. carrierIntegratorToPpm：每個 channel 的載波頻率、110 kb/s 的 / 8192、正負號（正 = 對方快）、不支援的 channel 回 0；
+ *      再經過 DW1000Class::getCarrierIntegrator() / getClockOffsetPpm()（DW1000.cpp 接 DW1000RegSim 的 DRX_CAR_INT）
+ *   3. UWBClockOffsetFilter：warm-up 期間是精確平均、valid() 的時間點、EMA 係數、gate 擋單筆、
+ *      連續 CLOCK_OFFSET_MAX_REJECTS 筆被擋就在新值重來；0.3 ppm 雜訊 + 3% 亂值時的 RMS 誤差
+ *   4. singleSidedTof：模擬 TAG / anchor 各自的晶振誤差（+-20 ppm）、距離 1..30 m、reply 0.3..7 ms，
+ *      TAG 量 round、anchor 量 reply（各自的 tick，取整數），用真的頻偏 / 濾波後的頻偏 / 不修正 算距離誤差
+ *
+ * 編譯：
+ *   g++ -O2 -Wall -std=c++17 -Ihost_arduino -I../DW1000_BACKUP/src_0205 UWB_ClockOffset_Test.cpp host_arduino/HostArduino.cpp \
+ *       ../DW1000_BACKUP/src_0205/DW1000.cpp ../DW1000_BACKUP/src_0205/DW1000Time.cpp \
+ *       ../DW1000_BACKUP/src_0205/UWBCir.cpp ../DW1000_BACKUP/src_0205/UWBClockOffset.cpp -o uwb_clockoffset_test
+ * 執行：
+ *   ./uwb_clockoffset_test [-n 100000]
+ */
+
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "DW1000.h"
+#include "DW1000RegSim.h"
+#include "HostTest.h"
+
+#define SPEED_OF_LIGHT 299792458.0
+#define TICK_SECONDS   (1.0 / (128.0 * 499.2e6))
+
+static const double HZ_PER_LSB = 998.4e6 / 2.0 / 1024.0 / 131072.0;
+
+static void testDecode() {
+	const uint8_t minusOne[3] = {0xFF, 0xFF, 0x1F};
+	const uint8_t minVal[3] = {0x00, 0x00, 0x10};
+	const uint8_t maxVal[3] = {0xFF, 0xFF, 0x0F};
+	const uint8_t upper[3] = {0x34, 0x12, 0xE0};
+	TEST_CHECK(carrierIntegratorDecode(minusOne) == -1, "0x1FFFFF -> %d", carrierIntegratorDecode(minusOne));
+	TEST_CHECK(carrierIntegratorDecode(minVal) == -(1 << 20), "0x100000 -> %d", carrierIntegratorDecode(minVal));
+	TEST_CHECK(carrierIntegratorDecode(maxVal) == (1 << 20) - 1, "0x0FFFFF -> %d", carrierIntegratorDecode(maxVal));
+	TEST_CHECK(carrierIntegratorDecode(upper) == 0x1234, "bits above 21 not ignored: %d", carrierIntegratorDecode(upper));
+
+	std::mt19937 rng(45);
+	uint32_t bad = 0;
+	for (int i = 0; i < 100000; i++) {
+		int32_t v = (int32_t)(rng() % (1 << 21)) - (1 << 20);
+		uint32_t u = (uint32_t)v;
+		uint8_t b[3] = {(uint8_t)u, (uint8_t)(u >> 8), (uint8_t)(((u >> 16) & 0x1F) | (rng() & 0xE0))};
+		if (carrierIntegratorDecode(b) != v) bad++;
+	}
+	TEST_CHECK(bad == 0, "%u random 21-bit values did not round trip", bad);
+}
+
+static void testToPpm() {
+	const struct {
+		uint8_t ch;
+		double carrierHz;
+	} chans[] = {{1, 3494.4e6}, {2, 3993.6e6}, {3, 4492.8e6}, {4, 3993.6e6}, {5, 6489.6e6}, {7, 6489.6e6}};
+	uint32_t bad = 0;
+	for (auto& c : chans) {
+		for (int32_t raw : {-1048576, -17448, -1, 0, 1, 5000, 1048575}) {
+			double want = raw * HZ_PER_LSB * (-1e6 / c.carrierHz);
+			double want110 = raw * HZ_PER_LSB / 8.0 * (-1e6 / c.carrierHz);
+			if (fabs(carrierIntegratorToPpm(raw, c.ch, false) - want) > 1e-4 * (1 + fabs(want))) bad++;
+			if (fabs(carrierIntegratorToPpm(raw, c.ch, true) - want110) > 1e-4 * (1 + fabs(want110))) bad++;
+		}
+	}
+	TEST_CHECK(bad == 0, "%u conversions differ from the user-manual formula", bad);
+	for (uint8_t ch : {0, 6, 8}) {
+		TEST_CHECK(carrierIntegratorToPpm(1000, ch, false) == 0.0f, "channel %u not rejected", ch);
+	}
+	// ch5 6.8 Mb/s：raw -17448 約 = 對方快 10 ppm
+	float ppm = carrierIntegratorToPpm(-17448, 5, false);
+	TEST_CHECK(fabsf(ppm - 10.0f) < 0.01f, "ch5 raw -17448 = %f ppm (want +10)", ppm);
+	printf("ch5 6.8 Mb/s: %.4g ppm per LSB\n", -HZ_PER_LSB * 1e6 / 6489.6e6);
+
+	// 經過 DW1000Class：暫存器 0x27:0x28 -> ppm
+	dwSimInstall();
+	DW1000Class::setChannel(DW1000Class::CHANNEL_5);
+	DW1000Class::setDataRate(DW1000Class::TRX_RATE_6800KBPS);
+	dwSimSet(DRX_TUNE, DRX_CAR_INT_SUB, (uint32_t)(-17448) & 0x1FFFFF, 3);
+	TEST_CHECK(DW1000Class::getCarrierIntegrator() == -17448, "getCarrierIntegrator() = %d", DW1000Class::getCarrierIntegrator());
+	TEST_CHECK(DW1000Class::getClockOffsetPpm() == ppm, "getClockOffsetPpm() = %f", DW1000Class::getClockOffsetPpm());
+	DW1000Class::setDataRate(DW1000Class::TRX_RATE_110KBPS);
+	TEST_CHECK(fabsf(DW1000Class::getClockOffsetPpm() - ppm / 8) < 1e-4f, "110 kb/s getClockOffsetPpm() = %f", DW1000Class::getClockOffsetPpm());
+	DW1000Class::setDataRate(DW1000Class::TRX_RATE_6800KBPS);
+}
+
+static void testFilter() {
+	UWBClockOffsetFilter f;
+	TEST_CHECK(!f.valid() && f.count() == 0 && f.ppm() == 0.0f, "new filter not empty");
+
+	// warm-up：精確平均，第 CLOCK_OFFSET_WARMUP 筆之後 valid
+	double sum = 0;
+	for (int i = 0; i < CLOCK_OFFSET_WARMUP; i++) {
+		TEST_CHECK(!f.valid(), "valid after %d samples", i);
+		float x = 10.0f + (float)i * 0.25f;   // 都在 gate 內
+		f.update(x);
+		sum += x;
+	}
+	TEST_CHECK(f.valid() && fabs(f.ppm() - sum / CLOCK_OFFSET_WARMUP) < 1e-5, "warm-up mean %f, want %f", f.ppm(),
+	           sum / CLOCK_OFFSET_WARMUP);
+
+	// EMA 一步
+	float before = f.ppm();
+	TEST_CHECK(f.update(before + 1.0f), "sample inside the gate rejected");
+	TEST_CHECK(fabsf(f.ppm() - (before + CLOCK_OFFSET_ALPHA)) < 1e-5f, "EMA step %f, want %f", f.ppm(), before + CLOCK_OFFSET_ALPHA);
+
+	// gate：單筆亂值不採用；連續 MAX_REJECTS 筆就換到新值
+	before = f.ppm();
+	TEST_CHECK(!f.update(before + 2 * CLOCK_OFFSET_GATE_PPM) && f.ppm() == before, "outlier accepted");
+	TEST_CHECK(f.update(before), "sample after one outlier rejected");
+	for (int i = 0; i < CLOCK_OFFSET_MAX_REJECTS - 1; i++) f.update(-4.0f);
+	TEST_CHECK(f.ppm() == before, "filter moved before %d rejects", CLOCK_OFFSET_MAX_REJECTS);
+	f.update(-4.0f);
+	TEST_CHECK(f.ppm() == -4.0f && f.count() == 1 && !f.valid(), "no restart after %d rejects (ppm %f, n %u)",
+	           CLOCK_OFFSET_MAX_REJECTS, f.ppm(), f.count());
+	f.reset();
+	TEST_CHECK(f.count() == 0 && !f.valid(), "reset() kept samples");
+
+	// 雜訊：真值 12.5 ppm、單筆 0.3 ppm、3% 亂值
+	std::mt19937 rng(1);
+	std::normal_distribution<double> noise(0.0, 0.3);
+	std::uniform_real_distribution<double> u(0.0, 1.0);
+	double e2 = 0;
+	int n = 0, rejected = 0;
+	for (int i = 0; i < 5000; i++) {
+		double x = 12.5 + noise(rng);
+		if (u(rng) < 0.03) x += (u(rng) - 0.5) * 40;
+		if (!f.update((float)x)) rejected++;
+		if (i > 50) {
+			e2 += (f.ppm() - 12.5) * (f.ppm() - 12.5);
+			n++;
+		}
+	}
+	double rms = sqrt(e2 / n);
+	printf("filter: single sample 0.30 ppm, filtered rms %.3f ppm, %d rejected\n", rms, rejected);
+	TEST_CHECK(rms < 0.15, "filtered rms %.3f ppm", rms);
+}
+
+// 晶振誤差 e（相對真實時間）：t 秒量到 round(t * (1 + e) / TICK) 個 tick
+static int64_t ticksOf(double seconds, double e) {
+	return (int64_t)llround(seconds * (1.0 + e) / TICK_SECONDS);
+}
+
+static void testSingleSided(uint32_t exchanges) {
+	std::mt19937 rng(50);
+	std::uniform_real_distribution<double> xtal(-20e-6, 20e-6);
+	std::uniform_real_distribution<double> dist(1.0, 30.0);
+	std::uniform_real_distribution<double> replyS(0.3e-3, 7e-3);
+	std::normal_distribution<double> ppmNoise(0.0, 0.3);
+	double eExact = 0, eFilt = 0, eNone = 0, maxExact = 0;
+	for (uint32_t i = 0; i < exchanges; i++) {
+		const double eTag = xtal(rng), eAnchor = xtal(rng);
+		const double d = dist(rng), reply = replyS(rng);
+		const double tof = d / SPEED_OF_LIGHT;
+		const int64_t round = ticksOf(2 * tof + reply, eTag);
+		const int64_t replyTicks = ticksOf(reply, eAnchor);
+		// TAG 量到的頻偏：anchor 相對 TAG（正 = anchor 快）
+		const double truePpm = ((1.0 + eAnchor) / (1.0 + eTag) - 1.0) * 1e6;
+		UWBClockOffsetFilter f;
+		for (int k = 0; k < 30; k++) f.update((float)(truePpm + ppmNoise(rng)));
+
+		// 回傳的是 TAG 的 tick：換回秒要除掉 TAG 的晶振誤差才是真的 TOF，但 20 ppm * 100 ns 只有 2 fs，可以忽略
+		const double exact = singleSidedTof(round, replyTicks, (float)truePpm) * TICK_SECONDS * SPEED_OF_LIGHT - d;
+		const double filt = singleSidedTof(round, replyTicks, f.ppm()) * TICK_SECONDS * SPEED_OF_LIGHT - d;
+		const double none = singleSidedTof(round, replyTicks, 0.0f) * TICK_SECONDS * SPEED_OF_LIGHT - d;
+		eExact += exact * exact;
+		eFilt += filt * filt;
+		eNone += none * none;
+		if (fabs(exact) > maxExact) maxExact = fabs(exact);
+	}
+	const double rExact = sqrt(eExact / exchanges), rFilt = sqrt(eFilt / exchanges), rNone = sqrt(eNone / exchanges);
+	printf("SS-TWR range error (reply 0.3..7 ms, xtal +-20 ppm, %u exchanges)\n", exchanges);
+	printf("  ppm correction    rms m\n");
+	printf("  none            %7.3f\n", rNone);
+	printf("  filtered        %7.3f\n", rFilt);
+	printf("  exact           %7.3f  (max %.3f)\n", rExact, maxExact);
+	// 只剩 tick 取整數（15.65 ps = 0.47 cm，round 和 reply 各一次，再除 2）
+	TEST_CHECK(maxExact < 0.01, "exact-ppm error up to %.4f m", maxExact);
+	TEST_CHECK(rNone > 1.0, "uncorrected error only %.3f m (test clocks too close)", rNone);
+	TEST_CHECK(rFilt < 0.3 && rFilt < rNone / 20, "filtered-ppm rms %.3f m", rFilt);
+
+	// 正負號：anchor 快 10 ppm、reply 5 ms、距離 0 -> 不修正會多算 reply * 10e-6 / 2
+	const int64_t reply = ticksOf(5e-3, 10e-6), round = ticksOf(5e-3, 0.0);
+	TEST_CHECK(llabs(singleSidedTof(round, reply, 10.0f)) <= 1, "sign: TOF %lld ticks with the right ppm",
+	           (long long)singleSidedTof(round, reply, 10.0f));
+	TEST_CHECK(singleSidedTof(round, reply, -10.0f) < -1000, "sign: wrong ppm sign not visible");
+}
+
+int main(int argc, char** argv) {
+	uint32_t exchanges = 100000;
+	int opt;
+	while ((opt = getopt(argc, argv, "n:h")) != -1) {
+		switch (opt) {
+			case 'n': exchanges = (uint32_t)strtoul(optarg, nullptr, 10); break;
+			default:
+				fprintf(stderr, "usage: %s [-n exchanges]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (exchanges == 0) exchanges = 1;
+	testDecode();
+	testToPpm();
+	testFilter();
+	testSingleSided(exchanges);
+	return testSummary("UWB_ClockOffset_Test");
+}
@@ -0,0 +1,167 @@
+/*
+ * @file UWB_Cmac_Bench.cpp
+ * RANGE 封包 MAC（DW1000Cmac，AES-128 CMAC 截短成 RANGE_MAC_LEN）的正確性檢查與每包成本
+ *
+ * - RFC 4493 的 4 組已知答案（0 / 16 / 40 / 64 bytes）
+ * - RANGE 的 MAC 範圍 = header + msgid + 數量 + 每台 anchor 17 bytes + POLL 的 round 編號（4 bytes），
+ *   也就是 SHORT_MAC_LEN + 2 + 17n + 4 bytes；n = 1..RANGE_AUTH_MAX_DEVICES 各量一次 compute / verify
+ *   的 ns/frame（x86 另外印 TSC cycles/frame）
+ * - 竄改一個時間戳 byte、或 round 編號不同（重送上一輪的 RANGE）都要驗證失敗
+ *
+ * 這裡量的是 host 上的 portable 後端，只當作相對比較；ESP32 上的實際 cycles 用
+ * setEncryptionDebugFlag(true) 看 "[MAC][TX] bytes/cycles"。
+ *
+ * 編譯：
+ *   g++ -O2 -std=c++17 -I../DW1000_BACKUP/src_0205 UWB_Cmac_Bench.cpp \
+ *       ../DW1000_BACKUP/src_0205/DW1000Cmac.cpp ../DW1000_BACKUP/src_0205/DW1000Crypto.cpp -o uwb_cmac_bench
+ * 執行：
+ *   ./uwb_cmac_bench [-n 200000]
+ */
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#include "DW1000Cmac.h"
+#include "HostTest.h"
+
+// 同 DW1000Mac.h / DW1000Ranging.h
+#define SHORT_MAC_LEN   9
+#define LEN_DATA        90
+#define RANGE_MAC_LEN   8
+#define RANGE_ROUND_LEN 4
+#define RANGE_AUTH_MAX_DEVICES ((LEN_DATA - SHORT_MAC_LEN - 2 - RANGE_MAC_LEN) / 17)
+
+static const uint8_t RFC_KEY[16] = {
+	0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+};
+static const uint8_t RFC_MSG[64] = {
+	0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+	0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+	0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+	0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10,
+};
+static const struct {
+	size_t  len;
+	uint8_t tag[16];
+} RFC_TAGS[] = {
+	{ 0, {0xbb, 0x1d, 0x69, 0x29, 0xe9, 0x59, 0x37, 0x28, 0x7f, 0xa3, 0x7d, 0x12, 0x9b, 0x75, 0x67, 0x46}},
+	{16, {0x07, 0x0a, 0x16, 0xb4, 0x6b, 0x4d, 0x41, 0x44, 0xf7, 0x9b, 0xdd, 0x9d, 0xd0, 0x4a, 0x28, 0x7c}},
+	{40, {0xdf, 0xa6, 0x67, 0x47, 0xde, 0x9a, 0xe6, 0x30, 0x30, 0xca, 0x32, 0x61, 0x14, 0x97, 0xc8, 0x27}},
+	{64, {0x51, 0xf0, 0xbe, 0xbf, 0x7e, 0x3b, 0x9d, 0x92, 0xfc, 0x49, 0x74, 0x17, 0x79, 0x36, 0x3c, 0xfe}},
+};
+
+static void checkKnownAnswers() {
+	DW1000Cmac cmac;
+	TEST_CHECK(cmac.setKey(RFC_KEY), "setKey failed");
+	for (const auto& v : RFC_TAGS) {
+		uint8_t tag[16];
+		cmac.compute(RFC_MSG, v.len, tag, sizeof(tag));
+		TEST_CHECK(memcmp(tag, v.tag, sizeof(tag)) == 0, "RFC 4493 tag mismatch for %zu bytes", v.len);
+		// 截短 = 前 RANGE_MAC_LEN bytes
+		TEST_CHECK(cmac.verify(RFC_MSG, v.len, v.tag, RANGE_MAC_LEN), "truncated verify failed for %zu bytes", v.len);
+	}
+}
+
+// 模擬 transmitRange(nullptr)：n 台 anchor 的 RANGE，round 暫放在 macOff 算 MAC 後被 MAC 蓋掉
+static uint16_t buildRange(DW1000Cmac& cmac, uint8_t* data, uint8_t n, uint32_t round) {
+	for (uint16_t i = 0; i < LEN_DATA; i++) data[i] = (uint8_t)(i * 37 + n);
+	data[SHORT_MAC_LEN + 1] = n;
+	const uint16_t macOff = SHORT_MAC_LEN + 2 + 17 * (uint16_t)n;
+	uint8_t tag[RANGE_MAC_LEN];
+	memcpy(data + macOff, &round, RANGE_ROUND_LEN);
+	cmac.compute(data, macOff + RANGE_ROUND_LEN, tag, RANGE_MAC_LEN);
+	memcpy(data + macOff, tag, RANGE_MAC_LEN);
+	return macOff;
+}
+
+// 模擬 ANCHOR 收 RANGE：MAC 拿出來，放自己從 POLL 收到的 round 再驗
+static bool verifyRange(DW1000Cmac& cmac, const uint8_t* rx, uint8_t n, uint32_t pollRound) {
+	uint8_t data[LEN_DATA];
+	memcpy(data, rx, LEN_DATA);
+	const uint16_t macOff = SHORT_MAC_LEN + 2 + 17 * (uint16_t)n;
+	if (macOff + RANGE_MAC_LEN > LEN_DATA) return false;
+	uint8_t rxMac[RANGE_MAC_LEN];
+	memcpy(rxMac, data + macOff, RANGE_MAC_LEN);
+	memcpy(data + macOff, &pollRound, RANGE_ROUND_LEN);
+	return cmac.verify(data, macOff + RANGE_ROUND_LEN, rxMac, RANGE_MAC_LEN);
+}
+
+static void checkRangeFrames(DW1000Cmac& cmac) {
+	TEST_CHECK(RANGE_AUTH_MAX_DEVICES == 4, "RANGE_AUTH_MAX_DEVICES = %d", RANGE_AUTH_MAX_DEVICES);
+	TEST_CHECK(SHORT_MAC_LEN + 2 + 17 * (RANGE_AUTH_MAX_DEVICES + 1) + RANGE_MAC_LEN > LEN_DATA,
+	           "one more anchor would still fit");
+	uint8_t frame[LEN_DATA];
+	for (uint8_t n = 1; n <= RANGE_AUTH_MAX_DEVICES; n++) {
+		buildRange(cmac, frame, n, 1000 + n);
+		TEST_CHECK(verifyRange(cmac, frame, n, 1000 + n), "n=%u: valid RANGE rejected", n);
+		TEST_CHECK(!verifyRange(cmac, frame, n, 999 + n), "n=%u: RANGE from the previous round accepted", n);
+		frame[SHORT_MAC_LEN + 2 + 17 * (n - 1) + 14] ^= 0x01;   // 最後一台的 RANGE sent timestamp
+		TEST_CHECK(!verifyRange(cmac, frame, n, 1000 + n), "n=%u: tampered timestamp accepted", n);
+	}
+}
+
+static void benchFrames(DW1000Cmac& cmac, uint32_t iters) {
+	uint8_t frame[LEN_DATA];
+	printf("anchors  MAC bytes  compute ns/frame  verify ns/frame");
+#ifdef HAVE_TSC
+	printf("  compute cycles/frame");
+#endif
+	printf("\n");
+	for (uint8_t n = 1; n <= RANGE_AUTH_MAX_DEVICES; n++) {
+		uint16_t macOff = buildRange(cmac, frame, n, 1);
+		uint32_t ok = 0;
+		auto t0 = std::chrono::steady_clock::now();
+#ifdef HAVE_TSC
+		uint64_t c0 = __rdtsc();
+#endif
+		for (uint32_t i = 0; i < iters; i++) buildRange(cmac, frame, n, i);
+#ifdef HAVE_TSC
+		uint64_t c1 = __rdtsc();
+#endif
+		auto t1 = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < iters; i++) ok += verifyRange(cmac, frame, n, iters - 1) ? 1 : 0;
+		auto t2 = std::chrono::steady_clock::now();
+		TEST_CHECK(ok == iters, "n=%u: %u of %u verifies passed", n, ok, iters);
+		double computeNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / iters;
+		double verifyNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / iters;
+		printf("%7u  %9u  %16.0f  %15.0f", n, macOff + RANGE_ROUND_LEN, computeNs, verifyNs);
+#ifdef HAVE_TSC
+		printf("  %20.0f", (double)(c1 - c0) / iters);
+#endif
+		printf("\n");
+	}
+}
+
+int main(int argc, char** argv) {
+	uint32_t iters = 200000;
+	int opt;
+	while ((opt = getopt(argc, argv, "n:h")) != -1) {
+		switch (opt) {
+			case 'n': iters = (uint32_t)strtoul(optarg, nullptr, 10); break;
+			default:
+				fprintf(stderr, "usage: %s [-n frames_per_size]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (iters == 0) iters = 1;
+	printf("backend %s, selfTest %s\n", DW1000Crypto::backendName(), DW1000Crypto::selfTest() ? "PASS" : "FAIL");
+	TEST_CHECK(DW1000Crypto::selfTest(), "AES self test failed");
+	checkKnownAnswers();
+
+	DW1000Cmac cmac;
+	const uint8_t key[CMAC_KEY_LEN] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+	TEST_CHECK(cmac.setKey(key), "setKey failed");
+	checkRangeFrames(cmac);
+	benchFrames(cmac, iters);
+	return testSummary("UWB_Cmac_Bench");
+}
@@ -0,0 +1,247 @@
+/*
+ * @file UWB_Crypto_Test.cpp
+ * DW1000Crypto（AES / AES-GCM）的已知答案測試與每包成本
+ *
+ * 測試：
+ *   1. FIPS-197 Appendix C.1 / C.2 / C.3（AES-128 / 192 / 256 單一 block）
+ *   2. GCM 規格（McGrew & Viega）Test Case 2 / 3 / 4 / 5 / 14 / 15 / 16：
+ *      TC4、TC16 有 20-byte AAD、60-byte 明文（最後一個 block 只有 12 bytes），TC5 是 8-byte IV（不是 96-bit 的 J0 路徑）；
+ *      每組都要解密回原文，改一個 TAG / 密文 / AAD byte 都要 CRYPTO_ERR_AUTH_FAILED 且輸出清成 0
+ *   3. RANGE_REPORT 的形狀：AES-256、12-byte AAD、12-byte IV、明文 1..49 bytes 來回，TAG 截短到 4 bytes 也要驗得過
+ *   4. DW1000Crypto::selfTest()
+ *   5. 每包成本：encryptBlock 的 ns/block，和 crypto_benchmark.ino 一樣的 padding 下 gcmEncrypt / gcmDecrypt 的 us/包
+ *
+ * host 只能編 portable 後端（UWB_CRYPTO_BACKEND_PORTABLE），這裡量到的只當相對比較；
+ * mbedtls / esp32-hw 的時間要在 ESP32 上跑 Encryption_YP/crypto_benchmark（同樣的 BENCH 行格式）。
+ *
+ * 編譯：
+ *   g++ -O2 -std=c++17 -I../DW1000_BACKUP/src_0205 UWB_Crypto_Test.cpp ../DW1000_BACKUP/src_0205/DW1000Crypto.cpp \
+ *       -o uwb_crypto_test
+ * 執行：
+ *   ./uwb_crypto_test [-n 20000]
+ */
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "DW1000Crypto.h"
+#include "HostTest.h"
+
+// 同 DW1000Ranging.h / crypto_benchmark.ino
+#define ENC_IV_LEN  12
+#define ENC_TAG_LEN 16
+#define ENC_AAD_LEN 12
+#define REPORT_MAX_PLAIN 49   // LEN_DATA 90 - header 12 - ivMode/IV/TAG 29
+#define BENCH_BASE_LEN   5    // "12.34"
+
+static std::vector<uint8_t> hex(const char* s) {
+	std::vector<uint8_t> v;
+	for (size_t i = 0; s[i] && s[i + 1]; i += 2) {
+		char b[3] = {s[i], s[i + 1], 0};
+		v.push_back((uint8_t)strtoul(b, nullptr, 16));
+	}
+	return v;
+}
+
+struct BlockCase {
+	const char* name;
+	const char* key;
+	const char* ct;
+};
+
+static void testBlock() {
+	const BlockCase cases[] = {
+		{"FIPS-197 C.1", "000102030405060708090a0b0c0d0e0f", "69c4e0d86a7b0430d8cdb78070b4c55a"},
+		{"FIPS-197 C.2", "000102030405060708090a0b0c0d0e0f1011121314151617", "dda97ca4864cdfe06eaf70a0ec0d7191"},
+		{"FIPS-197 C.3", "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f",
+		 "8ea2b7ca516745bfeafc49904b496089"},
+	};
+	const std::vector<uint8_t> pt = hex("00112233445566778899aabbccddeeff");
+	for (const BlockCase& c : cases) {
+		const std::vector<uint8_t> key = hex(c.key), want = hex(c.ct);
+		DW1000Crypto aes;
+		uint8_t out[CRYPTO_BLOCK_LEN];
+		TEST_CHECK(aes.setKey(key.data(), key.size() * 8), "%s: setKey failed", c.name);
+		TEST_CHECK(aes.encryptBlock(pt.data(), out) == 0 && memcmp(out, want.data(), CRYPTO_BLOCK_LEN) == 0,
+		           "%s: ciphertext mismatch", c.name);
+	}
+	DW1000Crypto bad;
+	uint8_t out[CRYPTO_BLOCK_LEN];
+	TEST_CHECK(!bad.setKey(pt.data(), 64) && bad.encryptBlock(pt.data(), out) == CRYPTO_ERR_NOT_READY,
+	           "64-bit key accepted");
+}
+
+struct GcmCase {
+	const char* name;
+	const char* key;
+	const char* iv;
+	const char* aad;
+	const char* pt;
+	const char* ct;
+	const char* tag;
+};
+
+#define GCM_K1  "feffe9928665731c6d6a8f9467308308"
+#define GCM_IV  "cafebabefacedbaddecaf888"
+#define GCM_AAD "feedfacedeadbeeffeedfacedeadbeefabaddad2"
+#define GCM_P60 \
+	"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39"
+
+static const GcmCase GCM_CASES[] = {
+	{"TC2", "00000000000000000000000000000000", "000000000000000000000000", "", "00000000000000000000000000000000",
+	 "0388dace60b6a392f328c2b971b2fe78", "ab6e47d42cec13bdf53a67b21257bddf"},
+	{"TC3", GCM_K1, GCM_IV, "", GCM_P60 "1aafd255",
+	 "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091"
+	 "473f5985",
+	 "4d5c2af327cd64a62cf35abd2ba6fab4"},
+	{"TC4", GCM_K1, GCM_IV, GCM_AAD, GCM_P60,
+	 "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091",
+	 "5bc94fbc3221a5db94fae95ae7121a47"},
+	{"TC5", GCM_K1, "cafebabefacedbad", GCM_AAD, GCM_P60,
+	 "61353b4c2806934a777ff51fa22a4755699b2a714fcdc6f83766e5f97b6c742373806900e49f24b22b097544d4896b424989b5e1ebac0f07c23f4598",
+	 "3612d2e79e3b0785561be14aaca2fccb"},
+	{"TC14", "0000000000000000000000000000000000000000000000000000000000000000", "000000000000000000000000", "",
+	 "00000000000000000000000000000000", "cea7403d4d606b6e074ec5d3baf39d18", "d0d1c8a799996bf0265b98b5d48ab919"},
+	{"TC15", GCM_K1 GCM_K1, GCM_IV, "", GCM_P60 "1aafd255",
+	 "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662"
+	 "898015ad",
+	 "b094dac5d93471bdec1a502270e3cc6c"},
+	{"TC16", GCM_K1 GCM_K1, GCM_IV, GCM_AAD, GCM_P60,
+	 "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662",
+	 "76fc6ece0f4e1768cddf8853bb2d551b"},
+};
+
+// 改 buf[i] 一個 bit 之後解密：要 AUTH_FAILED 且輸出全 0
+static bool rejects(DW1000Crypto& c, const std::vector<uint8_t>& iv, std::vector<uint8_t> aad, std::vector<uint8_t> ct,
+                    std::vector<uint8_t> tag, int which) {
+	std::vector<uint8_t>& buf = which == 0 ? tag : which == 1 ? ct : aad;
+	if (buf.empty()) return true;
+	buf[buf.size() / 2] ^= 0x01;
+	std::vector<uint8_t> out(ct.size() + 1, 0xA5);
+	const int ret = c.gcmDecrypt(iv.data(), iv.size(), aad.data(), aad.size(), ct.data(), ct.size(), out.data(), tag.data(),
+	                             tag.size());
+	for (size_t i = 0; i < ct.size(); i++) {
+		if (out[i] != 0) return false;
+	}
+	return ret == CRYPTO_ERR_AUTH_FAILED;
+}
+
+static void testGcm() {
+	static const char* const WHAT[] = {"tag", "ciphertext", "AAD"};
+	for (const GcmCase& g : GCM_CASES) {
+		const std::vector<uint8_t> key = hex(g.key), iv = hex(g.iv), aad = hex(g.aad), pt = hex(g.pt), want = hex(g.ct),
+		                           wantTag = hex(g.tag);
+		DW1000Crypto c;
+		TEST_CHECK(c.setKey(key.data(), key.size() * 8), "%s: setKey failed", g.name);
+		std::vector<uint8_t> ct(pt.size()), back(pt.size()), tag(ENC_TAG_LEN);
+		TEST_CHECK(c.gcmEncrypt(iv.data(), iv.size(), aad.data(), aad.size(), pt.data(), pt.size(), ct.data(), tag.data(),
+		                        tag.size()) == 0,
+		           "%s: gcmEncrypt failed", g.name);
+		TEST_CHECK(ct == want, "%s: ciphertext mismatch", g.name);
+		TEST_CHECK(tag == wantTag, "%s: tag mismatch", g.name);
+		TEST_CHECK(c.gcmDecrypt(iv.data(), iv.size(), aad.data(), aad.size(), ct.data(), ct.size(), back.data(), tag.data(),
+		                        tag.size()) == 0 &&
+		               back == pt,
+		           "%s: decrypt failed", g.name);
+		for (int k = 0; k < 3; k++) {
+			TEST_CHECK(rejects(c, iv, aad, ct, tag, k), "%s: modified %s accepted", g.name, WHAT[k]);
+		}
+	}
+}
+
+static void buildReport(uint8_t aad[ENC_AAD_LEN], uint8_t iv[ENC_IV_LEN], uint32_t n) {
+	aad[0] = 0x03;   // msgid
+	aad[1] = 0x81;   // anchor short address
+	aad[2] = 0x00;
+	aad[3] = 0x02;   // ivMode
+	memset(iv, 0, ENC_IV_LEN);
+	memcpy(iv, &n, sizeof(n));
+	memcpy(aad + 4, iv, 8);
+}
+
+static void testReport() {
+	uint8_t key[32];
+	for (uint8_t i = 0; i < 32; i++) key[i] = (uint8_t)(0x20 + i);
+	DW1000Crypto c;
+	TEST_CHECK(c.setKey(key, 256), "setKey failed");
+	for (uint32_t n = 1; n <= REPORT_MAX_PLAIN; n++) {
+		uint8_t aad[ENC_AAD_LEN], iv[ENC_IV_LEN], pt[REPORT_MAX_PLAIN], ct[REPORT_MAX_PLAIN], back[REPORT_MAX_PLAIN],
+		    tag[ENC_TAG_LEN];
+		buildReport(aad, iv, n);
+		for (uint32_t i = 0; i < n; i++) pt[i] = (uint8_t)('0' + (i + n) % 10);
+		TEST_CHECK(c.gcmEncrypt(iv, ENC_IV_LEN, aad, ENC_AAD_LEN, pt, n, ct, tag, ENC_TAG_LEN) == 0, "n=%u: encrypt failed",
+		           n);
+		TEST_CHECK(c.gcmDecrypt(iv, ENC_IV_LEN, aad, ENC_AAD_LEN, ct, n, back, tag, ENC_TAG_LEN) == 0 &&
+		               memcmp(back, pt, n) == 0,
+		           "n=%u: round trip failed", n);
+		TEST_CHECK(c.gcmDecrypt(iv, ENC_IV_LEN, aad, ENC_AAD_LEN, ct, n, back, tag, 4) == 0, "n=%u: 4-byte tag rejected", n);
+		aad[2] ^= 0x01;   // 別台 anchor 的位址
+		TEST_CHECK(c.gcmDecrypt(iv, ENC_IV_LEN, aad, ENC_AAD_LEN, ct, n, back, tag, ENC_TAG_LEN) == CRYPTO_ERR_AUTH_FAILED,
+		           "n=%u: report bound to another anchor accepted", n);
+	}
+	uint8_t iv[ENC_IV_LEN] = {0}, tag[ENC_TAG_LEN], b[1] = {0};
+	TEST_CHECK(c.gcmEncrypt(iv, ENC_IV_LEN, NULL, 0, b, 1, b, tag, 3) == CRYPTO_ERR_BAD_INPUT, "3-byte tag accepted");
+	TEST_CHECK(c.gcmEncrypt(iv, 0, NULL, 0, b, 1, b, tag, ENC_TAG_LEN) == CRYPTO_ERR_BAD_INPUT, "empty IV accepted");
+}
+
+static void bench(uint32_t iters) {
+	uint8_t key[32];
+	for (uint8_t i = 0; i < 32; i++) key[i] = (uint8_t)(0x20 + i);
+	DW1000Crypto c;
+	c.setKey(key, 256);
+
+	uint8_t blk[CRYPTO_BLOCK_LEN] = {0};
+	auto t0 = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < iters * 4; i++) c.encryptBlock(blk, blk);
+	auto t1 = std::chrono::steady_clock::now();
+	printf("backend %s: encryptBlock (AES-256) %.0f ns/block (%02x)\n", DW1000Crypto::backendName(),
+	       std::chrono::duration<double, std::nano>(t1 - t0).count() / (iters * 4.0), blk[0]);
+
+	// 同 crypto_benchmark.ino：BENCH,<backend>,<padding>,<plainLen>,<enc_us>,<dec_us>
+	for (int pad : {0, 10, 20, 30, 44}) {
+		const uint32_t n = BENCH_BASE_LEN + pad;
+		uint8_t aad[ENC_AAD_LEN], iv[ENC_IV_LEN], pt[REPORT_MAX_PLAIN] = {0}, ct[REPORT_MAX_PLAIN], back[REPORT_MAX_PLAIN],
+		    tag[ENC_TAG_LEN];
+		uint32_t ok = 0;
+		auto e0 = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < iters; i++) {
+			buildReport(aad, iv, i);
+			c.gcmEncrypt(iv, ENC_IV_LEN, aad, ENC_AAD_LEN, pt, n, ct, tag, ENC_TAG_LEN);
+		}
+		auto e1 = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < iters; i++) {
+			ok += c.gcmDecrypt(iv, ENC_IV_LEN, aad, ENC_AAD_LEN, ct, n, back, tag, ENC_TAG_LEN) == 0 ? 1 : 0;
+		}
+		auto e2 = std::chrono::steady_clock::now();
+		TEST_CHECK(ok == iters, "pad %d: %u of %u decrypts passed", pad, ok, iters);
+		printf("BENCH,%s,%d,%u,%.2f,%.2f\n", DW1000Crypto::backendName(), pad, n,
+		       std::chrono::duration<double, std::micro>(e1 - e0).count() / iters,
+		       std::chrono::duration<double, std::micro>(e2 - e1).count() / iters);
+	}
+}
+
+int main(int argc, char** argv) {
+	uint32_t iters = 20000;
+	int opt;
+	while ((opt = getopt(argc, argv, "n:h")) != -1) {
+		switch (opt) {
+			case 'n': iters = (uint32_t)strtoul(optarg, nullptr, 10); break;
+			default:
+				fprintf(stderr, "usage: %s [-n packets_per_size]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (iters == 0) iters = 1;
+	TEST_CHECK(DW1000Crypto::selfTest(), "selfTest failed");
+	testBlock();
+	testGcm();
+	testReport();
+	bench(iters);
+	return testSummary("UWB_Crypto_Test");
+}
@@ -0,0 +1,209 @@
+/*
+ * @file UWB_DelaySolver_Sim.cpp
+ * DelaySolver（UWB_Delay_Solver 的 pairwise antenna delay 最小平方解）的模擬驗證
+ *
+ * 模型：anchor 81..84 用 anchors.txt 的座標，另外 2 台 tag 在 anchor 範圍內離地約 1 m；每台真正 delay 在 16400..16800，
+ * 量測時用的 delay 是 16384 或 16600（隨機），每一對量 SIM_SAMPLES 筆：
+ *   range = 距離 - S * ((D_i - d_i) + (D_j - d_j)) + 高斯雜訊，-p 比例的 range 多 0.3..2 m（反射）
+ * S = ANTCAL_SEED_SLOPE（和 solver 假設的一樣，斜率誤差不在這裡模擬）。每次試驗重新抽 delay，跑 -n 次。
+ *
+ * 測試：
+ *   1. 全部 15 對（anchor-anchor、anchor-tag、tag-tag）：delay 誤差 RMS < SIM_RMS_SD 倍、最大 < SIM_MAX_SD 倍回報的平均 1 sd
+ *      （5 cm 雜訊時 1 sd 約 0.6 tick；sd 本身照雜訊縮放，所以 -e 改大也適用）
+ *   2. chi2/dof 平均在 SIM_CHI2_LO..SIM_CHI2_HI（雜訊模型正確時應約 1）
+ *   3. 回報的 1 sd 換成 95% CI（1.96 sd）涵蓋真值 >= SIM_COVERAGE（-n 100 x 6 台時 95% 的二項標準差約 0.9%）
+ *   4. 只有 anchor-tag（二分圖）-> DELAY_SOLVE_SINGULAR；加上 tag-tag 一對就解得出來
+ *   5. < 3 台、pair 數 < node 數 -> DELAY_SOLVE_TOO_FEW；summarizePair() 去離群值後不到 2 筆回 false
+ *   6. 一台 anchor 座標錯 0.3 m：chi2/dof > 4（UWB_Delay_Solver 印警告的門檻）
+ *
+ * 編譯：
+ *   g++ -O2 -std=c++17 -I../DW1000_BACKUP/src_0205 UWB_DelaySolver_Sim.cpp DelaySolver.cpp -o uwb_delaysolver_sim
+ * 執行：
+ *   ./uwb_delaysolver_sim [-n 100] [-e 0.05] [-p 0.03]
+ */
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "DelaySolver.h"
+#include "HostTest.h"
+#include "UWBAntennaCal.h"   // ANTCAL_SEED_SLOPE
+
+#define SIM_SAMPLES   100
+#define SIM_RMS_SD    1.3
+#define SIM_MAX_SD    4.5
+#define SIM_CHI2_LO   0.7
+#define SIM_CHI2_HI   1.4
+#define SIM_COVERAGE  92.0
+
+struct Node {
+	uint16_t id;
+	double   p[3];
+	double   trueDelay;
+	double   usedDelay;
+};
+
+static double dist(const Node& a, const Node& b) {
+	const double dx = a.p[0] - b.p[0], dy = a.p[1] - b.p[1], dz = a.p[2] - b.p[2];
+	return sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+static std::vector<Node> makeNodes(std::mt19937& rng) {
+	std::uniform_real_distribution<double> u(0.0, 1.0);
+	std::vector<Node> nodes = {
+		{0x81, {0.00, 0.00, 0.97}, 0, 0},  {0x82, {3.99, 5.44, 1.14}, 0, 0}, {0x83, {3.71, -0.30, 0.61}, 0, 0},
+		{0x84, {-0.56, 4.88, 0.15}, 0, 0}, {0x01, {1.20, 1.50, 1.00}, 0, 0}, {0x02, {2.60, 3.40, 1.10}, 0, 0},
+	};
+	for (Node& n : nodes) {
+		n.trueDelay = 16400.0 + 400.0 * u(rng);
+		n.usedDelay = (u(rng) < 0.5) ? 16384.0 : 16600.0;
+	}
+	return nodes;
+}
+
+// 量 a-b 一對；distance 是給 solver 的已知距離（座標量錯時和真正距離不同）
+static PairInput measure(const Node& a, const Node& b, double distance, double noise, double outliers,
+                         std::mt19937& rng) {
+	std::normal_distribution<double> n(0.0, noise);
+	std::uniform_real_distribution<double> u(0.0, 1.0);
+	const double bias = -ANTCAL_SEED_SLOPE * ((a.trueDelay - a.usedDelay) + (b.trueDelay - b.usedDelay));
+	std::vector<double> r;
+	for (int k = 0; k < SIM_SAMPLES; k++) {
+		double x = dist(a, b) + bias + n(rng);
+		if (u(rng) < outliers) x += 0.3 + 1.7 * u(rng);
+		r.push_back(x);
+	}
+	PairInput in;
+	summarizePair(r, &in.stat);
+	in.distance = distance;
+	return in;
+}
+
+static std::map<uint16_t, double> usedDelays(const std::vector<Node>& nodes) {
+	std::map<uint16_t, double> used;
+	for (const Node& n : nodes) used[n.id] = n.usedDelay;
+	return used;
+}
+
+static bool isAnchor(const Node& n) {
+	return n.id >= 0x80;
+}
+
+int main(int argc, char** argv) {
+	int trials = 100;
+	double noise = 0.05, outliers = 0.03;
+	int opt;
+	while ((opt = getopt(argc, argv, "n:e:p:h")) != -1) {
+		switch (opt) {
+			case 'n': trials = atoi(optarg); break;
+			case 'e': noise = strtod(optarg, nullptr); break;
+			case 'p': outliers = strtod(optarg, nullptr); break;
+			default:
+				fprintf(stderr, "usage: %s [-n trials] [-e noise_m] [-p outlier_rate]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (trials < 20) trials = 20;
+
+	std::mt19937 rng(7);
+	printf("noise %.2f m, outliers %.0f%%, %d samples/pair, %d trials\n", noise, outliers * 100.0, SIM_SAMPLES, trials);
+
+	// ===== 1-3：全部互量，誤差 / chi2 / CI 涵蓋率 =====
+	double sumErr2 = 0.0, maxErr = 0.0, sumChi2 = 0.0, sumSd = 0.0;
+	int estimates = 0, covered = 0, failed = 0;
+	for (int t = 0; t < trials; t++) {
+		const std::vector<Node> nodes = makeNodes(rng);
+		std::map<PairKey, PairInput> pairs;
+		for (size_t i = 0; i < nodes.size(); i++)
+			for (size_t j = i + 1; j < nodes.size(); j++)
+				pairs[pairKey(nodes[i].id, nodes[j].id)] =
+				    measure(nodes[i], nodes[j], dist(nodes[i], nodes[j]), noise, outliers, rng);
+		DelaySolution sol;
+		if (solveDelays(pairs, usedDelays(nodes), &sol) != DELAY_SOLVE_OK) {
+			failed++;
+			continue;
+		}
+		sumChi2 += sol.chi2 / sol.dof;
+		for (size_t i = 0; i < sol.ids.size(); i++) {
+			for (const Node& n : nodes) {
+				if (n.id != sol.ids[i]) continue;
+				const double e = fabs(sol.delay[i] - n.trueDelay);
+				sumErr2 += e * e;
+				maxErr = std::max(maxErr, e);
+				sumSd += sol.sd[i];
+				if (e <= 1.96 * sol.sd[i]) covered++;
+				estimates++;
+			}
+		}
+	}
+	TEST_CHECK(failed == 0 && estimates == 6 * trials, "%d of %d full-mesh solves failed", failed, trials);
+	const double rms = sqrt(sumErr2 / std::max(estimates, 1));
+	const double meanSd = sumSd / std::max(estimates, 1);
+	const double chi2dof = sumChi2 / std::max(trials - failed, 1);
+	const double coverage = 100.0 * covered / std::max(estimates, 1);
+	printf("  full mesh: delay error rms %.2f max %.2f ticks, mean 1 sd %.2f, chi2/dof %.2f, 95%% CI coverage %.1f%%\n", rms,
+	       maxErr, meanSd, chi2dof, coverage);
+	TEST_CHECK(rms < SIM_RMS_SD * meanSd, "delay error rms %.2f ticks, 1 sd %.2f", rms, meanSd);
+	TEST_CHECK(maxErr < SIM_MAX_SD * meanSd, "delay error max %.2f ticks, 1 sd %.2f", maxErr, meanSd);
+	TEST_CHECK(chi2dof > SIM_CHI2_LO && chi2dof < SIM_CHI2_HI, "mean chi2/dof %.2f", chi2dof);
+	TEST_CHECK(coverage >= SIM_COVERAGE, "95%% CI coverage %.1f%%", coverage);
+
+	// ===== 4：二分圖（只有 anchor-tag）解不出來，加一對 tag-tag 就可以 =====
+	{
+		const std::vector<Node> nodes = makeNodes(rng);
+		std::map<PairKey, PairInput> pairs;
+		for (const Node& a : nodes)
+			for (const Node& b : nodes)
+				if (isAnchor(a) && !isAnchor(b)) pairs[pairKey(a.id, b.id)] = measure(a, b, dist(a, b), noise, outliers, rng);
+		DelaySolution sol;
+		const DelaySolveStatus s = solveDelays(pairs, usedDelays(nodes), &sol);
+		TEST_CHECK(s == DELAY_SOLVE_SINGULAR, "anchor-tag only (%zu pairs): status %d, expected singular", pairs.size(), s);
+		pairs[pairKey(nodes[4].id, nodes[5].id)] = measure(nodes[4], nodes[5], dist(nodes[4], nodes[5]), noise, outliers, rng);
+		TEST_CHECK(solveDelays(pairs, usedDelays(nodes), &sol) == DELAY_SOLVE_OK, "anchor-tag + one tag-tag pair not solved");
+		printf("  bipartite: anchor-tag only -> status %d, + tag-tag -> chi2/dof %.2f\n", s, sol.chi2 / sol.dof);
+	}
+
+	// ===== 5：太少 =====
+	{
+		const std::vector<Node> nodes = makeNodes(rng);
+		std::map<PairKey, PairInput> pairs;
+		pairs[pairKey(nodes[0].id, nodes[1].id)] = measure(nodes[0], nodes[1], dist(nodes[0], nodes[1]), noise, 0.0, rng);
+		DelaySolution sol;
+		TEST_CHECK(solveDelays(pairs, usedDelays(nodes), &sol) == DELAY_SOLVE_TOO_FEW, "2 nodes not rejected");
+		// 4 台、3 對（一條鏈）
+		pairs[pairKey(nodes[1].id, nodes[2].id)] = measure(nodes[1], nodes[2], dist(nodes[1], nodes[2]), noise, 0.0, rng);
+		pairs[pairKey(nodes[2].id, nodes[3].id)] = measure(nodes[2], nodes[3], dist(nodes[2], nodes[3]), noise, 0.0, rng);
+		TEST_CHECK(solveDelays(pairs, usedDelays(nodes), &sol) == DELAY_SOLVE_TOO_FEW, "4 nodes / 3 pairs not rejected");
+		TEST_CHECK(solveDelays(std::map<PairKey, PairInput>(), usedDelays(nodes), &sol) == DELAY_SOLVE_TOO_FEW,
+		           "empty input not rejected");
+		PairStat st;
+		TEST_CHECK(!summarizePair({1.0}, &st) && !summarizePair({}, &st), "summarizePair accepted < 2 samples");
+	}
+
+	// ===== 6：anchor 83 的座標錯 0.3 m（solver 拿到的距離不對）=====
+	{
+		const std::vector<Node> nodes = makeNodes(rng);
+		Node wrong = nodes[2];
+		wrong.p[0] += 0.3;
+		std::map<PairKey, PairInput> pairs;
+		for (size_t i = 0; i < nodes.size(); i++) {
+			for (size_t j = i + 1; j < nodes.size(); j++) {
+				const Node& a = (i == 2) ? wrong : nodes[i];
+				pairs[pairKey(nodes[i].id, nodes[j].id)] = measure(nodes[i], nodes[j], dist(a, nodes[j]), noise, outliers, rng);
+			}
+		}
+		DelaySolution sol;
+		TEST_CHECK(solveDelays(pairs, usedDelays(nodes), &sol) == DELAY_SOLVE_OK, "misplaced anchor: solve failed");
+		printf("  anchor %X off by 0.3 m: chi2/dof %.1f\n", wrong.id, sol.chi2 / sol.dof);
+		TEST_CHECK(sol.chi2 / sol.dof > 4.0, "misplaced anchor not flagged: chi2/dof %.2f", sol.chi2 / sol.dof);
+	}
+	return testSummary("UWB_DelaySolver_Sim");
+}
@@ -0,0 +1,161 @@
+/*
+ * @file UWB_Delay_Solver.cpp
+ * 多台一次校正 antenna delay：所有 node（anchor + tag）兩兩互量，用已知座標以最小平方法同時解出每台的 delay
+ *
+ * 每台板子跑 ESP32_UWB_pairwise_calibrate.ino，serial 會印
+ *   DLY,<自己的 short address hex>,<量測時用的 antenna delay>
+ *   RNG,<自己>,<對方>,<range m>
+ * 把所有板子的 serial log 接在一起當輸入（其他行會忽略）；座標檔和 anchors.txt 同格式，tag 也要寫進去。
+ *
+ * 模型：delay 改變 1 tick，range 變化 ANTCAL_SEED_SLOPE（約 -4.69 mm），兩端的 delay 效果相加：
+ *   range_ij + S * ((D_i - d_i) + (D_j - d_j)) = |p_i - p_j|
+ *   d = 量測時用的 delay，D = 要解的 delay，S = ANTCAL_SEED_SLOPE
+ *   => D_i + D_j = d_i + d_j + (|p_i - p_j| - range_ij) / S
+ *   每一對先用 median / MAD 去掉離群值再取平均與標準誤，1 / 標準誤^2 當權重解正規方程式（DelaySolver.h）。
+ *   方程式只和 D_i + D_j 有關：至少要 3 台，且量到的 pair 不能只有 anchor-tag（二分圖，差一個自由度解不出來），
+ *   anchor 之間也要互量。模擬驗證見 UWB_DelaySolver_Sim.cpp。
+ *
+ * 輸出：每台 delay ± 標準誤（殘差 reduced chi2 > 1 時照比例放大），和每一對的殘差；
+ *       殘差特別大的 pair 多半是 NLOS 或座標量錯，可以用 -x 排除後重解。
+ *
+ * 編譯：
+ *   g++ -O2 -std=c++17 -I../DW1000_BACKUP/src_0205 UWB_Delay_Solver.cpp DelaySolver.cpp -o uwb_delay
+ * 執行：
+ *   cat anchor81.log anchor82.log ... tag.log > pairs.log
+ *   ./uwb_delay -a nodes.txt -i pairs.log [-d 16384] [-m 10] [-x 81-84]
+ */
+
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "DelaySolver.h"
+
+static bool loadNodes(const char* path, std::map<uint16_t, std::vector<double>>* nodes) {
+	FILE* f = fopen(path, "r");
+	if (f == nullptr) return false;
+	char line[256];
+	while (fgets(line, sizeof(line), f)) {
+		if (line[0] == '#' || line[0] == '\n') continue;
+		unsigned id;
+		double x, y, z;
+		if (sscanf(line, "%x %lf %lf %lf", &id, &x, &y, &z) == 4) (*nodes)[(uint16_t)id] = {x, y, z};
+	}
+	fclose(f);
+	return nodes->size() >= 3;
+}
+
+int main(int argc, char** argv) {
+	const char* nodePath = "anchors.txt";
+	const char* inPath = nullptr;
+	long defaultDelay = 16384;
+	size_t minSamples = 10;
+	std::set<PairKey> excluded;
+	int opt;
+	while ((opt = getopt(argc, argv, "a:i:d:m:x:h")) != -1) {
+		switch (opt) {
+			case 'a': nodePath = optarg; break;
+			case 'i': inPath = optarg; break;
+			case 'd': defaultDelay = atol(optarg); break;
+			case 'm': minSamples = (size_t)atol(optarg); break;
+			case 'x': {
+				unsigned a, b;
+				if (sscanf(optarg, "%x-%x", &a, &b) == 2) excluded.insert(pairKey((uint16_t)a, (uint16_t)b));
+				break;
+			}
+			default:
+				fprintf(stderr, "usage: %s -a nodes.txt -i pairs.log [-d default_delay] [-m min_samples] [-x aa-bb ...]\n", argv[0]);
+				return 1;
+		}
+	}
+	std::map<uint16_t, std::vector<double>> nodes;
+	if (!loadNodes(nodePath, &nodes)) {
+		fprintf(stderr, "cannot load >= 3 node positions from %s\n", nodePath);
+		return 1;
+	}
+	FILE* in = (inPath == nullptr || inPath[0] == '-') ? stdin : fopen(inPath, "r");
+	if (in == nullptr) {
+		perror(inPath);
+		return 1;
+	}
+
+	// ===== 讀 log：DLY / RNG 行 =====
+	std::map<uint16_t, long> delayOf;
+	std::map<PairKey, std::vector<double>> samples;
+	size_t lines = 0, unknown = 0;
+	char line[256];
+	while (fgets(line, sizeof(line), in)) {
+		// serial monitor 可能在行首加時間戳：從 "DLY," / "RNG," 開始解析
+		const char* p;
+		unsigned a, b;
+		long dly;
+		double r;
+		if ((p = strstr(line, "DLY,")) != nullptr && sscanf(p, "DLY,%x,%ld", &a, &dly) == 2) {
+			auto it = delayOf.find((uint16_t)a);
+			if (it != delayOf.end() && it->second != dly)
+				fprintf(stderr, "[DELAY][WARN] node %X delay changed %ld -> %ld, using the last one\n", a, it->second, dly);
+			delayOf[(uint16_t)a] = dly;
+		} else if ((p = strstr(line, "RNG,")) != nullptr && sscanf(p, "RNG,%x,%x,%lf", &a, &b, &r) == 3) {
+			lines++;
+			if (a == b) continue;
+			if (!nodes.count((uint16_t)a) || !nodes.count((uint16_t)b)) {
+				unknown++;
+				continue;
+			}
+			samples[pairKey((uint16_t)a, (uint16_t)b)].push_back(r);
+		}
+	}
+	if (in != stdin) fclose(in);
+
+	// ===== 每一對：去離群值、平均、標準誤 =====
+	auto distance = [&](const PairKey& k) {
+		const std::vector<double>& p = nodes.at(k.first);
+		const std::vector<double>& q = nodes.at(k.second);
+		return std::sqrt((p[0] - q[0]) * (p[0] - q[0]) + (p[1] - q[1]) * (p[1] - q[1]) + (p[2] - q[2]) * (p[2] - q[2]));
+	};
+	std::map<PairKey, PairInput> pairs;
+	std::map<uint16_t, double> usedDelay;
+	for (auto& kv : samples) {
+		if (excluded.count(kv.first) || kv.second.size() < minSamples) continue;
+		PairInput in;
+		if (!summarizePair(kv.second, &in.stat)) continue;
+		in.distance = distance(kv.first);
+		pairs[kv.first] = in;
+		for (uint16_t id : {kv.first.first, kv.first.second}) {
+			auto it = delayOf.find(id);
+			usedDelay[id] = (double)(it != delayOf.end() ? it->second : defaultDelay);
+		}
+	}
+
+	DelaySolution sol;
+	const DelaySolveStatus status = solveDelays(pairs, usedDelay, &sol);
+	printf("RNG lines=%zu (unknown node %zu), pairs=%zu, nodes=%zu\n", lines, unknown, pairs.size(), sol.ids.size());
+	if (status == DELAY_SOLVE_TOO_FEW) {
+		fprintf(stderr, "need >= 3 nodes and >= as many pairs as nodes (anchors must also range each other)\n");
+		return 1;
+	}
+	if (status == DELAY_SOLVE_SINGULAR) {
+		fprintf(stderr, "singular system: the measured pairs only tie (D_i + D_j) of a bipartite set, add anchor-anchor pairs\n");
+		return 1;
+	}
+
+	printf("\nnode  used_delay  new_delay   +/-1sd(tick)\n");
+	for (size_t i = 0; i < sol.ids.size(); i++)
+		printf("%4X  %10.0f  %9ld  %8.1f\n", sol.ids[i], usedDelay[sol.ids[i]], lround(sol.delay[i]), sol.sd[i]);
+	printf("\npair    samples  rejected  true(m)  mean(m)  before(m)  after(m)\n");
+	for (auto& kv : pairs) {
+		const PairStat& st = kv.second.stat;
+		printf("%X-%X  %7zu  %8zu  %7.3f  %7.3f  %+9.3f  %+8.3f\n", kv.first.first, kv.first.second, st.used, st.rejected,
+		       kv.second.distance, st.mean, st.mean - kv.second.distance, sol.residual[kv.first]);
+	}
+	const double chi2dof = sol.dof ? sol.chi2 / sol.dof : 0.0;
+	printf("\nchi2/dof = %.2f (dof %zu)%s\n", chi2dof, sol.dof,
+	       (sol.dof && chi2dof > 4.0) ? "  -- large: check positions / NLOS pairs (-x)" : "");
+	return 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * @file UWB_DelayedTx_Test.cpp
+ * DW1000Class::setDelayFrom() / cancelLateTransmit() 的 host 測試（DW1000.cpp 接 DW1000RegSim 模擬的暫存器）
+ *
+ * 測試：
+ *   1. setDelayFrom()：{SYS_TIME = now, reference, delay us}，DX_TIME = (reference + delay) mod 2^40、低 9 bits 清掉，
+ *      txTime = DX_TIME + antenna delay，getDelaySlackUs() = DX_TIME - now；
+ *      一般情況、reference 和 now 都在 40-bit 週期尾端、target 繞回 0（now 已經繞回、reference 還沒）
+ *   2. slack < DW1000_DELAYED_TX_MIN_SLACK_US（或已經過了：reference 太舊、delay 太短）：回 false、不寫 DX_TIME、txTime 不動、
+ *      startTransmit() 不帶 TXDLYS；不是 TX mode 時也回 false
+ *   3. 成功時 startTransmit() 的 SYS_CTRL 有 TXDLYS + TXSTRT
+ *   4. cancelLateTransmit()：SYS_STATUS 有 HPDWARN -> true、TRXOFF、HPDWARN 被清掉（寫 1 清除），再呼叫一次 -> false；
+ *      沒有 HPDWARN 時不動 SYS_CTRL；receivePermanently 時重新打開 receiver；newTransmit() 也會清掉舊的 HPDWARN
+ *
+ * 編譯：
+ *   g++ -O2 -Wall -std=c++17 -Ihost_arduino -I../DW1000_BACKUP/src_0205 UWB_DelayedTx_Test.cpp host_arduino/HostArduino.cpp \
+ *       ../DW1000_BACKUP/src_0205/DW1000.cpp ../DW1000_BACKUP/src_0205/DW1000Time.cpp \
+ *       ../DW1000_BACKUP/src_0205/UWBCir.cpp ../DW1000_BACKUP/src_0205/UWBClockOffset.cpp -o uwb_delayedtx_test
+ * 執行：
+ *   ./uwb_delayedtx_test
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#include "DW1000.h"
+#include "DW1000RegSim.h"
+#include "HostTest.h"
+
+#define ANTENNA_DELAY 16436
+#define HPDWARN_BYTE  (HPDWARN_BIT / 8)
+#define HPDWARN_MASK  (1u << (HPDWARN_BIT % 8))
+
+static const int64_t M = DW1000Time::TIME_OVERFLOW;
+
+struct DelayCase {
+	int64_t now;
+	int64_t ref;
+	int32_t us;
+	bool    ok;
+	const char* name;
+};
+
+static void testSetDelayFrom() {
+	const DelayCase cases[] = {
+		{1000000000LL, 990000000LL, 1000, true, "normal"},
+		{1000000000LL, 900000000LL, 1000, false, "reference too old"},
+		{M - 2000, M - 64000 * 3, 4000, true, "end of the 40-bit period"},
+		{5000, M - 64000 * 3, 4000, true, "target wraps past 0"},
+		{1000000000LL, 900000000LL, 100, false, "already past"},
+		{1000000000LL, 1000000000LL, 150, false, "slack below the minimum"},
+	};
+	for (const DelayCase& c : cases) {
+		dwSimInstall();
+		DW1000.setAntennaDelay(ANTENNA_DELAY);
+		DW1000.newTransmit();
+		dwSimSet(SYS_TIME, 0, (uint64_t)c.now, LEN_SYS_TIME);
+		dwSimLog.clear();
+
+		DW1000Time ref((int64_t)c.ref), tx((int64_t)12345);
+		const DW1000Time delay(c.us, DW1000Time::MICROSECONDS);
+		TEST_CHECK(fabs((double)delay.getTimestamp() - c.us * 63897.6) <= 1.0, "%s: delay %lld ticks", c.name,
+		           (long long)delay.getTimestamp());
+		const boolean ok = DW1000.setDelayFrom(ref, delay, &tx);
+		const int64_t target = ((c.ref + delay.getTimestamp()) & (M - 1)) & ~0x1FFLL;
+		int64_t slack = (target - c.now) & (M - 1);
+		if (slack > M / 2) slack -= M;
+
+		TEST_CHECK(ok == c.ok, "%s: setDelayFrom returned %d", c.name, ok);
+		TEST_CHECK(fabs(DW1000.getDelaySlackUs() - slack * DW1000Time::TIME_RES) < 0.01, "%s: slack %.3f us, expected %.3f",
+		           c.name, DW1000.getDelaySlackUs(), slack * DW1000Time::TIME_RES);
+		if (c.ok) {
+			const int64_t dx = (int64_t)dwSimGet(DX_TIME, 0, LEN_DX_TIME);
+			TEST_CHECK(dx == target, "%s: DX_TIME %llX, expected %llX", c.name, (long long)dx, (long long)target);
+			TEST_CHECK(tx.getTimestamp() == target + ANTENNA_DELAY, "%s: txTime %lld, expected %lld", c.name,
+			           (long long)tx.getTimestamp(), (long long)(target + ANTENNA_DELAY));
+		} else {
+			TEST_CHECK(dwSimCount(DX_TIME, true) == 0, "%s: DX_TIME written on a rejected schedule", c.name);
+			TEST_CHECK(tx.getTimestamp() == 12345, "%s: txTime changed on a rejected schedule", c.name);
+		}
+
+		DW1000.startTransmit();
+		const uint32_t ctrl = (uint32_t)dwSimGet(SYS_CTRL, 0, LEN_SYS_CTRL);
+		TEST_CHECK((ctrl & (1u << TXSTRT_BIT)) && ((ctrl & (1u << TXDLYS_BIT)) != 0) == c.ok, "%s: SYS_CTRL %08X", c.name,
+		           ctrl);
+	}
+
+	// 不是 TX mode
+	dwSimInstall();
+	DW1000.newReceive();
+	dwSimSet(SYS_TIME, 0, 1000, LEN_SYS_TIME);
+	dwSimLog.clear();
+	DW1000Time tx;
+	TEST_CHECK(!DW1000.setDelayFrom(DW1000Time((int64_t)1000), DW1000Time(1000, DW1000Time::MICROSECONDS), &tx) &&
+	               dwSimCount(DX_TIME, true) == 0,
+	           "setDelayFrom scheduled outside TX mode");
+}
+
+static void testCancelLateTransmit() {
+	dwSimInstall();
+	DW1000.receivePermanently(false);
+	DW1000.newTransmit();
+	dwSimRegs[SYS_STATUS][HPDWARN_BYTE] = HPDWARN_MASK | 0x01;   // 0x01：別的 status bit，不能被清掉
+	dwSimLog.clear();
+	TEST_CHECK(DW1000.cancelLateTransmit(), "HPDWARN not detected");
+	TEST_CHECK((dwSimRegs[SYS_STATUS][HPDWARN_BYTE] & HPDWARN_MASK) == 0, "HPDWARN not cleared (%02X)",
+	           dwSimRegs[SYS_STATUS][HPDWARN_BYTE]);
+	TEST_CHECK(dwSimRegs[SYS_STATUS][HPDWARN_BYTE] & 0x01, "other status bits cleared");
+	TEST_CHECK(dwSimGet(SYS_CTRL, 0, LEN_SYS_CTRL) == (1u << TRXOFF_BIT), "TX not cancelled: SYS_CTRL %08X",
+	           (unsigned)dwSimGet(SYS_CTRL, 0, LEN_SYS_CTRL));
+	dwSimLog.clear();
+	TEST_CHECK(!DW1000.cancelLateTransmit(), "second cancelLateTransmit returned true");
+	TEST_CHECK(dwSimCount(SYS_CTRL, true) == 0 && dwSimCount(SYS_STATUS, true) == 0,
+	           "cancelLateTransmit without HPDWARN wrote SYS_CTRL / SYS_STATUS");
+
+	// receivePermanently：取消後重新開 receiver
+	DW1000.receivePermanently(true);
+	DW1000.newTransmit();
+	dwSimRegs[SYS_STATUS][HPDWARN_BYTE] = HPDWARN_MASK;
+	TEST_CHECK(DW1000.cancelLateTransmit(), "HPDWARN not detected (permanent receive)");
+	TEST_CHECK(dwSimGet(SYS_CTRL, 0, LEN_SYS_CTRL) & (1u << RXENAB_BIT), "receiver not restarted: SYS_CTRL %08X",
+	           (unsigned)dwSimGet(SYS_CTRL, 0, LEN_SYS_CTRL));
+	DW1000.receivePermanently(false);
+
+	// newTransmit() 清掉上一次留下的 HPDWARN
+	dwSimRegs[SYS_STATUS][HPDWARN_BYTE] = HPDWARN_MASK;
+	DW1000.newTransmit();
+	TEST_CHECK((dwSimRegs[SYS_STATUS][HPDWARN_BYTE] & HPDWARN_MASK) == 0, "newTransmit kept a stale HPDWARN");
+	TEST_CHECK(!DW1000.cancelLateTransmit(), "stale HPDWARN cancelled a new transmit");
+}
+
+int main() {
+	testSetDelayFrom();
+	testCancelLateTransmit();
+	return testSummary("UWB_DelayedTx_Test");
+}
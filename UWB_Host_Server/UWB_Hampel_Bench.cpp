@@ -0,0 +1,277 @@
+/*
+ * @file UWB_Hampel_Bench.cpp
+ * UWBMedianWindow / UWBHampel（每個 anchor 的 range 離群值過濾）的 host 測試與 spiky range 重播 benchmark
+ *
+ * 測試：
+ *   1. UWBMedianWindow：視窗 1..HAMPEL_MAX_WINDOW，隨機值 + 大量重複值，每筆都和排序算出的 median 比對；
+ *      begin() 的視窗夾在 1..HAMPEL_MAX_WINDOW
+ *   2. UWBHampel：前 3 筆不判斷、單一 spike 換成 median、量化後 MAD = 0 時 minSigma 不讓每筆都變離群值、
+ *      真的跳一階（tag 移動）時 w/2 + 1 筆內跟上、outliers() 計數
+ *   3. 視窗 0 / > HAMPEL_MAX_WINDOW：configure() 後的 window() = hampelClampWindow()，照 DW1000Ranging 的比較方式
+ *      只 configure 一次（不會每筆清掉視窗），spike 照樣抓到
+ * Benchmark（重播 spiky range）：
+ *   - 預設：合成 trace（3 m +- 1.5 m 正弦移動，4 cm 雜訊，-p 比例的 spike +0.5..3 m，-n 筆）
+ *   - -f file：重播文字檔，一行一筆 range（m）；有第二欄就當真值，沒有就只印離群比例和速度
+ *   比較 raw、只有 EMA（filterValue，-e 筆，預設 15 = DW1000Ranging 預設值）、只有 Hampel、Hampel + EMA
+ *   （DW1000Ranging 實際的順序）的 RMS 誤差，spike 抓到 / 誤判比例，每筆 ns
+ *
+ * 編譯：
+ *   g++ -O2 -std=c++17 -I../DW1000_BACKUP/src_0205 UWB_Hampel_Bench.cpp ../DW1000_BACKUP/src_0205/UWBHampel.cpp \
+ *       -o uwb_hampel_bench
+ * 執行：
+ *   ./uwb_hampel_bench [-n 200000] [-p 0.05] [-w 7] [-k 3] [-e 15] [-f trace.txt]
+ */
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "HostTest.h"
+#include "UWBHampel.h"
+
+static float sortedMedian(const std::deque<float>& q) {
+	std::vector<float> s(q.begin(), q.end());
+	std::sort(s.begin(), s.end());
+	const size_t n = s.size();
+	return (n % 2) ? s[n / 2] : 0.5f * (s[n / 2 - 1] + s[n / 2]);
+}
+
+static void testMedian() {
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> u(0.0f, 10.0f);
+	uint32_t bad = 0;
+	for (uint8_t w = 1; w <= HAMPEL_MAX_WINDOW; w++) {
+		UWBMedianWindow m;
+		m.begin(w);
+		std::deque<float> q;
+		for (int i = 0; i < 20000; i++) {
+			// 每 50 筆有 5 筆一樣的值，測重複值的 heap 順序
+			float x = (i % 50 < 5) ? 5.0f : u(rng);
+			m.push(x);
+			q.push_back(x);
+			if (q.size() > w) q.pop_front();
+			if (m.count() != q.size() || fabsf(sortedMedian(q) - m.median()) > 1e-6f) bad++;
+		}
+	}
+	TEST_CHECK(bad == 0, "%u medians differ from a sorted window", bad);
+
+	UWBMedianWindow m;
+	m.begin(0);
+	TEST_CHECK(m.window() == 1, "begin(0) gave window %u", m.window());
+	m.begin(HAMPEL_MAX_WINDOW + 10);
+	TEST_CHECK(m.window() == HAMPEL_MAX_WINDOW, "begin(max + 10) gave window %u", m.window());
+}
+
+static void testHampel() {
+	UWBHampel h;
+	h.configure(7, 3.0f, 0.05f);
+	bool out = true;
+	TEST_CHECK(h.filter(10.0f, &out) == 10.0f && !out, "first sample flagged");
+	h.filter(3.0f, &out);
+	TEST_CHECK(!out, "second sample flagged before 3 samples");
+
+	// 量化：一直是同一個值，MAD = 0，+3 cm 不能算離群
+	h.configure(7, 3.0f, 0.05f);
+	for (int i = 0; i < 10; i++) h.filter(3.0f, 0);
+	float y = h.filter(3.03f, &out);
+	TEST_CHECK(!out && y == 3.03f, "3 cm step flagged with MAD = 0 (minSigma)");
+
+	// 單一 spike
+	y = h.filter(5.0f, &out);
+	TEST_CHECK(out && y == 3.0f, "spike not replaced by median (%f)", y);
+	TEST_CHECK(h.outliers() == 1, "outliers() = %u", h.outliers());
+
+	// 真的移動 1 m：過半數之後 median 跟上，不再判離群
+	int followed = -1;
+	for (int i = 0; i < 10; i++) {
+		h.filter(4.0f, &out);
+		if (!out) {
+			followed = i;
+			break;
+		}
+	}
+	TEST_CHECK(followed >= 0 && followed <= 7 / 2 + 1, "1 m step followed after %d samples", followed);
+
+	h.reset();
+	h.filter(9.0f, &out);
+	TEST_CHECK(!out && h.window() == 7 && h.k() == 3.0f, "reset() lost the configuration or kept the window");
+}
+
+// 視窗超出 1..HAMPEL_MAX_WINDOW：DW1000Ranging 存的是 hampelClampWindow() 夾過的值，
+// 每筆比較 window() 時不能一直不相等（否則每筆都 configure、清掉視窗，filter 等於關掉）
+static void testWindowClamp() {
+	uint32_t bad = 0;
+	for (int w = 0; w <= 255; w++) {
+		UWBHampel h;
+		h.configure((uint8_t)w, 3.0f);
+		if (h.window() != hampelClampWindow((uint8_t)w)) bad++;
+	}
+	TEST_CHECK(bad == 0, "%u windows differ from hampelClampWindow()", bad);
+
+	const uint8_t windows[] = {0, HAMPEL_MAX_WINDOW + 1, 40, 255};
+	for (uint8_t w : windows) {
+		const uint8_t stored = hampelClampWindow(w);
+		UWBHampel h;
+		int reconfigures = 0;
+		bool spikeFlagged = false;
+		for (int i = 0; i < 30; i++) {
+			// 同 DW1000RangingClass::applyRangeOutlierFilter
+			if (h.window() != stored || h.k() != 3.0f) {
+				h.configure(stored, 3.0f);
+				reconfigures++;
+			}
+			bool out = false;
+			h.filter(i == 20 ? 6.0f : 3.0f + 0.01f * (i % 3), &out);
+			if (i == 20) spikeFlagged = out;
+		}
+		TEST_CHECK(reconfigures == 1, "window %u: configure() called %d times", w, reconfigures);
+		TEST_CHECK(stored < 3 || spikeFlagged, "window %u (clamped %u): spike not flagged", w, stored);
+	}
+}
+
+// ---- spiky range 重播 ----
+struct Trace {
+	std::vector<float> x;
+	std::vector<float> truth;   // 空的 = 沒有真值
+	std::vector<uint8_t> spike;
+};
+
+static Trace synthTrace(uint32_t n, float spikeRate) {
+	std::mt19937 rng(42);
+	std::normal_distribution<float> noise(0.0f, 0.04f);
+	std::uniform_real_distribution<float> u(0.0f, 1.0f);
+	std::uniform_real_distribution<float> spike(0.5f, 3.0f);
+	Trace t;
+	t.x.reserve(n);
+	t.truth.reserve(n);
+	t.spike.reserve(n);
+	for (uint32_t i = 0; i < n; i++) {
+		float truth = 3.0f + 1.5f * sinf((float)i * 0.01f);
+		float x = truth + noise(rng);
+		bool s = u(rng) < spikeRate;
+		if (s) x += spike(rng);   // multipath：只會變長
+		t.x.push_back(x);
+		t.truth.push_back(truth);
+		t.spike.push_back(s);
+	}
+	return t;
+}
+
+static bool loadTrace(const char* path, Trace* t) {
+	FILE* f = fopen(path, "r");
+	if (f == NULL) return false;
+	char line[256];
+	bool allTruth = true;
+	while (fgets(line, sizeof(line), f) != NULL) {
+		float x, truth;
+		int n = sscanf(line, "%f %f", &x, &truth);
+		if (n < 1) continue;
+		t->x.push_back(x);
+		if (n == 2) t->truth.push_back(truth);
+		else allTruth = false;
+	}
+	fclose(f);
+	if (!allTruth) t->truth.clear();
+	return !t->x.empty();
+}
+
+static void replay(const Trace& t, uint8_t window, float k, uint16_t emaN) {
+	const size_t n = t.x.size();
+	const bool hasTruth = !t.truth.empty();
+	const bool hasSpike = !t.spike.empty();
+	const float a = 2.0f / ((float)emaN + 1.0f);   // DW1000RangingClass::filterValue
+	UWBHampel h;
+	h.configure(window, k);
+	std::vector<float> hy(n);
+	std::vector<uint8_t> flagged(n);
+
+	auto t0 = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < n; i++) {
+		bool out;
+		hy[i] = h.filter(t.x[i], &out);
+		flagged[i] = out;
+	}
+	double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / n;
+
+	double eRaw = 0, eEma = 0, eHampel = 0, eBoth = 0;
+	float ema = t.x[0], both = hy[0];
+	uint32_t spikes = 0, caught = 0, falsePos = 0, flaggedAll = 0;
+	for (size_t i = 0; i < n; i++) {
+		if (i > 0) {
+			ema = t.x[i] * a + ema * (1.0f - a);
+			both = hy[i] * a + both * (1.0f - a);
+		}
+		flaggedAll += flagged[i];
+		if (hasSpike) {
+			spikes += t.spike[i];
+			caught += flagged[i] && t.spike[i];
+			falsePos += flagged[i] && !t.spike[i];
+		}
+		if (hasTruth) {
+			const double tr = t.truth[i];
+			eRaw += (t.x[i] - tr) * (t.x[i] - tr);
+			eEma += (ema - tr) * (ema - tr);
+			eHampel += (hy[i] - tr) * (hy[i] - tr);
+			eBoth += (both - tr) * (both - tr);
+		}
+	}
+	printf("samples %zu, window %u, k %.1f, EMA %u, %.0f ns/sample, flagged %.2f%%\n", n, window, k, emaN, ns,
+	       100.0 * flaggedAll / n);
+	if (hasTruth) {
+		printf("rms error m: raw %.3f  EMA %.3f  Hampel %.3f  Hampel+EMA %.3f\n", sqrt(eRaw / n), sqrt(eEma / n),
+		       sqrt(eHampel / n), sqrt(eBoth / n));
+		TEST_CHECK(eHampel < eRaw && eBoth < eEma, "Hampel did not reduce the error");
+	}
+	if (hasSpike && spikes > 0) {
+		double caughtPct = 100.0 * caught / spikes, falsePct = 100.0 * falsePos / (n - spikes);
+		printf("spikes caught %.1f%%, false positives %.2f%%\n", caughtPct, falsePct);
+		TEST_CHECK(caughtPct > 95.0 && falsePct < 1.0, "caught %.1f%% false %.2f%%", caughtPct, falsePct);
+	}
+}
+
+int main(int argc, char** argv) {
+	uint32_t samples = 200000;
+	float spikeRate = 0.05f, k = HAMPEL_DEFAULT_K;
+	uint8_t window = HAMPEL_DEFAULT_WINDOW;
+	uint16_t emaN = 15;
+	const char* path = NULL;
+	int opt;
+	while ((opt = getopt(argc, argv, "n:p:w:k:e:f:h")) != -1) {
+		switch (opt) {
+			case 'n': samples = (uint32_t)strtoul(optarg, nullptr, 10); break;
+			case 'p': spikeRate = strtof(optarg, nullptr); break;
+			case 'w': window = (uint8_t)atoi(optarg); break;
+			case 'k': k = strtof(optarg, nullptr); break;
+			case 'e': emaN = (uint16_t)atoi(optarg); break;
+			case 'f': path = optarg; break;
+			default:
+				fprintf(stderr, "usage: %s [-n samples] [-p spike_rate] [-w window] [-k k] [-e ema_n] [-f trace.txt]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (samples == 0) samples = 1;
+	if (emaN < 2) emaN = 2;
+	testMedian();
+	testHampel();
+	testWindowClamp();
+
+	Trace t;
+	if (path != NULL) {
+		if (!loadTrace(path, &t)) {
+			fprintf(stderr, "cannot read %s\n", path);
+			return 1;
+		}
+	} else {
+		t = synthTrace(samples, spikeRate);
+	}
+	replay(t, window, k, emaN);
+	return testSummary("UWB_Hampel_Bench");
+}
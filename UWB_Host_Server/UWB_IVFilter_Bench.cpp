@@ -0,0 +1,176 @@
+/*
+ * @file UWB_IVFilter_Bench.cpp
+ * IV_MODE_RAND_UNIQUE 查重：DW1000BloomFilter 和原本精確查重表（_iv_used）的 inserts/s 與記憶體比較
+ *
+ * - TABLE：和 DW1000Ranging.cpp 的 iv_table_insert_if_new() 同一套演算法（FNV-1a + linear probing，
+ *   IV_UNIQ_TABLE_SIZE 筆）；那段是 ESP32 專用的 static function，這裡照抄一份在 host 上跑。
+ *   依填滿比例分 4 段計時，看 linear probing 越滿越慢；滿了之後每包都失敗（session 上限）。
+ * - BLOOM：隨機 12-byte IV 連續插入 -n 筆，量 inserts/s 和實際誤判率（新 IV 被判成重複的比例），
+ *   再把最近插入的一個世代份量的 IV 重插一次，確認視窗內的重複全部抓得到（沒有 false negative）。
+ *
+ * 編譯：
+ *   g++ -O2 -std=c++17 -I../DW1000_BACKUP/src_0205 UWB_IVFilter_Bench.cpp \
+ *       ../DW1000_BACKUP/src_0205/DW1000BloomFilter.cpp -o uwb_ivfilter_bench
+ *   （-DBLOOM_SIZE_KB=16 之類可以改 Bloom 大小，和 library 一樣）
+ * 執行：
+ *   ./uwb_ivfilter_bench [-n 10000000] [-p 0.001,0.0001]
+ */
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "DW1000BloomFilter.h"
+#include "HostTest.h"
+
+#ifndef IV_UNIQ_TABLE_SIZE
+#define IV_UNIQ_TABLE_SIZE 4096   // 同 DW1000Ranging.h
+#endif
+#define IV_LEN 12                 // 同 ENC_IV_LEN
+
+#define RECHECK_KEYS 10000        // 重插檢查的 IV 數上限（實際取 min(這個, 每世代容量)）
+
+// DW1000Ranging.cpp 的精確查重表
+struct ExactTable {
+	uint8_t  iv[IV_UNIQ_TABLE_SIZE][IV_LEN];
+	uint8_t  flag[IV_UNIQ_TABLE_SIZE];
+	uint32_t count;
+
+	void clear() {
+		memset(flag, 0, sizeof(flag));
+		count = 0;
+	}
+
+	static uint32_t fnv1a32(const uint8_t* p, size_t n) {
+		uint32_t h = 2166136261u;
+		for (size_t i = 0; i < n; i++) {
+			h ^= (uint32_t)p[i];
+			h *= 16777619u;
+		}
+		return h;
+	}
+
+	bool insertIfNew(const uint8_t* key) {
+		if (count >= IV_UNIQ_TABLE_SIZE) return false;
+		uint32_t idx = fnv1a32(key, IV_LEN) % IV_UNIQ_TABLE_SIZE;
+		for (uint32_t step = 0; step < IV_UNIQ_TABLE_SIZE; step++) {
+			uint32_t j = (idx + step) % IV_UNIQ_TABLE_SIZE;
+			if (flag[j] == 0) {
+				memcpy(iv[j], key, IV_LEN);
+				flag[j] = 1;
+				count++;
+				return true;
+			}
+			if (memcmp(iv[j], key, IV_LEN) == 0) return false;
+		}
+		return false;
+	}
+};
+
+static ExactTable g_table;
+static DW1000BloomFilter g_bloom;
+
+static void randomIV(std::mt19937_64& rng, uint8_t out[IV_LEN]) {
+	uint64_t a = rng();
+	uint32_t b = (uint32_t)rng();
+	memcpy(out, &a, 8);
+	memcpy(out + 8, &b, 4);
+}
+
+static double seconds(std::chrono::steady_clock::time_point t0) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void benchTable(std::mt19937_64& rng) {
+	// 每次量測都要從空表開始，重複幾輪取總時間
+	const int rounds = 200;
+	const uint32_t quarter = IV_UNIQ_TABLE_SIZE / 4;
+	double t[4] = {0, 0, 0, 0};
+	uint8_t key[IV_LEN];
+	for (int r = 0; r < rounds; r++) {
+		g_table.clear();
+		for (int q = 0; q < 4; q++) {
+			auto t0 = std::chrono::steady_clock::now();
+			for (uint32_t i = 0; i < quarter; i++) {
+				randomIV(rng, key);
+				g_table.insertIfNew(key);
+			}
+			t[q] += seconds(t0);
+		}
+	}
+	TEST_CHECK(g_table.count == IV_UNIQ_TABLE_SIZE, "table holds %u of %u", g_table.count, IV_UNIQ_TABLE_SIZE);
+	randomIV(rng, key);
+	bool full = !g_table.insertIfNew(key);
+	TEST_CHECK(full, "full table accepted another IV");
+
+	printf("TABLE  %u entries, %zu bytes\n", IV_UNIQ_TABLE_SIZE, sizeof(g_table.iv) + sizeof(g_table.flag));
+	for (int q = 0; q < 4; q++) {
+		printf("  fill %3d-%3d%%: %.2f M inserts/s\n", q * 25, (q + 1) * 25, (double)quarter * rounds / t[q] / 1e6);
+	}
+	printf("  full: every further packet fails (session cap %u)\n", IV_UNIQ_TABLE_SIZE);
+}
+
+static void benchBloom(std::mt19937_64& rng, float rate, uint64_t n) {
+	g_bloom.setFalsePositiveRate(rate);
+	uint8_t key[IV_LEN];
+	// 視窗 = 目前世代 + 上一個世代，最近「一個世代容量」個 IV 一定都還在
+	const uint32_t recheck = (g_bloom.getCapacity() < RECHECK_KEYS) ? g_bloom.getCapacity() : RECHECK_KEYS;
+	std::vector<uint8_t> recent((size_t)recheck * IV_LEN);
+	uint64_t falsePositive = 0;
+	uint64_t accepted = 0;
+	auto t0 = std::chrono::steady_clock::now();
+	for (uint64_t i = 0; i < n; i++) {
+		randomIV(rng, key);
+		if (!g_bloom.insertIfNew(key, IV_LEN)) {
+			falsePositive++;
+			continue;
+		}
+		memcpy(&recent[(size_t)(accepted++ % recheck) * IV_LEN], key, IV_LEN);
+	}
+	double s = seconds(t0);
+	double measured = (double)falsePositive / (double)n;
+
+	uint32_t missed = 0;
+	for (uint32_t i = 0; i < recheck; i++) {
+		if (g_bloom.insertIfNew(&recent[(size_t)i * IV_LEN], IV_LEN)) missed++;
+	}
+
+	printf("BLOOM  target fp %.4f%%: %zu bytes, k=%u, %u / generation, %.2f M inserts/s, measured fp %.4f%%, missed dups %u/%u\n",
+	       rate * 100.0f, DW1000BloomFilter::getMemoryBytes(), g_bloom.getHashCount(), g_bloom.getCapacity(),
+	       (double)n / s / 1e6, measured * 100.0, missed, recheck);
+	TEST_CHECK(missed == 0, "bloom missed %u duplicates inside the window", missed);
+	// 誤判率要落在設定值附近（樣本夠多時容許 1.5 倍）
+	if (n >= 1000000) {
+		TEST_CHECK(measured <= rate * 1.5, "measured fp %.5f above target %.5f", measured, rate);
+	}
+}
+
+int main(int argc, char** argv) {
+	uint64_t n = 10000000ULL;
+	std::vector<float> rates = {0.001f, 0.0001f};
+	int opt;
+	while ((opt = getopt(argc, argv, "n:p:h")) != -1) {
+		switch (opt) {
+			case 'n': n = strtoull(optarg, nullptr, 10); break;
+			case 'p': {
+				rates.clear();
+				for (char* p = strtok(optarg, ","); p != nullptr; p = strtok(nullptr, ",")) rates.push_back(strtof(p, nullptr));
+				break;
+			}
+			default:
+				fprintf(stderr, "usage: %s [-n inserts] [-p fp_rate,fp_rate,...]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (n < RECHECK_KEYS) n = RECHECK_KEYS;
+	std::mt19937_64 rng(1);
+	benchTable(rng);
+	for (float rate : rates) benchBloom(rng, rate, n);
+	return testSummary("UWB_IVFilter_Bench");
+}
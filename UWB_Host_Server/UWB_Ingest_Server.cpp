@@ -0,0 +1,320 @@
+/*
+ * @file UWB_Ingest_Server.cpp
+ * 多 tag 的 UDP 遙測接收 daemon（Linux），取代 ✅Position_Display.py 的單一 socket 收資料
+ *
+ *   receiver thread : recvmmsg 一次收一批 datagram，檢查 header，依 tagId hash 丟給 worker（SPSC ring，不上鎖）
+ *   worker threads  : 解開 record、檢查每個 tag 的序號（掉包統計），輸出 RangeSample
+ *   merger thread   : 把各 worker 的輸出依 host 接收時間合併成單一時間序串流，寫入檔案
+ *
+ * 同一個 tag 永遠由同一個 worker 處理，所以 tag 內的順序不會亂；
+ * merger 用各 worker 的「已處理到的時間」當 watermark，確保輸出檔嚴格依時間排序。
+ *
+ * 編譯：
+ *   g++ -O2 -std=c++17 -pthread -I../DW1000_BACKUP/src_0205 \
+ *       UWB_Ingest_Server.cpp ../DW1000_BACKUP/src_0205/UWBTelemetry.cpp -o uwb_ingest
+ * 執行：
+ *   ./uwb_ingest -p 8001 -w 4 -o ranges.bin        （Ctrl+C 結束；-d 秒數 可自動結束）
+ * 壓測：見 UWB_Load_Generator.cpp
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "UWBTelemetry.h"
+#include "RangeStream.h"
+#include "SpscRing.h"
+
+#define INGEST_BATCH        64      // 一次 recvmmsg 最多收幾個 datagram
+#define INGEST_DGRAM_MAX    2048    // 單一 datagram 上限（header + 203 筆 record）
+#define INGEST_RING_DGRAMS  4096    // 每個 worker 的輸入 ring（datagram）
+#define INGEST_RING_SAMPLES 65536   // 每個 worker 的輸出 ring（RangeSample）
+#define INGEST_MAX_WORKERS  64
+
+struct Datagram {
+	uint64_t hostNs;
+	uint16_t len;
+	uint8_t  data[INGEST_DGRAM_MAX];
+};
+
+struct Worker {
+	SpscRing<Datagram>    in{INGEST_RING_DGRAMS};
+	SpscRing<RangeSample> out{INGEST_RING_SAMPLES};
+	alignas(64) std::atomic<uint64_t> doneNs{0};   // 此 worker 已把 hostNs <= doneNs 的 datagram 全部輸出
+	std::atomic<uint64_t> records{0};
+	std::atomic<uint64_t> seqGaps{0};               // 依序號推算的掉包數
+	std::thread th;
+};
+
+static std::atomic<bool>     g_running{true};
+static std::atomic<bool>     g_receiverDone{false};
+static std::atomic<uint64_t> g_recvWatermark{0};    // receiver 已交出 hostNs <= 此值的所有 datagram
+static std::atomic<uint64_t> g_datagrams{0};
+static std::atomic<uint64_t> g_decodeErrors{0};
+static std::atomic<uint64_t> g_queueDrops{0};
+
+static uint64_t monoNs() {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void onSignal(int) {
+	g_running.store(false);
+}
+
+static inline uint32_t tagToWorker(uint16_t tagId, uint32_t workers) {
+	uint32_t h = (uint32_t)tagId * 2654435761u;   // Fibonacci hashing，相鄰位址也能分散
+	return (uint32_t)(((uint64_t)h * workers) >> 32);
+}
+
+// ===== receiver =====
+static void receiverLoop(int fd, std::vector<std::unique_ptr<Worker>>* workers) {
+	static uint8_t bufs[INGEST_BATCH][INGEST_DGRAM_MAX];
+	mmsghdr msgs[INGEST_BATCH];
+	iovec   iov[INGEST_BATCH];
+	for (int i = 0; i < INGEST_BATCH; i++) {
+		iov[i].iov_base = bufs[i];
+		iov[i].iov_len  = INGEST_DGRAM_MAX;
+		memset(&msgs[i], 0, sizeof(msgs[i]));
+		msgs[i].msg_hdr.msg_iov    = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+	const uint32_t nWorkers = (uint32_t)workers->size();
+
+	while (g_running.load(std::memory_order_relaxed)) {
+		int n = recvmmsg(fd, msgs, INGEST_BATCH, MSG_WAITFORONE, nullptr);
+		uint64_t now = monoNs();   // 同一批共用一個時間戳（少呼叫 clock）
+		if (n <= 0) {
+			g_recvWatermark.store(now, std::memory_order_release); // 沒資料也推進 watermark
+			continue;
+		}
+		for (int i = 0; i < n; i++) {
+			const uint8_t* p = bufs[i];
+			size_t len = msgs[i].msg_len;
+			UWBTelemetryHeader h;
+			if ((msgs[i].msg_hdr.msg_flags & MSG_TRUNC) || uwbTelemetryDecodeHeader(p, len, &h) != UWB_TELEM_OK) {
+				g_decodeErrors.fetch_add(1, std::memory_order_relaxed);
+				continue;
+			}
+			Worker& w = *(*workers)[tagToWorker(h.tagId, nWorkers)];
+			Datagram* d = w.in.claim();
+			if (d == nullptr) {
+				g_queueDrops.fetch_add(1, std::memory_order_relaxed); // worker 跟不上：丟掉，不擋住 socket
+				continue;
+			}
+			d->hostNs = now;
+			d->len    = (uint16_t)len;
+			memcpy(d->data, p, len);
+			w.in.commit();
+		}
+		g_datagrams.fetch_add((uint64_t)n, std::memory_order_relaxed);
+		g_recvWatermark.store(now, std::memory_order_release);
+	}
+	g_receiverDone.store(true, std::memory_order_release);
+}
+
+// ===== worker =====
+static void workerLoop(Worker* w) {
+	std::unordered_map<uint16_t, uint32_t> lastSeq;   // 這個 worker 負責的 tag 才會出現在這裡
+	for (;;) {
+		// 先讀 watermark 再看 ring：ring 是空的 => watermark 以前的 datagram 都處理完了
+		uint64_t wm = g_recvWatermark.load(std::memory_order_acquire);
+		bool recvDone = g_receiverDone.load(std::memory_order_acquire);
+		Datagram* d = w->in.front();
+		if (d == nullptr) {
+			w->doneNs.store(recvDone ? UINT64_MAX : wm, std::memory_order_release);
+			if (recvDone) return;
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+			continue;
+		}
+
+		UWBTelemetryHeader h;
+		uwbTelemetryDecodeHeader(d->data, d->len, &h);   // receiver 已檢查過
+		auto it = lastSeq.find(h.tagId);
+		if (it != lastSeq.end()) {
+			uint32_t gap = h.seq - it->second - 1;
+			if (gap != 0 && gap < 0x80000000u) w->seqGaps.fetch_add(gap, std::memory_order_relaxed);
+			it->second = h.seq;
+		} else {
+			lastSeq.emplace(h.tagId, h.seq);
+		}
+
+		for (uint8_t i = 0; i < h.count; i++) {
+			UWBTelemetryRecord r;
+			uwbTelemetryGetRecord(d->data, i, &r);
+			if (r.rangeMm == UWB_TELEM_RANGE_INVALID) continue;   // tag 端是 NaN：沒有距離可解
+			RangeSample* s;
+			while ((s = w->out.claim()) == nullptr) {
+				std::this_thread::yield();   // merger/寫檔跟不上：這裡等，背壓會回到輸入 ring
+			}
+			s->hostNs  = d->hostNs;
+			s->dwTime  = h.dwTime;
+			s->seq     = h.seq;
+			s->tagId   = h.tagId;
+			s->anchor  = r.anchor;
+			s->rangeMm = r.rangeMm;
+			s->rxPower = r.rxPower;
+			s->fpPower = r.fpPower;
+			w->out.commit();
+		}
+		w->records.fetch_add(h.count, std::memory_order_relaxed);
+		uint64_t ts = d->hostNs;
+		w->in.pop();
+		w->doneNs.store(ts - 1, std::memory_order_release); // 同一批 hostNs 可能還有別的 datagram 在 ring 裡
+	}
+}
+
+// ===== merger：k-way merge，只輸出 hostNs <= 所有 worker watermark 的資料 =====
+static void mergerLoop(std::vector<std::unique_ptr<Worker>>* workers, FILE* out, std::atomic<uint64_t>* written) {
+	std::vector<RangeSample> buf;
+	buf.reserve(4096);
+	for (;;) {
+		uint64_t safe = UINT64_MAX;
+		for (auto& w : *workers) {
+			uint64_t d = w->doneNs.load(std::memory_order_acquire);
+			if (d < safe) safe = d;
+		}
+
+		bool progressed = false;
+		for (;;) {
+			RangeSample* best = nullptr;
+			Worker* bestW = nullptr;
+			for (auto& w : *workers) {
+				RangeSample* s = w->out.front();
+				if (s != nullptr && s->hostNs <= safe && (best == nullptr || s->hostNs < best->hostNs)) {
+					best = s;
+					bestW = w.get();
+				}
+			}
+			if (best == nullptr) break;
+			buf.push_back(*best);
+			bestW->out.pop();
+			progressed = true;
+			if (buf.size() == buf.capacity()) {
+				fwrite(buf.data(), sizeof(RangeSample), buf.size(), out);
+				written->fetch_add(buf.size(), std::memory_order_relaxed);
+				buf.clear();
+			}
+		}
+		if (!buf.empty()) {
+			fwrite(buf.data(), sizeof(RangeSample), buf.size(), out);
+			written->fetch_add(buf.size(), std::memory_order_relaxed);
+			buf.clear();
+		}
+		if (safe == UINT64_MAX) {
+			bool drained = true;
+			for (auto& w : *workers) drained = drained && w->out.empty();
+			if (drained) return;
+		}
+		if (!progressed) std::this_thread::sleep_for(std::chrono::microseconds(200));
+	}
+}
+
+static void usage(const char* prog) {
+	fprintf(stderr, "usage: %s [-p port] [-w workers] [-o out.bin] [-d seconds]\n", prog);
+}
+
+int main(int argc, char** argv) {
+	int port = 8001;
+	int nWorkers = 4;
+	const char* outPath = "ranges.bin";
+	int duration = 0;
+	int opt;
+	while ((opt = getopt(argc, argv, "p:w:o:d:h")) != -1) {
+		switch (opt) {
+			case 'p': port = atoi(optarg); break;
+			case 'w': nWorkers = atoi(optarg); break;
+			case 'o': outPath = optarg; break;
+			case 'd': duration = atoi(optarg); break;
+			default: usage(argv[0]); return 1;
+		}
+	}
+	if (nWorkers < 1 || nWorkers > INGEST_MAX_WORKERS) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0) {
+		perror("socket");
+		return 1;
+	}
+	int rcvbuf = 32 * 1024 * 1024;   // 大 buffer 吃掉突發流量（實際上限看 net.core.rmem_max）
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+	timeval tv = {0, 100 * 1000};    // 100 ms：讓 receiver 能定期檢查結束旗標並推進 watermark
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons((uint16_t)port);
+	if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+		perror("bind");
+		return 1;
+	}
+
+	FILE* out = fopen(outPath, "wb");
+	if (out == nullptr) {
+		perror(outPath);
+		return 1;
+	}
+	static char fileBuf[1 << 20];
+	setvbuf(out, fileBuf, _IOFBF, sizeof(fileBuf));
+
+	signal(SIGINT, onSignal);
+	signal(SIGTERM, onSignal);
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	for (int i = 0; i < nWorkers; i++) workers.emplace_back(new Worker());
+	for (auto& w : workers) w->th = std::thread(workerLoop, w.get());
+	std::atomic<uint64_t> written{0};
+	std::thread merger(mergerLoop, &workers, out, &written);
+	std::thread receiver(receiverLoop, fd, &workers);
+
+	fprintf(stderr, "*** UWB ingest on UDP %d, %d workers, output %s ***\n", port, nWorkers, outPath);
+
+	// 每秒印一次統計
+	uint64_t lastDg = 0, lastRec = 0;
+	uint64_t t0 = monoNs(), lastT = t0;
+	while (g_running.load()) {
+		std::this_thread::sleep_for(std::chrono::seconds(1));
+		uint64_t now = monoNs();
+		uint64_t dg = g_datagrams.load(), rec = 0, gaps = 0;
+		for (auto& w : workers) {
+			rec += w->records.load();
+			gaps += w->seqGaps.load();
+		}
+		double dt = (double)(now - lastT) / 1e9;
+		fprintf(stderr, "[INGEST] dgram/s=%.0f rec/s=%.0f total=%llu written=%llu decodeErr=%llu queueDrop=%llu seqGap=%llu\n",
+		        (double)(dg - lastDg) / dt, (double)(rec - lastRec) / dt,
+		        (unsigned long long)dg, (unsigned long long)written.load(),
+		        (unsigned long long)g_decodeErrors.load(), (unsigned long long)g_queueDrops.load(),
+		        (unsigned long long)gaps);
+		lastDg = dg;
+		lastRec = rec;
+		lastT = now;
+		if (duration > 0 && now - t0 >= (uint64_t)duration * 1000000000ull) g_running.store(false);
+	}
+
+	receiver.join();
+	for (auto& w : workers) w->th.join();
+	merger.join();
+	fclose(out);
+	close(fd);
+	fprintf(stderr, "[INGEST] done, %llu samples written\n", (unsigned long long)written.load());
+	return 0;
+}
@@ -0,0 +1,188 @@
+/*
+ * @file UWB_LinkJson_Bench.cpp
+ * make_link_json：寫進固定 buffer 的版本 vs 原本 String 版本的 bytes/s 與每次呼叫的 heap 配置次數
+ *
+ * - heap 配置次數：這個程式把 malloc / realloc / calloc 換成會計數的版本（glibc）；
+ *   String 量兩種用法：重複使用同一個（原本 sketch 的全域 all_json，長度變長才 realloc）
+ *   和每次新建（host_arduino 的 String 和 WString 一樣，長度不夠就 realloc 成剛好）
+ * - 輸出檢查：buffer 版本每筆 R 讀回來和 range[0] 差距 <= 0.5 mm、A 和 "%X" 一樣；
+ *   負距離、NaN（印 "nan"，和 String 版一樣）、超出 int32 mm 的距離飽和、buffer 剛好夠 / 少 1 byte（要回 -1 且是空字串）
+ * - anchor 數 4 / 8 / LINK_MAX_ANCHORS
+ *
+ * 註：ESP32 Arduino core 的 String 有 SSO（短字串不配置），但這裡的 JSON 都超過 SSO 長度，
+ *     配置次數和 host 版差不多；絕對的 bytes/s 只能當相對比較。
+ *
+ * 編譯：
+ *   g++ -O2 -std=c++17 -Ihost_arduino -I../DW1000_BACKUP/src_0205 UWB_LinkJson_Bench.cpp host_arduino/HostArduino.cpp \
+ *       ../DW1000_BACKUP/src_0205/link.cpp -o uwb_linkjson_bench
+ * 執行：
+ *   ./uwb_linkjson_bench [-n 1000000]
+ */
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "HostTest.h"
+#include "link.h"
+
+// ---- heap 配置計數（glibc 的 __libc_* 是真正的實作） ----
+extern "C" void* __libc_malloc(size_t n);
+extern "C" void* __libc_realloc(void* p, size_t n);
+extern "C" void* __libc_calloc(size_t n, size_t m);
+static unsigned long g_heapAllocs = 0;
+extern "C" void* malloc(size_t n) {
+	g_heapAllocs++;
+	return __libc_malloc(n);
+}
+extern "C" void* realloc(void* p, size_t n) {
+	g_heapAllocs++;
+	return __libc_realloc(p, n);
+}
+extern "C" void* calloc(size_t n, size_t m) {
+	g_heapAllocs++;
+	return __libc_calloc(n, m);
+}
+
+static struct MyLink* fillTable(uint8_t anchors, std::mt19937& rng) {
+	struct MyLink* head = init_link();
+	std::uniform_real_distribution<float> r(0.2f, 30.0f);
+	for (uint8_t i = 0; i < anchors; i++) {
+		uint16_t addr = (uint16_t)(0x1780 + i * 0x111);
+		add_link(head, addr);
+		struct MyLink* a = find_link(head, addr);
+		a->range[0] = r(rng);
+	}
+	return head;
+}
+
+// buffer 版本逐筆讀回比對
+static void checkOutput(struct MyLink* head) {
+	char buf[LINK_JSON_MAX];
+	int n = make_link_json(head, buf, sizeof(buf));
+	TEST_CHECK(n > 0 && (size_t)n == strlen(buf), "make_link_json returned %d", n);
+	const char* s = buf;
+	uint32_t bad = 0;
+	for (struct MyLink* a = head->next; a != NULL; a = a->next) {
+		char want[8];
+		snprintf(want, sizeof(want), "%X", a->anchor_addr);
+		s = strstr(s, "{\"A\":\"");
+		if (s == NULL) {
+			bad++;
+			break;
+		}
+		s += 6;
+		if (strncmp(s, want, strlen(want)) != 0 || s[strlen(want)] != '"') bad++;
+		s = strstr(s, "\"R\":\"");
+		if (s == NULL) {
+			bad++;
+			break;
+		}
+		s += 5;
+		double r = strtod(s, NULL);
+		if (fabs(r - a->range[0]) > 0.0005 + 1e-6) bad++;
+	}
+	TEST_CHECK(bad == 0, "%u entries differ from the table", bad);
+
+	// 剛好夠 / 少 1 byte
+	char exact[LINK_JSON_MAX];
+	TEST_CHECK(make_link_json(head, exact, (size_t)n + 1) == n && strcmp(exact, buf) == 0, "exact-size buffer failed");
+	TEST_CHECK(make_link_json(head, exact, (size_t)n) == -1 && exact[0] == '\0', "short buffer not rejected");
+}
+
+static void checkNegative() {
+	struct MyLink* head = init_link();
+	add_link(head, 0xABC);
+	struct MyLink* a = find_link(head, 0xABC);
+	a->range[0] = -0.0126f;
+	char buf[LINK_JSON_MAX];
+	make_link_json(head, buf, sizeof(buf));
+	TEST_CHECK(strcmp(buf, "{\"links\":[{\"A\":\"ABC\",\"R\":\"-0.013\"}]}") == 0, "negative range: %s", buf);
+
+	a->range[0] = NAN;
+	make_link_json(head, buf, sizeof(buf));
+	TEST_CHECK(strcmp(buf, "{\"links\":[{\"A\":\"ABC\",\"R\":\"nan\"}]}") == 0, "NaN range: %s", buf);
+	a->range[0] = 1e12f;
+	make_link_json(head, buf, sizeof(buf));
+	TEST_CHECK(strcmp(buf, "{\"links\":[{\"A\":\"ABC\",\"R\":\"2147483.647\"}]}") == 0, "huge range: %s", buf);
+	a->range[0] = -INFINITY;
+	make_link_json(head, buf, sizeof(buf));
+	TEST_CHECK(strcmp(buf, "{\"links\":[{\"A\":\"ABC\",\"R\":\"-2147483.648\"}]}") == 0, "-inf range: %s", buf);
+}
+
+static void bench(uint8_t anchors, uint32_t calls) {
+	std::mt19937 rng(anchors);
+	struct MyLink* head = fillTable(anchors, rng);
+	checkOutput(head);
+
+	static char buf[LINK_JSON_MAX];
+	size_t bytes = 0;
+	unsigned long heap0 = g_heapAllocs;
+	auto t0 = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < calls; i++) {
+		head->next->range[0] = (float)(i & 1023) * 0.01f;   // 每次內容不同
+		bytes += (size_t)make_link_json(head, buf, sizeof(buf));
+	}
+	double sBuf = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	unsigned long heapBuf = g_heapAllocs - heap0;
+
+	// 原本 sketch 的用法：全域 String 重複使用（容量只增不減，長度變長時才 realloc）
+	String s;
+	size_t bytesStr = 0;
+	heap0 = g_heapAllocs;
+	t0 = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < calls; i++) {
+		head->next->range[0] = (float)(i & 1023) * 0.01f;
+		make_link_json(head, &s);
+		bytesStr += s.length();
+	}
+	double sStr = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	unsigned long heapStr = g_heapAllocs - heap0;
+
+	// 每次都是新的 String（例如寫成 loop() 裡的區域變數）
+	size_t bytesNew = 0;
+	heap0 = g_heapAllocs;
+	unsigned long str0 = hostStringAllocs;
+	t0 = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < calls; i++) {
+		String fresh;
+		head->next->range[0] = (float)(i & 1023) * 0.01f;
+		make_link_json(head, &fresh);
+		bytesNew += fresh.length();
+	}
+	double sNew = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	unsigned long heapNew = g_heapAllocs - heap0;
+
+	TEST_CHECK(heapBuf == 0, "buffer version made %lu heap allocations", heapBuf);
+	TEST_CHECK(heapNew >= hostStringAllocs - str0, "heap counter missed String allocations");
+	printf("%7u  %10zu  %8.1f  %6.2f  %8.1f  %6.2f  %8.1f  %6.2f\n", anchors, bytes / calls,
+	       (double)bytes / sBuf / 1e6, (double)heapBuf / calls,
+	       (double)bytesStr / sStr / 1e6, (double)heapStr / calls,
+	       (double)bytesNew / sNew / 1e6, (double)heapNew / calls);
+}
+
+int main(int argc, char** argv) {
+	uint32_t calls = 1000000;
+	int opt;
+	while ((opt = getopt(argc, argv, "n:h")) != -1) {
+		switch (opt) {
+			case 'n': calls = (uint32_t)strtoul(optarg, nullptr, 10); break;
+			default:
+				fprintf(stderr, "usage: %s [-n calls]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (calls == 0) calls = 1;
+	checkNegative();
+	printf("                     - char buffer -  - String reused -  -- String new --\n");
+	printf("anchors  bytes/call      MB/s  allocs      MB/s  allocs      MB/s  allocs\n");
+	bench(4, calls);
+	bench(8, calls);
+	bench(LINK_MAX_ANCHORS, calls);
+	return testSummary("UWB_LinkJson_Bench");
+}
@@ -0,0 +1,197 @@
+/*
+ * @file UWB_Link_Test.cpp
+ * link.cpp（固定容量 anchor 表 + hash index）的 host 單元測試與查詢 benchmark
+ *
+ * 測試：
+ *   1. add / find / 重複位址 / 位址 0 / 表滿（LINK_MAX_ANCHORS）
+ *   2. delete：最後一筆搬進空槽，next 串列和 index 都還是對的
+ *   3. fresh_link：3 筆平均、沒給 FP power 時保留原值、找不到的位址不動
+ *   4. 隨機 add / delete / find 和 std::map 參考答案比對（-n 次，預設 200000）
+ * Benchmark：
+ *   find_link / fresh_link 每次呼叫的 ns，和原本 malloc 串列逐一比對（舊版 find_link 照抄）比較，
+ *   anchor 數 4 / 8 / LINK_MAX_ANCHORS，位址隨機（命中）
+ *
+ * 編譯：
+ *   g++ -O2 -std=c++17 -Ihost_arduino -I../DW1000_BACKUP/src_0205 UWB_Link_Test.cpp host_arduino/HostArduino.cpp \
+ *       ../DW1000_BACKUP/src_0205/link.cpp -o uwb_link_test
+ * 執行：
+ *   ./uwb_link_test [-n 200000]
+ */
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "HostTest.h"
+#include "link.h"
+
+// 走 next 串列：數量、每筆都找得到、位址不重複
+static bool chainMatches(struct MyLink* head, const std::map<uint16_t, float>& ref) {
+	size_t n = 0;
+	for (struct MyLink* a = head->next; a != NULL; a = a->next) {
+		if (ref.find(a->anchor_addr) == ref.end()) return false;
+		if (find_link(head, a->anchor_addr) != a) return false;
+		if (++n > ref.size()) return false;
+	}
+	return n == ref.size();
+}
+
+static void testBasics() {
+	struct MyLink* head = init_link();
+	TEST_CHECK(head->next == NULL, "new table not empty");
+	TEST_CHECK(find_link(head, 0x1234) == NULL, "found addr in empty table");
+
+	add_link(head, 0);
+	TEST_CHECK(head->next == NULL, "addr 0 was added");
+
+	add_link(head, 0x1786);
+	add_link(head, 0x1787);
+	add_link(head, 0x1786);   // 重複
+	std::map<uint16_t, float> ref = {{0x1786, 0}, {0x1787, 0}};
+	TEST_CHECK(chainMatches(head, ref), "chain after duplicate add");
+
+	// 填滿
+	for (uint16_t a = 0x2000; ref.size() < LINK_MAX_ANCHORS; a++) {
+		add_link(head, a);
+		ref[a] = 0;
+	}
+	add_link(head, 0x7777);
+	TEST_CHECK(find_link(head, 0x7777) == NULL, "full table accepted another anchor");
+	TEST_CHECK(chainMatches(head, ref), "chain of full table");
+
+	// 刪中間一筆：最後一筆搬過來
+	struct MyLink* first = find_link(head, 0x1786);
+	delete_link(head, 0x1786);
+	ref.erase(0x1786);
+	TEST_CHECK(find_link(head, 0x1786) == NULL, "deleted anchor still found");
+	TEST_CHECK(first->anchor_addr != 0x1786, "slot not reused by the last entry");
+	TEST_CHECK(chainMatches(head, ref), "chain after delete");
+	delete_link(head, 0x1786);   // 不存在：不動
+	TEST_CHECK(chainMatches(head, ref), "chain after deleting a missing anchor");
+
+	// 刪到空
+	for (auto& kv : ref) delete_link(head, kv.first);
+	TEST_CHECK(head->next == NULL, "table not empty after deleting everything");
+}
+
+static void testFresh() {
+	struct MyLink* head = init_link();
+	add_link(head, 0x1786);
+	struct MyLink* a = find_link(head, 0x1786);
+	fresh_link(head, 0x1786, 3.0f, -80.0f, -82.0f);
+	TEST_CHECK(fabsf(a->range[0] - 1.0f) < 1e-6f, "range[0] after 1 sample = %f", a->range[0]);
+	fresh_link(head, 0x1786, 3.0f, -81.0f);
+	TEST_CHECK(fabsf(a->range[0] - (3.0f + 1.0f) / 3) < 1e-6f, "range[0] after 2 samples = %f", a->range[0]);
+	TEST_CHECK(a->dbm == -81.0f && a->fp_dbm == -82.0f, "dbm %f fp %f (fp should be kept)", a->dbm, a->fp_dbm);
+	fresh_link(head, 0x9999, 5.0f, -70.0f, -71.0f);   // 沒這台
+	TEST_CHECK(a->dbm == -81.0f, "fresh of unknown addr touched another entry");
+}
+
+static void testRandom(uint32_t ops) {
+	std::mt19937 rng(7);
+	struct MyLink* head = init_link();
+	std::map<uint16_t, float> ref;
+	uint32_t bad = 0;
+	for (uint32_t i = 0; i < ops; i++) {
+		// 位址集中在 40 個裡，才會常常重複、刪到存在的
+		uint16_t addr = (uint16_t)(0x1780 + rng() % 40);
+		switch (rng() % 4) {
+			case 0:
+			case 1:
+				add_link(head, addr);
+				if (ref.size() < LINK_MAX_ANCHORS) ref[addr] = 0;
+				break;
+			case 2:
+				delete_link(head, addr);
+				ref.erase(addr);
+				break;
+			default: {
+				bool found = find_link(head, addr) != NULL;
+				if (found != (ref.count(addr) != 0)) bad++;
+			}
+		}
+		if ((i & 1023) == 0 && !chainMatches(head, ref)) bad++;
+	}
+	TEST_CHECK(bad == 0, "random ops: %u mismatches against reference", bad);
+	TEST_CHECK(chainMatches(head, ref), "random ops: final chain");
+}
+
+// 原本的 malloc 串列（find_link 照抄，拿掉 Serial 輸出）
+static struct MyLink* oldFind(struct MyLink* p, uint16_t addr) {
+	if (addr == 0 || p->next == NULL) return NULL;
+	struct MyLink* temp = p;
+	while (temp->next != NULL) {
+		temp = temp->next;
+		if (temp->anchor_addr == addr) return temp;
+	}
+	return NULL;
+}
+
+static void bench(uint8_t anchors) {
+	const uint32_t calls = 20000000;
+	std::vector<uint16_t> addrs;
+	std::mt19937 rng(anchors);
+	for (uint8_t i = 0; i < anchors; i++) addrs.push_back((uint16_t)(0x1700 + rng() % 0x800));
+
+	struct MyLink* head = init_link();
+	struct MyLink oldHead = {};
+	struct MyLink* tail = &oldHead;
+	for (uint16_t a : addrs) {
+		add_link(head, a);
+		struct MyLink* n = (struct MyLink*)calloc(1, sizeof(struct MyLink));
+		n->anchor_addr = a;
+		tail->next = n;
+		tail = n;
+	}
+	std::vector<uint16_t> seq(4096);
+	for (auto& s : seq) s = addrs[rng() % addrs.size()];
+
+	uintptr_t sink = 0;
+	auto t0 = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < calls; i++) sink += (uintptr_t)find_link(head, seq[i & 4095]);
+	auto t1 = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < calls; i++) sink += (uintptr_t)oldFind(&oldHead, seq[i & 4095]);
+	auto t2 = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < calls; i++) fresh_link(head, seq[i & 4095], 1.0f, -80.0f, -82.0f);
+	auto t3 = std::chrono::steady_clock::now();
+	TEST_CHECK(sink != 0, "lookups returned nothing");
+
+	auto ns = [calls](std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b) {
+		return std::chrono::duration<double, std::nano>(b - a).count() / calls;
+	};
+	printf("%7u  %15.2f  %18.2f  %13.2f\n", anchors, ns(t0, t1), ns(t1, t2), ns(t2, t3));
+
+	for (struct MyLink* a = oldHead.next; a != NULL;) {
+		struct MyLink* n = a->next;
+		free(a);
+		a = n;
+	}
+}
+
+int main(int argc, char** argv) {
+	uint32_t ops = 200000;
+	int opt;
+	while ((opt = getopt(argc, argv, "n:h")) != -1) {
+		switch (opt) {
+			case 'n': ops = (uint32_t)strtoul(optarg, nullptr, 10); break;
+			default:
+				fprintf(stderr, "usage: %s [-n random_ops]\n", argv[0]);
+				return 1;
+		}
+	}
+	testBasics();
+	testFresh();
+	testRandom(ops);
+
+	printf("anchors  find ns (table)  find ns (old list)  fresh_link ns\n");
+	bench(4);
+	bench(8);
+	bench(LINK_MAX_ANCHORS);
+	return testSummary("UWB_Link_Test");
+}
@@ -0,0 +1,218 @@
+/*
+ * @file UWB_Load_Generator.cpp
+ * UWB_Ingest_Server 壓測用：模擬很多個 tag 送 UWBTelemetry datagram（Linux）
+ *
+ * anchor 的位址與座標讀 -a 指定的檔案（和 UWB_Solver_Service 同一份 anchors.txt：每行 `id x y z`，id 16 進位，# 開頭是註解），
+ * 每個 tag 有自己的序號與 DW1000 時間，在 anchor 圍起來的範圍內、離地約 1 m 繞橢圓移動，
+ * 送出的 range 是到每個 anchor 的 3D 距離，錄下來的 ranges.bin 可以直接給 UWB_Solver_Service 解。
+ * 用 sendmmsg 一次送一批，依 -r 控制總速率。
+ *
+ * 編譯：
+ *   g++ -O2 -std=c++17 -I../DW1000_BACKUP/src_0205 \
+ *       UWB_Load_Generator.cpp ../DW1000_BACKUP/src_0205/UWBTelemetry.cpp -o uwb_loadgen
+ * 執行（1000 個 tag、anchors.txt 的 anchor、總共 100k datagram/s、10 秒）：
+ *   ./uwb_loadgen -H 127.0.0.1 -p 8001 -t 1000 -a anchors.txt -r 100000 -d 10
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include "UWBTelemetry.h"
+
+#define LOADGEN_BATCH       64
+#define LOADGEN_MAX_ANCHORS 16
+#define DW_TICKS_PER_MS     63897600ull   // 1 ms 的 DW1000 tick 數（15.65 ps/tick）
+#define DW_TIME_MASK        0xFFFFFFFFFFull
+#define LOADGEN_TAG_Z       1.0    // m，tag 大約的離地高度
+
+struct SimTag {
+	uint16_t id;
+	uint32_t seq;
+	uint64_t dwTime;
+	double   phase;
+};
+
+struct Anchor {
+	double x, y, z;
+};
+
+// 格式同 UWB_Solver_Service：`id x y z`（id 16 進位），# 開頭是註解
+static bool loadAnchors(const char* path, std::map<uint16_t, Anchor>* anchors) {
+	FILE* f = fopen(path, "r");
+	if (f == nullptr) return false;
+	char line[256];
+	while (fgets(line, sizeof(line), f)) {
+		if (line[0] == '#' || line[0] == '\n') continue;
+		unsigned id;
+		Anchor a;
+		if (sscanf(line, "%x %lf %lf %lf", &id, &a.x, &a.y, &a.z) == 4) (*anchors)[(uint16_t)id] = a;
+	}
+	fclose(f);
+	return !anchors->empty();
+}
+
+static uint64_t monoNs() {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char** argv) {
+	const char* host = "127.0.0.1";
+	int port = 8001;
+	int nTags = 100;
+	const char* anchorPath = "anchors.txt";
+	double rate = 10000.0;   // datagram/s（全部 tag 合計）
+	int duration = 10;
+	int opt;
+	while ((opt = getopt(argc, argv, "H:p:t:a:r:d:h")) != -1) {
+		switch (opt) {
+			case 'H': host = optarg; break;
+			case 'p': port = atoi(optarg); break;
+			case 't': nTags = atoi(optarg); break;
+			case 'a': anchorPath = optarg; break;
+			case 'r': rate = atof(optarg); break;
+			case 'd': duration = atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-H host] [-p port] [-t tags] [-a anchors.txt] [-r dgram/s] [-d seconds]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (nTags < 1 || rate <= 0) {
+		fprintf(stderr, "bad arguments\n");
+		return 1;
+	}
+	std::map<uint16_t, Anchor> anchorMap;
+	if (!loadAnchors(anchorPath, &anchorMap)) {
+		fprintf(stderr, "cannot load anchors from %s\n", anchorPath);
+		return 1;
+	}
+	if (anchorMap.size() > LOADGEN_MAX_ANCHORS) {
+		fprintf(stderr, "%s has %zu anchors, at most %d\n", anchorPath, anchorMap.size(), LOADGEN_MAX_ANCHORS);
+		return 1;
+	}
+
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	sockaddr_in dst;
+	memset(&dst, 0, sizeof(dst));
+	dst.sin_family = AF_INET;
+	dst.sin_port = htons((uint16_t)port);
+	if (inet_pton(AF_INET, host, &dst.sin_addr) != 1) {
+		fprintf(stderr, "bad host %s\n", host);
+		return 1;
+	}
+	int sndbuf = 8 * 1024 * 1024;
+	setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+	// tag 繞的橢圓：中心 = anchor 的平均位置，半徑 = anchor 範圍（x / y）的 0.3 倍，整個路徑都在 anchor 圍起來的範圍內
+	const int nAnchors = (int)anchorMap.size();
+	uint16_t aid[LOADGEN_MAX_ANCHORS];
+	Anchor anc[LOADGEN_MAX_ANCHORS];
+	double cx = 0.0, cy = 0.0, minX = 1e9, maxX = -1e9, minY = 1e9, maxY = -1e9;
+	int k = 0;
+	for (auto& kv : anchorMap) {
+		aid[k] = kv.first;
+		anc[k] = kv.second;
+		cx += kv.second.x / nAnchors;
+		cy += kv.second.y / nAnchors;
+		minX = std::min(minX, kv.second.x);
+		maxX = std::max(maxX, kv.second.x);
+		minY = std::min(minY, kv.second.y);
+		maxY = std::max(maxY, kv.second.y);
+		k++;
+	}
+	const double rx = 0.3 * (maxX - minX), ry = 0.3 * (maxY - minY);
+	fprintf(stderr, "[LOADGEN] %d anchors from %s, tags circle (%.2f, %.2f) radius %.2f x %.2f m at z %.1f m\n", nAnchors,
+	        anchorPath, cx, cy, rx, ry, LOADGEN_TAG_Z);
+
+	std::vector<SimTag> tags((size_t)nTags);
+	for (int i = 0; i < nTags; i++) {
+		tags[i].id = (uint16_t)(0x1000 + i);
+		tags[i].seq = 0;
+		tags[i].dwTime = ((uint64_t)rand() << 8) & DW_TIME_MASK;
+		tags[i].phase = (double)i;
+	}
+
+	static uint8_t bufs[LOADGEN_BATCH][UWB_TELEM_LEN(LOADGEN_MAX_ANCHORS)];
+	mmsghdr msgs[LOADGEN_BATCH];
+	iovec iov[LOADGEN_BATCH];
+	for (int i = 0; i < LOADGEN_BATCH; i++) {
+		memset(&msgs[i], 0, sizeof(msgs[i]));
+		iov[i].iov_base = bufs[i];
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_name = &dst;
+		msgs[i].msg_hdr.msg_namelen = sizeof(dst);
+	}
+
+	const double periodMs = 1000.0 * nTags / rate;   // 每個 tag 的送包週期
+	uint64_t t0 = monoNs();
+	uint64_t sent = 0, failed = 0, lastSent = 0, lastT = t0;
+	size_t next = 0;
+	while (monoNs() - t0 < (uint64_t)duration * 1000000000ull) {
+		// 依目標速率決定現在應該送到第幾個
+		uint64_t now = monoNs();
+		uint64_t due = (uint64_t)((double)(now - t0) / 1e9 * rate);
+		if (due <= sent + failed) {
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+			continue;
+		}
+		int n = (int)std::min<uint64_t>(LOADGEN_BATCH, due - sent - failed);
+
+		for (int i = 0; i < n; i++) {
+			SimTag& t = tags[next];
+			next = (next + 1) % tags.size();
+			t.phase += periodMs * 1e-3 * 0.5;   // 0.5 rad/s 繞圓
+			t.dwTime = (t.dwTime + (uint64_t)(periodMs * DW_TICKS_PER_MS)) & DW_TIME_MASK;
+			const double x = cx + rx * cos(t.phase), y = cy + ry * sin(t.phase);
+			const double z = LOADGEN_TAG_Z + 0.1 * sin(3.0 * t.phase);
+
+			UWBTelemetryRecord r[LOADGEN_MAX_ANCHORS];
+			for (int a = 0; a < nAnchors; a++) {
+				const double d = sqrt((x - anc[a].x) * (x - anc[a].x) + (y - anc[a].y) * (y - anc[a].y) +
+				                      (z - anc[a].z) * (z - anc[a].z));
+				r[a].anchor  = aid[a];
+				r[a].rangeMm = uwbTelemetryMeterToMm((float)d);
+				r[a].rxPower = uwbTelemetryDbmToCenti((float)(-78.0 - 2.0 * d));
+				r[a].fpPower = uwbTelemetryDbmToCenti((float)(-80.0 - 2.0 * d));
+			}
+			UWBTelemetryHeader h;
+			h.version = UWB_TELEM_VERSION;
+			h.tagId = t.id;
+			h.seq = t.seq++;
+			h.dwTime = t.dwTime;
+			h.flags = 0;
+			int len = uwbTelemetryEncode(&h, r, (uint8_t)nAnchors, bufs[i], sizeof(bufs[i]));
+			iov[i].iov_len = (size_t)len;
+		}
+
+		int done = sendmmsg(fd, msgs, (unsigned)n, 0);
+		if (done < 0) done = 0;
+		sent += (uint64_t)done;
+		failed += (uint64_t)(n - done);   // socket buffer 滿：算成 tag 端的掉包
+
+		if (now - lastT >= 1000000000ull) {
+			fprintf(stderr, "[LOADGEN] sent/s=%.0f total=%llu failed=%llu\n",
+			        (double)(sent - lastSent) * 1e9 / (double)(now - lastT),
+			        (unsigned long long)sent, (unsigned long long)failed);
+			lastSent = sent;
+			lastT = now;
+		}
+	}
+	fprintf(stderr, "[LOADGEN] done, sent=%llu failed=%llu\n", (unsigned long long)sent, (unsigned long long)failed);
+	close(fd);
+	return 0;
+}
@@ -0,0 +1,395 @@
+/*
+ * @file UWB_Multilateration_Test.cpp
+ * UWBMultilateration 和原本 sketch 的 trilat2D_4A / trilat3D_4A 的精度比對
+ *
+ * trilat3D_4A / trilat2D_4A 從 ESP32_UWB_tag3D_4A / tag2D_4A 換成 UWBMultilateration 之前的版本照抄
+ * （只拿掉 debug 輸出，奇異矩陣改成 return 0），3D 版用同一份 util/m33v3.h 巨集。
+ *
+ *   1. 沒雜訊：3D 解回真實位置；2D 給水平距離時解回 (x, y)
+ *   2. 4 個 anchor、距離加 N(0, sigma) 雜訊：和原本公式的位置差、rmse 差都在 float 誤差內（-n 組，預設 10000）
+ *   3. 精度：4 / 5 / 6 個 anchor 的平均誤差與 p95，refine() 前後（多 anchor 與精修應該比較準）
+ *   4. anchor 不夠（3D 只有 3 個）、共線 anchor 要回 false；anchor 組合不變時快取命中
+ *   5. factorize() + const solve() 和快取版 solve() 結果相同
+ * 另外印每次 solve 的 ns
+ *
+ * -B：只跑 refine benchmark。4 / 5 / 6 個 anchor、雜訊 sigma，每個 fix 印 solve / solveRefined 的 µs、
+ *     refine 平均與最多迭代幾次、等權和 powerWeight 加權各一組（每次 refine 的成本 = 兩者差 / 迭代次數）
+ *
+ * 編譯：
+ *   g++ -O2 -std=c++17 -I../DW1000_BACKUP/src_0205 UWB_Multilateration_Test.cpp \
+ *       ../DW1000_BACKUP/src_0205/UWBMultilateration.cpp ../DW1000_BACKUP/src_0205/UWBNlos.cpp -o uwb_multilateration_test
+ * 執行：
+ *   ./uwb_multilateration_test [-n 10000] [-s 0.05]
+ *   ./uwb_multilateration_test -B [-n 10000] [-s 0.05]
+ */
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "HostTest.h"
+#include "UWBMultilateration.h"
+#include "../Old_Program/ESP32_UWB_tag3D_4A/util/m33v3.h"
+
+// ---- 原本 sketch 的 globals 與 trilat 函式 ----
+#define N_ANCHORS 4
+static float anchor_matrix[N_ANCHORS][3] = {   // ESP32_UWB_tag3D_4A 的 anchor 座標
+	{0.0, 0.0, 0.97},
+	{3.99, 5.44, 1.14},
+	{3.71, -0.3, 0.61},
+	{-0.56, 4.88, 0.15},
+};
+static float last_anchor_distance[N_ANCHORS];
+static float current_tag_position[3];
+static float current_distance_rmse;
+
+static int trilat3D_4A(void) {
+	static bool first = true;
+	float b[3], d[N_ANCHORS];
+	static float Ainv[3][3], k[N_ANCHORS];
+	int i;
+	for (i = 0; i < N_ANCHORS; i++) d[i] = last_anchor_distance[i];
+	if (first) {
+		first = false;
+		float x[N_ANCHORS], y[N_ANCHORS], z[N_ANCHORS];
+		float A[3][3];
+		for (i = 0; i < N_ANCHORS; i++) {
+			x[i] = anchor_matrix[i][0];
+			y[i] = anchor_matrix[i][1];
+			z[i] = anchor_matrix[i][2];
+			k[i] = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+		}
+		for (i = 1; i < N_ANCHORS; i++) {
+			A[i - 1][0] = x[i] - x[0];
+			A[i - 1][1] = y[i] - y[0];
+			A[i - 1][2] = z[i] - z[0];
+		}
+		float det;
+		DETERMINANT_3X3(det, A);
+		if (fabs(det) < 1.0e-4) return 0;
+		det = 1.0 / det;
+		SCALE_ADJOINT_3X3(Ainv, det, A);
+	}
+	for (i = 1; i < 4; i++) {
+		b[i - 1] = d[0] * d[0] - d[i] * d[i] + k[i] - k[0];
+	}
+	float posn2[3];
+	MAT_DOT_VEC_3X3(posn2, Ainv, b);
+	for (i = 0; i < 3; i++) current_tag_position[i] = posn2[i] * 0.5;
+	float x[3] = {0}, rmse = 0.0, dc = 0.0;
+	for (i = 0; i < N_ANCHORS; i++) {
+		x[0] = anchor_matrix[i][0] - current_tag_position[0];
+		x[1] = anchor_matrix[i][1] - current_tag_position[1];
+		x[2] = anchor_matrix[i][2] - current_tag_position[2];
+		dc = sqrt(x[0] * x[0] + x[1] * x[1] + x[2] * x[2]);
+		rmse += (d[i] - dc) * (d[i] - dc);
+	}
+	current_distance_rmse = sqrt(rmse / ((float)N_ANCHORS));
+	return 1;
+}
+
+static int trilat2D_4A(void) {
+	static bool first = true;
+	float d[N_ANCHORS];
+	static float A[N_ANCHORS - 1][2], Ainv[2][2], b[N_ANCHORS - 1], kv[N_ANCHORS];
+	int i, j, k;
+	for (i = 0; i < N_ANCHORS; i++) d[i] = last_anchor_distance[i];
+	if (first) {
+		first = false;
+		float x[N_ANCHORS], y[N_ANCHORS];
+		for (i = 0; i < N_ANCHORS; i++) {
+			x[i] = anchor_matrix[i][0];
+			y[i] = anchor_matrix[i][1];
+			kv[i] = x[i] * x[i] + y[i] * y[i];
+		}
+		for (i = 1; i < N_ANCHORS; i++) {
+			A[i - 1][0] = x[i] - x[0];
+			A[i - 1][1] = y[i] - y[0];
+		}
+		float ATA[2][2];
+		for (i = 0; i < 2; i++) {
+			for (j = 0; j < 2; j++) {
+				ATA[i][j] = 0.0;
+				for (k = 0; k < N_ANCHORS - 1; k++) ATA[i][j] += A[k][i] * A[k][j];
+			}
+		}
+		float det = ATA[0][0] * ATA[1][1] - ATA[1][0] * ATA[0][1];
+		if (fabs(det) < 1.0E-4) return 0;
+		det = 1.0 / det;
+		Ainv[0][0] = det * ATA[1][1];
+		Ainv[0][1] = -det * ATA[0][1];
+		Ainv[1][0] = -det * ATA[1][0];
+		Ainv[1][1] = det * ATA[0][0];
+	}
+	for (i = 1; i < N_ANCHORS; i++) {
+		b[i - 1] = d[0] * d[0] - d[i] * d[i] + kv[i] - kv[0];
+	}
+	float ATb[2] = {0.0};
+	for (i = 0; i < N_ANCHORS - 1; i++) {
+		ATb[0] += A[i][0] * b[i];
+		ATb[1] += A[i][1] * b[i];
+	}
+	current_tag_position[0] = 0.5 * (Ainv[0][0] * ATb[0] + Ainv[0][1] * ATb[1]);
+	current_tag_position[1] = 0.5 * (Ainv[1][0] * ATb[0] + Ainv[1][1] * ATb[1]);
+	float rmse = 0.0, dc0 = 0.0, dc1 = 0.0, dc2 = 0.0;
+	for (i = 0; i < N_ANCHORS; i++) {
+		dc0 = current_tag_position[0] - anchor_matrix[i][0];
+		dc1 = current_tag_position[1] - anchor_matrix[i][1];
+		dc2 = anchor_matrix[i][2];
+		dc0 = d[i] - sqrt(dc0 * dc0 + dc1 * dc1 + dc2 * dc2);
+		rmse += dc0 * dc0;
+	}
+	current_distance_rmse = sqrt(rmse / ((float)N_ANCHORS));
+	return 1;
+}
+
+// ---- 測試 ----
+// 另外兩個 anchor（天花板附近），測 5 / 6 個 anchor
+static const float EXTRA[2][3] = {{2.0f, 2.5f, 2.6f}, {0.5f, 5.2f, 2.4f}};
+
+static void setupAnchors(UWBMultilateration& m) {
+	for (uint8_t i = 0; i < N_ANCHORS; i++) m.setAnchor(i, anchor_matrix[i][0], anchor_matrix[i][1], anchor_matrix[i][2]);
+	m.setAnchor(4, EXTRA[0][0], EXTRA[0][1], EXTRA[0][2]);
+	m.setAnchor(5, EXTRA[1][0], EXTRA[1][1], EXTRA[1][2]);
+}
+
+static float dist(const float* a, const float* p) {
+	return sqrtf((a[0] - p[0]) * (a[0] - p[0]) + (a[1] - p[1]) * (a[1] - p[1]) + (a[2] - p[2]) * (a[2] - p[2]));
+}
+
+static void testExact() {
+	UWBMultilateration m3(3), m2(2);
+	setupAnchors(m3);
+	setupAnchors(m2);
+	const float truth[3] = {1.3f, 2.1f, 0.4f};
+	const float flat[3] = {1.3f, 2.1f, 0.0f};
+	float d3[6], d2[6], p[3], r;
+	for (uint8_t i = 0; i < 6; i++) {
+		d3[i] = dist(m3.anchor(i), truth);
+		// 2D 的線性化沒有 anchor z（同 trilat2D_4A），水平距離才是精確解
+		const float* a = m2.anchor(i);
+		d2[i] = sqrtf((a[0] - flat[0]) * (a[0] - flat[0]) + (a[1] - flat[1]) * (a[1] - flat[1]));
+	}
+	TEST_CHECK(m3.solve(0x0F, d3, p, &r), "3D exact solve failed");
+	TEST_CHECK(dist(p, truth) < 1e-3f && r < 1e-3f, "3D exact error %.2e m, rmse %.2e", dist(p, truth), r);
+	TEST_CHECK(m2.solve(0x0F, d2, p, &r), "2D exact solve failed");
+	TEST_CHECK(dist(p, flat) < 1e-3f && p[2] == 0.0f, "2D exact error %.2e m", dist(p, flat));
+	TEST_CHECK(m3.solve(0x3F, d3, p, &r) && dist(p, truth) < 1e-3f, "3D exact, 6 anchors: error %.2e m", dist(p, truth));
+}
+
+static void testAgainstOriginal(uint32_t n, float sigma) {
+	UWBMultilateration m3(3), m2(2);
+	setupAnchors(m3);
+	setupAnchors(m2);
+	std::mt19937 rng(37);
+	std::uniform_real_distribution<float> ux(-0.5f, 4.5f), uz(0.0f, 1.5f);
+	std::normal_distribution<float> noise(0.0f, sigma);
+	double maxPos3 = 0, maxPos2 = 0, maxRmse3 = 0, maxRmse2 = 0;
+	uint32_t failed = 0;
+	for (uint32_t t = 0; t < n; t++) {
+		float truth[3] = {ux(rng), ux(rng), uz(rng)};
+		float d[N_ANCHORS], p[3], r;
+		for (uint8_t i = 0; i < N_ANCHORS; i++) {
+			d[i] = dist(anchor_matrix[i], truth) + noise(rng);
+			last_anchor_distance[i] = d[i];
+		}
+		if (!m3.solve(0x0F, d, p, &r) || !trilat3D_4A()) {
+			failed++;
+			continue;
+		}
+		for (int c = 0; c < 3; c++) maxPos3 = std::max(maxPos3, (double)fabsf(p[c] - current_tag_position[c]));
+		maxRmse3 = std::max(maxRmse3, (double)fabsf(r - current_distance_rmse));
+		if (!m2.solve(0x0F, d, p, &r) || !trilat2D_4A()) {
+			failed++;
+			continue;
+		}
+		for (int c = 0; c < 2; c++) maxPos2 = std::max(maxPos2, (double)fabsf(p[c] - current_tag_position[c]));
+		maxRmse2 = std::max(maxRmse2, (double)fabsf(r - current_distance_rmse));
+	}
+	printf("vs original (%u fixes, sigma %.3f m): max |dpos| 3D %.2e m, 2D %.2e m; max |drmse| 3D %.2e, 2D %.2e\n",
+	       n, sigma, maxPos3, maxPos2, maxRmse3, maxRmse2);
+	TEST_CHECK(failed == 0, "%u solves failed", failed);
+	// float 運算順序不同，容許 0.1 mm
+	TEST_CHECK(maxPos3 < 1e-4 && maxPos2 < 1e-4, "position differs from the original formula");
+	TEST_CHECK(maxRmse3 < 1e-4 && maxRmse2 < 1e-4, "rmse differs from the original formula");
+}
+
+static void testAccuracy(uint32_t n, float sigma) {
+	UWBMultilateration m3(3);
+	setupAnchors(m3);
+	std::mt19937 rng(38);
+	std::uniform_real_distribution<float> ux(0.0f, 4.0f), uz(0.0f, 1.5f);
+	std::normal_distribution<float> noise(0.0f, sigma);
+	const uint16_t masks[3] = {0x0F, 0x1F, 0x3F};
+	std::vector<float> err[3], errRef[3];
+	for (uint32_t t = 0; t < n; t++) {
+		float truth[3] = {ux(rng), ux(rng), uz(rng)};
+		float d[6];
+		for (uint8_t i = 0; i < 6; i++) d[i] = dist(m3.anchor(i), truth) + noise(rng);
+		for (int k = 0; k < 3; k++) {
+			float p[3], r;
+			if (!m3.solve(masks[k], d, p, &r)) continue;
+			err[k].push_back(dist(p, truth));
+			if (m3.solveRefined(masks[k], d, nullptr, p, &r)) errRef[k].push_back(dist(p, truth));
+		}
+	}
+	auto stats = [](std::vector<float>& v, double* mean, double* p95) {
+		std::sort(v.begin(), v.end());
+		double s = 0;
+		for (float x : v) s += x;
+		*mean = v.empty() ? 0 : s / v.size();
+		*p95 = v.empty() ? 0 : v[(size_t)(0.95 * (v.size() - 1))];
+	};
+	printf("3D accuracy, sigma %.3f m     linear mean / p95       refined mean / p95\n", sigma);
+	double mean[3], p95[3], meanR[3], p95R[3];
+	for (int k = 0; k < 3; k++) {
+		stats(err[k], &mean[k], &p95[k]);
+		stats(errRef[k], &meanR[k], &p95R[k]);
+		printf("  %d anchors                    %6.3f / %6.3f m         %6.3f / %6.3f m\n", 4 + k, mean[k], p95[k], meanR[k], p95R[k]);
+		TEST_CHECK(err[k].size() == n && errRef[k].size() == n, "%d anchors: %zu/%zu of %u solved", 4 + k, err[k].size(), errRef[k].size(), n);
+		TEST_CHECK(meanR[k] <= mean[k], "%d anchors: refine made it worse (%.3f > %.3f)", 4 + k, meanR[k], mean[k]);
+	}
+	TEST_CHECK(mean[2] < mean[0], "6 anchors not better than 4 (%.3f vs %.3f)", mean[2], mean[0]);
+}
+
+static void testEdgeCases() {
+	UWBMultilateration m3(3), m2(2);
+	setupAnchors(m3);
+	setupAnchors(m2);
+	float d[6] = {2, 3, 3, 3, 2, 2}, p[3], r;
+	TEST_CHECK(!m3.solve(0x07, d, p, &r), "3D accepted 3 anchors");
+	TEST_CHECK(m2.solve(0x07, d, p, &r), "2D rejected 3 anchors");
+
+	UWBMultilateration line(2);
+	line.setAnchor(0, 0, 0, 0);
+	line.setAnchor(1, 1, 0, 0);
+	line.setAnchor(2, 2, 0, 0);
+	TEST_CHECK(!line.solve(0x07, d, p, &r), "collinear anchors accepted");
+
+	uint32_t miss0 = m3.cacheMisses();
+	for (int i = 0; i < 100; i++) m3.solve(0x1F, d, p, &r);
+	TEST_CHECK(m3.cacheMisses() - miss0 == 1, "same mask refactorised %u times", m3.cacheMisses() - miss0);
+
+	MlatFactor f;
+	float q[3], rq;
+	TEST_CHECK(m3.factorize(0x1F, &f) && m3.solve(f, d, q, &rq), "factorize/const solve failed");
+	m3.solve(0x1F, d, p, &r);
+	TEST_CHECK(p[0] == q[0] && p[1] == q[1] && p[2] == q[2] && r == rq, "const solve differs from cached solve");
+}
+
+static void bench() {
+	UWBMultilateration m3(3);
+	setupAnchors(m3);
+	float d[6] = {2.1f, 3.3f, 2.9f, 3.1f, 2.0f, 2.2f}, p[3], r;
+	const uint32_t calls = 2000000;
+	volatile float sink = 0;
+	auto t0 = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < calls; i++) {
+		d[0] = 2.1f + (float)(i & 255) * 1e-4f;
+		m3.solve(0x1F, d, p, &r);
+		sink = sink + p[0];
+	}
+	auto t1 = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < calls; i++) {
+		for (int k = 0; k < N_ANCHORS; k++) last_anchor_distance[k] = d[k];
+		last_anchor_distance[0] = 2.1f + (float)(i & 255) * 1e-4f;
+		trilat3D_4A();
+		sink = sink + current_tag_position[0];
+	}
+	auto t2 = std::chrono::steady_clock::now();
+	printf("solve (5 anchors, cached) %.1f ns, trilat3D_4A %.1f ns\n",
+	       std::chrono::duration<double, std::nano>(t1 - t0).count() / calls,
+	       std::chrono::duration<double, std::nano>(t2 - t1).count() / calls);
+}
+
+// -B：refine 的迭代次數與每個 fix 的時間（同一組 fix 重複 MLAT_BENCH_REPEAT 次取平均）
+#define MLAT_BENCH_REPEAT 20
+
+static void benchRefine(uint32_t n, float sigma) {
+	UWBMultilateration m3(3);
+	setupAnchors(m3);
+	std::mt19937 rng(39);
+	std::uniform_real_distribution<float> ux(0.0f, 4.0f), uz(0.0f, 1.5f), upow(-100.0f, -80.0f), unlos(0.0f, 12.0f);
+	std::normal_distribution<float> noise(0.0f, sigma);
+	std::vector<float> d((size_t)n * 6), w((size_t)n * 6);
+	for (uint32_t t = 0; t < n; t++) {
+		const float truth[3] = {ux(rng), ux(rng), uz(rng)};
+		for (uint8_t i = 0; i < 6; i++) {
+			const float fp = upow(rng);
+			d[t * 6 + i] = dist(m3.anchor(i), truth) + noise(rng);
+			w[t * 6 + i] = UWBMultilateration::powerWeight(fp + unlos(rng), fp);
+		}
+	}
+	printf("refine benchmark: %u fixes x %d, sigma %.3f m, max %d iterations, tol %.1f mm\n", n, MLAT_BENCH_REPEAT, sigma,
+	       MLAT_REFINE_MAX_ITER, MLAT_REFINE_TOL * 1000.0f);
+	printf("anchors  weights  solve us/fix  solveRefined us/fix  iters mean  iters max  us/iteration\n");
+	const uint16_t masks[3] = {0x0F, 0x1F, 0x3F};
+	volatile float sink = 0;
+	for (int k = 0; k < 3; k++) {
+		for (int weighted = 0; weighted < 2; weighted++) {
+			float p[3], r;
+			auto t0 = std::chrono::steady_clock::now();
+			for (int rep = 0; rep < MLAT_BENCH_REPEAT; rep++) {
+				for (uint32_t t = 0; t < n; t++) {
+					m3.solve(masks[k], &d[t * 6], p, &r);
+					sink = sink + p[0];
+				}
+			}
+			auto t1 = std::chrono::steady_clock::now();
+			uint64_t iters = 0;
+			uint8_t maxIters = 0;
+			for (int rep = 0; rep < MLAT_BENCH_REPEAT; rep++) {
+				for (uint32_t t = 0; t < n; t++) {
+					uint8_t it = 0;
+					m3.solveRefined(masks[k], &d[t * 6], weighted ? &w[t * 6] : nullptr, p, &r, &it);
+					sink = sink + p[0];
+					iters += it;
+					maxIters = std::max(maxIters, it);
+				}
+			}
+			auto t2 = std::chrono::steady_clock::now();
+			const double fixes = (double)n * MLAT_BENCH_REPEAT;
+			const double solveUs = std::chrono::duration<double, std::micro>(t1 - t0).count() / fixes;
+			const double refinedUs = std::chrono::duration<double, std::micro>(t2 - t1).count() / fixes;
+			const double meanIters = iters / fixes;
+			printf("%7d  %-7s  %12.3f  %19.3f  %10.2f  %9u  %12.3f\n", 4 + k, weighted ? "power" : "equal", solveUs, refinedUs,
+			       meanIters, maxIters, meanIters > 0 ? (refinedUs - solveUs) / meanIters : 0.0);
+			TEST_CHECK(maxIters <= MLAT_REFINE_MAX_ITER, "%d anchors: %u iterations", 4 + k, maxIters);
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	uint32_t n = 10000;
+	float sigma = 0.05f;
+	bool refineBench = false;
+	int opt;
+	while ((opt = getopt(argc, argv, "n:s:Bh")) != -1) {
+		switch (opt) {
+			case 'n': n = (uint32_t)strtoul(optarg, nullptr, 10); break;
+			case 's': sigma = strtof(optarg, nullptr); break;
+			case 'B': refineBench = true; break;
+			default:
+				fprintf(stderr, "usage: %s [-B] [-n fixes] [-s range_sigma_m]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (n == 0) n = 1;
+	if (refineBench) {
+		benchRefine(n, sigma);
+		return testSummary("UWB_Multilateration_Test");
+	}
+	testExact();
+	testAgainstOriginal(n, sigma);
+	testAccuracy(n, sigma);
+	testEdgeCases();
+	bench();
+	return testSummary("UWB_Multilateration_Test");
+}
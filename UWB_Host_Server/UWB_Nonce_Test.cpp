@@ -0,0 +1,173 @@
+/*
+ * @file UWB_Nonce_Test.cpp
+ * DW1000Nonce（IV_MODE_BOOT_COUNTER）的 host 測試
+ *
+ * 每次「開機」在 fork 出來的子行程裡跑（DW1000NonceClass 是 static，begin() 一次開機只能做一次）：
+ *   1. 沒有 boot 檔：boot = 1，連續產生 N 個 IV（預設 1e8），IV[0..7] 當 little-endian uint64 嚴格遞增、salt 不變
+ *   2. boot 檔內容 = 1（round trip），再開機 boot = 2，而且第一個 IV 大於上次開機的最後一個
+ *   3. 第三次開機 boot = 3
+ *   4. boot 檔損毀（長度不對）：begin() 失敗，檔案不被改寫
+ *   5. boot 檔 = 0xFFFFFFFF（用盡）：begin() 失敗
+ *
+ * 編譯：
+ *   g++ -O2 -std=c++17 -I../DW1000_BACKUP/src_0205 -DNONCE_BOOT_FILE='"nonce_test_boot.bin"' \
+ *       UWB_Nonce_Test.cpp ../DW1000_BACKUP/src_0205/DW1000Nonce.cpp -o uwb_nonce_test
+ * 執行：
+ *   ./uwb_nonce_test [-n 100000000]
+ */
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "DW1000Nonce.h"
+#include "HostTest.h"
+
+struct BootResult {
+	bool     began;
+	bool     increasing;
+	bool     saltStable;
+	uint32_t boot;
+	uint32_t fileBoot;   // begin() 之後檔案裡的值
+	uint64_t firstIV;
+	uint64_t lastIV;
+	uint64_t generated;
+};
+
+static uint64_t ivSequence(const uint8_t iv[NONCE_IV_LEN]) {
+	uint64_t v = 0;
+	for (int i = 7; i >= 0; i--) v = (v << 8) | iv[i];
+	return v;
+}
+
+static bool readBootFile(uint32_t* value) {
+	FILE* f = fopen(NONCE_BOOT_FILE, "rb");
+	if (f == nullptr) return false;
+	uint8_t b[4];
+	size_t n = fread(b, 1, sizeof(b), f);
+	fclose(f);
+	if (n != sizeof(b)) return false;
+	*value = (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+	return true;
+}
+
+static void writeBootFile(const uint8_t* bytes, size_t n) {
+	FILE* f = fopen(NONCE_BOOT_FILE, "wb");
+	if (f == nullptr) {
+		perror(NONCE_BOOT_FILE);
+		exit(2);
+	}
+	fwrite(bytes, 1, n, f);
+	fclose(f);
+}
+
+// 子行程 = 一次開機：begin() 後產生 count 個 IV
+static BootResult boot(uint64_t count) {
+	int fd[2];
+	BootResult r;
+	memset(&r, 0, sizeof(r));
+	if (pipe(fd) != 0) {
+		perror("pipe");
+		exit(2);
+	}
+	pid_t pid = fork();
+	if (pid == 0) {
+		close(fd[0]);
+		r.began = DW1000Nonce.begin();
+		r.increasing = true;
+		r.saltStable = true;
+		if (r.began) {
+			r.boot = DW1000Nonce.getBootCounter();
+			readBootFile(&r.fileBoot);
+			uint8_t iv[NONCE_IV_LEN];
+			uint64_t prev = 0;
+			for (uint64_t i = 0; i < count; i++) {
+				if (!DW1000Nonce.next(iv)) break;
+				uint64_t v = ivSequence(iv);
+				uint32_t salt = (uint32_t)iv[8] | ((uint32_t)iv[9] << 8) | ((uint32_t)iv[10] << 16) | ((uint32_t)iv[11] << 24);
+				if (i == 0) r.firstIV = v;
+				else if (v <= prev) r.increasing = false;
+				if (salt != DW1000Nonce.getSalt()) r.saltStable = false;
+				prev = v;
+				r.generated++;
+			}
+			r.lastIV = prev;
+		}
+		ssize_t w = write(fd[1], &r, sizeof(r));
+		_exit(w == (ssize_t)sizeof(r) ? 0 : 1);
+	}
+	close(fd[1]);
+	ssize_t n = read(fd[0], &r, sizeof(r));
+	close(fd[0]);
+	int status = 0;
+	waitpid(pid, &status, 0);
+	if (n != (ssize_t)sizeof(r) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+		fprintf(stderr, "boot child failed\n");
+		exit(2);
+	}
+	return r;
+}
+
+int main(int argc, char** argv) {
+	uint64_t count = 100000000ULL;
+	int opt;
+	while ((opt = getopt(argc, argv, "n:h")) != -1) {
+		switch (opt) {
+			case 'n': count = strtoull(optarg, nullptr, 10); break;
+			default:
+				fprintf(stderr, "usage: %s [-n ivs_per_boot]\n", argv[0]);
+				return 1;
+		}
+	}
+	remove(NONCE_BOOT_FILE);
+
+	// 1. 第一次開機
+	BootResult b1 = boot(count);
+	TEST_CHECK(b1.began, "first begin() failed");
+	TEST_CHECK(b1.boot == 1, "first boot = %u", b1.boot);
+	TEST_CHECK(b1.fileBoot == 1, "boot file after first begin = %u", b1.fileBoot);
+	TEST_CHECK(b1.generated == count, "generated %llu of %llu", (unsigned long long)b1.generated, (unsigned long long)count);
+	TEST_CHECK(b1.increasing, "IV[0..7] not strictly increasing within boot 1");
+	TEST_CHECK(b1.saltStable, "salt changed within boot 1");
+	printf("boot 1: %llu IVs, seq %016llx..%016llx\n", (unsigned long long)b1.generated,
+	       (unsigned long long)b1.firstIV, (unsigned long long)b1.lastIV);
+
+	// 2. 重新開機：boot 從檔案讀回再 +1，序號接著往上
+	uint32_t stored = 0;
+	TEST_CHECK(readBootFile(&stored) && stored == 1, "boot file round trip = %u", stored);
+	BootResult b2 = boot(1000);
+	TEST_CHECK(b2.began && b2.boot == 2, "second boot = %u", b2.boot);
+	TEST_CHECK(b2.firstIV > b1.lastIV, "IV went backwards across reboot");
+	TEST_CHECK(b2.increasing && b2.saltStable, "boot 2 sequence");
+
+	// 3. 第三次開機
+	BootResult b3 = boot(1);
+	TEST_CHECK(b3.began && b3.boot == 3 && b3.fileBoot == 3, "third boot = %u (file %u)", b3.boot, b3.fileBoot);
+
+	// 4. 檔案損毀：拒絕，不改寫
+	const uint8_t broken[2] = {0x05, 0x00};
+	writeBootFile(broken, sizeof(broken));
+	BootResult b4 = boot(1);
+	TEST_CHECK(!b4.began, "begin() accepted a corrupt boot file");
+	FILE* f = fopen(NONCE_BOOT_FILE, "rb");
+	long size = -1;
+	if (f != nullptr) {
+		fseek(f, 0, SEEK_END);
+		size = ftell(f);
+		fclose(f);
+	}
+	TEST_CHECK(size == 2, "corrupt boot file was rewritten (size %ld)", size);
+
+	// 5. 開機計數器用盡
+	const uint8_t full[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+	writeBootFile(full, sizeof(full));
+	BootResult b5 = boot(1);
+	TEST_CHECK(!b5.began, "begin() accepted an exhausted boot counter");
+
+	remove(NONCE_BOOT_FILE);
+	return testSummary("UWB_Nonce_Test");
+}
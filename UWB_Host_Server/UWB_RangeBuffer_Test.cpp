@@ -0,0 +1,238 @@
+/*
+ * @file UWB_RangeBuffer_Test.cpp
+ * UWBRangeBuffer（每個 anchor 的 range 歷史 + 時間對齊）的 host 單元測試與合成軌跡誤差比較
+ *
+ * 測試：
+ *   1. elapsed()：40-bit 繞回前後相減、正負號
+ *   2. running sums：隨機間隔 / 隨機距離連續 push（timestamp 中途繞回），每次 alignTo 的結果
+ *      和「用最近 RB_HISTORY 筆重新做 double 最小平方」的參考答案比對（-n 次，預設 200000）
+ *   3. 邊界：只有一筆不外插、時間倒退 / 間隔超過 maxAge 重來、比 epoch 舊超過 maxAge 的 anchor 不給、
+ *      斜率限制在 RB_MAX_SPEED、slot 超出範圍
+ *   4. 合成軌跡（2D，4 個 anchor 輪流 25 ms 一筆，3 cm 雜訊，timestamp 3 s 後繞回）：
+ *      每個 anchor 最後一筆直接解 vs alignTo(latest) 之後再解的 RMS 位置誤差，對齊後要比較小
+ *      - 圓周 1.5 m/s
+ *      - 直線來回 1 m/s
+ *
+ * 編譯：
+ *   g++ -O2 -std=c++17 -I../DW1000_BACKUP/src_0205 UWB_RangeBuffer_Test.cpp \
+ *       ../DW1000_BACKUP/src_0205/UWBRangeBuffer.cpp ../DW1000_BACKUP/src_0205/UWBMultilateration.cpp \
+ *       ../DW1000_BACKUP/src_0205/UWBNlos.cpp -o uwb_rangebuffer_test
+ * 執行：
+ *   ./uwb_rangebuffer_test [-n 200000]
+ */
+
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <random>
+
+#include "HostTest.h"
+#include "UWBMultilateration.h"
+#include "UWBRangeBuffer.h"
+
+static uint64_t ticks(double seconds) {
+	return (uint64_t)llround(seconds / RB_TICK_SECONDS);
+}
+
+static void testElapsed() {
+	TEST_CHECK(fabs(UWBRangeBuffer::elapsed(5, RB_TIME_MASK - 5) - 11 * RB_TICK_SECONDS) < 1e-15,
+	           "elapsed across wrap = %g s", UWBRangeBuffer::elapsed(5, RB_TIME_MASK - 5));
+	TEST_CHECK(fabs(UWBRangeBuffer::elapsed(RB_TIME_MASK - 5, 5) + 11 * RB_TICK_SECONDS) < 1e-15,
+	           "negative elapsed across wrap = %g s", UWBRangeBuffer::elapsed(RB_TIME_MASK - 5, 5));
+	uint64_t a = RB_TIME_MASK - ticks(0.3);
+	uint64_t b = (a + ticks(0.7)) & RB_TIME_MASK;
+	TEST_CHECK(fabsf(UWBRangeBuffer::elapsed(b, a) - 0.7f) < 1e-6f, "0.7 s across wrap = %f", UWBRangeBuffer::elapsed(b, a));
+	// 高於 40 bit 的部分不算
+	TEST_CHECK(fabsf(UWBRangeBuffer::elapsed(b | (7ULL << 40), a) - 0.7f) < 1e-6f, "bits above 40 not ignored");
+}
+
+// 參考答案：最近 RB_HISTORY 筆的 double 最小平方，外插到 epoch（斜率一樣夾在 RB_MAX_SPEED）
+struct Sample {
+	uint64_t t;
+	float r;
+};
+
+static double reference(const std::deque<Sample>& s, uint64_t epoch) {
+	const size_t n = s.size();
+	if (n == 1) return s.back().r;
+	double st = 0, sr = 0, stt = 0, str = 0;
+	for (const Sample& x : s) {
+		double t = UWBRangeBuffer::elapsed(x.t, s.back().t);
+		st += t;
+		sr += x.r;
+		stt += t * t;
+		str += t * x.r;
+	}
+	double slope = (n * str - st * sr) / (n * stt - st * st);
+	if (slope > RB_MAX_SPEED) slope = RB_MAX_SPEED;
+	if (slope < -RB_MAX_SPEED) slope = -RB_MAX_SPEED;
+	double te = UWBRangeBuffer::elapsed(epoch, s.back().t);
+	return sr / n + slope * (te - st / n);
+}
+
+static void testRunningSums(uint32_t pushes) {
+	std::mt19937 rng(41);
+	std::uniform_real_distribution<double> gap(0.005, 0.12);
+	std::uniform_real_distribution<float> speed(-3.0f, 3.0f);
+	std::normal_distribution<float> noise(0.0f, 0.05f);
+	UWBRangeBuffer rb;
+	std::deque<Sample> ref[3];
+	float range[3] = {2.0f, 10.0f, 25.0f};
+	float v[3] = {0.5f, -1.0f, 2.0f};
+	uint64_t now = RB_TIME_MASK - ticks(5.0);   // 5 s 後繞回
+	double maxErr = 0;
+	uint32_t bad = 0, badMask = 0;
+	for (uint32_t i = 0; i < pushes; i++) {
+		double dt = gap(rng);
+		now = (now + ticks(dt)) & RB_TIME_MASK;
+		uint8_t slot = (uint8_t)(i % 3);
+		if (rng() % 50 == 0) v[slot] = speed(rng);
+		range[slot] += v[slot] * (float)dt * 3;   // 3 個 slot 輪流，每個 slot 的間隔約是 3 倍
+		if (range[slot] < 0.2f || range[slot] > 30.0f) v[slot] = -v[slot];
+		float r = range[slot] + noise(rng);
+		rb.push(slot, now, r);
+		ref[slot].push_back({now, r});
+		if (ref[slot].size() > RB_HISTORY) ref[slot].pop_front();
+
+		float d[RB_MAX_ANCHORS];
+		uint64_t epoch = (now + ticks(gap(rng) * 0.5)) & RB_TIME_MASK;
+		uint16_t mask = rb.alignTo(epoch, d);
+		if (i >= 2 && mask != 0x07) badMask++;
+		for (uint8_t s = 0; s < 3; s++) {
+			if (!(mask & (1u << s))) continue;
+			double err = fabs(d[s] - reference(ref[s], epoch));
+			if (err > maxErr) maxErr = err;
+			if (err > 2e-3) bad++;
+		}
+	}
+	TEST_CHECK(badMask == 0, "%u alignTo calls dropped a live anchor", badMask);
+	TEST_CHECK(bad == 0, "%u aligned ranges differ from the least-squares reference by > 2 mm (max %.4f m)", bad, maxErr);
+	printf("running sums: %u pushes, max |aligned - reference| = %.2e m\n", pushes, maxErr);
+}
+
+static void testEdges() {
+	UWBRangeBuffer rb;
+	float d[RB_MAX_ANCHORS];
+	const uint64_t t0 = 1000;
+
+	TEST_CHECK(rb.alignTo(t0, d) == 0, "empty buffer returned anchors");
+	TEST_CHECK(!rb.push(RB_MAX_ANCHORS, t0, 1.0f), "slot out of range accepted");
+
+	// 一筆：不外插
+	rb.push(0, t0, 3.0f);
+	TEST_CHECK(rb.alignTo(t0 + ticks(0.2), d) == 0x01 && d[0] == 3.0f, "single sample extrapolated to %f", d[0]);
+
+	// 1 m/s 直線：外插 0.1 s
+	rb.push(0, t0 + ticks(0.1), 3.1f);
+	rb.push(0, t0 + ticks(0.2), 3.2f);
+	rb.alignTo(t0 + ticks(0.3), d);
+	TEST_CHECK(fabsf(d[0] - 3.3f) < 1e-4f, "1 m/s line extrapolated to %f", d[0]);
+
+	// 時間倒退：視窗重來，只剩新的一筆
+	rb.push(0, t0 + ticks(0.15), 5.0f);
+	rb.alignTo(t0 + ticks(0.25), d);
+	TEST_CHECK(d[0] == 5.0f, "window kept after timestamp went backwards (%f)", d[0]);
+
+	// 間隔超過 maxAge：視窗重來
+	rb.push(0, t0 + ticks(0.25), 5.1f);
+	rb.push(0, t0 + ticks(0.25 + RB_DEFAULT_MAX_AGE + 0.1), 9.0f);
+	rb.alignTo(t0 + ticks(0.25 + RB_DEFAULT_MAX_AGE + 0.2), d);
+	TEST_CHECK(d[0] == 9.0f, "window kept across a gap longer than maxAge (%f)", d[0]);
+
+	// 比 epoch 舊超過 maxAge 的 anchor 不給；latest() 是最新的那筆
+	rb.clear();
+	rb.push(1, t0, 4.0f);
+	rb.push(2, t0 + ticks(0.6), 6.0f);
+	TEST_CHECK(rb.latest() == t0 + ticks(0.6), "latest() is not the newest timestamp");
+	TEST_CHECK(rb.alignTo(rb.latest(), d) == 0x04, "stale anchor returned by alignTo");
+	rb.setMaxAge(1.0f);
+	TEST_CHECK(rb.alignTo(rb.latest(), d) == 0x06, "setMaxAge(1.0) did not keep the 0.6 s old anchor");
+	rb.clear(1);
+	TEST_CHECK(rb.alignTo(rb.latest(), d) == 0x04, "clear(slot) left the slot");
+
+	// 20 m/s：斜率夾在 RB_MAX_SPEED，直線仍通過視窗的平均點
+	rb.clear();
+	float sumR = 0.0f;
+	for (int k = 0; k < RB_HISTORY; k++) {
+		rb.push(0, t0 + ticks(0.05 * k), 1.0f + 20.0f * 0.05f * k);
+		sumR += 1.0f + 20.0f * 0.05f * k;
+	}
+	const float tMean = 0.05f * (RB_HISTORY - 1) / 2, te = 0.05f * (RB_HISTORY - 1) + 0.1f;
+	const float want = sumR / RB_HISTORY + RB_MAX_SPEED * (te - tMean);
+	rb.alignTo(t0 + ticks(te), d);
+	TEST_CHECK(fabsf(d[0] - want) < 1e-3f, "slope not clamped: %f, want %f", d[0], want);
+}
+
+// ---- 合成軌跡 ----
+static const float ANCHORS[4][3] = {{0, 0, 0.97f}, {3.99f, 5.44f, 1.14f}, {3.71f, -0.3f, 0.61f}, {-0.56f, 4.88f, 0.15f}};
+
+static void trajectory(int kind, const char* name) {
+	std::mt19937 rng(2);
+	std::normal_distribution<float> noise(0.0f, 0.03f);
+	UWBMultilateration m(2);
+	for (uint8_t i = 0; i < 4; i++) m.setAnchor(i, ANCHORS[i][0], ANCHORS[i][1], ANCHORS[i][2]);
+	UWBRangeBuffer rb;
+	float last[4] = {0};
+	double eLatest = 0, eAligned = 0;
+	uint32_t fixes = 0, badMask = 0;
+	const uint64_t t0 = RB_TIME_MASK - ticks(3.0);   // 3 s 後繞回
+	for (int k = 0; k < 8000; k++) {
+		double ts = k * 0.025;
+		float P[2];
+		if (kind == 0) {
+			P[0] = 2 + 1.5f * (float)cos(ts);
+			P[1] = 2 + 1.5f * (float)sin(ts);
+		} else {
+			double u = fmod(ts, 8.0);
+			P[0] = (float)(u < 4 ? u : 8 - u);
+			P[1] = 2;
+		}
+		int i = k % 4;
+		float dx = ANCHORS[i][0] - P[0], dy = ANCHORS[i][1] - P[1];
+		float d = sqrtf(dx * dx + dy * dy + ANCHORS[i][2] * ANCHORS[i][2]) + noise(rng);
+		last[i] = d;
+		rb.push((uint8_t)i, (t0 + ticks(ts)) & RB_TIME_MASK, d);
+		if (k < 8) continue;
+
+		float p[3], rmse, aligned[RB_MAX_ANCHORS];
+		m.solve(0x0F, last, p, &rmse);
+		eLatest += (p[0] - P[0]) * (p[0] - P[0]) + (p[1] - P[1]) * (p[1] - P[1]);
+		uint16_t mask = rb.alignTo(rb.latest(), aligned);
+		if (mask != 0x0F) {
+			badMask++;
+			continue;
+		}
+		m.solve(mask, aligned, p, &rmse);
+		eAligned += (p[0] - P[0]) * (p[0] - P[0]) + (p[1] - P[1]) * (p[1] - P[1]);
+		fixes++;
+	}
+	double rmsLatest = sqrt(eLatest / fixes), rmsAligned = sqrt(eAligned / fixes);
+	TEST_CHECK(badMask == 0, "%s: %u epochs lost an anchor", name, badMask);
+	TEST_CHECK(rmsAligned < rmsLatest, "%s: aligned %.3f m is not better than latest %.3f m", name, rmsAligned, rmsLatest);
+	printf("%-22s  %12.3f  %12.3f\n", name, rmsLatest, rmsAligned);
+}
+
+int main(int argc, char** argv) {
+	uint32_t pushes = 200000;
+	int opt;
+	while ((opt = getopt(argc, argv, "n:h")) != -1) {
+		switch (opt) {
+			case 'n': pushes = (uint32_t)strtoul(optarg, nullptr, 10); break;
+			default:
+				fprintf(stderr, "usage: %s [-n pushes]\n", argv[0]);
+				return 1;
+		}
+	}
+	testElapsed();
+	testRunningSums(pushes);
+	testEdges();
+
+	printf("trajectory              rms latest m  rms aligned m\n");
+	trajectory(0, "circle 1.5 m/s");
+	trajectory(1, "back-and-forth 1 m/s");
+	return testSummary("UWB_RangeBuffer_Test");
+}
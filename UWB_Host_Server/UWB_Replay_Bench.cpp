@@ -0,0 +1,382 @@
+/*
+ * @file UWB_Replay_Bench.cpp
+ * 錄下來的 ranges.bin 重播：用 BatchTrilat 批次解所有 fix，量 fixes/s，並和逐筆解的結果比對
+ *
+ *   1. 讀 ranges.bin（RangeSample），同一個 (tag, seq) 組成一筆 fix
+ *   2. 依 anchor 組合分組，每組轉成 SoA（d[anchor][fix]）
+ *   3. 每組分別跑 scalar / AVX2，重複 -n 次取總時間；再和 UWBMultilateration 逐筆解比對
+ *   -k：改成依時間順序把每筆 range 餵給各 tag 的 UWBKalman（同 tag 端），量每次更新的時間，
+ *       以及 Kalman 位置和逐筆 LS 解的 RMS 差（錄下來的資料沒有真值，LS 當參考）
+ *   -N：NLOS 判斷評估。每筆 range 用 UWBNlos 分成 LOS / NLOS，每個 fix 分別用
+ *       「線性 LS」「等權 refine」「powerWeight 加權 refine」解。加 -g x,y,z（tag 固定在已知點錄的資料）
+ *       會印兩類 range 相對真實距離的 bias / RMS（看分類有沒有抓到偏長的 range）和三種解的位置誤差；
+ *       沒有 -g 時殘差改用加權解當參考
+ *
+ * 編譯：
+ *   g++ -O2 -std=c++17 -I../DW1000_BACKUP/src_0205 UWB_Replay_Bench.cpp BatchTrilat.cpp \
+ *       ../DW1000_BACKUP/src_0205/UWBMultilateration.cpp ../DW1000_BACKUP/src_0205/UWBKalman.cpp \
+ *       ../DW1000_BACKUP/src_0205/UWBNlos.cpp -o uwb_replay
+ * 執行：
+ *   ./uwb_replay -a anchors.txt -i ranges.bin [-m 3] [-n 20] [-o positions.csv] [-k] [-N [-g x,y,z]]
+ */
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "BatchTrilat.h"
+#include "RangeStream.h"
+#include "UWBKalman.h"
+#include "UWBMultilateration.h"
+#include "UWBNlos.h"
+
+struct Group {
+	std::vector<uint16_t> anchors;            // 依位址排序
+	std::vector<std::vector<float>> d;        // d[i][n]
+	std::vector<uint16_t> tag;
+	std::vector<uint32_t> seq;
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point t0) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static bool loadAnchors(const char* path, std::map<uint16_t, std::vector<float>>* anchors) {
+	FILE* f = fopen(path, "r");
+	if (f == nullptr) return false;
+	char line[256];
+	while (fgets(line, sizeof(line), f)) {
+		if (line[0] == '#' || line[0] == '\n') continue;
+		unsigned id;
+		float x, y, z;
+		if (sscanf(line, "%x %f %f %f", &id, &x, &y, &z) == 4) (*anchors)[(uint16_t)id] = {x, y, z};
+	}
+	fclose(f);
+	return !anchors->empty();
+}
+
+// ===== -k：tag 端 Kalman 重播 =====
+static int runKalman(const char* inPath, const std::map<uint16_t, std::vector<float>>& anchors, int dim) {
+	FILE* in = fopen(inPath, "rb");
+	if (in == nullptr) {
+		perror(inPath);
+		return 1;
+	}
+	UWBMultilateration mlat((uint8_t)dim);
+	std::map<uint16_t, uint8_t> slotOf;
+	for (auto& kv : anchors) {
+		if (slotOf.size() >= MLAT_MAX_ANCHORS) break;
+		uint8_t slot = (uint8_t)slotOf.size();
+		mlat.setAnchor(slot, kv.second[0], kv.second[1], kv.second[2]);
+		slotOf[kv.first] = slot;
+	}
+	struct Track {
+		UWBKalman kf;
+		uint32_t seq = 0;
+		uint16_t mask = 0;
+		float d[MLAT_MAX_ANCHORS];
+		Track(int dim) : kf((uint8_t)dim) {}
+	};
+	std::unordered_map<uint16_t, Track> tracks;
+	size_t updates = 0, rejected = 0, compared = 0;
+	double updateNs = 0.0, err2 = 0.0;
+	RangeSample buf[4096];
+	size_t n;
+	while ((n = fread(buf, sizeof(RangeSample), 4096, in)) > 0) {
+		for (size_t i = 0; i < n; i++) {
+			const RangeSample& s = buf[i];
+			auto a = slotOf.find(s.anchor);
+			if (a == slotOf.end()) continue;
+			Track& t = tracks.emplace(s.tagId, Track(dim)).first->second;
+			const uint32_t ms = (uint32_t)(s.hostNs / 1000000ull);
+			const float range = s.rangeMm / 1000.0f;
+
+			if (s.seq != t.seq && t.mask != 0) {
+				// 上一個 fix 收齊了：LS 解，當參考（還沒初始化就拿來初始化）
+				float p[3], rmse;
+				if (mlat.solve(t.mask, t.d, p, &rmse)) {
+					if (!t.kf.isInitialized() || t.kf.rejectedInRow() >= 8) {
+						t.kf.reset(p, rmse + 0.1f, ms);
+					} else {
+						float k[3];
+						t.kf.getPosition(k);
+						for (int c = 0; c < dim; c++) err2 += (k[c] - p[c]) * (k[c] - p[c]);
+						compared++;
+					}
+				}
+				t.mask = 0;
+			}
+			t.seq = s.seq;
+			t.mask |= (uint16_t)(1u << a->second);
+			t.d[a->second] = range;
+
+			if (t.kf.isInitialized()) {
+				auto t0 = std::chrono::steady_clock::now();
+				bool ok = t.kf.updateRange(mlat.anchor(a->second), range, ms,
+				                           UWBMultilateration::powerWeight(s.rxPower / 100.0f, s.fpPower / 100.0f));
+				updateNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+				updates++;
+				if (!ok) rejected++;
+			}
+		}
+	}
+	fclose(in);
+	printf("tags=%zu updates=%zu rejected=%.2f%%\n", tracks.size(), updates, updates ? 100.0 * rejected / updates : 0.0);
+	printf("kalman update: %.0f ns/range, rms |kalman - LS| = %.3f m over %zu fixes\n",
+	       updates ? updateNs / updates : 0.0, compared ? sqrt(err2 / compared) : 0.0, compared);
+	return 0;
+}
+
+// ===== -N：NLOS 判斷評估 =====
+static int runNlos(const char* inPath, const std::map<uint16_t, std::vector<float>>& anchors, int dim, const float* truth) {
+	FILE* in = fopen(inPath, "rb");
+	if (in == nullptr) {
+		perror(inPath);
+		return 1;
+	}
+	UWBMultilateration mlat((uint8_t)dim);
+	std::map<uint16_t, uint8_t> slotOf;
+	std::vector<uint16_t> addrOf;
+	for (auto& kv : anchors) {
+		if (slotOf.size() >= MLAT_MAX_ANCHORS) break;
+		uint8_t slot = (uint8_t)slotOf.size();
+		mlat.setAnchor(slot, kv.second[0], kv.second[1], kv.second[2]);
+		slotOf[kv.first] = slot;
+		addrOf.push_back(kv.first);
+	}
+	struct Fix {
+		uint32_t seq = 0;
+		uint16_t mask = 0;
+		float d[MLAT_MAX_ANCHORS], w[MLAT_MAX_ANCHORS];
+		bool nlos[MLAT_MAX_ANCHORS];
+	};
+	struct Class {
+		size_t n = 0;
+		double sum = 0.0, sum2 = 0.0;
+	};
+	std::unordered_map<uint16_t, Fix> open;
+	Class cls[2];                                   // [0] LOS, [1] NLOS：range - 參考距離
+	std::vector<size_t> perAnchor(addrOf.size(), 0), perAnchorNlos(addrOf.size(), 0);
+	size_t fixes = 0;
+	double err2[3] = {0.0, 0.0, 0.0};               // LS / 等權 refine / 加權 refine
+	double classifyNs = 0.0;
+	size_t classified = 0;
+	float ones[MLAT_MAX_ANCHORS];
+	for (int i = 0; i < MLAT_MAX_ANCHORS; i++) ones[i] = 1.0f;
+
+	auto close = [&](Fix& f) {
+		float p[3][3], rmse;
+		if (!mlat.solve(f.mask, f.d, p[0], &rmse)) return;
+		if (!mlat.solveRefined(f.mask, f.d, ones, p[1], &rmse)) return;
+		if (!mlat.solveRefined(f.mask, f.d, f.w, p[2], &rmse)) return;
+		fixes++;
+		const float* ref = (truth != nullptr) ? truth : p[2];
+		if (truth != nullptr) {
+			for (int m = 0; m < 3; m++)
+				for (int c = 0; c < dim; c++) err2[m] += (p[m][c] - truth[c]) * (p[m][c] - truth[c]);
+		}
+		for (uint8_t s = 0; s < addrOf.size(); s++) {
+			if (!(f.mask & (1u << s))) continue;
+			const float* a = mlat.anchor(s);
+			float r2 = 0.0f;
+			for (int c = 0; c < 3; c++) {
+				const float dc = (c < dim ? ref[c] : 0.0f) - a[c];
+				r2 += dc * dc;
+			}
+			const double e = f.d[s] - sqrt(r2);
+			Class& k = cls[f.nlos[s] ? 1 : 0];
+			k.n++;
+			k.sum += e;
+			k.sum2 += e * e;
+		}
+	};
+
+	RangeSample buf[4096];
+	size_t n;
+	while ((n = fread(buf, sizeof(RangeSample), 4096, in)) > 0) {
+		for (size_t i = 0; i < n; i++) {
+			const RangeSample& s = buf[i];
+			auto a = slotOf.find(s.anchor);
+			if (a == slotOf.end()) continue;
+			Fix& f = open[s.tagId];
+			if (s.seq != f.seq && f.mask != 0) {
+				close(f);
+				f.mask = 0;
+			}
+			f.seq = s.seq;
+			const uint8_t slot = a->second;
+			const float rx = s.rxPower / 100.0f, fp = s.fpPower / 100.0f;
+			auto t0 = std::chrono::steady_clock::now();
+			f.w[slot] = UWBMultilateration::powerWeight(rx, fp);
+			f.nlos[slot] = UWBNlos::isNlos(rx, fp);
+			classifyNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+			classified++;
+			f.d[slot] = s.rangeMm / 1000.0f;
+			f.mask |= (uint16_t)(1u << slot);
+			perAnchor[slot]++;
+			if (f.nlos[slot]) perAnchorNlos[slot]++;
+		}
+	}
+	for (auto& kv : open)
+		if (kv.second.mask != 0) close(kv.second);
+	fclose(in);
+
+	printf("fixes=%zu ranges=%zu classify %.0f ns/range\n", fixes, classified, classified ? classifyNs / classified : 0.0);
+	for (size_t s = 0; s < addrOf.size(); s++)
+		printf("anchor %X: %zu ranges, NLOS %.1f%%\n", addrOf[s], perAnchor[s],
+		       perAnchor[s] ? 100.0 * perAnchorNlos[s] / perAnchor[s] : 0.0);
+	const char* refName = (truth != nullptr) ? "true distance" : "weighted fix";
+	for (int c = 0; c < 2; c++)
+		printf("%s ranges: %zu, bias vs %s %+.3f m, rms %.3f m\n", c ? "NLOS" : "LOS ", cls[c].n, refName,
+		       cls[c].n ? cls[c].sum / cls[c].n : 0.0, cls[c].n ? sqrt(cls[c].sum2 / cls[c].n) : 0.0);
+	if (truth != nullptr && fixes > 0)
+		printf("position rms error: LS %.3f m, refine %.3f m, weighted refine %.3f m\n",
+		       sqrt(err2[0] / fixes), sqrt(err2[1] / fixes), sqrt(err2[2] / fixes));
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	const char* anchorPath = "anchors.txt";
+	const char* inPath = "ranges.bin";
+	const char* outPath = nullptr;
+	int dim = 3, repeat = 20;
+	bool kalman = false, nlos = false;
+	float truth[3] = {0.0f, 0.0f, 0.0f};
+	bool hasTruth = false;
+	int opt;
+	while ((opt = getopt(argc, argv, "a:i:m:n:o:kNg:h")) != -1) {
+		switch (opt) {
+			case 'a': anchorPath = optarg; break;
+			case 'i': inPath = optarg; break;
+			case 'm': dim = atoi(optarg); break;
+			case 'n': repeat = atoi(optarg); break;
+			case 'o': outPath = optarg; break;
+			case 'k': kalman = true; break;
+			case 'N': nlos = true; break;
+			case 'g': hasTruth = sscanf(optarg, "%f,%f,%f", &truth[0], &truth[1], &truth[2]) >= 2; break;
+			default:
+				fprintf(stderr, "usage: %s -a anchors.txt -i ranges.bin [-m 2|3] [-n repeat] [-o positions.csv] [-k] [-N [-g x,y,z]]\n", argv[0]);
+				return 1;
+		}
+	}
+	std::map<uint16_t, std::vector<float>> anchors;
+	if (!loadAnchors(anchorPath, &anchors)) {
+		fprintf(stderr, "cannot load anchors from %s\n", anchorPath);
+		return 1;
+	}
+	if (kalman) return runKalman(inPath, anchors, dim);
+	if (nlos) return runNlos(inPath, anchors, dim, hasTruth ? truth : nullptr);
+	FILE* in = fopen(inPath, "rb");
+	if (in == nullptr) {
+		perror(inPath);
+		return 1;
+	}
+
+	// ===== 讀檔，組 fix，依 anchor 組合分組 =====
+	std::map<std::vector<uint16_t>, Group> groups;
+	struct Open {
+		uint32_t seq;
+		std::map<uint16_t, float> r;
+	};
+	std::unordered_map<uint16_t, Open> open;
+	size_t samples = 0;
+	auto close = [&](uint16_t tag, const Open& o) {
+		std::vector<uint16_t> key;
+		for (auto& kv : o.r) key.push_back(kv.first);
+		if ((int)key.size() < dim + 1 || (int)key.size() > BATCH_MAX_ANCHORS) return;
+		Group& g = groups[key];
+		if (g.anchors.empty()) {
+			g.anchors = key;
+			g.d.resize(key.size());
+		}
+		size_t i = 0;
+		for (auto& kv : o.r) g.d[i++].push_back(kv.second);
+		g.tag.push_back(tag);
+		g.seq.push_back(o.seq);
+	};
+	RangeSample buf[4096];
+	size_t n;
+	while ((n = fread(buf, sizeof(RangeSample), 4096, in)) > 0) {
+		for (size_t i = 0; i < n; i++) {
+			const RangeSample& s = buf[i];
+			samples++;
+			if (!anchors.count(s.anchor)) continue;
+			auto it = open.find(s.tagId);
+			if (it != open.end() && it->second.seq != s.seq) {
+				close(s.tagId, it->second);
+				open.erase(it);
+				it = open.end();
+			}
+			if (it == open.end()) it = open.emplace(s.tagId, Open{s.seq, {}}).first;
+			it->second.r[s.anchor] = s.rangeMm / 1000.0f;
+		}
+	}
+	for (auto& kv : open) close(kv.first, kv.second);
+	fclose(in);
+
+	// ===== 每組跑 scalar / AVX2，和 UWBMultilateration 比對 =====
+	const bool avx2 = batchTrilatHasAvx2();
+	size_t fixes = 0;
+	double tScalar = 0.0, tAvx2 = 0.0, maxSimdDiff = 0.0, maxRefDiff = 0.0;
+	FILE* out = (outPath != nullptr) ? fopen(outPath, "w") : nullptr;
+	if (out != nullptr) fprintf(out, "tag,seq,x,y,z,rmse\n");
+
+	for (auto& kv : groups) {
+		Group& g = kv.second;
+		const int k = (int)g.anchors.size();
+		const size_t m = g.tag.size();
+		float a[BATCH_MAX_ANCHORS][3];
+		UWBMultilateration ref((uint8_t)dim);
+		for (int i = 0; i < k; i++) {
+			const std::vector<float>& p = anchors.at(g.anchors[i]);
+			a[i][0] = p[0];
+			a[i][1] = p[1];
+			a[i][2] = p[2];
+			ref.setAnchor((uint8_t)i, p[0], p[1], p[2]);
+		}
+		BatchGeometry geom;
+		if (!batchTrilatInit(&geom, a, k, dim)) {
+			fprintf(stderr, "[REPLAY][WARN] singular anchor set (%d anchors, %zu fixes) skipped\n", k, m);
+			continue;
+		}
+		std::vector<const float*> d(k);
+		for (int i = 0; i < k; i++) d[i] = g.d[i].data();
+		std::vector<float> x(m), y(m), z(m), e(m), x2(m), y2(m), z2(m), e2(m);
+
+		auto t0 = std::chrono::steady_clock::now();
+		for (int r = 0; r < repeat; r++) batchTrilatSolveScalar(geom, d.data(), m, x.data(), y.data(), z.data(), e.data());
+		tScalar += secondsSince(t0);
+		t0 = std::chrono::steady_clock::now();
+		for (int r = 0; r < repeat; r++) batchTrilatSolve(geom, d.data(), m, x2.data(), y2.data(), z2.data(), e2.data());
+		tAvx2 += secondsSince(t0);
+
+		MlatFactor f;
+		ref.factorize((uint16_t)((1u << k) - 1), &f);
+		float dd[BATCH_MAX_ANCHORS], p[3], rm;
+		for (size_t j = 0; j < m; j++) {
+			maxSimdDiff = std::max(maxSimdDiff, (double)std::max(std::fabs(x[j] - x2[j]),
+			                                    std::max(std::fabs(y[j] - y2[j]), std::fabs(z[j] - z2[j]))));
+			for (int i = 0; i < k; i++) dd[i] = g.d[i][j];
+			if (ref.solve(f, dd, p, &rm))
+				maxRefDiff = std::max(maxRefDiff, (double)std::max(std::fabs(x[j] - p[0]),
+				                                  std::max(std::fabs(y[j] - p[1]), std::fabs(z[j] - p[2]))));
+			if (out != nullptr)
+				fprintf(out, "%X,%u,%.3f,%.3f,%.3f,%.3f\n", g.tag[j], g.seq[j], x2[j], y2[j], z2[j], e2[j]);
+		}
+		fixes += m;
+	}
+	if (out != nullptr) fclose(out);
+
+	const double total = (double)fixes * repeat;
+	printf("samples=%zu fixes=%zu geometries=%zu dim=%d repeat=%d\n", samples, fixes, groups.size(), dim, repeat);
+	printf("scalar : %.3f s  %.0f fixes/s\n", tScalar, tScalar > 0 ? total / tScalar : 0.0);
+	printf("%s: %.3f s  %.0f fixes/s\n", avx2 ? "avx2  " : "scalar", tAvx2, tAvx2 > 0 ? total / tAvx2 : 0.0);
+	printf("max |scalar - simd| = %.3g m, max |batch - UWBMultilateration| = %.3g m\n", maxSimdDiff, maxRefDiff);
+	return 0;
+}
@@ -0,0 +1,411 @@
+/*
+ * @file UWB_Solver_Service.cpp
+ * host 端定位服務：讀 UWB_Ingest_Server 輸出的 range 串流，多執行緒解出每個 tag 的位置
+ *
+ *   reader    : 依序讀 RangeSample，同一個 (tag, seq) 的 record 組成一組 range；串流依 hostNs 排序，
+ *               同一個 datagram 的 record hostNs 相同，所以讀到更新的 hostNs 時所有還開著的組都已完整，馬上送出
+ *               （-f 時檔案停止成長超過 SOLVER_IDLE_MS 也全部送出，tag 停了最後一組也會解）
+ *   dispatcher: 依 anchor 組合（geometry）分批；每種 geometry 的矩陣只算一次，之後同組 tag 共用
+ *   pool      : work-stealing thread pool，一個工作 = 同一 geometry 的一批 range
+ *
+ * 解算用函式庫的 UWBMultilateration（trilat2D_4A / trilat3D_4A 推廣到 K 個 anchor）：
+ *   每種 anchor 組合 factorize() 一次，MlatFactor 唯讀、多個 worker 共用，每次 solve 只剩三角代換。
+ *
+ * 編譯：
+ *   g++ -O2 -std=c++17 -pthread -I../DW1000_BACKUP/src_0205 UWB_Solver_Service.cpp \
+ *       ../DW1000_BACKUP/src_0205/UWBMultilateration.cpp ../DW1000_BACKUP/src_0205/UWBNlos.cpp -o uwb_solver
+ * 執行：
+ *   ./uwb_solver -a anchors.txt -i ranges.bin -o positions.csv [-f] [-m 3] [-t 8] [-r]
+ *     -f : 持續追檔案尾端（和 uwb_ingest 同時跑）
+ *     -m : 2 = 平面（anchor 的 z 只用在 rmse，同 trilat2D_4A），3 = 3D
+ *     -r : 線性解之後再做加權 Gauss-Newton 精修（權重由 rxPower / fpPower 算，見 UWBMultilateration::refine）
+ *   ./uwb_solver -a anchors.txt -B [-r]     （benchmark：不同 tag 數的 solves/s、p99 延遲、平均迭代次數）
+ * 延遲：從這組第一筆 record 的時間算到解完。-f 時是 hostNs（ingest 收到 datagram，和這裡同一個 CLOCK_MONOTONIC），
+ *   離線讀檔時 hostNs 是過去的時間，改用讀到第一筆的時間。
+ * anchors.txt：每行「anchor短位址(16進位) x y z」，# 開頭為註解，最多 MLAT_MAX_ANCHORS 個
+ */
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "RangeStream.h"
+#include "UWBMultilateration.h"
+#include "WorkStealingPool.h"
+
+#define SOLVER_MAX_ANCHORS 32
+#define SOLVER_BATCH       64      // 一個工作最多幾組 range
+#define SOLVER_BATCH_US    2000    // 一批最多等多久（µs）就送出，避免低流量時延遲變大
+#define SOLVER_IDLE_MS     20      // -f：檔案這麼久沒有新資料，還開著的組全部送出
+
+struct Anchor {
+	double x, y, z;
+};
+
+// 一組 range（同一 tag 同一個 datagram）
+struct RangeSet {
+	uint64_t hostNs;
+	uint64_t startNs;      // 延遲量測的起點：第一筆 record 的時間（見檔頭）
+	uint16_t tagId;
+	uint32_t seq;
+	uint8_t  n;
+	uint16_t anchor[SOLVER_MAX_ANCHORS];
+	double   range[SOLVER_MAX_ANCHORS];
+	float    weight[SOLVER_MAX_ANCHORS];
+	uint16_t mask;                 // push() 換成 solver slot 後填
+	float    d[MLAT_MAX_ANCHORS];
+	float    w[MLAT_MAX_ANCHORS];
+};
+
+struct Fix {
+	uint64_t hostNs;
+	uint16_t tagId;
+	uint32_t seq;
+	float    pos[3];
+	float    rmse;
+};
+
+static uint64_t monoNs() {
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ===== 統計（每個 pool worker 一份，減少競爭） =====
+struct WorkerStats {
+	std::mutex m;
+	std::vector<uint32_t> latencyUs;
+	uint64_t solves = 0;
+	uint64_t iters = 0;            // refine 迭代次數總和
+};
+
+class SolverService {
+public:
+	SolverService(const std::map<uint16_t, Anchor>& anchors, int dim, unsigned threads, FILE* out, bool refine)
+		: _mlat((uint8_t)dim), _refine(refine), _stats(threads), _out(out), _pool(threads) {
+		for (auto& s : _stats) s.reset(new WorkerStats());
+		// anchor 依位址排序給 slot => 同一組 anchor 一定得到同一個 mask
+		uint8_t slot = 0;
+		for (auto& kv : anchors) {
+			if (slot >= MLAT_MAX_ANCHORS) break;
+			_mlat.setAnchor(slot, (float)kv.second.x, (float)kv.second.y, (float)kv.second.z);
+			_slotOf[kv.first] = slot++;
+		}
+	}
+
+	// reader 呼叫：一組完整的 range
+	void push(const RangeSet& rs) {
+		// 只保留已知座標的 anchor
+		RangeSet s = rs;
+		s.mask = 0;
+		for (uint8_t i = 0; i < rs.n; i++) {
+			auto it = _slotOf.find(rs.anchor[i]);
+			if (it == _slotOf.end()) continue;
+			s.mask |= (uint16_t)(1u << it->second);
+			s.d[it->second] = (float)rs.range[i];
+			s.w[it->second] = rs.weight[i];
+		}
+
+		Pending& p = _batches[s.mask];
+		if (!p.factored) {
+			p.factored = true;
+			if (!_mlat.factorize(s.mask, &p.f) && p.f.k >= _mlat.minAnchors())
+				fprintf(stderr, "[SOLVER][WARN] singular anchor set (%u anchors), skipped\n", (unsigned)p.f.k);
+		}
+		if (!p.f.ok) {
+			_skipped++;
+			return;
+		}
+		if (p.sets.empty()) p.firstNs = monoNs();
+		p.sets.push_back(s);
+		if (p.sets.size() >= SOLVER_BATCH) dispatch(p);
+	}
+
+	// 定期呼叫：把等太久的小批次送出
+	void flushAged(bool all) {
+		uint64_t now = monoNs();
+		for (auto& kv : _batches) {
+			Pending& p = kv.second;
+			if (!p.sets.empty() && (all || now - p.firstNs >= SOLVER_BATCH_US * 1000ull)) dispatch(p);
+		}
+	}
+
+	void finish() {
+		flushAged(true);
+		_pool.wait();
+	}
+
+	// 回傳並清除本區間的統計：solves、p50 / p99 延遲（µs）、平均 refine 迭代次數
+	void takeStats(uint64_t* solves, double* p50, double* p99, double* iters) {
+		std::vector<uint32_t> all;
+		uint64_t n = 0, it = 0;
+		for (auto& s : _stats) {
+			std::lock_guard<std::mutex> lk(s->m);
+			n += s->solves;
+			it += s->iters;
+			s->solves = 0;
+			s->iters = 0;
+			all.insert(all.end(), s->latencyUs.begin(), s->latencyUs.end());
+			s->latencyUs.clear();
+		}
+		*solves = n;
+		*iters = n ? (double)it / n : 0.0;
+		*p50 = *p99 = 0.0;
+		if (!all.empty()) {
+			size_t i50 = all.size() / 2, i99 = (size_t)(all.size() * 0.99);
+			if (i99 >= all.size()) i99 = all.size() - 1;
+			std::nth_element(all.begin(), all.begin() + i50, all.end());
+			*p50 = all[i50];
+			std::nth_element(all.begin(), all.begin() + i99, all.end());
+			*p99 = all[i99];
+		}
+	}
+
+	uint64_t skipped() const { return _skipped; }
+	uint64_t steals() const { return _pool.steals(); }
+	size_t geometries() const { return _batches.size(); }
+
+private:
+	struct Pending {
+		MlatFactor f;
+		bool factored = false;
+		std::vector<RangeSet> sets;
+		uint64_t firstNs = 0;
+	};
+
+	void dispatch(Pending& p) {
+		std::shared_ptr<std::vector<RangeSet>> batch(new std::vector<RangeSet>());
+		batch->swap(p.sets);
+		p.sets.reserve(SOLVER_BATCH);
+		const MlatFactor* f = &p.f;   // unordered_map 的元素位址不會變，factor 建好後唯讀
+		_pool.submit([this, batch, f](unsigned worker) {
+			std::vector<Fix> fixes(batch->size());
+			uint64_t iters = 0;
+			for (size_t i = 0; i < batch->size(); i++) {
+				const RangeSet& s = (*batch)[i];
+				fixes[i].hostNs = s.hostNs;
+				fixes[i].tagId = s.tagId;
+				fixes[i].seq = s.seq;
+				_mlat.solve(*f, s.d, fixes[i].pos, &fixes[i].rmse);
+				if (_refine) iters += _mlat.refine(*f, s.d, s.w, fixes[i].pos, &fixes[i].rmse);
+			}
+			uint64_t done = monoNs();
+			{
+				WorkerStats& st = *_stats[worker];
+				std::lock_guard<std::mutex> lk(st.m);
+				st.solves += batch->size();
+				st.iters += iters;
+				for (auto& s : *batch) st.latencyUs.push_back((uint32_t)((done - s.startNs) / 1000));
+			}
+			if (_out != nullptr) {
+				std::lock_guard<std::mutex> lk(_outMutex);
+				for (auto& f : fixes)
+					fprintf(_out, "%llu,%X,%u,%.3f,%.3f,%.3f,%.3f\n", (unsigned long long)f.hostNs, f.tagId,
+					        f.seq, f.pos[0], f.pos[1], f.pos[2], f.rmse);
+			}
+		});
+	}
+
+	UWBMultilateration _mlat;                  // 建構後不再改，worker 只呼叫 const solve() / refine()
+	bool _refine;
+	std::map<uint16_t, uint8_t> _slotOf;       // anchor 短位址 -> solver slot
+	std::vector<std::unique_ptr<WorkerStats>> _stats;
+	std::unordered_map<uint16_t, Pending> _batches;   // key = anchor mask，只有 dispatcher thread 用
+	uint64_t _skipped = 0;
+	FILE* _out;
+	std::mutex _outMutex;
+	WorkStealingPool _pool;   // 放最後：解構時先等工作做完，其他成員才釋放
+};
+
+static bool loadAnchors(const char* path, std::map<uint16_t, Anchor>* anchors) {
+	FILE* f = fopen(path, "r");
+	if (f == nullptr) return false;
+	char line[256];
+	while (fgets(line, sizeof(line), f)) {
+		if (line[0] == '#' || line[0] == '\n') continue;
+		unsigned id;
+		Anchor a;
+		if (sscanf(line, "%x %lf %lf %lf", &id, &a.x, &a.y, &a.z) == 4) (*anchors)[(uint16_t)id] = a;
+	}
+	fclose(f);
+	return !anchors->empty();
+}
+
+// ===== benchmark：模擬 nTags 個 tag，每個 tag 一秒 10 組 range，盡量快地丟進 service =====
+static void runBenchmark(const std::map<uint16_t, Anchor>& anchors, int dim, unsigned threads, bool refine) {
+	std::mt19937 rng(1);
+	std::normal_distribution<double> noise(0.0, 0.05);
+	std::vector<uint16_t> ids;
+	for (auto& kv : anchors) ids.push_back(kv.first);
+	const int tagCounts[] = {100, 1000, 10000, 50000};
+
+	printf("tags,threads,solves_per_s,p50_us,p99_us,iters,geometries,steals\n");
+	for (int nTags : tagCounts) {
+		SolverService svc(anchors, dim, threads, nullptr, refine);
+		const int rounds = std::max(4, 200000 / nTags);
+		uint64_t t0 = monoNs();
+		for (int r = 0; r < rounds; r++) {
+			for (int t = 0; t < nTags; t++) {
+				RangeSet s;
+				s.hostNs = monoNs();
+				s.startNs = s.hostNs;
+				s.tagId = (uint16_t)t;
+				s.seq = (uint32_t)r;
+				double px = (t % 100) * 0.05, py = (t / 100 % 100) * 0.05, pz = 1.0;
+				// 少數 tag 缺一個 anchor（不同 geometry）
+				int skip = (t % 10 == 0 && (int)ids.size() > dim + 1) ? t % (int)ids.size() : -1;
+				s.n = 0;
+				for (int i = 0; i < (int)ids.size(); i++) {
+					if (i == skip) continue;
+					const Anchor& a = anchors.at(ids[i]);
+					s.anchor[s.n] = ids[i];
+					s.range[s.n] = sqrt((a.x - px) * (a.x - px) + (a.y - py) * (a.y - py) + (a.z - pz) * (a.z - pz)) + noise(rng);
+					s.weight[s.n] = 1.0f;
+					s.n++;
+				}
+				svc.push(s);
+			}
+			svc.flushAged(false);
+		}
+		svc.finish();
+		double sec = (double)(monoNs() - t0) / 1e9;
+		uint64_t solves;
+		double p50, p99, iters;
+		svc.takeStats(&solves, &p50, &p99, &iters);
+		printf("%d,%u,%.0f,%.0f,%.0f,%.2f,%zu,%llu\n", nTags, threads, solves / sec, p50, p99, iters, svc.geometries(),
+		       (unsigned long long)svc.steals());
+	}
+}
+
+int main(int argc, char** argv) {
+	const char* anchorPath = "anchors.txt";
+	const char* inPath = "ranges.bin";
+	const char* outPath = nullptr;
+	bool follow = false, bench = false, refine = false;
+	int dim = 3;
+	unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+	int opt;
+	while ((opt = getopt(argc, argv, "a:i:o:fm:t:rBh")) != -1) {
+		switch (opt) {
+			case 'a': anchorPath = optarg; break;
+			case 'i': inPath = optarg; break;
+			case 'o': outPath = optarg; break;
+			case 'f': follow = true; break;
+			case 'm': dim = atoi(optarg); break;
+			case 't': threads = (unsigned)atoi(optarg); break;
+			case 'r': refine = true; break;
+			case 'B': bench = true; break;
+			default:
+				fprintf(stderr, "usage: %s -a anchors.txt [-i ranges.bin] [-o positions.csv] [-f] [-m 2|3] [-t threads] [-r] [-B]\n", argv[0]);
+				return 1;
+		}
+	}
+	if ((dim != 2 && dim != 3) || threads < 1) {
+		fprintf(stderr, "bad -m / -t\n");
+		return 1;
+	}
+	std::map<uint16_t, Anchor> anchors;
+	if (!loadAnchors(anchorPath, &anchors)) {
+		fprintf(stderr, "cannot load anchors from %s\n", anchorPath);
+		return 1;
+	}
+	if (bench) {
+		runBenchmark(anchors, dim, threads, refine);
+		return 0;
+	}
+
+	FILE* in = fopen(inPath, "rb");
+	if (in == nullptr) {
+		perror(inPath);
+		return 1;
+	}
+	FILE* out = nullptr;
+	if (outPath != nullptr) {
+		out = fopen(outPath, "w");
+		if (out == nullptr) {
+			perror(outPath);
+			return 1;
+		}
+		fprintf(out, "host_ns,tag,seq,x,y,z,rmse\n");
+	}
+
+	SolverService svc(anchors, dim, threads, out, refine);
+	std::unordered_map<uint16_t, RangeSet> open;   // 每個 tag 正在組的那一組
+	RangeSample buf[4096];
+	uint64_t lastStats = monoNs(), lastData = lastStats;
+	uint64_t openNs = 0;   // 還開著的組的 hostNs（串流依 hostNs 排序，開著的組 hostNs 都一樣）
+	auto closeAll = [&]() {
+		for (auto& kv : open) svc.push(kv.second);
+		open.clear();
+	};
+	for (;;) {
+		size_t n = fread(buf, sizeof(RangeSample), 4096, in);
+		const uint64_t readNs = monoNs();
+		for (size_t i = 0; i < n; i++) {
+			const RangeSample& r = buf[i];
+			if (r.hostNs != openNs) {
+				closeAll();   // 更新的 datagram：之前的組不會再有 record
+				openNs = r.hostNs;
+			}
+			auto it = open.find(r.tagId);
+			if (it != open.end() && it->second.seq != r.seq) {
+				svc.push(it->second);   // 同一個 tag 換了 seq：上一組已完整
+				open.erase(it);
+				it = open.end();
+			}
+			if (it == open.end()) {
+				RangeSet s;
+				s.hostNs = r.hostNs;
+				s.startNs = follow ? r.hostNs : readNs;
+				s.tagId = r.tagId;
+				s.seq = r.seq;
+				s.n = 0;
+				it = open.emplace(r.tagId, s).first;
+			}
+			RangeSet& s = it->second;
+			if (s.n < SOLVER_MAX_ANCHORS) {
+				s.anchor[s.n] = r.anchor;
+				s.range[s.n] = r.rangeMm / 1000.0;
+				s.weight[s.n] = UWBMultilateration::powerWeight(r.rxPower / 100.0f, r.fpPower / 100.0f);
+				s.n++;
+			}
+		}
+		if (n > 0) {
+			lastData = readNs;
+		} else {
+			if (!follow) break;
+			if (!open.empty() && readNs - lastData >= SOLVER_IDLE_MS * 1000000ull) closeAll();
+			clearerr(in);
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+		svc.flushAged(false);
+
+		uint64_t now = monoNs();
+		if (now - lastStats >= 1000000000ull) {
+			uint64_t solves;
+			double p50, p99, iters;
+			svc.takeStats(&solves, &p50, &p99, &iters);
+			fprintf(stderr, "[SOLVER] solves/s=%.0f p50=%.0fus p99=%.0fus iters=%.2f geometries=%zu skipped=%llu\n",
+			        solves * 1e9 / (double)(now - lastStats), p50, p99, iters, svc.geometries(),
+			        (unsigned long long)svc.skipped());
+			lastStats = now;
+		}
+	}
+	closeAll();
+	svc.finish();
+	if (out != nullptr) fclose(out);
+	fclose(in);
+	return 0;
+}
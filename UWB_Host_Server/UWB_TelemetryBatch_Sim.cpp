@@ -0,0 +1,309 @@
+/*
+ * @file UWB_TelemetryBatch_Sim.cpp
+ * UWBTelemetryBatch（tag 端遙測批次）的 host 模擬：假 socket + 模擬時間，量 callback -> send 的延遲與 jitter
+ *
+ * 模擬 tag 的 loop()：每 LOOP_US 跑一次 batch.due()/flush()，flush 出來的 datagram 交給 FakeSocket
+ * （記錄送出時間、用 uwbTelemetryDecodeHeader 解回來）。newRange() 依 ranging 週期 push，每筆 record 的
+ * rangeMm 放流水號，送出時對回 push 時間 = callback-to-send 延遲。
+ *
+ * 測試：
+ *   1. round flush：4 台 anchor，每個 datagram 剛好一輪 4 筆、anchor 不重複，延遲 <= 一個 loop 週期
+ *   2. size flush：只開 size 條件，每個 datagram 剛好 maxRecords 筆
+ *   3. age flush：只開 age 條件，最舊一筆延遲 <= maxAgeMs + 一個 loop 週期
+ *   4. overflow：loop() 卡住不 flush，push 超過 UWB_BATCH_CAPACITY 筆，丟掉的是最舊的、getDropped 正確，
+ *      之後送出的是最新的 capacity 筆且順序不變
+ *   5. 沒丟包時每筆 record 剛好送一次、順序不變，seq 連續
+ * 另外印不同 flush 設定的延遲（mean / p50 / p99 / max）、延遲 jitter（標準差）與 datagram/s、bytes/s
+ *
+ * 編譯：
+ *   g++ -O2 -std=c++17 -I../DW1000_BACKUP/src_0205 UWB_TelemetryBatch_Sim.cpp \
+ *       ../DW1000_BACKUP/src_0205/UWBTelemetryBatch.cpp ../DW1000_BACKUP/src_0205/UWBTelemetry.cpp -o uwb_telemetrybatch_sim
+ * 執行：
+ *   ./uwb_telemetrybatch_sim [-s 60]（模擬秒數）
+ */
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "HostTest.h"
+#include "UWBTelemetryBatch.h"
+
+#define LOOP_US          1000     // loop() 週期（DW1000Ranging.loop() + 其他工作）
+#define ROUND_US         40000    // 一輪 POLL -> RANGE_REPORT（4 台 anchor 約 25 Hz）
+#define REPORT_GAP_US    3000     // 同一輪裡各 anchor 的 RANGE_REPORT 間隔
+
+struct SentDatagram {
+	uint64_t atUs;
+	uint32_t seq;
+	std::vector<UWBTelemetryRecord> records;
+	size_t bytes;
+};
+
+// 假 socket：只記錄、解碼
+struct FakeSocket {
+	std::vector<SentDatagram> sent;
+	uint32_t badDecode = 0;
+
+	void send(const uint8_t* buf, int len, uint64_t nowUs) {
+		UWBTelemetryHeader h;
+		if (len <= 0 || uwbTelemetryDecodeHeader(buf, (size_t)len, &h) != UWB_TELEM_OK) {
+			badDecode++;
+			return;
+		}
+		SentDatagram d;
+		d.atUs = nowUs;
+		d.seq = h.seq;
+		d.bytes = (size_t)len;
+		for (uint8_t i = 0; i < h.count; i++) {
+			UWBTelemetryRecord r;
+			uwbTelemetryGetRecord(buf, i, &r);
+			d.records.push_back(r);
+		}
+		sent.push_back(d);
+	}
+};
+
+struct Push {
+	uint64_t atUs;
+	uint16_t anchor;
+};
+
+struct SimResult {
+	FakeSocket sock;
+	std::vector<Push> pushes;   // index = rangeMm 流水號
+	uint32_t dropped;
+	uint8_t  pending;
+};
+
+struct SimConfig {
+	uint8_t  anchors;
+	uint8_t  maxRecords;
+	uint16_t maxAgeMs;
+	bool     onRound;
+	bool     roundSize;      // 是否呼叫 setRoundSize(anchors)
+	double   lossRate;       // RANGE_REPORT 遺失機率（這輪少一台）
+	uint64_t stallFromUs;    // loop() 在這段時間不跑（模擬 WiFi 卡住）
+	uint64_t stallToUs;
+};
+
+static SimResult simulate(const SimConfig& c, uint64_t durationUs, uint32_t seed) {
+	SimResult res;
+	UWBTelemetryBatch batch;
+	batch.begin(0x1234);
+	batch.setFlushPolicy(c.maxRecords, c.maxAgeMs, c.onRound);
+	if (c.roundSize) batch.setRoundSize(c.anchors);
+
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> jitter(-300, 300);
+	std::uniform_real_distribution<double> u(0.0, 1.0);
+	uint8_t buf[UWB_TELEM_LEN(UWB_BATCH_CAPACITY)];
+
+	// 事件：RANGE_REPORT push 時間表
+	std::vector<Push> schedule;
+	for (uint64_t round = ROUND_US; round < durationUs; round += ROUND_US) {
+		for (uint8_t a = 0; a < c.anchors; a++) {
+			if (u(rng) < c.lossRate) continue;
+			int64_t t = (int64_t)round + (int64_t)a * REPORT_GAP_US + jitter(rng);
+			schedule.push_back({(uint64_t)t, (uint16_t)(0x1780 + a)});
+		}
+	}
+
+	size_t next = 0;
+	for (uint64_t now = 0; now < durationUs + 1000000; now += LOOP_US) {
+		// 這個 loop 週期內到的 RANGE_REPORT（callback 在 DW1000Ranging.loop() 裡）
+		while (next < schedule.size() && schedule[next].atUs <= now) {
+			UWBTelemetryRecord r;
+			r.anchor = schedule[next].anchor;
+			r.rangeMm = (int32_t)res.pushes.size();
+			r.rxPower = -8000;
+			r.fpPower = -8200;
+			res.pushes.push_back({now, r.anchor});   // callback 在 loop 開頭跑
+			batch.push(&r, (uint32_t)(now / 1000), now * 64);
+			next++;
+		}
+		if (now >= c.stallFromUs && now < c.stallToUs) continue;
+		while (batch.due((uint32_t)(now / 1000))) {
+			int len = batch.flush(buf, sizeof(buf));
+			if (len <= 0) break;
+			res.sock.send(buf, len, now);
+		}
+	}
+	res.dropped = batch.getDropped();
+	res.pending = batch.getPending();
+	return res;
+}
+
+// 每筆 record 的 callback -> send 延遲（us）
+static std::vector<double> latencies(const SimResult& r) {
+	std::vector<double> lat;
+	for (const auto& d : r.sock.sent) {
+		for (const auto& rec : d.records) {
+			lat.push_back((double)(d.atUs - r.pushes[(size_t)rec.rangeMm].atUs));
+		}
+	}
+	return lat;
+}
+
+static double percentile(std::vector<double> v, double p) {
+	if (v.empty()) return 0;
+	std::sort(v.begin(), v.end());
+	return v[(size_t)std::min((double)v.size() - 1, p * (double)(v.size() - 1) + 0.5)];
+}
+
+static void report(const char* name, const SimResult& r, uint64_t durationUs) {
+	std::vector<double> lat = latencies(r);
+	double mean = 0, var = 0;
+	for (double x : lat) mean += x;
+	mean /= std::max<size_t>(lat.size(), 1);
+	for (double x : lat) var += (x - mean) * (x - mean);
+	double sd = std::sqrt(var / std::max<size_t>(lat.size(), 1));
+	size_t bytes = 0;
+	for (const auto& d : r.sock.sent) bytes += d.bytes;
+	double secs = (double)durationUs / 1e6;
+	printf("%-22s %7.2f %7.2f %7.2f %7.2f %7.2f %8.1f %9.0f %6.1f %7u\n", name,
+	       mean / 1000, percentile(lat, 0.5) / 1000, percentile(lat, 0.99) / 1000,
+	       percentile(lat, 1.0) / 1000, sd / 1000,
+	       r.sock.sent.size() / secs, bytes / secs,
+	       r.sock.sent.empty() ? 0.0 : (double)lat.size() / r.sock.sent.size(), r.dropped);
+}
+
+// 沒丟包：每筆剛好一次、順序不變、seq 連續（結束時還在 ring 裡、沒達 flush 條件的不算）
+static bool deliveredInOrder(const SimResult& r) {
+	int32_t expect = 0;
+	uint32_t seq = 0;
+	for (const auto& d : r.sock.sent) {
+		if (d.seq != seq++) return false;
+		for (const auto& rec : d.records) {
+			if (rec.rangeMm != expect++) return false;
+		}
+	}
+	return r.sock.badDecode == 0 && r.dropped == 0 && (size_t)expect + r.pending == r.pushes.size();
+}
+
+static void testRound(uint64_t durationUs) {
+	SimConfig c = {4, 0, 0, true, true, 0.0, 0, 0};
+	SimResult r = simulate(c, durationUs, 1);
+	TEST_CHECK(deliveredInOrder(r), "round: records lost, duplicated or reordered");
+	uint32_t badSize = 0, dupAnchor = 0;
+	for (const auto& d : r.sock.sent) {
+		if (d.records.size() != 4) badSize++;
+		for (size_t i = 0; i < d.records.size(); i++)
+			for (size_t j = i + 1; j < d.records.size(); j++)
+				if (d.records[i].anchor == d.records[j].anchor) dupAnchor++;
+	}
+	TEST_CHECK(badSize == 0, "round: %u datagrams without exactly one round", badSize);
+	TEST_CHECK(dupAnchor == 0, "round: %u repeated anchors inside a datagram", dupAnchor);
+	// 一輪最後一筆在下一次 loop() 就送出
+	uint32_t late = 0;
+	for (const auto& d : r.sock.sent) {
+		const Push& last = r.pushes[(size_t)d.records.back().rangeMm];
+		if (d.atUs - last.atUs > LOOP_US) late++;
+	}
+	TEST_CHECK(late == 0, "round: %u rounds sent later than one loop after completing", late);
+
+	// 有 RANGE_REPORT 遺失：靠「anchor 重複出現」或 age 收尾，不能卡住
+	SimConfig lossy = {4, 0, 100, true, true, 0.1, 0, 0};
+	SimResult rl = simulate(lossy, durationUs, 2);
+	TEST_CHECK(deliveredInOrder(rl), "round with loss: records lost, duplicated or reordered");
+	std::vector<double> lat = latencies(rl);
+	TEST_CHECK(percentile(lat, 1.0) <= 100000 + LOOP_US, "round with loss: max latency %.1f ms", percentile(lat, 1.0) / 1000);
+}
+
+static void testSize(uint64_t durationUs) {
+	SimConfig c = {4, 6, 0, false, false, 0.0, 0, 0};
+	SimResult r = simulate(c, durationUs, 3);
+	TEST_CHECK(deliveredInOrder(r), "size: records lost, duplicated or reordered");
+	uint32_t bad = 0;
+	for (const auto& d : r.sock.sent) {
+		if (d.records.size() != 6) bad++;
+	}
+	TEST_CHECK(bad == 0, "size: %u datagrams not %u records", bad, 6u);
+	TEST_CHECK(r.pending < 6, "size: %u records left pending", r.pending);
+}
+
+static void testAge(uint64_t durationUs) {
+	SimConfig c = {4, 0, 50, false, false, 0.0, 0, 0};
+	SimResult r = simulate(c, durationUs, 4);
+	TEST_CHECK(deliveredInOrder(r), "age: records lost, duplicated or reordered");
+	uint32_t late = 0;
+	for (const auto& d : r.sock.sent) {
+		const Push& first = r.pushes[(size_t)d.records.front().rangeMm];
+		if (d.atUs - first.atUs > 50000 + LOOP_US) late++;
+	}
+	TEST_CHECK(late == 0, "age: %u datagrams whose oldest record waited past 50 ms", late);
+}
+
+static void testOverflow() {
+	// 4 台 anchor、40 ms 一輪：卡 400 ms = 約 40 筆，超過 32 筆容量
+	SimConfig c = {4, 0, 0, true, true, 0.0, 100000, 500000};
+	SimResult r = simulate(c, 1000000, 5);
+	TEST_CHECK(r.dropped > 0, "overflow: nothing dropped during a 400 ms stall");
+	TEST_CHECK(r.sock.badDecode == 0, "overflow: undecodable datagram");
+
+	// 送出的 = 全部 push 扣掉 dropped 筆；丟的是卡住期間最舊的那幾筆
+	size_t sentRecords = 0;
+	std::vector<int32_t> ids;
+	for (const auto& d : r.sock.sent)
+		for (const auto& rec : d.records) ids.push_back(rec.rangeMm);
+	sentRecords = ids.size();
+	TEST_CHECK(sentRecords + r.dropped + r.pending == r.pushes.size(), "overflow: %zu sent + %u dropped + %u pending != %zu pushed",
+	           sentRecords, r.dropped, r.pending, r.pushes.size());
+	bool increasing = true;
+	uint32_t gaps = 0;
+	for (size_t i = 1; i < ids.size(); i++) {
+		if (ids[i] <= ids[i - 1]) increasing = false;
+		if (ids[i] != ids[i - 1] + 1) gaps++;
+	}
+	TEST_CHECK(increasing, "overflow: records reordered");
+	TEST_CHECK(gaps == 1, "overflow: expected one contiguous gap of dropped records, got %u", gaps);
+	// 卡住結束後第一個 datagram 裡應該是最新的資料：gap 之後第一筆的前一筆一定在 stall 中被丟
+	for (size_t i = 1; i < ids.size(); i++) {
+		if (ids[i] != ids[i - 1] + 1) {
+			TEST_CHECK((uint32_t)(ids[i] - ids[i - 1] - 1) == r.dropped, "overflow: gap %d != dropped %u",
+			           ids[i] - ids[i - 1] - 1, r.dropped);
+			TEST_CHECK(r.pushes[(size_t)ids[i] - 1].atUs >= 100000, "overflow: dropped a record pushed before the stall");
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	double seconds = 60;
+	int opt;
+	while ((opt = getopt(argc, argv, "s:h")) != -1) {
+		switch (opt) {
+			case 's': seconds = strtod(optarg, nullptr); break;
+			default:
+				fprintf(stderr, "usage: %s [-s simulated_seconds]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (seconds < 1) seconds = 1;
+	uint64_t durationUs = (uint64_t)(seconds * 1e6);
+
+	testRound(durationUs);
+	testSize(durationUs);
+	testAge(durationUs);
+	testOverflow();
+
+	printf("4 anchors, %d ms/round, loop %d us, %.0f s simulated (latency in ms)\n", ROUND_US / 1000, LOOP_US, seconds);
+	printf("%-22s %7s %7s %7s %7s %7s %8s %9s %6s %7s\n", "policy", "mean", "p50", "p99", "max", "jitter",
+	       "dgram/s", "bytes/s", "rec/dg", "dropped");
+	SimConfig fixed = {4, 0, 100, false, false, 0.0, 0, 0};   // 舊版：固定 100 ms 送一次
+	report("age 100 ms (old)", simulate(fixed, durationUs, 10), durationUs);
+	SimConfig round = {4, 16, 100, true, true, 0.0, 0, 0};    // sketch 預設
+	report("round+16+100ms", simulate(round, durationUs, 10), durationUs);
+	SimConfig lossy = {4, 16, 100, true, true, 0.1, 0, 0};
+	report("round, 10% loss", simulate(lossy, durationUs, 10), durationUs);
+	SimConfig size8 = {4, 8, 0, false, false, 0.0, 0, 0};
+	report("size 8", simulate(size8, durationUs, 10), durationUs);
+	SimConfig stall = {4, 16, 100, true, true, 0.0, 1000000, 1500000};
+	report("round, 500 ms stall", simulate(stall, durationUs, 10), durationUs);
+	return testSummary("UWB_TelemetryBatch_Sim");
+}
@@ -0,0 +1,155 @@
+/*
+ * @file UWB_Telemetry_Test.cpp
+ * UWBTelemetry（tag -> host 二進位遙測）編碼 / 解碼 round trip 測試
+ *
+ *   1. 隨機 header + 0..UWB_TELEM_MAX_RECORDS 筆 record：uwbTelemetryEncode 後 decode，每個欄位相同
+ *      （dwTime 只保留低 40 bit），長度 = UWB_TELEM_LEN(n)；也檢查 PutRecord/PutHeader 逐筆寫的結果和 Encode 一樣
+ *   2. 已知 bytes：little-endian 位置和 UWBTelemetry.h 寫的格式一致
+ *   3. 錯誤碼：太短、magic 不對（舊版 JSON）、版本不對、count 比實際長度多；Encode buffer 不夠回 -1
+ *   4. float 換算：四捨五入、負值、飽和（不會變成 sentinel）、NaN -> UWB_TELEM_RANGE_INVALID / UWB_TELEM_POWER_INVALID
+ *
+ * 編譯：
+ *   g++ -O2 -std=c++17 -I../DW1000_BACKUP/src_0205 UWB_Telemetry_Test.cpp \
+ *       ../DW1000_BACKUP/src_0205/UWBTelemetry.cpp -o uwb_telemetry_test
+ * 執行：
+ *   ./uwb_telemetry_test [-n 100000]
+ */
+
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "HostTest.h"
+#include "UWBTelemetry.h"
+
+static bool sameRecord(const UWBTelemetryRecord& a, const UWBTelemetryRecord& b) {
+	return a.anchor == b.anchor && a.rangeMm == b.rangeMm && a.rxPower == b.rxPower && a.fpPower == b.fpPower;
+}
+
+static void testRoundTrip(uint32_t iters) {
+	std::mt19937_64 rng(33);
+	static UWBTelemetryRecord in[UWB_TELEM_MAX_RECORDS];
+	static uint8_t buf[UWB_TELEM_LEN(UWB_TELEM_MAX_RECORDS)];
+	static uint8_t put[UWB_TELEM_LEN(UWB_TELEM_MAX_RECORDS)];
+	uint32_t badLen = 0, badHeader = 0, badRecord = 0, badPut = 0;
+	for (uint32_t it = 0; it < iters; it++) {
+		// 大部分是 tag 實際的筆數，偶爾測到 255
+		uint8_t n = (it % 97 == 0) ? UWB_TELEM_MAX_RECORDS : (uint8_t)(rng() % 17);
+		UWBTelemetryHeader h;
+		h.version = UWB_TELEM_VERSION;
+		h.count = 0;   // Encode 會用 n 蓋掉
+		h.tagId = (uint16_t)rng();
+		h.seq = (uint32_t)rng();
+		h.dwTime = rng();   // 高 24 bit 應被丟掉
+		h.flags = (uint8_t)rng();
+		for (uint8_t i = 0; i < n; i++) {
+			in[i].anchor = (uint16_t)rng();
+			in[i].rangeMm = (int32_t)(uint32_t)rng();
+			in[i].rxPower = (int16_t)(uint16_t)rng();
+			in[i].fpPower = (int16_t)(uint16_t)rng();
+		}
+		int len = uwbTelemetryEncode(&h, in, n, buf, sizeof(buf));
+		if (len != UWB_TELEM_LEN(n)) {
+			badLen++;
+			continue;
+		}
+
+		UWBTelemetryHeader out;
+		if (uwbTelemetryDecodeHeader(buf, (size_t)len, &out) != UWB_TELEM_OK
+		    || out.version != UWB_TELEM_VERSION || out.count != n || out.tagId != h.tagId || out.seq != h.seq
+		    || out.dwTime != (h.dwTime & 0xFFFFFFFFFFULL) || out.flags != h.flags) {
+			badHeader++;
+		}
+		for (uint8_t i = 0; i < n; i++) {
+			UWBTelemetryRecord r;
+			uwbTelemetryGetRecord(buf, i, &r);
+			if (!sameRecord(r, in[i])) badRecord++;
+		}
+
+		// tag 邊收邊填的寫法要產生一樣的 bytes
+		for (uint8_t i = 0; i < n; i++) uwbTelemetryPutRecord(put, i, &in[i]);
+		h.count = n;
+		uwbTelemetryPutHeader(put, &h);
+		if (memcmp(put, buf, (size_t)len) != 0) badPut++;
+	}
+	TEST_CHECK(badLen == 0, "%u encodes returned the wrong length", badLen);
+	TEST_CHECK(badHeader == 0, "%u headers did not round trip", badHeader);
+	TEST_CHECK(badRecord == 0, "%u records did not round trip", badRecord);
+	TEST_CHECK(badPut == 0, "%u PutRecord/PutHeader datagrams differ from Encode", badPut);
+}
+
+static void testLayout() {
+	UWBTelemetryHeader h = {UWB_TELEM_VERSION, 0, 0x1786, 0x01020304, 0xAA0504030201ULL, 0x5A};
+	UWBTelemetryRecord r = {0xA1B2, -2, -8012, 300};
+	uint8_t buf[UWB_TELEM_LEN(1)];
+	TEST_CHECK(uwbTelemetryEncode(&h, &r, 1, buf, sizeof(buf)) == 26, "1-record datagram is not 26 bytes");
+	const uint8_t want[26] = {
+		'U', 'W', UWB_TELEM_VERSION, 1, 0x86, 0x17, 0x04, 0x03, 0x02, 0x01, 0x01, 0x02, 0x03, 0x04, 0x05, 0x5A,
+		0xB2, 0xA1, 0xFE, 0xFF, 0xFF, 0xFF, 0xB4, 0xE0, 0x2C, 0x01,
+	};
+	TEST_CHECK(memcmp(buf, want, sizeof(want)) == 0, "datagram bytes differ from the documented layout");
+	TEST_CHECK(UWB_TELEM_LEN(3) == 46, "3 anchors = %d bytes", UWB_TELEM_LEN(3));
+}
+
+static void testErrors() {
+	UWBTelemetryHeader h = {UWB_TELEM_VERSION, 0, 1, 2, 3, 0};
+	UWBTelemetryRecord r[2] = {{1, 1000, -8000, -8100}, {2, 2000, -8200, -8300}};
+	uint8_t buf[UWB_TELEM_LEN(2)];
+	UWBTelemetryHeader out;
+
+	TEST_CHECK(uwbTelemetryEncode(&h, r, 2, buf, sizeof(buf) - 1) == -1, "encode into a short buffer");
+	TEST_CHECK(uwbTelemetryEncode(&h, r, 2, NULL, sizeof(buf)) == -1, "encode into NULL");
+	int len = uwbTelemetryEncode(&h, r, 2, buf, sizeof(buf));
+
+	TEST_CHECK(uwbTelemetryDecodeHeader(buf, UWB_TELEM_HEADER_LEN - 1, &out) == UWB_TELEM_ERR_SHORT, "short header");
+	TEST_CHECK(uwbTelemetryDecodeHeader(buf, (size_t)len - 1, &out) == UWB_TELEM_ERR_SHORT, "count larger than datagram");
+	TEST_CHECK(uwbTelemetryDecodeHeader(buf, (size_t)len, &out) == UWB_TELEM_OK, "valid datagram rejected");
+
+	const char json[] = "{\"links\":[{\"A\":\"1786\",\"R\":\"1.234\"}]}";
+	TEST_CHECK(uwbTelemetryDecodeHeader((const uint8_t*)json, sizeof(json) - 1, &out) == UWB_TELEM_ERR_MAGIC,
+	           "JSON accepted as telemetry");
+	buf[2] = UWB_TELEM_VERSION + 1;
+	TEST_CHECK(uwbTelemetryDecodeHeader(buf, (size_t)len, &out) == UWB_TELEM_ERR_VERSION, "unknown version accepted");
+}
+
+static void testConversions() {
+	TEST_CHECK(uwbTelemetryMeterToMm(1.2344f) == 1234, "1.2344 m");
+	TEST_CHECK(uwbTelemetryMeterToMm(1.2346f) == 1235, "1.2346 m");
+	TEST_CHECK(uwbTelemetryMeterToMm(-0.0126f) == -13, "-0.0126 m");
+	TEST_CHECK(uwbTelemetryMeterToMm(0.0f) == 0, "0 m");
+	TEST_CHECK(uwbTelemetryMeterToMm(1e9f) == INT32_MAX, "large range not saturated");
+	TEST_CHECK(uwbTelemetryMeterToMm(-1e9f) == INT32_MIN + 1, "large negative range not saturated");
+	TEST_CHECK(uwbTelemetryMeterToMm(INFINITY) == INT32_MAX && uwbTelemetryMeterToMm(-INFINITY) == INT32_MIN + 1,
+	           "infinite range not saturated");
+	TEST_CHECK(uwbTelemetryMeterToMm(NAN) == UWB_TELEM_RANGE_INVALID, "NaN range -> %d", uwbTelemetryMeterToMm(NAN));
+	TEST_CHECK(uwbTelemetryDbmToCenti(-80.126f) == -8013, "-80.126 dBm -> %d", uwbTelemetryDbmToCenti(-80.126f));
+	TEST_CHECK(uwbTelemetryDbmToCenti(5.004f) == 500, "5.004 dBm");
+	TEST_CHECK(uwbTelemetryDbmToCenti(-400.0f) == INT16_MIN + 1, "-400 dBm not saturated");
+	TEST_CHECK(uwbTelemetryDbmToCenti(400.0f) == INT16_MAX, "400 dBm not saturated");
+	TEST_CHECK(uwbTelemetryDbmToCenti(-327.675f) == INT16_MIN + 1, "-327.675 dBm -> %d", uwbTelemetryDbmToCenti(-327.675f));
+	TEST_CHECK(uwbTelemetryDbmToCenti(NAN) == UWB_TELEM_POWER_INVALID, "NaN power -> %d", uwbTelemetryDbmToCenti(NAN));
+}
+
+int main(int argc, char** argv) {
+	uint32_t iters = 100000;
+	int opt;
+	while ((opt = getopt(argc, argv, "n:h")) != -1) {
+		switch (opt) {
+			case 'n': iters = (uint32_t)strtoul(optarg, nullptr, 10); break;
+			default:
+				fprintf(stderr, "usage: %s [-n datagrams]\n", argv[0]);
+				return 1;
+		}
+	}
+	testRoundTrip(iters);
+	testLayout();
+	testErrors();
+	testConversions();
+	return testSummary("UWB_Telemetry_Test");
+}
@@ -0,0 +1,126 @@
+/*
+ * @file UWB_XtalTrim_Sim.cpp
+ * UWBXtalTrim（crystal trim 自動調整）的收斂模擬
+ *
+ * 模型：量到的 reference 相對自己 ppm = base + k * x + 0.02 * k * x * |x|（x = trim - 16，有一點非線性），
+ * 每筆加 -s ppm 的高斯雜訊（carrier integrator 單筆的雜訊），reference 每秒 -r 筆。
+ *
+ * 測試：
+ *   1. 8 種 crystal（初始偏差 -18..+30 ppm，斜率 1.1..2.2 ppm/格，含斜率反向、從 trim 0 開始）：
+ *      -t 秒內 lock（預設 = 120 筆的時間，10 筆/秒時 12 s）、lock 後的殘差和 0..31 裡最好的 trim 差不到 0.05 ppm 且在 XTAL_TRIM_EXIT_PPM 以內、只寫回一次
+ *   2. hysteresis：lock 後 10 分鐘慢慢漂 0.5 ppm（0.3 -> 0.8），不重新調
+ *   3. store() / load() 來回（host 用 XTAL_TRIM_FILE，編譯時指到另一個檔案，不蓋掉真的設定）
+ *
+ * 編譯：
+ *   g++ -O2 -std=c++17 -I../DW1000_BACKUP/src_0205 -DXTAL_TRIM_FILE='"uwb_xtal_trim_sim.bin"' \
+ *       UWB_XtalTrim_Sim.cpp ../DW1000_BACKUP/src_0205/UWBXtalTrim.cpp -o uwb_xtal_trim_sim
+ * 執行：
+ *   ./uwb_xtal_trim_sim [-r 10] [-s 0.3] [-t max_lock_s]
+ */
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "HostTest.h"
+#include "UWBXtalTrim.h"
+
+#define SIM_SECONDS 600   // 每個 case 模擬 10 分鐘
+
+static double model(double base, double k, int trim) {
+	const double x = trim - XTAL_TRIM_DEFAULT;
+	return base + k * x + 0.02 * k * x * fabs(x);
+}
+
+struct Crystal {
+	double base;   // trim = 16 時的 ppm
+	double k;      // ppm / 格
+	int    start;  // 開機時的 trim
+};
+
+static void simulate(const Crystal& c, double rate, double noise, double maxLock, std::mt19937& rng) {
+	std::normal_distribution<double> nz(0.0, noise);
+	UWBXtalTrim t;
+	t.begin((uint8_t)c.start);
+	int trim = c.start, changes = 0, stores = 0;
+	double tLock = -1.0;
+	const int n = (int)(SIM_SECONDS * rate);
+	for (int i = 0; i < n; i++) {
+		if (t.update((float)(model(c.base, c.k, trim) + nz(rng)))) {
+			trim = t.trim();
+			changes++;
+		}
+		if (t.storeIfChanged()) stores++;
+		if (tLock < 0.0 && t.isLocked()) tLock = i / rate;
+	}
+	double best = 1e9;
+	for (int k = 0; k <= XTAL_TRIM_MAX; k++) best = std::min(best, fabs(model(c.base, c.k, k)));
+	const double residual = fabs(model(c.base, c.k, trim));
+	printf("base %+5.1f ppm slope %+.1f start %2d: lock %5.1f s, %d trim changes, final trim %2d, "
+	       "residual %.2f ppm (best %.2f), est slope %+.2f, stores %d\n",
+	       c.base, c.k, c.start, tLock, changes, trim, residual, best, t.ppmPerStep(), stores);
+	TEST_CHECK(tLock >= 0.0 && tLock <= maxLock, "base %+.1f: lock %.1f s", c.base, tLock);
+	TEST_CHECK(residual <= best + 0.05 && residual <= XTAL_TRIM_EXIT_PPM, "base %+.1f: residual %.2f ppm (best %.2f)", c.base,
+	           residual, best);
+	TEST_CHECK(stores == 1, "base %+.1f: stored %d times", c.base, stores);
+}
+
+static void simulateDrift(double rate, double noise, std::mt19937& rng) {
+	std::normal_distribution<double> nz(0.0, noise);
+	UWBXtalTrim t;
+	t.begin(XTAL_TRIM_DEFAULT);
+	int trim = XTAL_TRIM_DEFAULT, changes = 0;
+	const int n = (int)(SIM_SECONDS * rate);
+	for (int i = 0; i < n; i++) {
+		const double drift = 0.5 * i / n;
+		if (t.update((float)(model(0.3 + drift, 1.5, trim) + nz(rng)))) {
+			trim = t.trim();
+			changes++;
+		}
+	}
+	printf("drift 0.3 -> 0.8 ppm: %d trim changes, locked %d\n", changes, t.isLocked());
+	TEST_CHECK(changes == 0 && t.isLocked(), "drift inside hysteresis: %d changes, locked %d", changes, t.isLocked());
+}
+
+static void testStore() {
+	uint8_t v = 0xFF;
+	TEST_CHECK(UWBXtalTrim::store(21), "store() failed (%s)", XTAL_TRIM_FILE);
+	TEST_CHECK(UWBXtalTrim::load(&v) && v == 21, "load() gave %u", v);
+	UWBXtalTrim t;
+	t.begin(21, true);
+	for (int i = 0; i < 100; i++) t.update(0.0f);
+	TEST_CHECK(t.isLocked() && !t.storeIfChanged(), "storeIfChanged() wrote an unchanged trim");
+	remove(XTAL_TRIM_FILE);
+	TEST_CHECK(!UWBXtalTrim::load(&v), "load() without a file returned true");
+}
+
+int main(int argc, char** argv) {
+	double rate = 10.0, noise = 0.3, maxLock = -1.0;
+	int opt;
+	while ((opt = getopt(argc, argv, "r:s:t:h")) != -1) {
+		switch (opt) {
+			case 'r': rate = strtod(optarg, nullptr); break;
+			case 's': noise = strtod(optarg, nullptr); break;
+			case 't': maxLock = strtod(optarg, nullptr); break;
+			default:
+				fprintf(stderr, "usage: %s [-r packets_per_s] [-s noise_ppm] [-t max_lock_s]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (rate <= 0.0) rate = 10.0;
+	if (maxLock < 0.0) maxLock = 120.0 / rate;   // 收斂看的是筆數（視窗 16 筆）
+	std::mt19937 rng(5);
+	const Crystal cases[] = {
+		{12.0, 1.5, 16}, {-18.0, 1.5, 16}, {20.0, 1.1, 16}, {-9.0, 2.2, 16},
+		{7.0, -1.5, 16}, {30.0, 1.5, 0},   {-3.0, 1.5, 16}, {0.5, 1.5, 16},
+	};
+	for (const Crystal& c : cases) simulate(c, rate, noise, maxLock, rng);
+	simulateDrift(rate, noise, rng);
+	testStore();
+	return testSummary("UWB_XtalTrim_Sim");
+}
@@ -0,0 +1,119 @@
+/*
+ * @file WorkStealingPool.h
+ * 簡單的 work-stealing thread pool（host 端 solver 用）
+ *
+ * - 每個 worker 有自己的 deque：自己從尾端拿（LIFO，cache 比較熱），別人從頭端偷（FIFO，偷大塊的舊工作）
+ * - submit() 從 pool 外面丟進來的工作以 round-robin 分到各 worker
+ * - deque 用很短的 mutex 保護；工作本身是一批 solve（數十 µs），鎖的成本可忽略
+ */
+
+#ifndef _WorkStealingPool_H_INCLUDED
+#define _WorkStealingPool_H_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool {
+public:
+	typedef std::function<void(unsigned worker)> Task;
+
+	explicit WorkStealingPool(unsigned threads) : _queues(threads) {
+		for (unsigned i = 0; i < threads; i++) _queues[i].reset(new Queue());
+		for (unsigned i = 0; i < threads; i++) _threads.emplace_back(&WorkStealingPool::run, this, i);
+	}
+
+	~WorkStealingPool() {
+		wait();
+		{
+			std::lock_guard<std::mutex> lk(_sleepMutex);
+			_stop = true;
+		}
+		_sleepCv.notify_all();
+		for (auto& t : _threads) t.join();
+	}
+
+	unsigned size() const { return (unsigned)_queues.size(); }
+
+	void submit(Task task) {
+		unsigned i = _next.fetch_add(1, std::memory_order_relaxed) % size();
+		_pending.fetch_add(1, std::memory_order_acq_rel);
+		{
+			std::lock_guard<std::mutex> lk(_queues[i]->m);
+			_queues[i]->q.push_back(std::move(task));
+		}
+		_sleepCv.notify_one();
+	}
+
+	// 等到目前所有工作做完
+	void wait() {
+		std::unique_lock<std::mutex> lk(_sleepMutex);
+		_idleCv.wait(lk, [this] { return _pending.load(std::memory_order_acquire) == 0; });
+	}
+
+	uint64_t steals() const { return _steals.load(std::memory_order_relaxed); }
+
+private:
+	struct Queue {
+		std::mutex m;
+		std::deque<Task> q;
+	};
+
+	bool popLocal(unsigned i, Task& out) {
+		std::lock_guard<std::mutex> lk(_queues[i]->m);
+		if (_queues[i]->q.empty()) return false;
+		out = std::move(_queues[i]->q.back());
+		_queues[i]->q.pop_back();
+		return true;
+	}
+
+	bool steal(unsigned self, Task& out) {
+		for (unsigned k = 1; k < size(); k++) {
+			unsigned v = (self + k) % size();
+			std::lock_guard<std::mutex> lk(_queues[v]->m);
+			if (!_queues[v]->q.empty()) {
+				out = std::move(_queues[v]->q.front());
+				_queues[v]->q.pop_front();
+				_steals.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void run(unsigned self) {
+		for (;;) {
+			Task task;
+			if (popLocal(self, task) || steal(self, task)) {
+				task(self);
+				if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+					std::lock_guard<std::mutex> lk(_sleepMutex);
+					_idleCv.notify_all();
+				}
+				continue;
+			}
+			std::unique_lock<std::mutex> lk(_sleepMutex);
+			if (_stop) return;
+			// 有 pending 但還沒搶到：短暫等待後再掃一次（避免漏掉 notify）
+			_sleepCv.wait_for(lk, std::chrono::milliseconds(1));
+			if (_stop) return;
+		}
+	}
+
+	std::vector<std::unique_ptr<Queue>> _queues;
+	std::vector<std::thread> _threads;
+	std::atomic<unsigned> _next{0};
+	std::atomic<int64_t> _pending{0};
+	std::atomic<uint64_t> _steals{0};
+	std::mutex _sleepMutex;
+	std::condition_variable _sleepCv;
+	std::condition_variable _idleCv;
+	bool _stop = false;
+};
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ * @file Arduino.h
+ * Host 測試用的最小 Arduino API（只有 library 用到的部分），讓 link.cpp / DW1000.cpp 等可以在 PC 上編譯
+ *
+ * - String：和 Arduino WString 一樣放在 heap，長度不夠時 realloc 成剛好的大小；
+ *   每次配置記在 hostStringAllocs（量 String 版 make_link_json 的配置次數用）
+ * - Serial：預設不輸出，hostSerialEcho = true 時印到 stdout
+ * - millis() / micros()：回傳 hostMicros（測試自己推進時間）
+ * - SPI / digitalWrite：轉給 hostSpiTransfer / hostPinWrite（見 SPI.h），用來模擬 DW1000 暫存器
+ *
+ * 實作在 HostArduino.cpp，編譯時加 -Ihost_arduino host_arduino/HostArduino.cpp
+ */
+
+#ifndef _HostArduino_H_INCLUDED
+#define _HostArduino_H_INCLUDED
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+#define HEX 16
+#define DEC 10
+
+#define LOW    0
+#define HIGH   1
+#define INPUT  0
+#define OUTPUT 1
+#define RISING 3
+
+#define bitSet(v, b)   ((v) |= (1UL << (b)))
+#define bitClear(v, b) ((v) &= ~(1UL << (b)))
+#define bitRead(v, b)  (((v) >> (b)) & 1)
+
+template<class T> T constrain(T x, T lo, T hi) { return x < lo ? lo : (x > hi ? hi : x); }
+
+extern unsigned long hostStringAllocs;   // String 的 malloc/realloc 次數
+extern bool          hostSerialEcho;     // Serial 是否印到 stdout
+extern uint64_t      hostMicros;         // millis() / micros() 的時間來源
+
+class String {
+public:
+	String() : _buf(nullptr), _len(0), _cap(0) {}
+	String(const char* s) : String() { copy(s, s ? strlen(s) : 0); }
+	String(const String& s) : String() { copy(s._buf, s._len); }
+	explicit String(int v) : String() { char t[12]; snprintf(t, sizeof(t), "%d", v); copy(t, strlen(t)); }
+	~String() { free(_buf); }
+
+	String& operator=(const String& s) { if (this != &s) copy(s._buf, s._len); return *this; }
+	String& operator=(const char* s) { copy(s, s ? strlen(s) : 0); return *this; }
+	String& operator+=(const String& s) { return concat(s._buf, s._len); }
+	String& operator+=(const char* s) { return concat(s, s ? strlen(s) : 0); }
+	String& operator+=(char c) { return concat(&c, 1); }
+	String& concat(char c) { return concat(&c, 1); }
+
+	bool reserve(unsigned size);
+	unsigned length() const { return _len; }
+	const char* c_str() const { return _buf ? _buf : ""; }
+	char charAt(unsigned i) const { return i < _len ? _buf[i] : 0; }
+	char operator[](unsigned i) const { return charAt(i); }
+	void remove(unsigned index) { if (index < _len) { _len = index; _buf[_len] = '\0'; } }
+	void getBytes(unsigned char* out, unsigned size) const;
+
+private:
+	char*    _buf;
+	unsigned _len;
+	unsigned _cap;
+
+	void copy(const char* s, unsigned n);
+	String& concat(const char* s, unsigned n);
+};
+
+class Print;
+class Printable {
+public:
+	virtual ~Printable() {}
+	virtual size_t printTo(Print& p) const = 0;
+};
+
+class Print {
+public:
+	size_t print(const char* s);
+	size_t print(const String& s) { return print(s.c_str()); }
+	size_t print(char c) { char t[2] = {c, 0}; return print(t); }
+	size_t print(unsigned char v, int base = DEC) { return print((unsigned long)v, base); }
+	size_t print(int v, int base = DEC) { return print((long)v, base); }
+	size_t print(unsigned int v, int base = DEC) { return print((unsigned long)v, base); }
+	size_t print(long v, int base = DEC);
+	size_t print(unsigned long v, int base = DEC);
+	size_t print(long long v, int base = DEC) { return print((long)v, base); }
+	size_t print(unsigned long long v, int base = DEC) { return print((unsigned long)v, base); }
+	size_t print(double v, int digits = 2);
+	size_t print(const Printable& p) { return p.printTo(*this); }
+	size_t println() { return print("\n"); }
+	template<class T> size_t println(T v) { size_t n = print(v); return n + println(); }
+	template<class T> size_t println(T v, int f) { size_t n = print(v, f); return n + println(); }
+	size_t write(uint8_t c) { return print((char)c); }
+};
+
+class HardwareSerial : public Print {
+public:
+	void begin(unsigned long) {}
+};
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+	uint32_t getCycleCount() { return (uint32_t)(hostMicros * 240); }
+	uint32_t getFreeHeap() { return 0; }
+};
+extern EspClass ESP;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int  digitalRead(int pin);
+int  digitalPinToInterrupt(int pin);
+void attachInterrupt(int irq, void (*isr)(), int mode);
+int  analogRead(int pin);
+
+long random(long hi);
+long random(long lo, long hi);
+void randomSeed(unsigned long seed);
+
+#endif
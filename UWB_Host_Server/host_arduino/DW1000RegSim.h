@@ -0,0 +1,124 @@
+/*
+ * @file DW1000RegSim.h
+ * Host 測試用的 DW1000 暫存器模擬：接在 hostSpiTransfer / hostPinWrite 上，DW1000.cpp 讀寫的就是 dwSimRegs
+ *
+ * - SPI header 解碼：第 1 byte = 寫入 bit(7) + sub-index bit(6) + register(5..0)，
+ *   有 sub-index 時第 2 byte 是 offset 低 7 bits（bit 7 = 還有第 3 byte），第 3 byte 是 offset 的高 8 bits
+ * - 任何 pin 拉低（CS）= 新的交易
+ * - ACC_MEM（0x25）每次讀取的第一個 byte 是 dummy（和晶片一樣），之後才是 offset 開始的資料
+ * - SYS_STATUS（0x0F）寫 1 清除
+ * - 每次交易記在 dwSimLog（register、offset、讀 / 寫、byte 數、前 8 個 byte）
+ *
+ * 只有 header，一個測試程式 include 一次；開始前呼叫 dwSimInstall()。
+ */
+
+#ifndef _DW1000RegSim_H_INCLUDED
+#define _DW1000RegSim_H_INCLUDED
+
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+#include "SPI.h"
+
+#define DW_SIM_REG_BYTES 4104   // ACC_MEM：1016 * 4 + dummy，留一點餘裕
+
+struct DwSimAccess {
+	uint8_t  reg;
+	uint16_t off;
+	bool     write;
+	uint16_t len;       // 資料 byte 數（不含 header；ACC_MEM 讀取含 dummy）
+	uint8_t  data[8];   // 前 8 個資料 byte
+};
+
+static uint8_t dwSimRegs[64][DW_SIM_REG_BYTES];
+static std::vector<DwSimAccess> dwSimLog;
+
+static struct {
+	uint8_t  state;   // 0 = header，1 = sub-index，2 = extended，3 = 資料
+	uint8_t  reg;
+	bool     write;
+	uint16_t off;
+	bool     dummy;   // ACC_MEM 的 dummy byte 還沒送
+} dwSimBus;
+
+static inline uint8_t dwSimSpi(uint8_t b) {
+	if (dwSimBus.state != 3) {
+		switch (dwSimBus.state) {
+			case 0:
+				dwSimBus.reg = b & 0x3F;
+				dwSimBus.write = (b & 0x80) != 0;
+				dwSimBus.off = 0;
+				dwSimBus.dummy = !dwSimBus.write && dwSimBus.reg == 0x25;
+				dwSimBus.state = (b & 0x40) ? 1 : 3;
+				break;
+			case 1:
+				dwSimBus.off = b & 0x7F;
+				dwSimBus.state = (b & 0x80) ? 2 : 3;
+				break;
+			case 2:
+				dwSimBus.off |= (uint16_t)b << 7;
+				dwSimBus.state = 3;
+				break;
+		}
+		if (dwSimBus.state == 3) {
+			DwSimAccess a = {dwSimBus.reg, dwSimBus.off, dwSimBus.write, 0, {0}};
+			dwSimLog.push_back(a);
+		}
+		return 0;
+	}
+
+	DwSimAccess& a = dwSimLog.back();
+	uint8_t out = 0;
+	if (dwSimBus.write) {
+		if (dwSimBus.off < DW_SIM_REG_BYTES) {
+			if (dwSimBus.reg == 0x0F) dwSimRegs[0x0F][dwSimBus.off] &= (uint8_t)~b;
+			else dwSimRegs[dwSimBus.reg][dwSimBus.off] = b;
+		}
+		dwSimBus.off++;
+		out = b;
+	} else if (dwSimBus.dummy) {
+		dwSimBus.dummy = false;
+		out = 0xA5;
+	} else {
+		out = dwSimBus.off < DW_SIM_REG_BYTES ? dwSimRegs[dwSimBus.reg][dwSimBus.off] : 0;
+		dwSimBus.off++;
+	}
+	if (a.len < 8) a.data[a.len] = out;
+	a.len++;
+	return dwSimBus.write ? 0 : out;
+}
+
+static inline void dwSimPin(int pin, int value) {
+	(void)pin;
+	if (value == 0) dwSimBus.state = 0;
+}
+
+static inline void dwSimInstall() {
+	memset(dwSimRegs, 0, sizeof(dwSimRegs));
+	memset(&dwSimBus, 0, sizeof(dwSimBus));
+	dwSimLog.clear();
+	hostSpiTransfer = dwSimSpi;
+	hostPinWrite = dwSimPin;
+}
+
+// little-endian 讀寫 len（<= 8）bytes
+static inline void dwSimSet(uint8_t reg, uint16_t off, uint64_t v, uint8_t len) {
+	for (uint8_t i = 0; i < len; i++) dwSimRegs[reg][off + i] = (uint8_t)(v >> (8 * i));
+}
+
+static inline uint64_t dwSimGet(uint8_t reg, uint16_t off, uint8_t len) {
+	uint64_t v = 0;
+	for (int i = len - 1; i >= 0; i--) v = (v << 8) | dwSimRegs[reg][off + i];
+	return v;
+}
+
+// dwSimLog 裡某個 register 的讀 / 寫交易數
+static inline unsigned dwSimCount(uint8_t reg, bool write) {
+	unsigned n = 0;
+	for (const DwSimAccess& a : dwSimLog) n += (a.reg == reg && a.write == write);
+	return n;
+}
+
+#endif
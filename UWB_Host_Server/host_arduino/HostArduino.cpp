@@ -0,0 +1,111 @@
+/*
+ * @file HostArduino.cpp
+ * host_arduino/Arduino.h、SPI.h 的實作
+ */
+
+#include "Arduino.h"
+#include "SPI.h"
+
+unsigned long hostStringAllocs = 0;
+bool          hostSerialEcho = false;
+uint64_t      hostMicros = 0;
+
+uint8_t (*hostSpiTransfer)(uint8_t b) = nullptr;
+void    (*hostPinWrite)(int pin, int value) = nullptr;
+
+HardwareSerial Serial;
+SPIClass       SPI;
+EspClass       ESP;
+
+// ---- String ----
+// WString::reserve：容量不夠才 realloc，而且只配到剛好（不預留）
+bool String::reserve(unsigned size) {
+	if (_buf != nullptr && _cap >= size) return true;
+	char* p = (char*)realloc(_buf, size + 1);
+	if (p == nullptr) return false;
+	hostStringAllocs++;
+	if (_buf == nullptr) p[0] = '\0';
+	_buf = p;
+	_cap = size;
+	return true;
+}
+
+void String::copy(const char* s, unsigned n) {
+	if (!reserve(n)) return;
+	if (n > 0) memmove(_buf, s, n);
+	_buf[n] = '\0';
+	_len = n;
+}
+
+String& String::concat(const char* s, unsigned n) {
+	if (n == 0 || !reserve(_len + n)) return *this;
+	memmove(_buf + _len, s, n);
+	_len += n;
+	_buf[_len] = '\0';
+	return *this;
+}
+
+void String::getBytes(unsigned char* out, unsigned size) const {
+	if (size == 0) return;
+	unsigned n = (_len < size - 1) ? _len : size - 1;
+	if (n > 0) memcpy(out, _buf, n);
+	out[n] = '\0';
+}
+
+// ---- Print ----
+size_t Print::print(const char* s) {
+	if (s == nullptr) return 0;
+	if (hostSerialEcho) fputs(s, stdout);
+	return strlen(s);
+}
+
+size_t Print::print(long v, int base) {
+	if (base == DEC || v >= 0) {
+		char t[24];
+		snprintf(t, sizeof(t), "%ld", v);
+		return base == DEC ? print(t) : print((unsigned long)v, base);
+	}
+	return print((unsigned long)v, base);
+}
+
+size_t Print::print(unsigned long v, int base) {
+	char t[72];
+	if (base == HEX) snprintf(t, sizeof(t), "%lX", v);
+	else if (base == DEC) snprintf(t, sizeof(t), "%lu", v);
+	else {
+		char r[72];
+		int n = 0;
+		do {
+			r[n++] = "0123456789ABCDEF"[v % (unsigned long)base];
+			v /= (unsigned long)base;
+		} while (v != 0);
+		for (int i = 0; i < n; i++) t[i] = r[n - 1 - i];
+		t[n] = '\0';
+	}
+	return print(t);
+}
+
+size_t Print::print(double v, int digits) {
+	char t[48];
+	snprintf(t, sizeof(t), "%.*f", digits, v);
+	return print(t);
+}
+
+// ---- 時間 / 腳位 ----
+unsigned long millis() { return (unsigned long)(hostMicros / 1000); }
+unsigned long micros() { return (unsigned long)hostMicros; }
+void delay(unsigned long ms) { hostMicros += (uint64_t)ms * 1000; }
+void delayMicroseconds(unsigned int us) { hostMicros += us; }
+
+void pinMode(int, int) {}
+void digitalWrite(int pin, int value) {
+	if (hostPinWrite) hostPinWrite(pin, value);
+}
+int  digitalRead(int) { return LOW; }
+int  digitalPinToInterrupt(int pin) { return pin; }
+void attachInterrupt(int, void (*)(), int) {}
+int  analogRead(int) { return 0; }
+
+long random(long hi) { return hi > 0 ? rand() % hi : 0; }
+long random(long lo, long hi) { return hi > lo ? lo + rand() % (hi - lo) : lo; }
+void randomSeed(unsigned long seed) { srand((unsigned)seed); }
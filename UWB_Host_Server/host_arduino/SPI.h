@@ -0,0 +1,36 @@
+/*
+ * @file SPI.h
+ * Host 測試用的 SPI：每個 byte 交給 hostSpiTransfer（測試設定成 DW1000 暫存器模擬），
+ * 沒設定時讀回 0
+ */
+
+#ifndef _HostSPI_H_INCLUDED
+#define _HostSPI_H_INCLUDED
+
+#include "Arduino.h"
+
+#define MSBFIRST  1
+#define SPI_MODE0 0
+
+extern uint8_t (*hostSpiTransfer)(uint8_t b);
+extern void    (*hostPinWrite)(int pin, int value);   // digitalWrite（CS 拉低 = 新的 SPI 交易）
+
+class SPISettings {
+public:
+	SPISettings() {}
+	SPISettings(unsigned long, int, int) {}
+};
+
+class SPIClass {
+public:
+	void begin() {}
+	void begin(int, int, int) {}
+	void end() {}
+	void beginTransaction(SPISettings) {}
+	void endTransaction() {}
+	void usingInterrupt(int) {}
+	uint8_t transfer(uint8_t b) { return hostSpiTransfer ? hostSpiTransfer(b) : 0; }
+};
+extern SPIClass SPI;
+
+#endif
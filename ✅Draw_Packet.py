@@ -126,8 +126,10 @@ def get_packet_structure(b):
             return "Range_Report (Encryption - False)", struct
             
         # 加密
-        padding = b[11]-32
-        if func == 0x03 and encryption == 0x01:
+        # 0x03 = payload 前面多 1 byte IV 模式
+        ivmode = [("IV\nMode", 1, "#FDE8FE")] if encryption == 0x03 else []
+        padding = b[11] - 32 - len(ivmode)
+        if func == 0x03 and encryption in (0x01, 0x02, 0x03):  # 0x02 = 有 AAD 的新版
             if padding == 0:
                 struct += [
                     ("Mac\nHeader",        2, "#FEFDE8"),
@@ -138,6 +140,7 @@ def get_packet_structure(b):
                     ("Func",               1, "#ECFEE8"),
                     ("Encryption\n(True)", 1, "#FDE8FE"),
                     ("Length",             1, "#FDE8FE"),
+                    *ivmode,
                     ("IV",                 12,"#FDE8FE"),
                     ("Tag",                16,"#FDE8FE"),
                     ("Chiptext",           4, "#FDE8FE"),
@@ -153,6 +156,7 @@ def get_packet_structure(b):
                     ("Func",               1, "#ECFEE8"),
                     ("Encryption\n(True)", 1, "#FDE8FE"),
                     ("Length",             1, "#FDE8FE"),
+                    *ivmode,
                     ("IV",                 12,"#FDE8FE"),
                     ("Tag",                16,"#FDE8FE"),
                     ("Chiptext",           4, "#FDE8FE"),
@@ -3,6 +3,7 @@ import turtle
 import math, cmath
 import socket
 import json
+import struct
 
 # ==========================
 # UDP Setting
@@ -15,10 +16,58 @@ sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
 sock.bind((UDP_IP, UDP_PORT))
 sock.settimeout(0.5)
 
+# ==========================
+# Binary Telemetry (UWBTelemetry.h)
+# ==========================
+TELEM_MAGIC = b"UW"
+TELEM_VERSION = 1
+TELEM_HEADER = struct.Struct("<2sBBHI5sB")  # magic, version, count, tagId, seq, dwTime(40-bit), flags
+TELEM_RECORD = struct.Struct("<Hihh")       # anchor, range_mm, rx_cdBm, fp_cdBm
+
+def decode_telemetry(data):
+    magic, version, count, tag_id, seq, dw_time, flags = TELEM_HEADER.unpack_from(data, 0)
+    if magic != TELEM_MAGIC or version != TELEM_VERSION:
+        raise ValueError(f"unsupported telemetry magic/version {magic}/{version}")
+    if len(data) < TELEM_HEADER.size + count * TELEM_RECORD.size:
+        raise ValueError("telemetry datagram too short")
+    links = []
+    for i in range(count):
+        anchor, range_mm, rx, fp = TELEM_RECORD.unpack_from(data, TELEM_HEADER.size + i * TELEM_RECORD.size)
+        # 與 JSON 版欄位相同（A = 16 進位字串、R = 公尺），另外多 RX / FP power (dBm)
+        links.append({"A": f"{anchor:X}", "R": range_mm / 1000.0, "RX": rx / 100.0, "FP": fp / 100.0})
+    return links
+
+def decode_links(data):
+    # 二進位遙測以 'UW' 開頭；其他視為舊版 JSON
+    if data[:2] == TELEM_MAGIC:
+        return decode_telemetry(data)
+    return json.loads(data)["links"]
+
 # ==========================
 # Coordination and Scale Setting
 # ==========================
 distance_A1_A2 = 2
+# ===== [Add] 有 UWB_Anchor_Survey 算出的座標檔（-o anchors.txt）時，A1-A2 距離改用座標算，不必拿捲尺量 =====
+ANCHOR_LAYOUT_FILE = None   # 例如 "UWB_Host_Server/anchors.txt"（前兩行 = A1、A2）
+
+def load_anchor_distance(path, default):
+    # 檔案格式：short address(16進位) x y z；取前兩台的水平距離
+    try:
+        rows = []
+        with open(path, encoding="utf-8") as f:
+            for line in f:
+                fields = line.split()
+                if len(fields) == 4 and not line.startswith("#"):
+                    rows.append([float(v) for v in fields[1:3]])
+        if len(rows) >= 2:
+            return math.hypot(rows[1][0] - rows[0][0], rows[1][1] - rows[0][1])
+    except (OSError, ValueError):
+        pass
+    return default
+
+if ANCHOR_LAYOUT_FILE:
+    distance_A1_A2 = load_anchor_distance(ANCHOR_LAYOUT_FILE, distance_A1_A2)
+# ========= [End Add] =========
 MeterToPixel = 100.0
 range_offset = 0.9
 
@@ -158,9 +207,9 @@ def main():
             print(f"Received message: {data} from {address}")
 
             try:
-                List = json.loads(data)["links"]
+                List = decode_links(data)
             except Exception as e:
-                print("JSON decode error:", e)
+                print("Telemetry decode error:", e)
                 List = []
 
             Positioning = 0